@@ -0,0 +1,744 @@
+/*
+ * Copyright (C)2011 D. R. Commander.  All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the libjpeg-turbo Project nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS",
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * This program tests the libjpeg API extensions that are not reachable
+ * through the TurboJPEG API (see "Entropy checkpoint index" and "Progressive
+ * compression" and jpeg_set_huffman_sample() in libjpeg.txt.)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include "jpeglib.h"
+#include "jerror.h"
+
+
+void usage(char *progName)
+{
+  printf("\nUSAGE: %s [options]\n\n", progName);
+  printf("Options:\n");
+  printf("-checkpoints = test only the entropy checkpoint index\n");
+  printf("-scanthreads = test only jpeg_set_scan_threads()\n");
+  printf("-huffsample = test only jpeg_set_huffman_sample()\n\n");
+  exit(1);
+}
+
+
+#define _throw(m) { printf("ERROR: %s\n", m);  bailout() }
+
+int exitStatus = 0;
+#define bailout() { exitStatus = -1;  goto bailout; }
+
+const char *subName[] = { "444", "422", "420", "440", "411", "GRAY" };
+const int subSampH[] = { 1, 2, 2, 1, 4, 1 };
+const int subSampV[] = { 1, 1, 2, 2, 1, 1 };
+#define NUMSUBSAMP  (int)(sizeof(subName) / sizeof(subName[0]))
+#define SUBSAMP_GRAY  (NUMSUBSAMP - 1)
+
+
+/* Error handling: errors longjmp() back to the caller, and warnings are
+   counted rather than printed, so that the tests can check for them. */
+
+struct my_error_mgr {
+  struct jpeg_error_mgr pub;
+  jmp_buf setjmp_buffer;
+  int error_code;
+  int num_warnings;
+  int last_warning;
+};
+
+typedef struct my_error_mgr *my_error_ptr;
+
+static void my_error_exit(j_common_ptr cinfo)
+{
+  my_error_ptr myerr = (my_error_ptr)cinfo->err;
+
+  myerr->error_code = cinfo->err->msg_code;
+  longjmp(myerr->setjmp_buffer, 1);
+}
+
+static void my_emit_message(j_common_ptr cinfo, int msg_level)
+{
+  my_error_ptr myerr = (my_error_ptr)cinfo->err;
+
+  if (msg_level < 0) {
+    myerr->num_warnings++;
+    myerr->last_warning = cinfo->err->msg_code;
+  }
+}
+
+static void init_error_mgr(struct my_error_mgr *jerr)
+{
+  jpeg_std_error(&jerr->pub);
+  jerr->pub.error_exit = my_error_exit;
+  jerr->pub.emit_message = my_emit_message;
+  jerr->error_code = 0;
+  jerr->num_warnings = 0;
+  jerr->last_warning = 0;
+}
+
+
+/* Fill the image with a smooth gradient overlaid with a pseudo-random
+   pattern, so that the entropy-coded data contains a healthy mix of DC and AC
+   coefficients. */
+
+void initBuf(unsigned char *buf, int w, int h, int ps, unsigned int seed)
+{
+  int row, col, i;
+
+  for (row = 0; row < h; row++) {
+    for (col = 0; col < w; col++) {
+      for (i = 0; i < ps; i++) {
+        seed = seed * 1103515245 + 12345;
+        *buf++ = (unsigned char)(((row + col) * (i + 1) + (col * row) / 64 +
+                                  ((seed >> 16) & 63)) & 255);
+      }
+    }
+  }
+}
+
+
+/* Compression parameters */
+
+typedef struct {
+  int quality;
+  int restartRows;
+  boolean progressive;
+  boolean optimize;
+  int scanThreads;              /* 0 = do not call jpeg_set_scan_threads() */
+  JDIMENSION huffSample;        /* passed to jpeg_set_huffman_sample() */
+  size_t suspendSize;           /* nonzero = write to a suspending destination
+                                   with a buffer of this size */
+  /* Results */
+  int errorCode;                /* msg_code of the error, if any */
+} comp_params;
+
+
+/* A data destination that suspends when its buffer is full */
+
+typedef struct {
+  struct jpeg_destination_mgr pub;
+  JOCTET *buffer;
+  size_t size;
+} suspend_dest_mgr;
+
+static void init_suspend_dest(j_compress_ptr cinfo)
+{
+  suspend_dest_mgr *dest = (suspend_dest_mgr *)cinfo->dest;
+
+  dest->pub.next_output_byte = dest->buffer;
+  dest->pub.free_in_buffer = dest->size;
+}
+
+static boolean empty_suspend_dest(j_compress_ptr cinfo)
+{
+  return FALSE;
+}
+
+static void term_suspend_dest(j_compress_ptr cinfo)
+{
+}
+
+
+/* Compress an image with the given sampling factors to a memory buffer */
+
+int compressImage(unsigned char *srcBuf, int w, int h, int subsamp,
+                  comp_params *p, unsigned char **jpegBuf,
+                  unsigned long *jpegSize)
+{
+  struct jpeg_compress_struct cinfo;
+  struct my_error_mgr jerr;
+  suspend_dest_mgr dest;
+  JSAMPROW row_pointer[1];
+  int ps = subsamp == SUBSAMP_GRAY ? 1 : 3;
+
+  *jpegBuf = NULL;  *jpegSize = 0;
+  p->errorCode = 0;
+  cinfo.err = (struct jpeg_error_mgr *)&jerr;
+  init_error_mgr(&jerr);
+  if (setjmp(jerr.setjmp_buffer)) {
+    p->errorCode = jerr.error_code;
+    jpeg_destroy_compress(&cinfo);
+    free(*jpegBuf);  *jpegBuf = NULL;
+    return -1;
+  }
+  jpeg_create_compress(&cinfo);
+  if (p->suspendSize) {
+    if ((*jpegBuf = (unsigned char *)malloc(p->suspendSize)) == NULL) {
+      jpeg_destroy_compress(&cinfo);
+      return -1;
+    }
+    dest.pub.init_destination = init_suspend_dest;
+    dest.pub.empty_output_buffer = empty_suspend_dest;
+    dest.pub.term_destination = term_suspend_dest;
+    dest.buffer = *jpegBuf;
+    dest.size = p->suspendSize;
+    cinfo.dest = &dest.pub;
+  } else
+    jpeg_mem_dest(&cinfo, jpegBuf, jpegSize);
+  cinfo.image_width = w;
+  cinfo.image_height = h;
+  cinfo.input_components = ps;
+  cinfo.in_color_space = ps == 1 ? JCS_GRAYSCALE : JCS_RGB;
+  jpeg_set_defaults(&cinfo);
+  jpeg_set_quality(&cinfo, p->quality, TRUE);
+  cinfo.restart_in_rows = p->restartRows;
+  cinfo.optimize_coding = p->optimize;
+  if (ps == 3) {
+    cinfo.comp_info[0].h_samp_factor = subSampH[subsamp];
+    cinfo.comp_info[0].v_samp_factor = subSampV[subsamp];
+  }
+  if (p->progressive)
+    jpeg_simple_progression(&cinfo);
+  jpeg_set_huffman_sample(&cinfo, p->huffSample);
+
+  jpeg_start_compress(&cinfo, TRUE);
+  /* Before the first jpeg_write_scanlines() call, so that it also applies to
+     the first scan */
+  if (p->scanThreads)
+    jpeg_set_scan_threads(&cinfo, p->scanThreads);
+  while (cinfo.next_scanline < cinfo.image_height) {
+    row_pointer[0] = &srcBuf[cinfo.next_scanline * w * ps];
+    if (jpeg_write_scanlines(&cinfo, row_pointer, 1) == 0) {
+      /* The destination suspended. */
+      jpeg_destroy_compress(&cinfo);
+      free(*jpegBuf);  *jpegBuf = NULL;
+      return -1;
+    }
+  }
+  jpeg_finish_compress(&cinfo);
+  if (p->suspendSize)
+    *jpegSize = (unsigned long)(p->suspendSize - dest.pub.free_in_buffer);
+  jpeg_destroy_compress(&cinfo);
+  return 0;
+}
+
+
+/* Decompression parameters and results.  Rows [skipStart, skipStart +
+   skipLines) are skipped with jpeg_skip_scanlines(), and if cropWidth is
+   nonzero, the columns outside of [cropX, cropX + cropWidth) are skipped with
+   jpeg_crop_scanline().  The skipped parts of the output buffer are left
+   zeroed. */
+
+typedef struct {
+  FILE *file;                   /* read from this file rather than memory */
+  int saveInterval;             /* -1 = do not save checkpoints */
+  const unsigned char *ckptBuf;
+  unsigned long ckptSize;
+  JDIMENSION skipStart, skipLines;
+  JDIMENSION cropX, cropWidth;
+  /* Results */
+  unsigned char *dstBuf;        /* output_height rows of output_width pixels */
+  int width, height, ps;
+  boolean gotCheckpoints;
+  unsigned char *ckptOut;
+  unsigned long ckptOutSize;
+  int numWarnings, lastWarning;
+} decomp_params;
+
+
+int decompressImage(const unsigned char *jpegBuf, unsigned long jpegSize,
+                    decomp_params *p)
+{
+  struct jpeg_decompress_struct cinfo;
+  struct my_error_mgr jerr;
+  JSAMPROW row_pointer[1];
+  JDIMENSION xoffset, width;
+  int pitch, retval = -1;
+
+  p->dstBuf = NULL;
+  p->ckptOut = NULL;  p->ckptOutSize = 0;
+  p->gotCheckpoints = FALSE;
+  cinfo.err = (struct jpeg_error_mgr *)&jerr;
+  init_error_mgr(&jerr);
+  if (setjmp(jerr.setjmp_buffer)) {
+    jpeg_destroy_decompress(&cinfo);
+    free(p->dstBuf);  p->dstBuf = NULL;
+    free(p->ckptOut);  p->ckptOut = NULL;
+    return -1;
+  }
+  jpeg_create_decompress(&cinfo);
+  if (p->file) {
+    rewind(p->file);
+    jpeg_stdio_src(&cinfo, p->file);
+  } else
+    jpeg_mem_src(&cinfo, jpegBuf, jpegSize);
+  jpeg_read_header(&cinfo, TRUE);
+  if (p->saveInterval >= 0)
+    jpeg_save_checkpoints(&cinfo, (JDIMENSION)p->saveInterval);
+  if (p->ckptBuf)
+    jpeg_use_checkpoints(&cinfo, p->ckptBuf, p->ckptSize);
+
+  jpeg_start_decompress(&cinfo);
+  p->width = cinfo.output_width;
+  p->height = cinfo.output_height;
+  p->ps = cinfo.output_components;
+  pitch = p->width * p->ps;
+  if ((p->dstBuf = (unsigned char *)calloc(p->height, pitch)) == NULL)
+    _throw("Memory allocation failure");
+  xoffset = 0;  width = cinfo.output_width;
+  if (p->cropWidth) {
+    xoffset = p->cropX;  width = p->cropWidth;
+    jpeg_crop_scanline(&cinfo, &xoffset, &width);
+    p->cropX = xoffset;  p->cropWidth = width;
+  }
+  while (cinfo.output_scanline < cinfo.output_height) {
+    if (p->skipLines && cinfo.output_scanline == p->skipStart) {
+      jpeg_skip_scanlines(&cinfo, p->skipLines);
+      continue;
+    }
+    row_pointer[0] = &p->dstBuf[cinfo.output_scanline * pitch +
+                                xoffset * p->ps];
+    jpeg_read_scanlines(&cinfo, row_pointer, 1);
+  }
+  if (p->saveInterval >= 0)
+    p->gotCheckpoints = jpeg_get_checkpoints(&cinfo, &p->ckptOut,
+                                             &p->ckptOutSize);
+  jpeg_finish_decompress(&cinfo);
+  p->numWarnings = jerr.num_warnings;
+  p->lastWarning = jerr.last_warning;
+  retval = 0;
+
+  bailout:
+  jpeg_destroy_decompress(&cinfo);
+  return retval;
+}
+
+
+/* Check that the rows and columns decoded in p match the full decode in ref */
+
+int checkRegion(decomp_params *p, decomp_params *ref)
+{
+  int row, pitch = ref->width * ref->ps;
+  int x = p->cropWidth ? p->cropX : 0;
+  int w = p->cropWidth ? p->cropWidth : ref->width;
+
+  /* Fancy upsampling treats the edges of the cropping region as the edges of
+     the image, so the first and last columns may differ from a full decode. */
+  if (x > 0) { x++;  w--; }
+  if (x + w < ref->width) w--;
+
+  if (p->width != ref->width || p->height != ref->height || p->ps != ref->ps)
+    return 0;
+  for (row = 0; row < ref->height; row++) {
+    if (p->skipLines && row >= (int)p->skipStart &&
+        row < (int)(p->skipStart + p->skipLines))
+      continue;
+    if (memcmp(&p->dstBuf[row * pitch + x * p->ps],
+               &ref->dstBuf[row * pitch + x * p->ps], w * p->ps))
+      return 0;
+  }
+  return 1;
+}
+
+
+/* Decode the image with the given index, and check that the index was
+   accepted (or rejected, if expectValid is 0) and that the result matches
+   the same decode without an index. */
+
+int useIndexTest(const unsigned char *jpegBuf, unsigned long jpegSize,
+                 const unsigned char *ckptBuf, unsigned long ckptSize,
+                 decomp_params *noIndex, int expectValid)
+{
+  decomp_params p = *noIndex;
+  int retval = -1;
+
+  p.saveInterval = -1;
+  p.ckptBuf = ckptBuf;  p.ckptSize = ckptSize;
+  if (decompressImage(jpegBuf, jpegSize, &p) == -1)
+    _throw("Decompression failed");
+  if (expectValid && p.numWarnings != 0)
+    _throw("Valid index was rejected");
+  if (!expectValid &&
+      (p.numWarnings != 1 || p.lastWarning != JWRN_BAD_CHECKPOINTS))
+    _throw("Bad index was not rejected");
+  if (p.cropX != noIndex->cropX || p.cropWidth != noIndex->cropWidth ||
+      memcmp(p.dstBuf, noIndex->dstBuf, p.height * p.width * p.ps))
+    _throw("Output differs from decompression without an index");
+  retval = 0;
+
+  bailout:
+  free(p.dstBuf);
+  return retval;
+}
+
+
+/* Save an index during a full decode, serialize it, reload it, and use it to
+   skip and crop. */
+
+void checkpointTest(int w, int h, int subsamp, int restartRows, int interval)
+{
+  unsigned char *srcBuf = NULL, *jpegBuf = NULL, *ckptBuf = NULL;
+  unsigned long jpegSize = 0, ckptSize = 0;
+  decomp_params full, noIndex;
+  comp_params cp = { 95, 0, FALSE, FALSE, 0, 0, 0, 0 };
+  int ps = subsamp == SUBSAMP_GRAY ? 1 : 3, i;
+  /* { skipStart, skipLines, cropX, cropWidth } as fractions of 16 */
+  static const int regions[][4] = {
+    { 0, 0, 10, 3 }, { 9, 5, 0, 0 }, { 2, 12, 13, 3 }, { 0, 15, 5, 6 },
+    { 7, 1, 1, 14 }
+  };
+
+  memset(&full, 0, sizeof(full));
+  memset(&noIndex, 0, sizeof(noIndex));
+  printf("Checkpoints: %4d x %4d %-4s restart rows %d interval %3d ... ", w, h,
+         subName[subsamp], restartRows, interval);
+  if ((srcBuf = (unsigned char *)malloc(w * h * ps)) == NULL)
+    _throw("Memory allocation failure");
+  initBuf(srcBuf, w, h, ps, (unsigned int)(w * h + subsamp));
+  cp.restartRows = restartRows;
+  if (compressImage(srcBuf, w, h, subsamp, &cp, &jpegBuf, &jpegSize) == -1)
+    _throw("Compression failed");
+
+  full.saveInterval = interval;
+  if (decompressImage(jpegBuf, jpegSize, &full) == -1)
+    _throw("Decompression failed");
+  if (!full.gotCheckpoints || full.numWarnings != 0)
+    _throw("Index was not saved");
+  /* The application owns a serialized copy that it may store anywhere */
+  if ((ckptBuf = (unsigned char *)malloc(full.ckptOutSize)) == NULL)
+    _throw("Memory allocation failure");
+  memcpy(ckptBuf, full.ckptOut, full.ckptOutSize);
+  ckptSize = full.ckptOutSize;
+
+  for (i = 0; i < (int)(sizeof(regions) / sizeof(regions[0])); i++) {
+    memset(&noIndex, 0, sizeof(noIndex));
+    noIndex.saveInterval = -1;
+    noIndex.skipStart = regions[i][0] * h / 16;
+    noIndex.skipLines = regions[i][1] * h / 16;
+    noIndex.cropX = regions[i][2] * w / 16;
+    noIndex.cropWidth = regions[i][3] * w / 16;
+    if (decompressImage(jpegBuf, jpegSize, &noIndex) == -1)
+      _throw("Decompression failed");
+    if (!checkRegion(&noIndex, &full))
+      _throw("Partial decompression differs from full decompression");
+    if (useIndexTest(jpegBuf, jpegSize, ckptBuf, ckptSize, &noIndex, 1) == -1)
+      goto bailout;
+    free(noIndex.dstBuf);  noIndex.dstBuf = NULL;
+  }
+  printf("Passed.\n");
+
+  bailout:
+  free(srcBuf);  free(jpegBuf);  free(ckptBuf);
+  free(full.dstBuf);  free(full.ckptOut);  free(noIndex.dstBuf);
+}
+
+
+/* Check that truncated, corrupted, and mismatched indices, as well as indices
+   used with an unsupported data source, are rejected with a warning and do
+   not affect the output. */
+
+void badCheckpointTest(void)
+{
+  unsigned char *srcBuf = NULL, *jpegBuf = NULL, *jpegBuf2 = NULL,
+    *badBuf = NULL;
+  unsigned long jpegSize = 0, jpegSize2 = 0, i;
+  decomp_params full, noIndex, stdioParams;
+  comp_params cp = { 90, 0, FALSE, FALSE, 0, 0, 0, 0 };
+  int w = 97, h = 61, bit;
+  FILE *file = NULL;
+
+  memset(&full, 0, sizeof(full));
+  memset(&noIndex, 0, sizeof(noIndex));
+  memset(&stdioParams, 0, sizeof(stdioParams));
+  printf("Bad checkpoint indices ... ");
+  if ((srcBuf = (unsigned char *)malloc(w * h * 3)) == NULL)
+    _throw("Memory allocation failure");
+  initBuf(srcBuf, w, h, 3, 1);
+  if (compressImage(srcBuf, w, h, 2, &cp, &jpegBuf, &jpegSize) == -1)
+    _throw("Compression failed");
+  initBuf(srcBuf, w, h, 3, 2);
+  if (compressImage(srcBuf, w, h, 2, &cp, &jpegBuf2, &jpegSize2) == -1)
+    _throw("Compression failed");
+
+  full.saveInterval = 3;
+  if (decompressImage(jpegBuf, jpegSize, &full) == -1)
+    _throw("Decompression failed");
+  if (!full.gotCheckpoints)
+    _throw("Index was not saved");
+  if ((badBuf = (unsigned char *)malloc(full.ckptOutSize)) == NULL)
+    _throw("Memory allocation failure");
+
+  noIndex.saveInterval = -1;
+  noIndex.skipStart = 8;  noIndex.skipLines = 40;
+  noIndex.cropX = 60;  noIndex.cropWidth = 20;
+  if (decompressImage(jpegBuf, jpegSize, &noIndex) == -1)
+    _throw("Decompression failed");
+
+  /* Every truncation */
+  for (i = 1; i < full.ckptOutSize; i++) {
+    if (useIndexTest(jpegBuf, jpegSize, full.ckptOut, i, &noIndex, 0) == -1)
+      goto bailout;
+  }
+
+  /* Every single-bit error */
+  for (i = 0; i < full.ckptOutSize; i++) {
+    for (bit = 0; bit < 8; bit++) {
+      memcpy(badBuf, full.ckptOut, full.ckptOutSize);
+      badBuf[i] ^= 1 << bit;
+      if (useIndexTest(jpegBuf, jpegSize, badBuf, full.ckptOutSize, &noIndex,
+                       0) == -1)
+        goto bailout;
+    }
+  }
+
+  /* An index from a different image with the same dimensions */
+  free(noIndex.dstBuf);  noIndex.dstBuf = NULL;
+  if (decompressImage(jpegBuf2, jpegSize2, &noIndex) == -1)
+    _throw("Decompression failed");
+  if (useIndexTest(jpegBuf2, jpegSize2, full.ckptOut, full.ckptOutSize,
+                   &noIndex, 0) == -1)
+    goto bailout;
+
+  /* A data source other than jpeg_mem_src() supports neither saving nor
+     using an index. */
+  if ((file = tmpfile()) == NULL)
+    _throw("Could not create temporary file");
+  if (fwrite(jpegBuf, jpegSize, 1, file) != 1)
+    _throw("Could not write temporary file");
+  stdioParams.file = file;
+  stdioParams.saveInterval = 0;
+  if (decompressImage(NULL, 0, &stdioParams) == -1)
+    _throw("Decompression failed");
+  if (stdioParams.gotCheckpoints || stdioParams.ckptOut != NULL)
+    _throw("Index was saved with a stdio source");
+  free(stdioParams.dstBuf);  stdioParams.dstBuf = NULL;
+  free(noIndex.dstBuf);  noIndex.dstBuf = NULL;
+  if (decompressImage(jpegBuf, jpegSize, &noIndex) == -1)
+    _throw("Decompression failed");
+  noIndex.file = file;
+  if (useIndexTest(NULL, 0, full.ckptOut, full.ckptOutSize, &noIndex,
+                   0) == -1)
+    goto bailout;
+  printf("Passed.\n");
+
+  bailout:
+  if (file) fclose(file);
+  free(srcBuf);  free(jpegBuf);  free(jpegBuf2);  free(badBuf);
+  free(full.dstBuf);  free(full.ckptOut);  free(noIndex.dstBuf);
+  free(stdioParams.dstBuf);
+}
+
+
+void doCheckpointTests(void)
+{
+  int subsamp;
+
+  for (subsamp = 0; subsamp < NUMSUBSAMP; subsamp++) {
+    checkpointTest(227, 149, subsamp, 0, 0);
+    checkpointTest(227, 149, subsamp, 0, 7);
+    checkpointTest(227, 149, subsamp, 2, 0);
+  }
+  checkpointTest(1, 1, 2, 0, 0);
+  checkpointTest(2048, 16, 0, 0, 1);
+  checkpointTest(16, 2048, 5, 0, 0);
+  badCheckpointTest();
+}
+
+
+/* Check that compressing with several scan threads produces exactly the
+   same JPEG image as compressing with one. */
+
+void scanThreadTest(int w, int h, int subsamp, boolean progressive,
+                    boolean optimize, int restartRows)
+{
+  unsigned char *srcBuf = NULL, *jpegBuf1 = NULL, *jpegBuf4 = NULL;
+  unsigned long jpegSize1 = 0, jpegSize4 = 0;
+  comp_params cp = { 90, 0, FALSE, FALSE, 1, 0, 0, 0 };
+  int ps = subsamp == SUBSAMP_GRAY ? 1 : 3;
+
+  printf("Scan threads: %4d x %4d %-4s %s%s restart rows %d ... ", w, h,
+         subName[subsamp], progressive ? "progressive" : "sequential",
+         optimize ? " optimized" : "", restartRows);
+  if ((srcBuf = (unsigned char *)malloc(w * h * ps)) == NULL)
+    _throw("Memory allocation failure");
+  initBuf(srcBuf, w, h, ps, (unsigned int)(w + h + subsamp));
+
+  cp.restartRows = restartRows;
+  cp.progressive = progressive;
+  cp.optimize = optimize;
+  if (compressImage(srcBuf, w, h, subsamp, &cp, &jpegBuf1, &jpegSize1) == -1)
+    _throw("Compression failed");
+  cp.scanThreads = 4;
+  if (compressImage(srcBuf, w, h, subsamp, &cp, &jpegBuf4, &jpegSize4) == -1)
+    _throw("Compression failed");
+  if (jpegSize1 != jpegSize4 || memcmp(jpegBuf1, jpegBuf4, jpegSize1))
+    _throw("Output differs from single-threaded compression");
+  printf("Passed.\n");
+
+  bailout:
+  free(srcBuf);  free(jpegBuf1);  free(jpegBuf4);
+}
+
+
+void doScanThreadTests(void)
+{
+  int subsamp, restartRows;
+
+  for (subsamp = 0; subsamp < NUMSUBSAMP; subsamp++) {
+    for (restartRows = 0; restartRows <= 1; restartRows++) {
+      scanThreadTest(801, 723, subsamp, TRUE, FALSE, restartRows);
+      /* Sequential images this large gather their statistics on several
+         threads in jchuff.c. */
+      scanThreadTest(801, 723, subsamp, FALSE, TRUE, restartRows);
+    }
+  }
+  /* Fewer scans than threads, and fewer MCUs than scans */
+  scanThreadTest(1, 1, 0, TRUE, FALSE, 0);
+  scanThreadTest(17, 9, 2, TRUE, FALSE, 1);
+  /* Exactly enough MCUs for two threads, and one row of MCUs fewer */
+  scanThreadTest(512, 128, 0, FALSE, TRUE, 0);
+  scanThreadTest(512, 120, 0, FALSE, TRUE, 3);
+}
+
+
+/* Check that an image whose Huffman tables were derived from a sample of its
+   rows decodes to the same pixels as one with fully optimized tables.  The
+   top half of the image is flat, so that the bottom half contains symbols
+   that do not occur in the sample.  If the setting should be ignored, the two
+   images must be identical. */
+
+void huffSampleTest(int w, int h, int subsamp, JDIMENSION sampleLines,
+                    boolean progressive, int restartRows, boolean ignored)
+{
+  unsigned char *srcBuf = NULL, *jpegBuf = NULL, *sampledBuf = NULL;
+  unsigned long jpegSize = 0, sampledSize = 0;
+  decomp_params full, sampled;
+  comp_params cp = { 90, 0, FALSE, TRUE, 0, 0, 0, 0 };
+  int ps = subsamp == SUBSAMP_GRAY ? 1 : 3;
+
+  printf("Huffman sample: %4d x %4d %-4s %s restart rows %d sample %d ... ",
+         w, h, subName[subsamp], progressive ? "progressive" : "sequential",
+         restartRows, (int)sampleLines);
+  memset(&full, 0, sizeof(full));
+  memset(&sampled, 0, sizeof(sampled));
+  full.saveInterval = sampled.saveInterval = -1;
+  if ((srcBuf = (unsigned char *)malloc((size_t)w * h * ps)) == NULL)
+    _throw("Memory allocation failure");
+  initBuf(srcBuf, w, h, ps, (unsigned int)(w + h + subsamp));
+  memset(srcBuf, 128, (size_t)w * (h / 2) * ps);
+
+  cp.restartRows = restartRows;
+  cp.progressive = progressive;
+  if (compressImage(srcBuf, w, h, subsamp, &cp, &jpegBuf, &jpegSize) == -1)
+    _throw("Compression failed");
+  cp.huffSample = sampleLines;
+  if (compressImage(srcBuf, w, h, subsamp, &cp, &sampledBuf,
+                    &sampledSize) == -1)
+    _throw("Compression with a Huffman sample failed");
+  if (ignored) {
+    if (sampledSize != jpegSize || memcmp(sampledBuf, jpegBuf, jpegSize))
+      _throw("Huffman sample was not ignored");
+  } else {
+    if (sampledSize == jpegSize && !memcmp(sampledBuf, jpegBuf, jpegSize))
+      _throw("Huffman sample was ignored");
+    if (decompressImage(jpegBuf, jpegSize, &full) == -1 ||
+        decompressImage(sampledBuf, sampledSize, &sampled) == -1)
+      _throw("Decompression failed");
+    if (sampled.numWarnings)
+      _throw("Decompression produced a warning");
+    if (sampled.width != full.width || sampled.height != full.height ||
+        memcmp(sampled.dstBuf, full.dstBuf,
+               (size_t)full.width * full.height * full.ps))
+      _throw("Decompressed image differs from fully optimized image");
+  }
+  printf("Passed.\n");
+
+  bailout:
+  free(srcBuf);  free(jpegBuf);  free(sampledBuf);
+  free(full.dstBuf);  free(sampled.dstBuf);
+}
+
+
+/* Check that a suspending destination is rejected rather than producing a
+   truncated image.  The buffer holds the headers but not the sample rows. */
+
+void huffSampleSuspendTest(void)
+{
+  unsigned char *srcBuf = NULL, *jpegBuf = NULL;
+  unsigned long jpegSize = 0;
+  comp_params cp = { 90, 0, FALSE, TRUE, 0, 64, 4096, 0 };
+  int w = 1500, h = 1100;
+
+  printf("Huffman sample: suspending destination ... ");
+  if ((srcBuf = (unsigned char *)malloc((size_t)w * h * 3)) == NULL)
+    _throw("Memory allocation failure");
+  initBuf(srcBuf, w, h, 3, 1);
+  if (compressImage(srcBuf, w, h, 2, &cp, &jpegBuf, &jpegSize) == 0)
+    _throw("Compression succeeded");
+  if (cp.errorCode != JERR_CANT_SUSPEND)
+    _throw("Wrong error code");
+  printf("Passed.\n");
+
+  bailout:
+  free(srcBuf);  free(jpegBuf);
+}
+
+
+void doHuffSampleTests(void)
+{
+  int subsamp;
+
+  for (subsamp = 0; subsamp < NUMSUBSAMP; subsamp++) {
+    huffSampleTest(33, 17, subsamp, 8, FALSE, 0, FALSE);
+    huffSampleTest(1500, 1100, subsamp, 64, FALSE, 0, FALSE);
+    huffSampleTest(1500, 1100, subsamp, 64, FALSE, 1, FALSE);
+  }
+  huffSampleTest(4000, 3000, 0, 64, FALSE, 0, FALSE);
+  huffSampleTest(4000, 3000, 2, 256, FALSE, 2, FALSE);
+  /* Images no taller than the sample, and progressive images */
+  huffSampleTest(33, 17, 0, 17, FALSE, 0, TRUE);
+  huffSampleTest(33, 16, 2, 1, FALSE, 0, TRUE);
+  huffSampleTest(1500, 1100, 2, 2000, FALSE, 0, TRUE);
+  huffSampleTest(1500, 1100, 2, 64, TRUE, 0, TRUE);
+  huffSampleSuspendTest();
+}
+
+
+int main(int argc, char *argv[])
+{
+  int i, checkpoints = 0, scanThreads = 0, huffSample = 0;
+
+  for (i = 1; i < argc; i++) {
+    if (!strcasecmp(argv[i], "-checkpoints")) checkpoints = 1;
+    else if (!strcasecmp(argv[i], "-scanthreads")) scanThreads = 1;
+    else if (!strcasecmp(argv[i], "-huffsample")) huffSample = 1;
+    else usage(argv[0]);
+  }
+
+  if (checkpoints || argc == 1)
+    doCheckpointTests();
+  if (scanThreads || argc == 1)
+    doScanThreadTests();
+  if (huffSample || argc == 1)
+    doHuffSampleTests();
+
+  return exitStatus;
+}
@@ -52,6 +52,12 @@ typedef struct {
 
   /* In multi-pass modes, we need a virtual block array for each component. */
   jvirt_barray_ptr whole_image[MAX_COMPONENTS];
+
+  /* For sampled Huffman optimization, the virtual arrays hold only the first
+   * sample_rows iMCU rows, and the single-MCU workspace is used afterwards.
+   */
+  JDIMENSION sample_rows;       /* # of iMCU rows in the sample, or 0 */
+  JBLOCKROW workspace;          /* C_MAX_BLOCKS_IN_MCU blocks */
 } my_coef_controller;
 
 typedef my_coef_controller *my_coef_ptr;
@@ -63,6 +69,7 @@ METHODDEF(boolean) compress_data(j_compress_ptr cinfo, JSAMPIMAGE input_buf);
 METHODDEF(boolean) compress_first_pass(j_compress_ptr cinfo,
                                        JSAMPIMAGE input_buf);
 METHODDEF(boolean) compress_output(j_compress_ptr cinfo, JSAMPIMAGE input_buf);
+METHODDEF(boolean) compress_sample(j_compress_ptr cinfo, JSAMPIMAGE input_buf);
 #endif
 
 
@@ -112,7 +119,8 @@ start_pass_coef(j_compress_ptr cinfo, J_BUF_MODE pass_mode)
   case JBUF_SAVE_AND_PASS:
     if (coef->whole_image[0] == NULL)
       ERREXIT(cinfo, JERR_BAD_BUFFER_MODE);
-    coef->pub.compress_data = compress_first_pass;
+    coef->pub.compress_data = coef->sample_rows > 0 ? compress_sample :
+                                                      compress_first_pass;
     break;
   case JBUF_CRANK_DEST:
     if (coef->whole_image[0] == NULL)
@@ -394,6 +402,48 @@ compress_output(j_compress_ptr cinfo, JSAMPIMAGE input_buf)
   return TRUE;
 }
 
+
+/*
+ * Process some data in the sampled Huffman optimization case.
+ * The first sample_rows iMCU rows are DCT'd into the virtual arrays while
+ * the entropy encoder gathers their statistics, just as in the first pass of
+ * a multi-pass case.  Once the last of them has been loaded, the master
+ * control generates the Huffman tables and writes the headers, the buffered
+ * rows are emitted, and the rest of the image is processed as in the
+ * single-pass case.
+ */
+
+METHODDEF(boolean)
+compress_sample(j_compress_ptr cinfo, JSAMPIMAGE input_buf)
+{
+  my_coef_ptr coef = (my_coef_ptr)cinfo->coef;
+  JDIMENSION iMCU_row;
+  int i;
+
+  /* Gathering statistics never suspends. */
+  (void)compress_first_pass(cinfo, input_buf);
+  if (coef->iMCU_row_num < coef->sample_rows)
+    return TRUE;
+
+  (*cinfo->master->finish_sample) (cinfo);
+
+  /* Emit the buffered rows.  We could not resume this after a suspension, so
+   * like the multi-pass modes, this mode needs a non-suspending destination.
+   */
+  coef->iMCU_row_num = 0;
+  start_iMCU_row(cinfo);
+  for (iMCU_row = 0; iMCU_row < coef->sample_rows; iMCU_row++) {
+    if (!compress_output(cinfo, (JSAMPIMAGE)NULL))
+      ERREXIT(cinfo, JERR_CANT_SUSPEND);
+  }
+
+  /* Switch to the single-MCU buffer for the rest of the image */
+  for (i = 0; i < C_MAX_BLOCKS_IN_MCU; i++)
+    coef->MCU_buffer[i] = coef->workspace + i;
+  coef->pub.compress_data = compress_data;
+  return TRUE;
+}
+
 #endif /* FULL_COEF_BUFFER_SUPPORTED */
 
 
@@ -411,6 +461,7 @@ jinit_c_coef_controller(j_compress_ptr cinfo, boolean need_full_buffer)
                                 sizeof(my_coef_controller));
   cinfo->coef = (struct jpeg_c_coef_controller *)coef;
   coef->pub.start_pass = start_pass_coef;
+  coef->sample_rows = 0;
 
   /* Create the coefficient buffer. */
   if (need_full_buffer) {
@@ -444,6 +495,52 @@ jinit_c_coef_controller(j_compress_ptr cinfo, boolean need_full_buffer)
     for (i = 0; i < C_MAX_BLOCKS_IN_MCU; i++) {
       coef->MCU_buffer[i] = buffer + i;
     }
+    coef->workspace = buffer;
     coef->whole_image[0] = NULL; /* flag for no virtual arrays */
+
+#ifdef FULL_COEF_BUFFER_SUPPORTED
+    if (cinfo->master->sample_iMCU_rows > 0) {
+      /* Allocate a virtual array for each component that holds just the
+       * sampled iMCU rows.
+       */
+      int ci;
+      jpeg_component_info *compptr;
+
+      coef->sample_rows = cinfo->master->sample_iMCU_rows;
+      for (ci = 0, compptr = cinfo->comp_info; ci < cinfo->num_components;
+           ci++, compptr++) {
+        coef->whole_image[ci] = (*cinfo->mem->request_virt_barray)
+          ((j_common_ptr)cinfo, JPOOL_IMAGE, FALSE,
+           (JDIMENSION)jround_up((long)compptr->width_in_blocks,
+                                 (long)compptr->h_samp_factor),
+           coef->sample_rows * (JDIMENSION)compptr->v_samp_factor,
+           (JDIMENSION)compptr->v_samp_factor);
+      }
+    }
+#endif
   }
 }
+
+
+/*
+ * Replace cinfo->coef, which must be a full-image coefficient controller
+ * whose buffer has already been filled, with a private copy.  The copy reads
+ * the same buffer but keeps its own position, so a worker compression object
+ * (see jcmaster.c) can run an output pass for one scan while other scans are
+ * read from the buffer on other threads.
+ */
+
+GLOBAL(void)
+jcopy_c_coef_controller(j_compress_ptr cinfo)
+{
+  my_coef_ptr coef;
+
+  if (((my_coef_ptr)cinfo->coef)->whole_image[0] == NULL)
+    ERREXIT(cinfo, JERR_BAD_BUFFER_MODE);
+
+  coef = (my_coef_ptr)
+    (*cinfo->mem->alloc_small) ((j_common_ptr)cinfo, JPOOL_IMAGE,
+                                sizeof(my_coef_controller));
+  MEMCOPY(coef, cinfo->coef, sizeof(my_coef_controller));
+  cinfo->coef = (struct jpeg_c_coef_controller *)coef;
+}
@@ -611,11 +611,13 @@ jinit_color_converter(j_compress_ptr cinfo)
         rgb_green[cinfo->in_color_space] == 1 &&
         rgb_blue[cinfo->in_color_space] == 2 &&
         rgb_pixelsize[cinfo->in_color_space] == 3) {
+      if (jsimd_c_can_rgb_rgb())
+        cconvert->pub.color_convert = jsimd_c_rgb_rgb_convert;
 #if defined(__mips__)
-      if (jsimd_c_can_null_convert())
+      else if (jsimd_c_can_null_convert())
         cconvert->pub.color_convert = jsimd_c_null_convert;
-      else
 #endif
+      else
         cconvert->pub.color_convert = null_convert;
     } else if (cinfo->in_color_space == JCS_RGB ||
                cinfo->in_color_space == JCS_EXT_RGB ||
@@ -627,9 +629,12 @@ jinit_color_converter(j_compress_ptr cinfo)
                cinfo->in_color_space == JCS_EXT_RGBA ||
                cinfo->in_color_space == JCS_EXT_BGRA ||
                cinfo->in_color_space == JCS_EXT_ABGR ||
-               cinfo->in_color_space == JCS_EXT_ARGB)
-      cconvert->pub.color_convert = rgb_rgb_convert;
-    else
+               cinfo->in_color_space == JCS_EXT_ARGB) {
+      if (jsimd_c_can_rgb_rgb())
+        cconvert->pub.color_convert = jsimd_c_rgb_rgb_convert;
+      else
+        cconvert->pub.color_convert = rgb_rgb_convert;
+    } else
       ERREXIT(cinfo, JERR_CONVERSION_NOTIMPL);
     break;
 
@@ -682,8 +687,12 @@ jinit_color_converter(j_compress_ptr cinfo)
     if (cinfo->num_components != 4)
       ERREXIT(cinfo, JERR_BAD_J_COLORSPACE);
     if (cinfo->in_color_space == JCS_CMYK) {
-      cconvert->pub.start_pass = rgb_ycc_start;
-      cconvert->pub.color_convert = cmyk_ycck_convert;
+      if (jsimd_can_cmyk_ycck())
+        cconvert->pub.color_convert = jsimd_cmyk_ycck_convert;
+      else {
+        cconvert->pub.start_pass = rgb_ycc_start;
+        cconvert->pub.color_convert = cmyk_ycck_convert;
+      }
     } else if (cinfo->in_color_space == JCS_YCCK) {
 #if defined(__mips__)
       if (jsimd_c_can_null_convert())
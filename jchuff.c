@@ -26,6 +26,7 @@
 #include "jpeglib.h"
 #include "jsimd.h"
 #include "jconfigint.h"
+#include "jthread.h"
 #include <limits.h>
 
 /*
@@ -107,6 +108,11 @@ typedef struct {
 #ifdef ENTROPY_OPT_SUPPORTED    /* Statistics tables for optimization */
   long *dc_count_ptrs[NUM_HUFF_TBLS];
   long *ac_count_ptrs[NUM_HUFF_TBLS];
+
+  /* Multi-threaded statistics gathering (see finish_pass_gather_mt()) */
+  JCOEFPTR *saved_blocks;       /* DCT blocks of the MCUs seen so far */
+  size_t num_saved_blocks;      /* # of entries used in saved_blocks[] */
+  size_t max_saved_blocks;      /* allocated size of saved_blocks[] */
 #endif
 
   int simd;
@@ -133,6 +139,18 @@ METHODDEF(void) finish_pass_huff(j_compress_ptr cinfo);
 METHODDEF(boolean) encode_mcu_gather(j_compress_ptr cinfo,
                                      JBLOCKROW *MCU_data);
 METHODDEF(void) finish_pass_gather(j_compress_ptr cinfo);
+METHODDEF(boolean) encode_mcu_save(j_compress_ptr cinfo, JBLOCKROW *MCU_data);
+METHODDEF(void) finish_pass_gather_mt(j_compress_ptr cinfo);
+
+/* A statistics-gathering pass is split among threads only if each of them
+ * gets at least this many MCUs.
+ */
+#define MIN_MCUS_PER_THREAD  512
+
+/* Upper limit for the size of saved_blocks[] (well below the largest object
+ * that jmemmgr.c can allocate)
+ */
+#define MAX_SAVED_BLOCKS  ((size_t)100000000)
 #endif
 
 
@@ -151,8 +169,33 @@ start_pass_huff(j_compress_ptr cinfo, boolean gather_statistics)
 
   if (gather_statistics) {
 #ifdef ENTROPY_OPT_SUPPORTED
-    entropy->pub.encode_mcu = encode_mcu_gather;
-    entropy->pub.finish_pass = finish_pass_gather;
+    size_t num_blocks = (size_t)cinfo->MCUs_per_row *
+                        cinfo->MCU_rows_in_scan * cinfo->blocks_in_MCU;
+
+    /* If more than one thread may be used, just save the location of each
+     * block during the pass, and count the Huffman symbols on several threads
+     * at the end.  This relies on the blocks staying in place for the whole
+     * pass, which is true of the full-image buffer of jccoefct.c but not of
+     * the dummy blocks that jctrans.c constructs at the image edges.
+     */
+    if (cinfo->master->num_scan_threads > 1 &&
+        cinfo->master->sample_iMCU_rows == 0 &&
+        cinfo->global_state != CSTATE_WRCOEFS &&
+        num_blocks >= (size_t)MIN_MCUS_PER_THREAD * 2 * cinfo->blocks_in_MCU &&
+        num_blocks <= MAX_SAVED_BLOCKS) {
+      if (entropy->max_saved_blocks < num_blocks) {
+        entropy->saved_blocks = (JCOEFPTR *)
+          (*cinfo->mem->alloc_large) ((j_common_ptr)cinfo, JPOOL_IMAGE,
+                                      num_blocks * sizeof(JCOEFPTR));
+        entropy->max_saved_blocks = num_blocks;
+      }
+      entropy->num_saved_blocks = 0;
+      entropy->pub.encode_mcu = encode_mcu_save;
+      entropy->pub.finish_pass = finish_pass_gather_mt;
+    } else {
+      entropy->pub.encode_mcu = encode_mcu_gather;
+      entropy->pub.finish_pass = finish_pass_gather;
+    }
 #else
     ERREXIT(cinfo, JERR_NOT_COMPILED);
 #endif
@@ -749,9 +792,10 @@ finish_pass_huff(j_compress_ptr cinfo)
 
 /* Process a single block's worth of coefficients */
 
-LOCAL(void)
-htest_one_block(j_compress_ptr cinfo, JCOEFPTR block, int last_dc_val,
-                long dc_counts[], long ac_counts[])
+LOCAL(boolean)
+htest_one_block(JCOEFPTR block, int last_dc_val, long dc_counts[],
+                long ac_counts[])
+/* Returns FALSE if a coefficient is out of range */
 {
   register int temp;
   register int nbits;
@@ -773,7 +817,7 @@ htest_one_block(j_compress_ptr cinfo, JCOEFPTR block, int last_dc_val,
    * Since we're encoding a difference, the range limit is twice as much.
    */
   if (nbits > MAX_COEF_BITS + 1)
-    ERREXIT(cinfo, JERR_BAD_DCT_COEF);
+    return FALSE;
 
   /* Count the Huffman symbol for the number of bits */
   dc_counts[nbits]++;
@@ -802,7 +846,7 @@ htest_one_block(j_compress_ptr cinfo, JCOEFPTR block, int last_dc_val,
         nbits++;
       /* Check for out-of-range coefficient values */
       if (nbits > MAX_COEF_BITS)
-        ERREXIT(cinfo, JERR_BAD_DCT_COEF);
+        return FALSE;
 
       /* Count Huffman symbol for run length / number of bits */
       ac_counts[(r << 4) + nbits]++;
@@ -814,6 +858,8 @@ htest_one_block(j_compress_ptr cinfo, JCOEFPTR block, int last_dc_val,
   /* If the last coef(s) were zero, emit an end-of-block code */
   if (r > 0)
     ac_counts[0]++;
+
+  return TRUE;
 }
 
 
@@ -844,9 +890,10 @@ encode_mcu_gather(j_compress_ptr cinfo, JBLOCKROW *MCU_data)
   for (blkn = 0; blkn < cinfo->blocks_in_MCU; blkn++) {
     ci = cinfo->MCU_membership[blkn];
     compptr = cinfo->cur_comp_info[ci];
-    htest_one_block(cinfo, MCU_data[blkn][0], entropy->saved.last_dc_val[ci],
-                    entropy->dc_count_ptrs[compptr->dc_tbl_no],
-                    entropy->ac_count_ptrs[compptr->ac_tbl_no]);
+    if (!htest_one_block(MCU_data[blkn][0], entropy->saved.last_dc_val[ci],
+                         entropy->dc_count_ptrs[compptr->dc_tbl_no],
+                         entropy->ac_count_ptrs[compptr->ac_tbl_no]))
+      ERREXIT(cinfo, JERR_BAD_DCT_COEF);
     entropy->saved.last_dc_val[ci] = MCU_data[blkn][0][0];
   }
 
@@ -1021,6 +1068,39 @@ jpeg_gen_optimal_table(j_compress_ptr cinfo, JHUFF_TBL *htbl, long freq[])
 }
 
 
+/*
+ * When the statistics were gathered from a sample of the image, any symbol
+ * might still occur in the rest of it, so each one that can be encoded must be
+ * given a code.  Counting the missing ones once makes them the least likely
+ * symbols without changing the codes of the others much.
+ */
+
+LOCAL(void)
+count_missing_symbols(long dc_counts[], long ac_counts[])
+{
+  int r, nbits;
+
+  if (dc_counts != NULL) {
+    for (nbits = 0; nbits <= MAX_COEF_BITS + 1; nbits++) {
+      if (dc_counts[nbits] == 0)
+        dc_counts[nbits] = 1;
+    }
+  }
+  if (ac_counts != NULL) {
+    if (ac_counts[0x00] == 0)
+      ac_counts[0x00] = 1;
+    if (ac_counts[0xF0] == 0)
+      ac_counts[0xF0] = 1;
+    for (r = 0; r < 16; r++) {
+      for (nbits = 1; nbits <= MAX_COEF_BITS; nbits++) {
+        if (ac_counts[(r << 4) + nbits] == 0)
+          ac_counts[(r << 4) + nbits] = 1;
+      }
+    }
+  }
+}
+
+
 /*
  * Finish up a statistics-gathering pass and create the new Huffman tables.
  */
@@ -1049,6 +1129,8 @@ finish_pass_gather(j_compress_ptr cinfo)
       htblptr = &cinfo->dc_huff_tbl_ptrs[dctbl];
       if (*htblptr == NULL)
         *htblptr = jpeg_alloc_huff_table((j_common_ptr)cinfo);
+      if (cinfo->master->sample_iMCU_rows > 0)
+        count_missing_symbols(entropy->dc_count_ptrs[dctbl], NULL);
       jpeg_gen_optimal_table(cinfo, *htblptr, entropy->dc_count_ptrs[dctbl]);
       did_dc[dctbl] = TRUE;
     }
@@ -1056,6 +1138,8 @@ finish_pass_gather(j_compress_ptr cinfo)
       htblptr = &cinfo->ac_huff_tbl_ptrs[actbl];
       if (*htblptr == NULL)
         *htblptr = jpeg_alloc_huff_table((j_common_ptr)cinfo);
+      if (cinfo->master->sample_iMCU_rows > 0)
+        count_missing_symbols(NULL, entropy->ac_count_ptrs[actbl]);
       jpeg_gen_optimal_table(cinfo, *htblptr, entropy->ac_count_ptrs[actbl]);
       did_ac[actbl] = TRUE;
     }
@@ -1063,6 +1147,157 @@ finish_pass_gather(j_compress_ptr cinfo)
 }
 
 
+/*
+ * Multi-threaded statistics gathering.  encode_mcu_save() records where the
+ * blocks of each MCU are, and finish_pass_gather_mt() splits the MCUs into
+ * contiguous ranges and counts the Huffman symbols of each range on its own
+ * thread, using private statistics tables.  The DC predictions at the start of
+ * a range are recovered from the previous MCU (or reset, if a restart interval
+ * begins there), so the merged counts are identical to those that
+ * encode_mcu_gather() would have produced.
+ */
+
+typedef struct {
+  j_compress_ptr cinfo;
+  size_t first_MCU;             /* first MCU in the range */
+  size_t end_MCU;               /* first MCU after the range */
+  long *dc_counts[NUM_HUFF_TBLS]; /* statistics tables for the range */
+  long *ac_counts[NUM_HUFF_TBLS];
+  boolean bad_coef;             /* TRUE if a coefficient is out of range */
+} gather_range;
+
+
+METHODDEF(boolean)
+encode_mcu_save(j_compress_ptr cinfo, JBLOCKROW *MCU_data)
+{
+  huff_entropy_ptr entropy = (huff_entropy_ptr)cinfo->entropy;
+  JCOEFPTR *saved = entropy->saved_blocks + entropy->num_saved_blocks;
+  int blkn;
+
+  for (blkn = 0; blkn < cinfo->blocks_in_MCU; blkn++)
+    saved[blkn] = MCU_data[blkn][0];
+  entropy->num_saved_blocks += cinfo->blocks_in_MCU;
+
+  return TRUE;
+}
+
+
+METHODDEF(void)
+gather_range_task(void *arg, int task)
+{
+  gather_range *range = (gather_range *)arg + task;
+  j_compress_ptr cinfo = range->cinfo;
+  huff_entropy_ptr entropy = (huff_entropy_ptr)cinfo->entropy;
+  int blocks_in_MCU = cinfo->blocks_in_MCU;
+  JCOEFPTR *block = entropy->saved_blocks + range->first_MCU * blocks_in_MCU;
+  int last_dc_val[MAX_COMPS_IN_SCAN];
+  size_t MCU_num;
+  int blkn, ci;
+  jpeg_component_info *compptr;
+
+  /* Recover the DC predictions from the last MCU of the previous range */
+  for (ci = 0; ci < cinfo->comps_in_scan; ci++)
+    last_dc_val[ci] = 0;
+  if (range->first_MCU > 0) {
+    for (blkn = 0; blkn < blocks_in_MCU; blkn++)
+      last_dc_val[cinfo->MCU_membership[blkn]] =
+        block[blkn - blocks_in_MCU][0];
+  }
+
+  for (MCU_num = range->first_MCU; MCU_num < range->end_MCU; MCU_num++) {
+    /* Re-initialize DC predictions to 0 at the start of a restart interval */
+    if (cinfo->restart_interval && MCU_num % cinfo->restart_interval == 0) {
+      for (ci = 0; ci < cinfo->comps_in_scan; ci++)
+        last_dc_val[ci] = 0;
+    }
+    for (blkn = 0; blkn < blocks_in_MCU; blkn++) {
+      ci = cinfo->MCU_membership[blkn];
+      compptr = cinfo->cur_comp_info[ci];
+      if (!htest_one_block(block[blkn], last_dc_val[ci],
+                           range->dc_counts[compptr->dc_tbl_no],
+                           range->ac_counts[compptr->ac_tbl_no])) {
+        range->bad_coef = TRUE;
+        return;
+      }
+      last_dc_val[ci] = block[blkn][0];
+    }
+    block += blocks_in_MCU;
+  }
+}
+
+
+METHODDEF(void)
+finish_pass_gather_mt(j_compress_ptr cinfo)
+{
+  huff_entropy_ptr entropy = (huff_entropy_ptr)cinfo->entropy;
+  gather_range ranges[JTHREAD_MAX_THREADS];
+  size_t num_MCUs = entropy->num_saved_blocks / cinfo->blocks_in_MCU;
+  int num_ranges = cinfo->master->num_scan_threads;
+  int i, ci, k, tbl;
+  jpeg_component_info *compptr;
+
+  if (num_ranges > JTHREAD_MAX_THREADS)
+    num_ranges = JTHREAD_MAX_THREADS;
+  if ((size_t)num_ranges > num_MCUs / MIN_MCUS_PER_THREAD)
+    num_ranges = (int)(num_MCUs / MIN_MCUS_PER_THREAD);
+  if (num_ranges < 1)
+    num_ranges = 1;
+
+  /* The first range uses the entropy encoder's statistics tables, which
+   * start_pass_huff() has already zeroed.
+   */
+  for (i = 0; i < num_ranges; i++) {
+    ranges[i].cinfo = cinfo;
+    ranges[i].first_MCU = num_MCUs * i / num_ranges;
+    ranges[i].end_MCU = num_MCUs * (i + 1) / num_ranges;
+    ranges[i].bad_coef = FALSE;
+    for (tbl = 0; tbl < NUM_HUFF_TBLS; tbl++) {
+      ranges[i].dc_counts[tbl] = i == 0 ? entropy->dc_count_ptrs[tbl] : NULL;
+      ranges[i].ac_counts[tbl] = i == 0 ? entropy->ac_count_ptrs[tbl] : NULL;
+    }
+    if (i == 0)
+      continue;
+    for (ci = 0; ci < cinfo->comps_in_scan; ci++) {
+      compptr = cinfo->cur_comp_info[ci];
+      if (ranges[i].dc_counts[compptr->dc_tbl_no] == NULL) {
+        ranges[i].dc_counts[compptr->dc_tbl_no] = (long *)
+          (*cinfo->mem->alloc_small) ((j_common_ptr)cinfo, JPOOL_IMAGE,
+                                      257 * sizeof(long));
+        MEMZERO(ranges[i].dc_counts[compptr->dc_tbl_no], 257 * sizeof(long));
+      }
+      if (ranges[i].ac_counts[compptr->ac_tbl_no] == NULL) {
+        ranges[i].ac_counts[compptr->ac_tbl_no] = (long *)
+          (*cinfo->mem->alloc_small) ((j_common_ptr)cinfo, JPOOL_IMAGE,
+                                      257 * sizeof(long));
+        MEMZERO(ranges[i].ac_counts[compptr->ac_tbl_no], 257 * sizeof(long));
+      }
+    }
+  }
+
+  jthread_run(num_ranges, num_ranges, gather_range_task, ranges);
+
+  /* Merge the statistics of the other ranges into the first one's */
+  for (i = 0; i < num_ranges; i++) {
+    if (ranges[i].bad_coef)
+      ERREXIT(cinfo, JERR_BAD_DCT_COEF);
+    if (i == 0)
+      continue;
+    for (tbl = 0; tbl < NUM_HUFF_TBLS; tbl++) {
+      if (ranges[i].dc_counts[tbl] != NULL) {
+        for (k = 0; k < 257; k++)
+          entropy->dc_count_ptrs[tbl][k] += ranges[i].dc_counts[tbl][k];
+      }
+      if (ranges[i].ac_counts[tbl] != NULL) {
+        for (k = 0; k < 257; k++)
+          entropy->ac_count_ptrs[tbl][k] += ranges[i].ac_counts[tbl][k];
+      }
+    }
+  }
+
+  finish_pass_gather(cinfo);
+}
+
+
 #endif /* ENTROPY_OPT_SUPPORTED */
 
 
@@ -1089,4 +1324,8 @@ jinit_huff_encoder(j_compress_ptr cinfo)
     entropy->dc_count_ptrs[i] = entropy->ac_count_ptrs[i] = NULL;
 #endif
   }
+#ifdef ENTROPY_OPT_SUPPORTED
+  entropy->saved_blocks = NULL;
+  entropy->num_saved_blocks = entropy->max_saved_blocks = 0;
+#endif
 }
@@ -20,38 +20,9 @@
 #include "jpeglib.h"
 #include "jpegcomp.h"
 #include "jconfigint.h"
-
-
-/* Private state */
-
-typedef enum {
-  main_pass,                    /* input data, also do first output step */
-  huff_opt_pass,                /* Huffman code optimization pass */
-  output_pass                   /* data output pass */
-} c_pass_type;
-
-typedef struct {
-  struct jpeg_comp_master pub;  /* public fields */
-
-  c_pass_type pass_type;        /* the type of the current pass */
-
-  int pass_number;              /* # of passes completed */
-  int total_passes;             /* total # of passes needed */
-
-  int scan_number;              /* current index in scan_info[] */
-
-  /*
-   * This is here so we can add libjpeg-turbo version/build information to the
-   * global string table without introducing a new global symbol.  Adding this
-   * information to the global string table allows one to examine a binary
-   * object and determine which version of libjpeg-turbo it was built from or
-   * linked against.
-   */
-  const char *jpeg_version;
-
-} my_comp_master;
-
-typedef my_comp_master *my_master_ptr;
+#include "jcmaster.h"
+#include "jthread.h"
+#include <setjmp.h>
 
 
 /*
@@ -465,7 +436,8 @@ prepare_for_pass(j_compress_ptr cinfo)
     (*cinfo->fdct->start_pass) (cinfo);
     (*cinfo->entropy->start_pass) (cinfo, cinfo->optimize_coding);
     (*cinfo->coef->start_pass) (cinfo,
-                                (master->total_passes > 1 ?
+                                (master->total_passes > 1 ||
+                                 master->pub.sample_iMCU_rows > 0 ?
                                  JBUF_SAVE_AND_PASS : JBUF_PASS_THRU));
     (*cinfo->main->start_pass) (cinfo, JBUF_PASS_THRU);
     if (cinfo->optimize_coding) {
@@ -543,6 +515,24 @@ pass_startup(j_compress_ptr cinfo)
 }
 
 
+/*
+ * Switch from statistics gathering to data output in the middle of the
+ * main pass.  This is called by the coefficient controller once the iMCU
+ * rows sampled for Huffman optimization have been buffered.
+ */
+
+METHODDEF(void)
+finish_sample(j_compress_ptr cinfo)
+{
+  /* Create the Huffman tables from the sample, then start the output. */
+  (*cinfo->entropy->finish_pass) (cinfo);
+  (*cinfo->entropy->start_pass) (cinfo, FALSE);
+
+  (*cinfo->marker->write_frame_header) (cinfo);
+  (*cinfo->marker->write_scan_header) (cinfo);
+}
+
+
 /*
  * Finish up at end of pass.
  */
@@ -583,6 +573,390 @@ finish_pass_master(j_compress_ptr cinfo)
 }
 
 
+#ifdef C_MULTISCAN_FILES_SUPPORTED
+
+/*
+ * Multi-threaded scan encoding.
+ *
+ * After the first pass, the scans that remain to be written are coded from
+ * the full-image coefficient buffer, and none of them depends on another.
+ * Each one is given a private copy of the compression object, with its own
+ * memory manager, error manager, entropy encoder, coefficient controller and
+ * data destination, so that worker threads can run its optimization and
+ * output passes concurrently.  (jmemnobs.c keeps the coefficient buffer
+ * entirely in memory, so read-only access to it from several threads is
+ * safe.)  The main thread then writes the scan headers, and the entropy-coded
+ * segments that the workers produced, in scan order.  Since every scan sees
+ * the same parameters and Huffman tables as it would in a serial compression,
+ * the resulting datastream is identical.
+ */
+
+/* Initial size of the output buffer of a scan */
+#define SCAN_BUFFER_SIZE  65536
+
+typedef struct {
+  struct jpeg_error_mgr pub;    /* "public" fields */
+  jmp_buf setjmp_buffer;        /* for return to encode_scan() */
+} scan_error_mgr;
+
+typedef struct {
+  struct jpeg_destination_mgr pub; /* public fields */
+  JOCTET *buffer;               /* start of buffer */
+  size_t bufsize;               /* size of buffer */
+} scan_destination_mgr;
+
+typedef struct {
+  struct jpeg_compress_struct cinfo; /* private compression object */
+  my_comp_master master;        /* private master (for the scan number) */
+  scan_error_mgr err;
+  scan_destination_mgr dest;
+  boolean gather;               /* TRUE to run an optimization pass first */
+  boolean failed;               /* TRUE if an error occurred */
+  /* Private copies of the Huffman tables.  After the scan has been encoded,
+   * the ones for which sent_table is FALSE were generated by the optimization
+   * pass and must be emitted in the scan header.
+   */
+  JHUFF_TBL dc_huff_tbls[NUM_HUFF_TBLS];
+  JHUFF_TBL ac_huff_tbls[NUM_HUFF_TBLS];
+  JOCTET *data;                 /* entropy-coded segment */
+  size_t data_size;
+} scan_job;
+
+
+METHODDEF(void)
+scan_error_exit(j_common_ptr cinfo)
+{
+  scan_error_mgr *err = (scan_error_mgr *)cinfo->err;
+
+  longjmp(err->setjmp_buffer, 1);
+}
+
+
+METHODDEF(void)
+init_scan_destination(j_compress_ptr cinfo)
+{
+  scan_destination_mgr *dest = (scan_destination_mgr *)cinfo->dest;
+
+  dest->buffer = (JOCTET *)
+    (*cinfo->mem->alloc_large) ((j_common_ptr)cinfo, JPOOL_IMAGE,
+                                SCAN_BUFFER_SIZE * sizeof(JOCTET));
+  dest->bufsize = SCAN_BUFFER_SIZE;
+  dest->pub.next_output_byte = dest->buffer;
+  dest->pub.free_in_buffer = dest->bufsize;
+}
+
+
+METHODDEF(boolean)
+empty_scan_output_buffer(j_compress_ptr cinfo)
+{
+  scan_destination_mgr *dest = (scan_destination_mgr *)cinfo->dest;
+  JOCTET *nextbuffer;
+
+  /* The old buffer is released along with the worker's memory manager. */
+  nextbuffer = (JOCTET *)
+    (*cinfo->mem->alloc_large) ((j_common_ptr)cinfo, JPOOL_IMAGE,
+                                dest->bufsize * 2 * sizeof(JOCTET));
+  MEMCOPY(nextbuffer, dest->buffer, dest->bufsize);
+  dest->pub.next_output_byte = nextbuffer + dest->bufsize;
+  dest->pub.free_in_buffer = dest->bufsize;
+  dest->buffer = nextbuffer;
+  dest->bufsize *= 2;
+  return TRUE;
+}
+
+
+METHODDEF(void)
+term_scan_destination(j_compress_ptr cinfo)
+{
+}
+
+
+LOCAL(void)
+run_scan_pass(j_compress_ptr cinfo)
+/* Feed every iMCU row of the current scan to the entropy encoder */
+{
+  JDIMENSION iMCU_row;
+
+  (*cinfo->coef->start_pass) (cinfo, JBUF_CRANK_DEST);
+  for (iMCU_row = 0; iMCU_row < cinfo->total_iMCU_rows; iMCU_row++) {
+    if (!(*cinfo->coef->compress_data) (cinfo, (JSAMPIMAGE)NULL))
+      ERREXIT(cinfo, JERR_CANT_SUSPEND);
+  }
+}
+
+
+METHODDEF(void)
+encode_scan(void *arg, int task)
+/* Worker thread task: encode one scan into a private buffer */
+{
+  scan_job *job = (scan_job *)arg + task;
+  j_compress_ptr cinfo = &job->cinfo;
+  jpeg_component_info *comp_info;
+
+  if (setjmp(job->err.setjmp_buffer)) {
+    job->failed = TRUE;
+    return;
+  }
+
+  jinit_memory_mgr((j_common_ptr)cinfo);
+
+  /* per_scan_setup() modifies the component info, so it must be private. */
+  comp_info = (jpeg_component_info *)
+    (*cinfo->mem->alloc_small) ((j_common_ptr)cinfo, JPOOL_IMAGE,
+                                cinfo->num_components *
+                                sizeof(jpeg_component_info));
+  MEMCOPY(comp_info, cinfo->comp_info,
+          cinfo->num_components * sizeof(jpeg_component_info));
+  cinfo->comp_info = comp_info;
+  select_scan_parameters(cinfo);
+  per_scan_setup(cinfo);
+
+  jcopy_c_coef_controller(cinfo);
+  if (cinfo->arith_code) {
+#ifdef C_ARITH_CODING_SUPPORTED
+    jinit_arith_encoder(cinfo);
+#else
+    ERREXIT(cinfo, JERR_ARITH_NOTIMPL);
+#endif
+  } else {
+    if (cinfo->progressive_mode) {
+#ifdef C_PROGRESSIVE_SUPPORTED
+      jinit_phuff_encoder(cinfo);
+#else
+      ERREXIT(cinfo, JERR_NOT_COMPILED);
+#endif
+    } else
+      jinit_huff_encoder(cinfo);
+  }
+
+  if (job->gather) {
+    (*cinfo->entropy->start_pass) (cinfo, TRUE);
+    run_scan_pass(cinfo);
+    (*cinfo->entropy->finish_pass) (cinfo);
+  }
+  (*cinfo->dest->init_destination) (cinfo);
+  (*cinfo->entropy->start_pass) (cinfo, FALSE);
+  run_scan_pass(cinfo);
+  (*cinfo->entropy->finish_pass) (cinfo);
+}
+
+
+LOCAL(void)
+copy_huff_table(JHUFF_TBL **htblptr, JHUFF_TBL *copy)
+/* Point a worker's Huffman table slot at a private copy of the table */
+{
+  if (*htblptr != NULL) {
+    *copy = **htblptr;
+    *htblptr = copy;
+  }
+  copy->sent_table = TRUE;      /* not generated by this worker (yet) */
+}
+
+
+LOCAL(void)
+keep_huff_table(JHUFF_TBL *htbl, JHUFF_TBL *copy)
+/* Save a table that a worker may have allocated from its own pool */
+{
+  if (htbl != NULL && htbl != copy)
+    *copy = *htbl;
+}
+
+
+LOCAL(void)
+install_huff_table(j_compress_ptr cinfo, JHUFF_TBL **htblptr, JHUFF_TBL *copy)
+/* Make a table generated by a worker current, as its optimization pass would
+ * have done in a serial compression
+ */
+{
+  if (!copy->sent_table) {
+    if (*htblptr == NULL)
+      *htblptr = jpeg_alloc_huff_table((j_common_ptr)cinfo);
+    **htblptr = *copy;
+  }
+}
+
+
+LOCAL(void)
+write_scan_data(j_compress_ptr cinfo, const JOCTET *data, size_t size)
+{
+  struct jpeg_destination_mgr *dest = cinfo->dest;
+  size_t count;
+
+  while (size > 0) {
+    count = MIN(size, dest->free_in_buffer);
+    MEMCOPY(dest->next_output_byte, data, count);
+    dest->next_output_byte += count;
+    dest->free_in_buffer -= count;
+    data += count;
+    size -= count;
+    if (dest->free_in_buffer == 0) {
+      if (!(*dest->empty_output_buffer) (cinfo))
+        ERREXIT(cinfo, JERR_CANT_SUSPEND);
+    }
+  }
+}
+
+
+/*
+ * Encode all of the remaining scans on up to master->pub.num_scan_threads
+ * threads.  This is called by jpeg_finish_compress() after the first pass,
+ * and it leaves the remaining passes to that function if the scans cannot be
+ * encoded this way.
+ */
+
+METHODDEF(void)
+encode_scans_parallel(j_compress_ptr cinfo)
+{
+  my_master_ptr master = (my_master_ptr)cinfo->master;
+  int first_scan = master->scan_number;
+  int num_jobs = cinfo->num_scans - first_scan;
+  const jpeg_scan_info *scanptr;
+  scan_job *jobs, *job, *failed_job = NULL;
+  int i, tbl;
+
+  if (master->transcode_only || cinfo->scan_info == NULL || num_jobs < 2 ||
+      master->pass_type != output_pass)
+    return;
+
+  jobs = (scan_job *)
+    (*cinfo->mem->alloc_large) ((j_common_ptr)cinfo, JPOOL_IMAGE,
+                                num_jobs * sizeof(scan_job));
+  for (i = 0; i < num_jobs; i++) {
+    job = &jobs[i];
+    job->cinfo = *cinfo;
+    job->master = *master;
+    job->master.scan_number = first_scan + i;
+    job->master.pub.num_scan_threads = 1;
+    job->cinfo.master = &job->master.pub;
+    job->cinfo.err = jpeg_std_error(&job->err.pub);
+    job->err.pub.error_exit = scan_error_exit;
+    job->cinfo.mem = NULL;
+    job->cinfo.progress = NULL;
+    job->dest.pub.init_destination = init_scan_destination;
+    job->dest.pub.empty_output_buffer = empty_scan_output_buffer;
+    job->dest.pub.term_destination = term_scan_destination;
+    job->cinfo.dest = &job->dest.pub;
+    for (tbl = 0; tbl < NUM_HUFF_TBLS; tbl++) {
+      copy_huff_table(&job->cinfo.dc_huff_tbl_ptrs[tbl],
+                      &job->dc_huff_tbls[tbl]);
+      copy_huff_table(&job->cinfo.ac_huff_tbl_ptrs[tbl],
+                      &job->ac_huff_tbls[tbl]);
+    }
+    /* The first pass already gathered the statistics for the first scan.
+     * Huffman DC refinement scans need no table (see prepare_for_pass().)
+     */
+    scanptr = cinfo->scan_info + first_scan + i;
+    job->gather = cinfo->optimize_coding && i > 0 &&
+                  (scanptr->Ss != 0 || scanptr->Ah == 0 || cinfo->arith_code);
+    job->failed = FALSE;
+    job->data = NULL;
+    job->data_size = 0;
+  }
+
+  jthread_run(num_jobs, master->pub.num_scan_threads, encode_scan, jobs);
+
+  /* Move the results to the main object's pool and release the workers'
+   * memory, so that nothing is leaked if an error occurs below.
+   */
+  for (i = 0; i < num_jobs; i++) {
+    job = &jobs[i];
+    if (job->failed) {
+      if (failed_job == NULL)
+        failed_job = job;
+    } else if (failed_job == NULL) {
+      job->data_size = (size_t)(job->dest.pub.next_output_byte -
+                                job->dest.buffer);
+      if (job->data_size > 0) {
+        job->data = (JOCTET *)
+          (*cinfo->mem->alloc_large) ((j_common_ptr)cinfo, JPOOL_IMAGE,
+                                      job->data_size * sizeof(JOCTET));
+        MEMCOPY(job->data, job->dest.buffer, job->data_size);
+      }
+      for (tbl = 0; tbl < NUM_HUFF_TBLS; tbl++) {
+        keep_huff_table(job->cinfo.dc_huff_tbl_ptrs[tbl],
+                        &job->dc_huff_tbls[tbl]);
+        keep_huff_table(job->cinfo.ac_huff_tbl_ptrs[tbl],
+                        &job->ac_huff_tbls[tbl]);
+      }
+    }
+  }
+  for (i = 0; i < num_jobs; i++)
+    jpeg_destroy((j_common_ptr)&jobs[i].cinfo);
+
+  /* Report the error of the earliest failed scan as our own */
+  if (failed_job != NULL) {
+    cinfo->err->msg_code = failed_job->err.pub.msg_code;
+    MEMCOPY(&cinfo->err->msg_parm, &failed_job->err.pub.msg_parm,
+            sizeof(cinfo->err->msg_parm));
+    (*cinfo->err->error_exit) ((j_common_ptr)cinfo);
+  }
+
+  for (i = 0; i < num_jobs; i++) {
+    job = &jobs[i];
+    master->scan_number = first_scan + i;
+    select_scan_parameters(cinfo);
+    per_scan_setup(cinfo);
+    for (tbl = 0; tbl < NUM_HUFF_TBLS; tbl++) {
+      install_huff_table(cinfo, &cinfo->dc_huff_tbl_ptrs[tbl],
+                         &job->dc_huff_tbls[tbl]);
+      install_huff_table(cinfo, &cinfo->ac_huff_tbl_ptrs[tbl],
+                         &job->ac_huff_tbls[tbl]);
+    }
+    if (master->scan_number == 0)
+      (*cinfo->marker->write_frame_header) (cinfo);
+    (*cinfo->marker->write_scan_header) (cinfo);
+    write_scan_data(cinfo, job->data, job->data_size);
+  }
+
+  master->scan_number = cinfo->num_scans;
+  master->pass_number = master->total_passes;
+  master->pub.is_last_pass = TRUE;
+}
+
+#endif /* C_MULTISCAN_FILES_SUPPORTED */
+
+
+/*
+ * Allow jpeg_finish_compress() to encode the remaining scans of a
+ * multiple-scan image, and the Huffman encoder to gather statistics, on up to
+ * num_threads threads.
+ */
+
+GLOBAL(void)
+jpeg_set_scan_threads(j_compress_ptr cinfo, int num_threads)
+{
+  if (cinfo->global_state != CSTATE_SCANNING &&
+      cinfo->global_state != CSTATE_RAW_OK &&
+      cinfo->global_state != CSTATE_WRCOEFS)
+    ERREXIT1(cinfo, JERR_BAD_STATE, cinfo->global_state);
+
+  cinfo->master->num_scan_threads = num_threads;
+
+  /* If no data has been written yet, let the entropy encoder choose again how
+   * to gather the statistics for the first scan during the main pass.
+   */
+  if (((my_master_ptr)cinfo->master)->pass_type == main_pass &&
+      cinfo->optimize_coding && cinfo->next_scanline == 0)
+    (*cinfo->entropy->start_pass) (cinfo, TRUE);
+}
+
+
+/*
+ * Derive the optimized Huffman tables of sequential images from the first
+ * num_lines rows of the image and write the whole image in a single pass,
+ * or go back to the default behavior if num_lines is 0.
+ */
+
+GLOBAL(void)
+jpeg_set_huffman_sample(j_compress_ptr cinfo, JDIMENSION num_lines)
+{
+  if (cinfo->global_state != CSTATE_START)
+    ERREXIT1(cinfo, JERR_BAD_STATE, cinfo->global_state);
+
+  ((my_master_ptr)cinfo->master)->huff_sample_lines = num_lines;
+}
+
+
 /*
  * Initialize master compression control.
  */
@@ -590,16 +964,19 @@ finish_pass_master(j_compress_ptr cinfo)
 GLOBAL(void)
 jinit_c_master_control(j_compress_ptr cinfo, boolean transcode_only)
 {
-  my_master_ptr master;
+  my_master_ptr master = (my_master_ptr)cinfo->master;
 
-  master = (my_master_ptr)
-    (*cinfo->mem->alloc_small) ((j_common_ptr)cinfo, JPOOL_IMAGE,
-                                sizeof(my_comp_master));
-  cinfo->master = (struct jpeg_comp_master *)master;
   master->pub.prepare_for_pass = prepare_for_pass;
   master->pub.pass_startup = pass_startup;
   master->pub.finish_pass = finish_pass_master;
+  master->pub.finish_sample = finish_sample;
   master->pub.is_last_pass = FALSE;
+  master->pub.num_scan_threads = 1;
+#ifdef C_MULTISCAN_FILES_SUPPORTED
+  master->pub.encode_scans = encode_scans_parallel;
+#else
+  master->pub.encode_scans = NULL;
+#endif
 
   /* Validate parameters, determine derived values */
   initial_setup(cinfo, transcode_only);
@@ -619,6 +996,7 @@ jinit_c_master_control(j_compress_ptr cinfo, boolean transcode_only)
     cinfo->optimize_coding = TRUE; /* assume default tables no good for progressive mode */
 
   /* Initialize my private state */
+  master->transcode_only = transcode_only;
   if (transcode_only) {
     /* no main pass in transcoding */
     if (cinfo->optimize_coding)
@@ -636,5 +1014,23 @@ jinit_c_master_control(j_compress_ptr cinfo, boolean transcode_only)
   else
     master->total_passes = cinfo->num_scans;
 
+  /* Sampled Huffman optimization replaces the optimization pass of a
+   * sequential Huffman-coded scan, unless the sample would cover the whole
+   * image anyway.
+   */
+  master->pub.sample_iMCU_rows = 0;
+  if (master->huff_sample_lines > 0 && cinfo->optimize_coding &&
+      !transcode_only && cinfo->num_scans == 1 &&
+      !cinfo->progressive_mode && !cinfo->arith_code) {
+    JDIMENSION sample_rows = (JDIMENSION)
+      jdiv_round_up((long)master->huff_sample_lines,
+                    (long)(cinfo->max_v_samp_factor * DCTSIZE));
+
+    if (sample_rows < cinfo->total_iMCU_rows) {
+      master->pub.sample_iMCU_rows = sample_rows;
+      master->total_passes = 1;
+    }
+  }
+
   master->jpeg_version = PACKAGE_NAME " version " VERSION " (build " BUILD ")";
 }
@@ -51,6 +51,10 @@ jpeg_abort(j_common_ptr cinfo)
      * A bit kludgy to do it here, but this is the most central place.
      */
     ((j_decompress_ptr)cinfo)->marker_list = NULL;
+    /* Likewise for the entropy checkpoint index, which is per-image. */
+    ((j_decompress_ptr)cinfo)->master->save_checkpoints = FALSE;
+    ((j_decompress_ptr)cinfo)->master->checkpoint_data = NULL;
+    ((j_decompress_ptr)cinfo)->master->checkpoint_positions = NULL;
   } else {
     cinfo->global_state = CSTATE_START;
   }
@@ -493,7 +493,10 @@ jinit_downsampler(j_compress_ptr cinfo)
         compptr->v_samp_factor == cinfo->max_v_samp_factor) {
 #ifdef INPUT_SMOOTHING_SUPPORTED
       if (cinfo->smoothing_factor) {
-        downsample->methods[ci] = fullsize_smooth_downsample;
+        if (jsimd_can_fullsize_smooth_downsample())
+          downsample->methods[ci] = jsimd_fullsize_smooth_downsample;
+        else
+          downsample->methods[ci] = fullsize_smooth_downsample;
         downsample->pub.need_context_rows = TRUE;
       } else
 #endif
@@ -509,11 +512,9 @@ jinit_downsampler(j_compress_ptr cinfo)
                compptr->v_samp_factor * 2 == cinfo->max_v_samp_factor) {
 #ifdef INPUT_SMOOTHING_SUPPORTED
       if (cinfo->smoothing_factor) {
-#if defined(__mips__)
         if (jsimd_can_h2v2_smooth_downsample())
           downsample->methods[ci] = jsimd_h2v2_smooth_downsample;
         else
-#endif
           downsample->methods[ci] = h2v2_smooth_downsample;
         downsample->pub.need_context_rows = TRUE;
       } else
@@ -526,8 +527,23 @@ jinit_downsampler(j_compress_ptr cinfo)
       }
     } else if ((cinfo->max_h_samp_factor % compptr->h_samp_factor) == 0 &&
                (cinfo->max_v_samp_factor % compptr->v_samp_factor) == 0) {
+      /* Generic integral-factors downsampling method, with SIMD versions for
+       * some of the less common factors
+       */
+      int h_expand = cinfo->max_h_samp_factor / compptr->h_samp_factor;
+      int v_expand = cinfo->max_v_samp_factor / compptr->v_samp_factor;
+
       smoothok = FALSE;
-      downsample->methods[ci] = int_downsample;
+      if (h_expand == 4 && v_expand == 1 && jsimd_can_h4v1_downsample())
+        downsample->methods[ci] = jsimd_h4v1_downsample;
+      else if (h_expand == 4 && v_expand == 2 && jsimd_can_h4v2_downsample())
+        downsample->methods[ci] = jsimd_h4v2_downsample;
+      else if (h_expand == 1 && v_expand == 2 && jsimd_can_h1v2_downsample())
+        downsample->methods[ci] = jsimd_h1v2_downsample;
+      else if (h_expand == 2 && v_expand == 4 && jsimd_can_h2v4_downsample())
+        downsample->methods[ci] = jsimd_h2v4_downsample;
+      else
+        downsample->methods[ci] = int_downsample;
     } else
       ERREXIT(cinfo, JERR_FRACT_SAMPLE_NOTIMPL);
   }
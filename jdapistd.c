@@ -21,6 +21,8 @@
 #include "jinclude.h"
 #include "jdmainct.h"
 #include "jdcoefct.h"
+#include "jdmaster.h"
+#include "jdmerge.h"
 #include "jdsample.h"
 #include "jmemsys.h"
 
@@ -239,6 +241,24 @@ jpeg_crop_scanline(j_decompress_ptr cinfo, JDIMENSION *xoffset,
                                 (long)align) - 1;
   }
 
+#ifdef UPSAMPLE_MERGING_SUPPORTED
+  if (((my_master_ptr)cinfo->master)->using_merged_upsample) {
+    /* The merged upsampler emits whole output rows, so it must always learn
+     * the new output width.
+     */
+    my_merged_upsample_ptr upsample = (my_merged_upsample_ptr)cinfo->upsample;
+
+    upsample->out_row_width =
+      cinfo->output_width * cinfo->out_color_components;
+    if (reinit_upsampler) {
+      cinfo->master->jinit_upsampler_no_alloc = TRUE;
+      jinit_merged_upsampler(cinfo);
+      cinfo->master->jinit_upsampler_no_alloc = FALSE;
+    }
+    return;
+  }
+#endif
+
   if (reinit_upsampler) {
     cinfo->master->jinit_upsampler_no_alloc = TRUE;
     jinit_upsampler(cinfo);
@@ -316,6 +336,7 @@ LOCAL(void)
 read_and_discard_scanlines(j_decompress_ptr cinfo, JDIMENSION num_lines)
 {
   JDIMENSION n;
+  JSAMPARRAY scanlines = NULL;
   void (*color_convert) (j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
                          JDIMENSION input_row, JSAMPARRAY output_buf,
                          int num_rows) = NULL;
@@ -332,8 +353,20 @@ read_and_discard_scanlines(j_decompress_ptr cinfo, JDIMENSION num_lines)
     cinfo->cquantize->color_quantize = noop_quantize;
   }
 
+#ifdef UPSAMPLE_MERGING_SUPPORTED
+  /* The merged upsampler does the color conversion itself, so give it a row
+   * to write into.  Its spare row is free while the output rows of a row group
+   * are being discarded one at a time.
+   */
+  if (((my_master_ptr)cinfo->master)->using_merged_upsample &&
+      cinfo->max_v_samp_factor == 2) {
+    my_merged_upsample_ptr upsample = (my_merged_upsample_ptr)cinfo->upsample;
+    scanlines = &upsample->spare_row;
+  }
+#endif
+
   for (n = 0; n < num_lines; n++)
-    jpeg_read_scanlines(cinfo, NULL, 1);
+    jpeg_read_scanlines(cinfo, scanlines, 1);
 
   if (color_convert)
     cinfo->cconvert->color_convert = color_convert;
@@ -366,6 +399,34 @@ increment_simple_rowgroup_ctr(j_decompress_ptr cinfo, JDIMENSION rows)
   read_and_discard_scanlines(cinfo, rows_left);
 }
 
+/*
+ * Called by jpeg_skip_scanlines().  Skipping lines bypasses the upsampler, so
+ * its count of the rows remaining in the image must be updated.  If the
+ * current row group was skipped as well, then the rows of it that the
+ * upsampler is still holding must also be dropped.
+ */
+
+LOCAL(void)
+update_upsampler(j_decompress_ptr cinfo, boolean row_group_skipped)
+{
+#ifdef UPSAMPLE_MERGING_SUPPORTED
+  if (((my_master_ptr)cinfo->master)->using_merged_upsample) {
+    my_merged_upsample_ptr upsample = (my_merged_upsample_ptr)cinfo->upsample;
+
+    if (row_group_skipped)
+      upsample->spare_full = FALSE;
+    upsample->rows_to_go = cinfo->output_height - cinfo->output_scanline;
+  } else
+#endif
+  {
+    my_upsample_ptr upsample = (my_upsample_ptr)cinfo->upsample;
+
+    if (row_group_skipped)
+      upsample->next_row_out = cinfo->max_v_samp_factor;
+    upsample->rows_to_go = cinfo->output_height - cinfo->output_scanline;
+  }
+}
+
 /*
  * Skips some scanlines of data from the JPEG decompressor.
  *
@@ -382,7 +443,6 @@ jpeg_skip_scanlines(j_decompress_ptr cinfo, JDIMENSION num_lines)
 {
   my_main_ptr main_ptr = (my_main_ptr)cinfo->main;
   my_coef_ptr coef = (my_coef_ptr)cinfo->coef;
-  my_upsample_ptr upsample = (my_upsample_ptr)cinfo->upsample;
   JDIMENSION i, x;
   int y;
   JDIMENSION lines_per_iMCU_row, lines_left_in_iMCU_row, lines_after_iMCU_row;
@@ -445,8 +505,7 @@ jpeg_skip_scanlines(j_decompress_ptr cinfo, JDIMENSION num_lines)
     main_ptr->buffer_full = FALSE;
     main_ptr->rowgroup_ctr = 0;
     main_ptr->context_state = CTX_PREPARE_FOR_IMCU;
-    upsample->next_row_out = cinfo->max_v_samp_factor;
-    upsample->rows_to_go = cinfo->output_height - cinfo->output_scanline;
+    update_upsampler(cinfo, TRUE);
   }
 
   /* Skipping is much simpler when context rows are not required. */
@@ -458,8 +517,7 @@ jpeg_skip_scanlines(j_decompress_ptr cinfo, JDIMENSION num_lines)
       cinfo->output_scanline += lines_left_in_iMCU_row;
       main_ptr->buffer_full = FALSE;
       main_ptr->rowgroup_ctr = 0;
-      upsample->next_row_out = cinfo->max_v_samp_factor;
-      upsample->rows_to_go = cinfo->output_height - cinfo->output_scanline;
+      update_upsampler(cinfo, TRUE);
     }
   }
 
@@ -494,19 +552,28 @@ jpeg_skip_scanlines(j_decompress_ptr cinfo, JDIMENSION num_lines)
       cinfo->output_iMCU_row += lines_to_skip / lines_per_iMCU_row;
       increment_simple_rowgroup_ctr(cinfo, lines_to_read);
     }
-    upsample->rows_to_go = cinfo->output_height - cinfo->output_scanline;
+    update_upsampler(cinfo, FALSE);
     return num_lines;
   }
 
-  /* Skip the iMCU rows that we can safely skip. */
+  /* Skip the iMCU rows that we can safely skip.  If an entropy checkpoint
+   * index is available, then the entropy decoder can jump over all of them at
+   * once.
+   */
+  if (cinfo->entropy->skip_mcus != NULL)
+    (*cinfo->entropy->skip_mcus) (cinfo, (lines_to_skip / lines_per_iMCU_row) *
+                                         coef->MCU_rows_per_iMCU_row *
+                                         cinfo->MCUs_per_row);
   for (i = 0; i < lines_to_skip; i += lines_per_iMCU_row) {
-    for (y = 0; y < coef->MCU_rows_per_iMCU_row; y++) {
-      for (x = 0; x < cinfo->MCUs_per_row; x++) {
-        /* Calling decode_mcu() with a NULL pointer causes it to discard the
-         * decoded coefficients.  This is ~5% faster for large subsets, but
-         * it's tough to tell a difference for smaller images.
-         */
-        (*cinfo->entropy->decode_mcu) (cinfo, NULL);
+    if (cinfo->entropy->skip_mcus == NULL) {
+      for (y = 0; y < coef->MCU_rows_per_iMCU_row; y++) {
+        for (x = 0; x < cinfo->MCUs_per_row; x++) {
+          /* Calling decode_mcu() with a NULL pointer causes it to discard the
+           * decoded coefficients.  This is ~5% faster for large subsets, but
+           * it's tough to tell a difference for smaller images.
+           */
+          (*cinfo->entropy->decode_mcu) (cinfo, NULL);
+        }
       }
     }
     cinfo->input_iMCU_row++;
@@ -535,7 +602,7 @@ jpeg_skip_scanlines(j_decompress_ptr cinfo, JDIMENSION num_lines)
    * bit odd, since "rows_to_go" seems to be redundantly keeping track of
    * output_scanline.
    */
-  upsample->rows_to_go = cinfo->output_height - cinfo->output_scanline;
+  update_upsampler(cinfo, FALSE);
 
   /* Always skip the requested number of lines. */
   return num_lines;
@@ -22,6 +22,7 @@
 #define JPEG_INTERNALS
 #include "jinclude.h"
 #include "jpeglib.h"
+#include "jconfigint.h"
 
 
 #define NEG_1  ((unsigned int)-1)
@@ -46,9 +47,6 @@ typedef struct {
   /* Pointers to statistics areas (these workspaces have image lifespan) */
   unsigned char *dc_stats[NUM_ARITH_TBLS];
   unsigned char *ac_stats[NUM_ARITH_TBLS];
-
-  /* Statistics bin for coding with fixed probability 0.5 */
-  unsigned char fixed_bin[4];
 } arith_entropy_decoder;
 
 typedef arith_entropy_decoder *arith_entropy_ptr;
@@ -84,6 +82,150 @@ get_byte(j_decompress_ptr cinfo)
 }
 
 
+LOCAL(int)
+get_data_byte(j_decompress_ptr cinfo)
+/* Read next byte of compressed data, handling stuffed zero bytes & markers. */
+{
+  int data;
+
+  if (cinfo->unread_marker)
+    return 0;                   /* stuff zero data */
+  data = get_byte(cinfo);       /* read next input byte */
+  if (data == 0xFF) {           /* zero stuff or marker code */
+    do data = get_byte(cinfo);
+    while (data == 0xFF);       /* swallow extra 0xFF bytes */
+    if (data == 0)
+      data = 0xFF;              /* discard stuffed zero byte */
+    else {
+      /* Note: Different from the Huffman decoder, hitting
+       * a marker while processing the compressed data
+       * segment is legal in arithmetic coding.
+       * The convention is to supply zero data
+       * then until decoding is complete.
+       */
+      cinfo->unread_marker = data;
+      data = 0;
+    }
+  }
+  return data;
+}
+
+
+/*
+ * The MCU decoding routines copy the coding registers and the source
+ * manager's buffer pointer into one of these structures, which is a local
+ * variable, while they decode an MCU.  Every update of a statistics bin is a
+ * char store, which the compiler must assume may modify anything in memory,
+ * so keeping the registers in the entropy decoder object would force them to
+ * be reloaded after each decision.  A local copy can live in machine
+ * registers instead.
+ */
+
+typedef struct {
+  JLONG c;                      /* C register */
+  JLONG a;                      /* A register */
+  int ct;                       /* bit shift counter */
+  const JOCTET *next_input_byte; /* => next byte to read from source */
+  size_t bytes_in_buffer;       /* # of bytes remaining in source buffer */
+  j_decompress_ptr cinfo;       /* back link to decompress master record */
+} arith_working_state;
+
+#define ARITH_LOAD_STATE(state, cinfop, entropy) \
+  state.c = entropy->c; \
+  state.a = entropy->a; \
+  state.ct = entropy->ct; \
+  state.next_input_byte = cinfop->src->next_input_byte; \
+  state.bytes_in_buffer = cinfop->src->bytes_in_buffer; \
+  state.cinfo = cinfop
+
+#define ARITH_SAVE_STATE(state, cinfop, entropy) \
+  entropy->c = state.c; \
+  entropy->a = state.a; \
+  entropy->ct = state.ct; \
+  cinfop->src->next_input_byte = state.next_input_byte; \
+  cinfop->src->bytes_in_buffer = state.bytes_in_buffer
+
+
+/*
+ * Fetch the next data byte for the arithmetic decoder.  Most bytes are taken
+ * straight from the source buffer; the source manager is called only when
+ * the buffer is nearly empty or when a byte might start a marker.
+ */
+
+INLINE
+LOCAL(int)
+arith_get_data(arith_working_state *state)
+{
+  int data;
+
+  if (state->bytes_in_buffer >= 2 && !state->cinfo->unread_marker &&
+      ((data = GETJOCTET(state->next_input_byte[0])) != 0xFF ||
+       state->next_input_byte[1] == 0)) {
+    /* Plain data byte or stuffed zero byte */
+    if (data == 0xFF) {
+      state->next_input_byte += 2;
+      state->bytes_in_buffer -= 2;
+    } else {
+      state->next_input_byte++;
+      state->bytes_in_buffer--;
+    }
+  } else {
+    struct jpeg_source_mgr *src = state->cinfo->src;
+
+    src->next_input_byte = state->next_input_byte;
+    src->bytes_in_buffer = state->bytes_in_buffer;
+    data = get_data_byte(state->cinfo);
+    state->next_input_byte = src->next_input_byte;
+    state->bytes_in_buffer = src->bytes_in_buffer;
+  }
+  return data;
+}
+
+
+/*
+ * Renormalization & data input per section D.2.6
+ */
+
+INLINE
+LOCAL(void)
+arith_renormalize(arith_working_state *state)
+{
+  int data;
+
+  if (state->a < 0x8000L) {
+    if (state->ct >= 0) {
+      /* Normalize A first, then insert as many bytes as the shift used up.
+       * This is equivalent to the interleaved loop below, since the data
+       * insertion does not depend on A.
+       */
+      do {
+        state->a <<= 1;
+        state->ct--;
+      } while (state->a < 0x8000L);
+      while (state->ct < 0) {
+        data = arith_get_data(state);
+        state->c = (state->c << 8) | data; /* insert data into C register */
+        state->ct += 8;                    /* update bit shift counter */
+      }
+    } else {
+      /* Initial fill of C after start of scan or restart */
+      while (state->a < 0x8000L) {
+        if (--state->ct < 0) {
+          data = arith_get_data(state);
+          state->c = (state->c << 8) | data;
+          if ((state->ct += 8) < 0)
+            /* Need more initial bytes */
+            if (++state->ct == 0)
+              /* Got 2 initial bytes -> re-init A and exit loop */
+              state->a = 0x8000L; /* => state->a = 0x10000L after loop exit */
+        }
+        state->a <<= 1;
+      }
+    }
+  }
+}
+
+
 /*
  * The core arithmetic decoding routine (common in JPEG and JBIG).
  * This needs to go as fast as possible.
@@ -111,48 +253,15 @@ get_byte(j_decompress_ptr cinfo)
  * derived from Markus Kuhn's JBIG implementation.
  */
 
+INLINE
 LOCAL(int)
-arith_decode(j_decompress_ptr cinfo, unsigned char *st)
+arith_decode(arith_working_state *state, unsigned char *st)
 {
-  register arith_entropy_ptr e = (arith_entropy_ptr)cinfo->entropy;
   register unsigned char nl, nm;
   register JLONG qe, temp;
-  register int sv, data;
-
-  /* Renormalization & data input per section D.2.6 */
-  while (e->a < 0x8000L) {
-    if (--e->ct < 0) {
-      /* Need to fetch next data byte */
-      if (cinfo->unread_marker)
-        data = 0;               /* stuff zero data */
-      else {
-        data = get_byte(cinfo); /* read next input byte */
-        if (data == 0xFF) {     /* zero stuff or marker code */
-          do data = get_byte(cinfo);
-          while (data == 0xFF); /* swallow extra 0xFF bytes */
-          if (data == 0)
-            data = 0xFF;        /* discard stuffed zero byte */
-          else {
-            /* Note: Different from the Huffman decoder, hitting
-             * a marker while processing the compressed data
-             * segment is legal in arithmetic coding.
-             * The convention is to supply zero data
-             * then until decoding is complete.
-             */
-            cinfo->unread_marker = data;
-            data = 0;
-          }
-        }
-      }
-      e->c = (e->c << 8) | data; /* insert data into C register */
-      if ((e->ct += 8) < 0)      /* update bit shift counter */
-        /* Need more initial bytes */
-        if (++e->ct == 0)
-          /* Got 2 initial bytes -> re-init A and exit loop */
-          e->a = 0x8000L; /* => e->a = 0x10000L after loop exit */
-    }
-    e->a <<= 1;
-  }
+  register int sv;
+
+  arith_renormalize(state);
 
   /* Fetch values from our compact representation of Table D.2:
    * Qe values and probability estimation state machine
@@ -163,23 +272,23 @@ arith_decode(j_decompress_ptr cinfo, unsigned char *st)
   nm = qe & 0xFF;  qe >>= 8;    /* Next_Index_MPS */
 
   /* Decode & estimation procedures per sections D.2.4 & D.2.5 */
-  temp = e->a - qe;
-  e->a = temp;
-  temp <<= e->ct;
-  if (e->c >= temp) {
-    e->c -= temp;
+  temp = state->a - qe;
+  state->a = temp;
+  temp <<= state->ct;
+  if (state->c >= temp) {
+    state->c -= temp;
     /* Conditional LPS (less probable symbol) exchange */
-    if (e->a < qe) {
-      e->a = qe;
+    if (state->a < qe) {
+      state->a = qe;
       *st = (sv & 0x80) ^ nm;   /* Estimate_after_MPS */
     } else {
-      e->a = qe;
+      state->a = qe;
       *st = (sv & 0x80) ^ nl;   /* Estimate_after_LPS */
       sv ^= 0x80;               /* Exchange LPS/MPS */
     }
-  } else if (e->a < 0x8000L) {
+  } else if (state->a < 0x8000L) {
     /* Conditional MPS (more probable symbol) exchange */
-    if (e->a < qe) {
+    if (state->a < qe) {
       *st = (sv & 0x80) ^ nl;   /* Estimate_after_LPS */
       sv ^= 0x80;               /* Exchange LPS/MPS */
     } else {
@@ -191,6 +300,42 @@ arith_decode(j_decompress_ptr cinfo, unsigned char *st)
 }
 
 
+/*
+ * Decode a binary decision with fixed probability 0.5.  This is equivalent
+ * to arith_decode() with a statistics bin that is initialized to entry 113
+ * of Table D.2, which has Qe = 0x5a1d, MPS = 0, and points back to itself
+ * (so the bin never changes).  The sign of each AC coefficient and all
+ * refinement bits of DC coefficients are coded this way.
+ */
+
+#define FIXED_QE  0x5a1dL
+
+INLINE
+LOCAL(int)
+arith_decode_fixed(arith_working_state *state)
+{
+  register JLONG temp;
+
+  arith_renormalize(state);
+
+  /* Decode procedure per section D.2.4 */
+  temp = state->a - FIXED_QE;
+  state->a = temp;
+  temp <<= state->ct;
+  if (state->c >= temp) {
+    state->c -= temp;
+    /* Conditional LPS (less probable symbol) exchange */
+    temp = state->a;
+    state->a = FIXED_QE;
+    return temp >= FIXED_QE;
+  } else if (state->a < 0x8000L) {
+    /* Conditional MPS (more probable symbol) exchange */
+    return state->a < FIXED_QE;
+  }
+  return 0;
+}
+
+
 /*
  * Check for a restart marker & resynchronize decoder.
  */
@@ -250,6 +395,7 @@ METHODDEF(boolean)
 decode_mcu_DC_first(j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
 {
   arith_entropy_ptr entropy = (arith_entropy_ptr)cinfo->entropy;
+  arith_working_state state;
   JBLOCKROW block;
   unsigned char *st;
   int blkn, ci, tbl, sign;
@@ -264,6 +410,8 @@ decode_mcu_DC_first(j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
 
   if (entropy->ct == -1) return TRUE;   /* if error do nothing */
 
+  ARITH_LOAD_STATE(state, cinfo, entropy);
+
   /* Outer loop handles each block in the MCU */
 
   for (blkn = 0; blkn < cinfo->blocks_in_MCU; blkn++) {
@@ -277,21 +425,21 @@ decode_mcu_DC_first(j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
     st = entropy->dc_stats[tbl] + entropy->dc_context[ci];
 
     /* Figure F.19: Decode_DC_DIFF */
-    if (arith_decode(cinfo, st) == 0)
+    if (arith_decode(&state, st) == 0)
       entropy->dc_context[ci] = 0;
     else {
       /* Figure F.21: Decoding nonzero value v */
       /* Figure F.22: Decoding the sign of v */
-      sign = arith_decode(cinfo, st + 1);
+      sign = arith_decode(&state, st + 1);
       st += 2;  st += sign;
       /* Figure F.23: Decoding the magnitude category of v */
-      if ((m = arith_decode(cinfo, st)) != 0) {
+      if ((m = arith_decode(&state, st)) != 0) {
         st = entropy->dc_stats[tbl] + 20;       /* Table F.4: X1 = 20 */
-        while (arith_decode(cinfo, st)) {
+        while (arith_decode(&state, st)) {
           if ((m <<= 1) == 0x8000) {
             WARNMS(cinfo, JWRN_ARITH_BAD_CODE);
-            entropy->ct = -1;                   /* magnitude overflow */
-            return TRUE;
+            state.ct = -1;                      /* magnitude overflow */
+            goto done;
           }
           st += 1;
         }
@@ -307,7 +455,7 @@ decode_mcu_DC_first(j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
       /* Figure F.24: Decoding the magnitude bit pattern of v */
       st += 14;
       while (m >>= 1)
-        if (arith_decode(cinfo, st)) v |= m;
+        if (arith_decode(&state, st)) v |= m;
       v += 1;  if (sign) v = -v;
       entropy->last_dc_val[ci] = (entropy->last_dc_val[ci] + v) & 0xffff;
     }
@@ -316,6 +464,8 @@ decode_mcu_DC_first(j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
     (*block)[0] = (JCOEF)LEFT_SHIFT(entropy->last_dc_val[ci], cinfo->Al);
   }
 
+done:
+  ARITH_SAVE_STATE(state, cinfo, entropy);
   return TRUE;
 }
 
@@ -329,9 +479,10 @@ METHODDEF(boolean)
 decode_mcu_AC_first(j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
 {
   arith_entropy_ptr entropy = (arith_entropy_ptr)cinfo->entropy;
+  arith_working_state state;
   JBLOCKROW block;
-  unsigned char *st;
-  int tbl, sign, k;
+  unsigned char *st, *ac_stats;
+  int tbl, sign, k, Se, Al, kx;
   int v, m;
 
   /* Process restart marker if needed */
@@ -343,39 +494,44 @@ decode_mcu_AC_first(j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
 
   if (entropy->ct == -1) return TRUE;   /* if error do nothing */
 
+  ARITH_LOAD_STATE(state, cinfo, entropy);
+
   /* There is always only one block per MCU */
   block = MCU_data[0];
   tbl = cinfo->cur_comp_info[0]->ac_tbl_no;
+  ac_stats = entropy->ac_stats[tbl];
+  Se = cinfo->Se;
+  Al = cinfo->Al;
+  kx = cinfo->arith_ac_K[tbl];
 
   /* Sections F.2.4.2 & F.1.4.4.2: Decoding of AC coefficients */
 
   /* Figure F.20: Decode_AC_coefficients */
-  for (k = cinfo->Ss; k <= cinfo->Se; k++) {
-    st = entropy->ac_stats[tbl] + 3 * (k - 1);
-    if (arith_decode(cinfo, st)) break;         /* EOB flag */
-    while (arith_decode(cinfo, st + 1) == 0) {
+  for (k = cinfo->Ss; k <= Se; k++) {
+    st = ac_stats + 3 * (k - 1);
+    if (arith_decode(&state, st)) break;        /* EOB flag */
+    while (arith_decode(&state, st + 1) == 0) {
       st += 3;  k++;
-      if (k > cinfo->Se) {
+      if (k > Se) {
         WARNMS(cinfo, JWRN_ARITH_BAD_CODE);
-        entropy->ct = -1;                       /* spectral overflow */
-        return TRUE;
+        state.ct = -1;                          /* spectral overflow */
+        goto done;
       }
     }
     /* Figure F.21: Decoding nonzero value v */
     /* Figure F.22: Decoding the sign of v */
-    sign = arith_decode(cinfo, entropy->fixed_bin);
+    sign = arith_decode_fixed(&state);
     st += 2;
     /* Figure F.23: Decoding the magnitude category of v */
-    if ((m = arith_decode(cinfo, st)) != 0) {
-      if (arith_decode(cinfo, st)) {
+    if ((m = arith_decode(&state, st)) != 0) {
+      if (arith_decode(&state, st)) {
         m <<= 1;
-        st = entropy->ac_stats[tbl] +
-             (k <= cinfo->arith_ac_K[tbl] ? 189 : 217);
-        while (arith_decode(cinfo, st)) {
+        st = ac_stats + (k <= kx ? 189 : 217);
+        while (arith_decode(&state, st)) {
           if ((m <<= 1) == 0x8000) {
             WARNMS(cinfo, JWRN_ARITH_BAD_CODE);
-            entropy->ct = -1;                   /* magnitude overflow */
-            return TRUE;
+            state.ct = -1;                      /* magnitude overflow */
+            goto done;
           }
           st += 1;
         }
@@ -385,12 +541,14 @@ decode_mcu_AC_first(j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
     /* Figure F.24: Decoding the magnitude bit pattern of v */
     st += 14;
     while (m >>= 1)
-      if (arith_decode(cinfo, st)) v |= m;
+      if (arith_decode(&state, st)) v |= m;
     v += 1;  if (sign) v = -v;
     /* Scale and output coefficient in natural (dezigzagged) order */
-    (*block)[jpeg_natural_order[k]] = (JCOEF)((unsigned)v << cinfo->Al);
+    (*block)[jpeg_natural_order[k]] = (JCOEF)((unsigned)v << Al);
   }
 
+done:
+  ARITH_SAVE_STATE(state, cinfo, entropy);
   return TRUE;
 }
 
@@ -403,7 +561,7 @@ METHODDEF(boolean)
 decode_mcu_DC_refine(j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
 {
   arith_entropy_ptr entropy = (arith_entropy_ptr)cinfo->entropy;
-  unsigned char *st;
+  arith_working_state state;
   int p1, blkn;
 
   /* Process restart marker if needed */
@@ -413,17 +571,19 @@ decode_mcu_DC_refine(j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
     entropy->restarts_to_go--;
   }
 
-  st = entropy->fixed_bin;      /* use fixed probability estimation */
+  ARITH_LOAD_STATE(state, cinfo, entropy);
+
   p1 = 1 << cinfo->Al;          /* 1 in the bit position being coded */
 
   /* Outer loop handles each block in the MCU */
 
   for (blkn = 0; blkn < cinfo->blocks_in_MCU; blkn++) {
     /* Encoded data is simply the next bit of the two's-complement DC value */
-    if (arith_decode(cinfo, st))
+    if (arith_decode_fixed(&state))
       MCU_data[blkn][0][0] |= p1;
   }
 
+  ARITH_SAVE_STATE(state, cinfo, entropy);
   return TRUE;
 }
 
@@ -436,10 +596,11 @@ METHODDEF(boolean)
 decode_mcu_AC_refine(j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
 {
   arith_entropy_ptr entropy = (arith_entropy_ptr)cinfo->entropy;
+  arith_working_state state;
   JBLOCKROW block;
   JCOEFPTR thiscoef;
-  unsigned char *st;
-  int tbl, k, kex;
+  unsigned char *st, *ac_stats;
+  int tbl, k, kex, Se;
   int p1, m1;
 
   /* Process restart marker if needed */
@@ -451,25 +612,29 @@ decode_mcu_AC_refine(j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
 
   if (entropy->ct == -1) return TRUE;   /* if error do nothing */
 
+  ARITH_LOAD_STATE(state, cinfo, entropy);
+
   /* There is always only one block per MCU */
   block = MCU_data[0];
   tbl = cinfo->cur_comp_info[0]->ac_tbl_no;
+  ac_stats = entropy->ac_stats[tbl];
+  Se = cinfo->Se;
 
   p1 = 1 << cinfo->Al;          /* 1 in the bit position being coded */
   m1 = (NEG_1) << cinfo->Al;    /* -1 in the bit position being coded */
 
   /* Establish EOBx (previous stage end-of-block) index */
-  for (kex = cinfo->Se; kex > 0; kex--)
+  for (kex = Se; kex > 0; kex--)
     if ((*block)[jpeg_natural_order[kex]]) break;
 
-  for (k = cinfo->Ss; k <= cinfo->Se; k++) {
-    st = entropy->ac_stats[tbl] + 3 * (k - 1);
+  for (k = cinfo->Ss; k <= Se; k++) {
+    st = ac_stats + 3 * (k - 1);
     if (k > kex)
-      if (arith_decode(cinfo, st)) break;       /* EOB flag */
+      if (arith_decode(&state, st)) break;      /* EOB flag */
     for (;;) {
       thiscoef = *block + jpeg_natural_order[k];
       if (*thiscoef) {                          /* previously nonzero coef */
-        if (arith_decode(cinfo, st + 2)) {
+        if (arith_decode(&state, st + 2)) {
           if (*thiscoef < 0)
             *thiscoef += m1;
           else
@@ -477,22 +642,24 @@ decode_mcu_AC_refine(j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
         }
         break;
       }
-      if (arith_decode(cinfo, st + 1)) {        /* newly nonzero coef */
-        if (arith_decode(cinfo, entropy->fixed_bin))
+      if (arith_decode(&state, st + 1)) {       /* newly nonzero coef */
+        if (arith_decode_fixed(&state))
           *thiscoef = m1;
         else
           *thiscoef = p1;
         break;
       }
       st += 3;  k++;
-      if (k > cinfo->Se) {
+      if (k > Se) {
         WARNMS(cinfo, JWRN_ARITH_BAD_CODE);
-        entropy->ct = -1;                       /* spectral overflow */
-        return TRUE;
+        state.ct = -1;                          /* spectral overflow */
+        goto done;
       }
     }
   }
 
+done:
+  ARITH_SAVE_STATE(state, cinfo, entropy);
   return TRUE;
 }
 
@@ -505,10 +672,12 @@ METHODDEF(boolean)
 decode_mcu(j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
 {
   arith_entropy_ptr entropy = (arith_entropy_ptr)cinfo->entropy;
+  arith_working_state state;
   jpeg_component_info *compptr;
-  JBLOCKROW block;
-  unsigned char *st;
-  int blkn, ci, tbl, sign, k;
+  JCOEFPTR coefs;
+  JBLOCK discard;
+  unsigned char *st, *dc_stats, *ac_stats;
+  int blkn, ci, tbl, sign, k, kx;
   int v, m;
 
   /* Process restart marker if needed */
@@ -520,36 +689,42 @@ decode_mcu(j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
 
   if (entropy->ct == -1) return TRUE;   /* if error do nothing */
 
+  ARITH_LOAD_STATE(state, cinfo, entropy);
+
   /* Outer loop handles each block in the MCU */
 
   for (blkn = 0; blkn < cinfo->blocks_in_MCU; blkn++) {
-    block = MCU_data ? MCU_data[blkn] : NULL;
+    /* Decode into a scratch block if the caller does not want the data, so
+     * that the coefficient stores need not be conditional.
+     */
+    coefs = MCU_data ? MCU_data[blkn][0] : discard;
     ci = cinfo->MCU_membership[blkn];
     compptr = cinfo->cur_comp_info[ci];
 
     /* Sections F.2.4.1 & F.1.4.4.1: Decoding of DC coefficients */
 
     tbl = compptr->dc_tbl_no;
+    dc_stats = entropy->dc_stats[tbl];
 
     /* Table F.4: Point to statistics bin S0 for DC coefficient coding */
-    st = entropy->dc_stats[tbl] + entropy->dc_context[ci];
+    st = dc_stats + entropy->dc_context[ci];
 
     /* Figure F.19: Decode_DC_DIFF */
-    if (arith_decode(cinfo, st) == 0)
+    if (arith_decode(&state, st) == 0)
       entropy->dc_context[ci] = 0;
     else {
       /* Figure F.21: Decoding nonzero value v */
       /* Figure F.22: Decoding the sign of v */
-      sign = arith_decode(cinfo, st + 1);
+      sign = arith_decode(&state, st + 1);
       st += 2;  st += sign;
       /* Figure F.23: Decoding the magnitude category of v */
-      if ((m = arith_decode(cinfo, st)) != 0) {
-        st = entropy->dc_stats[tbl] + 20;       /* Table F.4: X1 = 20 */
-        while (arith_decode(cinfo, st)) {
+      if ((m = arith_decode(&state, st)) != 0) {
+        st = dc_stats + 20;                     /* Table F.4: X1 = 20 */
+        while (arith_decode(&state, st)) {
           if ((m <<= 1) == 0x8000) {
             WARNMS(cinfo, JWRN_ARITH_BAD_CODE);
-            entropy->ct = -1;                   /* magnitude overflow */
-            return TRUE;
+            state.ct = -1;                      /* magnitude overflow */
+            goto done;
           }
           st += 1;
         }
@@ -565,45 +740,45 @@ decode_mcu(j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
       /* Figure F.24: Decoding the magnitude bit pattern of v */
       st += 14;
       while (m >>= 1)
-        if (arith_decode(cinfo, st)) v |= m;
+        if (arith_decode(&state, st)) v |= m;
       v += 1;  if (sign) v = -v;
       entropy->last_dc_val[ci] = (entropy->last_dc_val[ci] + v) & 0xffff;
     }
 
-    if (block)
-      (*block)[0] = (JCOEF)entropy->last_dc_val[ci];
+    coefs[0] = (JCOEF)entropy->last_dc_val[ci];
 
     /* Sections F.2.4.2 & F.1.4.4.2: Decoding of AC coefficients */
 
     tbl = compptr->ac_tbl_no;
+    ac_stats = entropy->ac_stats[tbl];
+    kx = cinfo->arith_ac_K[tbl];
 
     /* Figure F.20: Decode_AC_coefficients */
     for (k = 1; k <= DCTSIZE2 - 1; k++) {
-      st = entropy->ac_stats[tbl] + 3 * (k - 1);
-      if (arith_decode(cinfo, st)) break;       /* EOB flag */
-      while (arith_decode(cinfo, st + 1) == 0) {
+      st = ac_stats + 3 * (k - 1);
+      if (arith_decode(&state, st)) break;      /* EOB flag */
+      while (arith_decode(&state, st + 1) == 0) {
         st += 3;  k++;
         if (k > DCTSIZE2 - 1) {
           WARNMS(cinfo, JWRN_ARITH_BAD_CODE);
-          entropy->ct = -1;                     /* spectral overflow */
-          return TRUE;
+          state.ct = -1;                        /* spectral overflow */
+          goto done;
         }
       }
       /* Figure F.21: Decoding nonzero value v */
       /* Figure F.22: Decoding the sign of v */
-      sign = arith_decode(cinfo, entropy->fixed_bin);
+      sign = arith_decode_fixed(&state);
       st += 2;
       /* Figure F.23: Decoding the magnitude category of v */
-      if ((m = arith_decode(cinfo, st)) != 0) {
-        if (arith_decode(cinfo, st)) {
+      if ((m = arith_decode(&state, st)) != 0) {
+        if (arith_decode(&state, st)) {
           m <<= 1;
-          st = entropy->ac_stats[tbl] +
-               (k <= cinfo->arith_ac_K[tbl] ? 189 : 217);
-          while (arith_decode(cinfo, st)) {
+          st = ac_stats + (k <= kx ? 189 : 217);
+          while (arith_decode(&state, st)) {
             if ((m <<= 1) == 0x8000) {
               WARNMS(cinfo, JWRN_ARITH_BAD_CODE);
-              entropy->ct = -1;                 /* magnitude overflow */
-              return TRUE;
+              state.ct = -1;                    /* magnitude overflow */
+              goto done;
             }
             st += 1;
           }
@@ -613,13 +788,14 @@ decode_mcu(j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
       /* Figure F.24: Decoding the magnitude bit pattern of v */
       st += 14;
       while (m >>= 1)
-        if (arith_decode(cinfo, st)) v |= m;
+        if (arith_decode(&state, st)) v |= m;
       v += 1;  if (sign) v = -v;
-      if (block)
-        (*block)[jpeg_natural_order[k]] = (JCOEF)v;
+      coefs[jpeg_natural_order[k]] = (JCOEF)v;
     }
   }
 
+done:
+  ARITH_SAVE_STATE(state, cinfo, entropy);
   return TRUE;
 }
 
@@ -748,6 +924,8 @@ jinit_arith_decoder(j_decompress_ptr cinfo)
                                 sizeof(arith_entropy_decoder));
   cinfo->entropy = (struct jpeg_entropy_decoder *)entropy;
   entropy->pub.start_pass = start_pass;
+  entropy->pub.skip_mcus = NULL;
+  entropy->pub.last_nonzero = NULL;
 
   /* Mark tables unallocated */
   for (i = 0; i < NUM_ARITH_TBLS; i++) {
@@ -755,9 +933,6 @@ jinit_arith_decoder(j_decompress_ptr cinfo)
     entropy->ac_stats[i] = NULL;
   }
 
-  /* Initialize index for fixed probability estimation */
-  entropy->fixed_bin[0] = 113;
-
   if (cinfo->progressive_mode) {
     /* Create progression status table */
     int *coef_bit_ptr, ci;
@@ -293,3 +293,21 @@ jpeg_mem_src(j_decompress_ptr cinfo, const unsigned char *inbuffer,
   src->next_input_byte = (const JOCTET *)inbuffer;
 }
 #endif
+
+
+/*
+ * Report whether the data source was set up by jpeg_mem_src(), in which case
+ * the whole JPEG datastream is resident in the source buffer and is never
+ * reloaded.  The entropy checkpoint index in jdhuff.c relies on this, since
+ * it records positions relative to the start of the entropy-coded data.
+ */
+
+GLOBAL(boolean)
+jpeg_src_in_memory(j_decompress_ptr cinfo)
+{
+#if JPEG_LIB_VERSION >= 80 || defined(MEM_SRCDST_SUPPORTED)
+  return (cinfo->src != NULL && cinfo->src->init_source == init_mem_source);
+#else
+  return FALSE;
+#endif
+}
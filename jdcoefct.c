@@ -71,6 +71,50 @@ start_output_pass(j_decompress_ptr cinfo)
 }
 
 
+/*
+ * Inverse-DCT a row of blocks in the MCU buffer, given the zigzag index of the
+ * last nonzero coefficient of each block.  Blocks whose nonzero coefficients
+ * all lie within the top left 4x4 corner go to the sparse method that covers
+ * them, and the others go to the full method (in runs, if it is available
+ * for runs of blocks.)
+ */
+
+LOCAL(void)
+inverse_DCT_sparse_row(j_decompress_ptr cinfo, jpeg_component_info *compptr,
+                       JBLOCKROW *blocks, const int *last_nonzero,
+                       JSAMPARRAY output_ptr, JDIMENSION output_col,
+                       int num_blocks)
+{
+  int ci = compptr->component_index;
+  inverse_DCT_method_ptr *inverse_DCT_sparse =
+    cinfo->idct->inverse_DCT_sparse[ci];
+  inverse_DCT_blocks_method_ptr inverse_DCT_blocks =
+    cinfo->idct->inverse_DCT_blocks[ci];
+  int xindex, run, last;
+
+  for (xindex = 0; xindex < num_blocks; xindex += run) {
+    last = last_nonzero[xindex];
+    run = 1;
+    if (last <= 9) {
+      (*inverse_DCT_sparse[last == 0 ? 0 : (last <= 2 ? 1 : 2)])
+        (cinfo, compptr, (JCOEFPTR)blocks[xindex], output_ptr, output_col);
+    } else {
+      while (inverse_DCT_blocks != NULL && xindex + run < num_blocks &&
+             last_nonzero[xindex + run] > 9)
+        run++;
+      if (run > 1)
+        (*inverse_DCT_blocks) (cinfo, compptr, (JCOEFPTR)blocks[xindex],
+                               output_ptr, output_col, (JDIMENSION)run);
+      else
+        (*cinfo->idct->inverse_DCT[ci]) (cinfo, compptr,
+                                         (JCOEFPTR)blocks[xindex],
+                                         output_ptr, output_col);
+    }
+    output_col += run * compptr->_DCT_scaled_size;
+  }
+}
+
+
 /*
  * Decompress and return some data in the single-pass case.
  * Always attempts to emit one fully interleaved MCU row ("iMCU" row).
@@ -93,12 +137,28 @@ decompress_onepass(j_decompress_ptr cinfo, JSAMPIMAGE output_buf)
   JDIMENSION start_col, output_col;
   jpeg_component_info *compptr;
   inverse_DCT_method_ptr inverse_DCT;
+  inverse_DCT_blocks_method_ptr inverse_DCT_blocks;
+  boolean use_sparse;
 
   /* Loop to process as much as one whole iMCU row */
   for (yoffset = coef->MCU_vert_offset; yoffset < coef->MCU_rows_per_iMCU_row;
        yoffset++) {
     for (MCU_col_num = coef->MCU_ctr; MCU_col_num <= last_MCU_col;
          MCU_col_num++) {
+      /* If an entropy checkpoint index is available, jump over the MCUs that
+       * lie outside of the cropping region rather than decoding them.
+       */
+      if (cinfo->entropy->skip_mcus != NULL) {
+        if (MCU_col_num < cinfo->master->first_iMCU_col) {
+          (*cinfo->entropy->skip_mcus) (cinfo, cinfo->master->first_iMCU_col -
+                                               MCU_col_num);
+          MCU_col_num = cinfo->master->first_iMCU_col;
+        } else if (MCU_col_num > cinfo->master->last_iMCU_col) {
+          (*cinfo->entropy->skip_mcus) (cinfo, last_MCU_col + 1 -
+                                               MCU_col_num);
+          break;
+        }
+      }
       /* Try to fetch an MCU.  Entropy decoder expects buffer to be zeroed. */
       jzero_far((void *)coef->MCU_buffer[0],
                 (size_t)(cinfo->blocks_in_MCU * sizeof(JBLOCK)));
@@ -128,6 +188,11 @@ decompress_onepass(j_decompress_ptr cinfo, JSAMPIMAGE output_buf)
             continue;
           }
           inverse_DCT = cinfo->idct->inverse_DCT[compptr->component_index];
+          inverse_DCT_blocks =
+            cinfo->idct->inverse_DCT_blocks[compptr->component_index];
+          use_sparse = cinfo->entropy->last_nonzero != NULL &&
+            cinfo->idct->inverse_DCT_sparse[compptr->component_index][0] !=
+            NULL;
           useful_width = (MCU_col_num < last_MCU_col) ?
                          compptr->MCU_width : compptr->last_col_width;
           output_ptr = output_buf[compptr->component_index] +
@@ -138,11 +203,23 @@ decompress_onepass(j_decompress_ptr cinfo, JSAMPIMAGE output_buf)
             if (cinfo->input_iMCU_row < last_iMCU_row ||
                 yoffset + yindex < compptr->last_row_height) {
               output_col = start_col;
-              for (xindex = 0; xindex < useful_width; xindex++) {
-                (*inverse_DCT) (cinfo, compptr,
-                                (JCOEFPTR)coef->MCU_buffer[blkn + xindex],
-                                output_ptr, output_col);
-                output_col += compptr->_DCT_scaled_size;
+              if (use_sparse)
+                inverse_DCT_sparse_row(cinfo, compptr,
+                                       &coef->MCU_buffer[blkn],
+                                       &cinfo->entropy->last_nonzero[blkn],
+                                       output_ptr, output_col, useful_width);
+              else if (inverse_DCT_blocks != NULL && useful_width > 1)
+                (*inverse_DCT_blocks) (cinfo, compptr,
+                                       (JCOEFPTR)coef->MCU_buffer[blkn],
+                                       output_ptr, output_col,
+                                       (JDIMENSION)useful_width);
+              else {
+                for (xindex = 0; xindex < useful_width; xindex++) {
+                  (*inverse_DCT) (cinfo, compptr,
+                                  (JCOEFPTR)coef->MCU_buffer[blkn + xindex],
+                                  output_ptr, output_col);
+                  output_col += compptr->_DCT_scaled_size;
+                }
               }
             }
             blkn += compptr->MCU_width;
@@ -270,6 +347,7 @@ decompress_data(j_decompress_ptr cinfo, JSAMPIMAGE output_buf)
   JDIMENSION output_col;
   jpeg_component_info *compptr;
   inverse_DCT_method_ptr inverse_DCT;
+  inverse_DCT_blocks_method_ptr inverse_DCT_blocks;
 
   /* Force some input to be done if we are getting ahead of the input. */
   while (cinfo->input_scan_number < cinfo->output_scan_number ||
@@ -299,17 +377,25 @@ decompress_data(j_decompress_ptr cinfo, JSAMPIMAGE output_buf)
       if (block_rows == 0) block_rows = compptr->v_samp_factor;
     }
     inverse_DCT = cinfo->idct->inverse_DCT[ci];
+    inverse_DCT_blocks = cinfo->idct->inverse_DCT_blocks[ci];
     output_ptr = output_buf[ci];
     /* Loop over all DCT blocks to be processed. */
     for (block_row = 0; block_row < block_rows; block_row++) {
       buffer_ptr = buffer[block_row] + cinfo->master->first_MCU_col[ci];
       output_col = 0;
-      for (block_num = cinfo->master->first_MCU_col[ci];
-           block_num <= cinfo->master->last_MCU_col[ci]; block_num++) {
-        (*inverse_DCT) (cinfo, compptr, (JCOEFPTR)buffer_ptr, output_ptr,
-                        output_col);
-        buffer_ptr++;
-        output_col += compptr->_DCT_scaled_size;
+      if (inverse_DCT_blocks != NULL)
+        (*inverse_DCT_blocks) (cinfo, compptr, (JCOEFPTR)buffer_ptr,
+                               output_ptr, output_col,
+                               cinfo->master->last_MCU_col[ci] -
+                               cinfo->master->first_MCU_col[ci] + 1);
+      else {
+        for (block_num = cinfo->master->first_MCU_col[ci];
+             block_num <= cinfo->master->last_MCU_col[ci]; block_num++) {
+          (*inverse_DCT) (cinfo, compptr, (JCOEFPTR)buffer_ptr, output_ptr,
+                          output_col);
+          buffer_ptr++;
+          output_col += compptr->_DCT_scaled_size;
+        }
       }
       output_ptr += compptr->_DCT_scaled_size;
     }
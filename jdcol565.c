@@ -26,7 +26,7 @@ ycc_rgb565_convert_internal(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
   register JSAMPROW outptr;
   register JSAMPROW inptr0, inptr1, inptr2;
   register JDIMENSION col;
-  JDIMENSION num_cols = cinfo->output_width;
+  JDIMENSION num_cols;
   /* copy these pointers into registers if possible */
   register JSAMPLE *range_limit = cinfo->sample_range_limit;
   register int *Crrtab = cconvert->Cr_r_tab;
@@ -43,6 +43,7 @@ ycc_rgb565_convert_internal(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
     inptr2 = input_buf[2][input_row];
     input_row++;
     outptr = *output_buf++;
+    num_cols = cinfo->output_width;
 
     if (PACK_NEED_ALIGNMENT(outptr)) {
       y  = GETJSAMPLE(*inptr0++);
@@ -105,7 +106,7 @@ ycc_rgb565D_convert_internal(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
   register JSAMPROW outptr;
   register JSAMPROW inptr0, inptr1, inptr2;
   register JDIMENSION col;
-  JDIMENSION num_cols = cinfo->output_width;
+  JDIMENSION num_cols;
   /* copy these pointers into registers if possible */
   register JSAMPLE *range_limit = cinfo->sample_range_limit;
   register int *Crrtab = cconvert->Cr_r_tab;
@@ -124,6 +125,7 @@ ycc_rgb565D_convert_internal(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
     inptr2 = input_buf[2][input_row];
     input_row++;
     outptr = *output_buf++;
+    num_cols = cinfo->output_width;
     if (PACK_NEED_ALIGNMENT(outptr)) {
       y  = GETJSAMPLE(*inptr0++);
       cb = GETJSAMPLE(*inptr1++);
@@ -189,7 +191,7 @@ rgb_rgb565_convert_internal(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
   register JSAMPROW outptr;
   register JSAMPROW inptr0, inptr1, inptr2;
   register JDIMENSION col;
-  JDIMENSION num_cols = cinfo->output_width;
+  JDIMENSION num_cols;
   SHIFT_TEMPS
 
   while (--num_rows >= 0) {
@@ -201,6 +203,7 @@ rgb_rgb565_convert_internal(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
     inptr2 = input_buf[2][input_row];
     input_row++;
     outptr = *output_buf++;
+    num_cols = cinfo->output_width;
     if (PACK_NEED_ALIGNMENT(outptr)) {
       r = GETJSAMPLE(*inptr0++);
       g = GETJSAMPLE(*inptr1++);
@@ -245,7 +248,7 @@ rgb_rgb565D_convert_internal(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
   register JSAMPROW inptr0, inptr1, inptr2;
   register JDIMENSION col;
   register JSAMPLE *range_limit = cinfo->sample_range_limit;
-  JDIMENSION num_cols = cinfo->output_width;
+  JDIMENSION num_cols;
   JLONG d0 = dither_matrix[cinfo->output_scanline & DITHER_MASK];
   SHIFT_TEMPS
 
@@ -258,6 +261,7 @@ rgb_rgb565D_convert_internal(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
     inptr2 = input_buf[2][input_row];
     input_row++;
     outptr = *output_buf++;
+    num_cols = cinfo->output_width;
     if (PACK_NEED_ALIGNMENT(outptr)) {
       r = range_limit[DITHER_565_R(GETJSAMPLE(*inptr0++), d0)];
       g = range_limit[DITHER_565_G(GETJSAMPLE(*inptr1++), d0)];
@@ -302,7 +306,7 @@ gray_rgb565_convert_internal(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
 {
   register JSAMPROW inptr, outptr;
   register JDIMENSION col;
-  JDIMENSION num_cols = cinfo->output_width;
+  JDIMENSION num_cols;
 
   while (--num_rows >= 0) {
     JLONG rgb;
@@ -310,6 +314,7 @@ gray_rgb565_convert_internal(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
 
     inptr = input_buf[0][input_row++];
     outptr = *output_buf++;
+    num_cols = cinfo->output_width;
     if (PACK_NEED_ALIGNMENT(outptr)) {
       g = *inptr++;
       rgb = PACK_SHORT_565(g, g, g);
@@ -343,7 +348,7 @@ gray_rgb565D_convert_internal(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
   register JSAMPROW inptr, outptr;
   register JDIMENSION col;
   register JSAMPLE *range_limit = cinfo->sample_range_limit;
-  JDIMENSION num_cols = cinfo->output_width;
+  JDIMENSION num_cols;
   JLONG d0 = dither_matrix[cinfo->output_scanline & DITHER_MASK];
 
   while (--num_rows >= 0) {
@@ -352,6 +357,7 @@ gray_rgb565D_convert_internal(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
 
     inptr = input_buf[0][input_row++];
     outptr = *output_buf++;
+    num_cols = cinfo->output_width;
     if (PACK_NEED_ALIGNMENT(outptr)) {
       g = *inptr++;
       g = range_limit[DITHER_565_R(g, d0)];
@@ -141,3 +141,100 @@ rgb_rgb_convert_internal(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
     }
   }
 }
+
+
+/*
+ * Convert Adobe-style (inverted) CMYK to RGB by scaling the C, M and Y values
+ * with K.  This is the naive conversion of cmyk_to_rgb() in cmyk.h and does
+ * not involve any color management.
+ */
+
+INLINE
+LOCAL(void)
+cmyk_rgb_convert_internal(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                          JDIMENSION input_row, JSAMPARRAY output_buf,
+                          int num_rows)
+{
+  register int k;
+  register JSAMPROW outptr;
+  register JSAMPROW inptr0, inptr1, inptr2, inptr3;
+  register JDIMENSION col;
+  JDIMENSION num_cols = cinfo->output_width;
+
+  while (--num_rows >= 0) {
+    inptr0 = input_buf[0][input_row];
+    inptr1 = input_buf[1][input_row];
+    inptr2 = input_buf[2][input_row];
+    inptr3 = input_buf[3][input_row];
+    input_row++;
+    outptr = *output_buf++;
+    for (col = 0; col < num_cols; col++) {
+      k = GETJSAMPLE(inptr3[col]);
+      outptr[RGB_RED] =   (JSAMPLE)SCALE_BY_K(GETJSAMPLE(inptr0[col]), k);
+      outptr[RGB_GREEN] = (JSAMPLE)SCALE_BY_K(GETJSAMPLE(inptr1[col]), k);
+      outptr[RGB_BLUE] =  (JSAMPLE)SCALE_BY_K(GETJSAMPLE(inptr2[col]), k);
+      /* Set unused byte to 0xFF so it can be interpreted as an opaque */
+      /* alpha channel value */
+#ifdef RGB_ALPHA
+      outptr[RGB_ALPHA] = 0xFF;
+#endif
+      outptr += RGB_PIXELSIZE;
+    }
+  }
+}
+
+
+/*
+ * Convert YCCK to RGB: the YCCK->CMYK conversion of ycck_cmyk_convert()
+ * followed by the CMYK->RGB conversion above.
+ */
+
+INLINE
+LOCAL(void)
+ycck_rgb_convert_internal(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                          JDIMENSION input_row, JSAMPARRAY output_buf,
+                          int num_rows)
+{
+  my_cconvert_ptr cconvert = (my_cconvert_ptr)cinfo->cconvert;
+  register int y, cb, cr, k;
+  register JSAMPROW outptr;
+  register JSAMPROW inptr0, inptr1, inptr2, inptr3;
+  register JDIMENSION col;
+  JDIMENSION num_cols = cinfo->output_width;
+  /* copy these pointers into registers if possible */
+  register JSAMPLE *range_limit = cinfo->sample_range_limit;
+  register int *Crrtab = cconvert->Cr_r_tab;
+  register int *Cbbtab = cconvert->Cb_b_tab;
+  register JLONG *Crgtab = cconvert->Cr_g_tab;
+  register JLONG *Cbgtab = cconvert->Cb_g_tab;
+  SHIFT_TEMPS
+
+  while (--num_rows >= 0) {
+    inptr0 = input_buf[0][input_row];
+    inptr1 = input_buf[1][input_row];
+    inptr2 = input_buf[2][input_row];
+    inptr3 = input_buf[3][input_row];
+    input_row++;
+    outptr = *output_buf++;
+    for (col = 0; col < num_cols; col++) {
+      y  = GETJSAMPLE(inptr0[col]);
+      cb = GETJSAMPLE(inptr1[col]);
+      cr = GETJSAMPLE(inptr2[col]);
+      k  = GETJSAMPLE(inptr3[col]);
+      outptr[RGB_RED] = (JSAMPLE)
+        SCALE_BY_K(range_limit[MAXJSAMPLE - (y + Crrtab[cr])], k);
+      outptr[RGB_GREEN] = (JSAMPLE)
+        SCALE_BY_K(range_limit[MAXJSAMPLE - (y +
+                               ((int)RIGHT_SHIFT(Cbgtab[cb] + Crgtab[cr],
+                                                 SCALEBITS)))], k);
+      outptr[RGB_BLUE] = (JSAMPLE)
+        SCALE_BY_K(range_limit[MAXJSAMPLE - (y + Cbbtab[cb])], k);
+      /* Set unused byte to 0xFF so it can be interpreted as an opaque */
+      /* alpha channel value */
+#ifdef RGB_ALPHA
+      outptr[RGB_ALPHA] = 0xFF;
+#endif
+      outptr += RGB_PIXELSIZE;
+    }
+  }
+}
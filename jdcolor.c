@@ -90,6 +90,14 @@ typedef my_color_deconverter *my_cconvert_ptr;
 #define TABLE_SIZE      (3 * (MAXJSAMPLE + 1))
 
 
+/* Scale an inverted C, M or Y value by K/MAXJSAMPLE.  Since MAXJSAMPLE is
+ * odd, this rounds to the nearest integer in the same way as the
+ * floating-point cmyk_to_rgb() in cmyk.h.
+ */
+
+#define SCALE_BY_K(x, k)  (((x) * (k) + (MAXJSAMPLE >> 1)) / MAXJSAMPLE)
+
+
 /* Include inline routines for colorspace extensions */
 
 #include "jdcolext.c"
@@ -105,6 +113,8 @@ typedef my_color_deconverter *my_cconvert_ptr;
 #define ycc_rgb_convert_internal  ycc_extrgb_convert_internal
 #define gray_rgb_convert_internal  gray_extrgb_convert_internal
 #define rgb_rgb_convert_internal  rgb_extrgb_convert_internal
+#define cmyk_rgb_convert_internal  cmyk_extrgb_convert_internal
+#define ycck_rgb_convert_internal  ycck_extrgb_convert_internal
 #include "jdcolext.c"
 #undef RGB_RED
 #undef RGB_GREEN
@@ -113,6 +123,8 @@ typedef my_color_deconverter *my_cconvert_ptr;
 #undef ycc_rgb_convert_internal
 #undef gray_rgb_convert_internal
 #undef rgb_rgb_convert_internal
+#undef cmyk_rgb_convert_internal
+#undef ycck_rgb_convert_internal
 
 #define RGB_RED  EXT_RGBX_RED
 #define RGB_GREEN  EXT_RGBX_GREEN
@@ -122,6 +134,8 @@ typedef my_color_deconverter *my_cconvert_ptr;
 #define ycc_rgb_convert_internal  ycc_extrgbx_convert_internal
 #define gray_rgb_convert_internal  gray_extrgbx_convert_internal
 #define rgb_rgb_convert_internal  rgb_extrgbx_convert_internal
+#define cmyk_rgb_convert_internal  cmyk_extrgbx_convert_internal
+#define ycck_rgb_convert_internal  ycck_extrgbx_convert_internal
 #include "jdcolext.c"
 #undef RGB_RED
 #undef RGB_GREEN
@@ -131,6 +145,8 @@ typedef my_color_deconverter *my_cconvert_ptr;
 #undef ycc_rgb_convert_internal
 #undef gray_rgb_convert_internal
 #undef rgb_rgb_convert_internal
+#undef cmyk_rgb_convert_internal
+#undef ycck_rgb_convert_internal
 
 #define RGB_RED  EXT_BGR_RED
 #define RGB_GREEN  EXT_BGR_GREEN
@@ -139,6 +155,8 @@ typedef my_color_deconverter *my_cconvert_ptr;
 #define ycc_rgb_convert_internal  ycc_extbgr_convert_internal
 #define gray_rgb_convert_internal  gray_extbgr_convert_internal
 #define rgb_rgb_convert_internal  rgb_extbgr_convert_internal
+#define cmyk_rgb_convert_internal  cmyk_extbgr_convert_internal
+#define ycck_rgb_convert_internal  ycck_extbgr_convert_internal
 #include "jdcolext.c"
 #undef RGB_RED
 #undef RGB_GREEN
@@ -147,6 +165,8 @@ typedef my_color_deconverter *my_cconvert_ptr;
 #undef ycc_rgb_convert_internal
 #undef gray_rgb_convert_internal
 #undef rgb_rgb_convert_internal
+#undef cmyk_rgb_convert_internal
+#undef ycck_rgb_convert_internal
 
 #define RGB_RED  EXT_BGRX_RED
 #define RGB_GREEN  EXT_BGRX_GREEN
@@ -156,6 +176,8 @@ typedef my_color_deconverter *my_cconvert_ptr;
 #define ycc_rgb_convert_internal  ycc_extbgrx_convert_internal
 #define gray_rgb_convert_internal  gray_extbgrx_convert_internal
 #define rgb_rgb_convert_internal  rgb_extbgrx_convert_internal
+#define cmyk_rgb_convert_internal  cmyk_extbgrx_convert_internal
+#define ycck_rgb_convert_internal  ycck_extbgrx_convert_internal
 #include "jdcolext.c"
 #undef RGB_RED
 #undef RGB_GREEN
@@ -165,6 +187,8 @@ typedef my_color_deconverter *my_cconvert_ptr;
 #undef ycc_rgb_convert_internal
 #undef gray_rgb_convert_internal
 #undef rgb_rgb_convert_internal
+#undef cmyk_rgb_convert_internal
+#undef ycck_rgb_convert_internal
 
 #define RGB_RED  EXT_XBGR_RED
 #define RGB_GREEN  EXT_XBGR_GREEN
@@ -174,6 +198,8 @@ typedef my_color_deconverter *my_cconvert_ptr;
 #define ycc_rgb_convert_internal  ycc_extxbgr_convert_internal
 #define gray_rgb_convert_internal  gray_extxbgr_convert_internal
 #define rgb_rgb_convert_internal  rgb_extxbgr_convert_internal
+#define cmyk_rgb_convert_internal  cmyk_extxbgr_convert_internal
+#define ycck_rgb_convert_internal  ycck_extxbgr_convert_internal
 #include "jdcolext.c"
 #undef RGB_RED
 #undef RGB_GREEN
@@ -183,6 +209,8 @@ typedef my_color_deconverter *my_cconvert_ptr;
 #undef ycc_rgb_convert_internal
 #undef gray_rgb_convert_internal
 #undef rgb_rgb_convert_internal
+#undef cmyk_rgb_convert_internal
+#undef ycck_rgb_convert_internal
 
 #define RGB_RED  EXT_XRGB_RED
 #define RGB_GREEN  EXT_XRGB_GREEN
@@ -192,6 +220,8 @@ typedef my_color_deconverter *my_cconvert_ptr;
 #define ycc_rgb_convert_internal  ycc_extxrgb_convert_internal
 #define gray_rgb_convert_internal  gray_extxrgb_convert_internal
 #define rgb_rgb_convert_internal  rgb_extxrgb_convert_internal
+#define cmyk_rgb_convert_internal  cmyk_extxrgb_convert_internal
+#define ycck_rgb_convert_internal  ycck_extxrgb_convert_internal
 #include "jdcolext.c"
 #undef RGB_RED
 #undef RGB_GREEN
@@ -201,6 +231,8 @@ typedef my_color_deconverter *my_cconvert_ptr;
 #undef ycc_rgb_convert_internal
 #undef gray_rgb_convert_internal
 #undef rgb_rgb_convert_internal
+#undef cmyk_rgb_convert_internal
+#undef ycck_rgb_convert_internal
 
 
 /*
@@ -567,6 +599,97 @@ ycck_cmyk_convert(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
 }
 
 
+/*
+ * Adobe-style CMYK->RGB conversion.
+ */
+
+METHODDEF(void)
+cmyk_rgb_convert(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                 JDIMENSION input_row, JSAMPARRAY output_buf, int num_rows)
+{
+  switch (cinfo->out_color_space) {
+  case JCS_EXT_RGB:
+    cmyk_extrgb_convert_internal(cinfo, input_buf, input_row, output_buf,
+                                 num_rows);
+    break;
+  case JCS_EXT_RGBX:
+  case JCS_EXT_RGBA:
+    cmyk_extrgbx_convert_internal(cinfo, input_buf, input_row, output_buf,
+                                  num_rows);
+    break;
+  case JCS_EXT_BGR:
+    cmyk_extbgr_convert_internal(cinfo, input_buf, input_row, output_buf,
+                                 num_rows);
+    break;
+  case JCS_EXT_BGRX:
+  case JCS_EXT_BGRA:
+    cmyk_extbgrx_convert_internal(cinfo, input_buf, input_row, output_buf,
+                                  num_rows);
+    break;
+  case JCS_EXT_XBGR:
+  case JCS_EXT_ABGR:
+    cmyk_extxbgr_convert_internal(cinfo, input_buf, input_row, output_buf,
+                                  num_rows);
+    break;
+  case JCS_EXT_XRGB:
+  case JCS_EXT_ARGB:
+    cmyk_extxrgb_convert_internal(cinfo, input_buf, input_row, output_buf,
+                                  num_rows);
+    break;
+  default:
+    cmyk_rgb_convert_internal(cinfo, input_buf, input_row, output_buf,
+                              num_rows);
+    break;
+  }
+}
+
+
+/*
+ * Adobe-style YCCK->RGB conversion.
+ * We assume build_ycc_rgb_table has been called.
+ */
+
+METHODDEF(void)
+ycck_rgb_convert(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                 JDIMENSION input_row, JSAMPARRAY output_buf, int num_rows)
+{
+  switch (cinfo->out_color_space) {
+  case JCS_EXT_RGB:
+    ycck_extrgb_convert_internal(cinfo, input_buf, input_row, output_buf,
+                                 num_rows);
+    break;
+  case JCS_EXT_RGBX:
+  case JCS_EXT_RGBA:
+    ycck_extrgbx_convert_internal(cinfo, input_buf, input_row, output_buf,
+                                  num_rows);
+    break;
+  case JCS_EXT_BGR:
+    ycck_extbgr_convert_internal(cinfo, input_buf, input_row, output_buf,
+                                 num_rows);
+    break;
+  case JCS_EXT_BGRX:
+  case JCS_EXT_BGRA:
+    ycck_extbgrx_convert_internal(cinfo, input_buf, input_row, output_buf,
+                                  num_rows);
+    break;
+  case JCS_EXT_XBGR:
+  case JCS_EXT_ABGR:
+    ycck_extxbgr_convert_internal(cinfo, input_buf, input_row, output_buf,
+                                  num_rows);
+    break;
+  case JCS_EXT_XRGB:
+  case JCS_EXT_ARGB:
+    ycck_extxrgb_convert_internal(cinfo, input_buf, input_row, output_buf,
+                                  num_rows);
+    break;
+  default:
+    ycck_rgb_convert_internal(cinfo, input_buf, input_row, output_buf,
+                              num_rows);
+    break;
+  }
+}
+
+
 /*
  * RGB565 conversion
  */
@@ -812,15 +935,32 @@ jinit_color_deconverter(j_decompress_ptr cinfo)
         build_ycc_rgb_table(cinfo);
       }
     } else if (cinfo->jpeg_color_space == JCS_GRAYSCALE) {
-      cconvert->pub.color_convert = gray_rgb_convert;
+      if (jsimd_can_gray_rgb())
+        cconvert->pub.color_convert = jsimd_gray_rgb_convert;
+      else
+        cconvert->pub.color_convert = gray_rgb_convert;
     } else if (cinfo->jpeg_color_space == JCS_RGB) {
-      if (rgb_red[cinfo->out_color_space] == 0 &&
-          rgb_green[cinfo->out_color_space] == 1 &&
-          rgb_blue[cinfo->out_color_space] == 2 &&
-          rgb_pixelsize[cinfo->out_color_space] == 3)
+      if (jsimd_can_rgb_rgb())
+        cconvert->pub.color_convert = jsimd_rgb_rgb_convert;
+      else if (rgb_red[cinfo->out_color_space] == 0 &&
+               rgb_green[cinfo->out_color_space] == 1 &&
+               rgb_blue[cinfo->out_color_space] == 2 &&
+               rgb_pixelsize[cinfo->out_color_space] == 3)
         cconvert->pub.color_convert = null_convert;
       else
         cconvert->pub.color_convert = rgb_rgb_convert;
+    } else if (cinfo->jpeg_color_space == JCS_YCCK) {
+      if (jsimd_can_ycck_rgb())
+        cconvert->pub.color_convert = jsimd_ycck_rgb_convert;
+      else {
+        cconvert->pub.color_convert = ycck_rgb_convert;
+        build_ycc_rgb_table(cinfo);
+      }
+    } else if (cinfo->jpeg_color_space == JCS_CMYK) {
+      if (jsimd_can_cmyk_rgb())
+        cconvert->pub.color_convert = jsimd_cmyk_rgb_convert;
+      else
+        cconvert->pub.color_convert = cmyk_rgb_convert;
     } else
       ERREXIT(cinfo, JERR_CONVERSION_NOTIMPL);
     break;
@@ -844,8 +984,12 @@ jinit_color_deconverter(j_decompress_ptr cinfo)
     } else {
       /* only ordered dithering is supported */
       if (cinfo->jpeg_color_space == JCS_YCbCr) {
-        cconvert->pub.color_convert = ycc_rgb565D_convert;
-        build_ycc_rgb_table(cinfo);
+        if (jsimd_can_ycc_rgb565D())
+          cconvert->pub.color_convert = jsimd_ycc_rgb565D_convert;
+        else {
+          cconvert->pub.color_convert = ycc_rgb565D_convert;
+          build_ycc_rgb_table(cinfo);
+        }
       } else if (cinfo->jpeg_color_space == JCS_GRAYSCALE) {
         cconvert->pub.color_convert = gray_rgb565D_convert;
       } else if (cinfo->jpeg_color_space == JCS_RGB) {
@@ -858,8 +1002,12 @@ jinit_color_deconverter(j_decompress_ptr cinfo)
   case JCS_CMYK:
     cinfo->out_color_components = 4;
     if (cinfo->jpeg_color_space == JCS_YCCK) {
-      cconvert->pub.color_convert = ycck_cmyk_convert;
-      build_ycc_rgb_table(cinfo);
+      if (jsimd_can_ycck_cmyk())
+        cconvert->pub.color_convert = jsimd_ycck_cmyk_convert;
+      else {
+        cconvert->pub.color_convert = ycck_cmyk_convert;
+        build_ycc_rgb_table(cinfo);
+      }
     } else if (cinfo->jpeg_color_space == JCS_CMYK) {
       cconvert->pub.color_convert = null_convert;
     } else
@@ -103,6 +103,20 @@ EXTERN(void) jpeg_idct_ifast(j_decompress_ptr cinfo,
 EXTERN(void) jpeg_idct_float(j_decompress_ptr cinfo,
                              jpeg_component_info *compptr, JCOEFPTR coef_block,
                              JSAMPARRAY output_buf, JDIMENSION output_col);
+EXTERN(void) jpeg_idct_islow_dc(j_decompress_ptr cinfo,
+                                jpeg_component_info *compptr,
+                                JCOEFPTR coef_block, JSAMPARRAY output_buf,
+                                JDIMENSION output_col);
+EXTERN(void) jpeg_idct_islow_corner2(j_decompress_ptr cinfo,
+                                     jpeg_component_info *compptr,
+                                     JCOEFPTR coef_block,
+                                     JSAMPARRAY output_buf,
+                                     JDIMENSION output_col);
+EXTERN(void) jpeg_idct_islow_corner4(j_decompress_ptr cinfo,
+                                     jpeg_component_info *compptr,
+                                     JCOEFPTR coef_block,
+                                     JSAMPARRAY output_buf,
+                                     JDIMENSION output_col);
 EXTERN(void) jpeg_idct_7x7(j_decompress_ptr cinfo,
                            jpeg_component_info *compptr, JCOEFPTR coef_block,
                            JSAMPARRAY output_buf, JDIMENSION output_col);
@@ -101,11 +101,15 @@ start_pass(j_decompress_ptr cinfo)
   jpeg_component_info *compptr;
   int method = 0;
   inverse_DCT_method_ptr method_ptr = NULL;
+  inverse_DCT_blocks_method_ptr blocks_method_ptr;
+  inverse_DCT_method_ptr sparse_method_ptr[3];
   JQUANT_TBL *qtbl;
 
   for (ci = 0, compptr = cinfo->comp_info; ci < cinfo->num_components;
        ci++, compptr++) {
     /* Select the proper IDCT routine for this component's scaling */
+    blocks_method_ptr = NULL;
+    sparse_method_ptr[0] = sparse_method_ptr[1] = sparse_method_ptr[2] = NULL;
     switch (compptr->_DCT_scaled_size) {
 #ifdef IDCT_SCALING_SUPPORTED
     case 1:
@@ -120,7 +124,10 @@ start_pass(j_decompress_ptr cinfo)
       method = JDCT_ISLOW;      /* jidctred uses islow-style table */
       break;
     case 3:
-      method_ptr = jpeg_idct_3x3;
+      if (jsimd_can_idct_scaled(3))
+        method_ptr = jsimd_idct_scaled;
+      else
+        method_ptr = jpeg_idct_3x3;
       method = JDCT_ISLOW;      /* jidctint uses islow-style table */
       break;
     case 4:
@@ -131,7 +138,10 @@ start_pass(j_decompress_ptr cinfo)
       method = JDCT_ISLOW;      /* jidctred uses islow-style table */
       break;
     case 5:
-      method_ptr = jpeg_idct_5x5;
+      if (jsimd_can_idct_scaled(5))
+        method_ptr = jsimd_idct_scaled;
+      else
+        method_ptr = jpeg_idct_5x5;
       method = JDCT_ISLOW;      /* jidctint uses islow-style table */
       break;
     case 6:
@@ -140,11 +150,17 @@ start_pass(j_decompress_ptr cinfo)
         method_ptr = jsimd_idct_6x6;
       else
 #endif
-      method_ptr = jpeg_idct_6x6;
+      if (jsimd_can_idct_scaled(6))
+        method_ptr = jsimd_idct_scaled;
+      else
+        method_ptr = jpeg_idct_6x6;
       method = JDCT_ISLOW;      /* jidctint uses islow-style table */
       break;
     case 7:
-      method_ptr = jpeg_idct_7x7;
+      if (jsimd_can_idct_scaled(7))
+        method_ptr = jsimd_idct_scaled;
+      else
+        method_ptr = jpeg_idct_7x7;
       method = JDCT_ISLOW;      /* jidctint uses islow-style table */
       break;
 #endif
@@ -156,6 +172,16 @@ start_pass(j_decompress_ptr cinfo)
           method_ptr = jsimd_idct_islow;
         else
           method_ptr = jpeg_idct_islow;
+        if (jsimd_can_idct_islow_blocks())
+          blocks_method_ptr = jsimd_idct_islow_blocks;
+        sparse_method_ptr[0] = jpeg_idct_islow_dc;
+        if (jsimd_can_idct_islow_corner4()) {
+          sparse_method_ptr[1] = jsimd_idct_islow_corner4;
+          sparse_method_ptr[2] = jsimd_idct_islow_corner4;
+        } else {
+          sparse_method_ptr[1] = jpeg_idct_islow_corner2;
+          sparse_method_ptr[2] = jpeg_idct_islow_corner4;
+        }
         method = JDCT_ISLOW;
         break;
 #endif
@@ -184,15 +210,24 @@ start_pass(j_decompress_ptr cinfo)
       break;
 #ifdef IDCT_SCALING_SUPPORTED
     case 9:
-      method_ptr = jpeg_idct_9x9;
+      if (jsimd_can_idct_scaled(9))
+        method_ptr = jsimd_idct_scaled;
+      else
+        method_ptr = jpeg_idct_9x9;
       method = JDCT_ISLOW;      /* jidctint uses islow-style table */
       break;
     case 10:
-      method_ptr = jpeg_idct_10x10;
+      if (jsimd_can_idct_scaled(10))
+        method_ptr = jsimd_idct_scaled;
+      else
+        method_ptr = jpeg_idct_10x10;
       method = JDCT_ISLOW;      /* jidctint uses islow-style table */
       break;
     case 11:
-      method_ptr = jpeg_idct_11x11;
+      if (jsimd_can_idct_scaled(11))
+        method_ptr = jsimd_idct_scaled;
+      else
+        method_ptr = jpeg_idct_11x11;
       method = JDCT_ISLOW;      /* jidctint uses islow-style table */
       break;
     case 12:
@@ -201,23 +236,38 @@ start_pass(j_decompress_ptr cinfo)
         method_ptr = jsimd_idct_12x12;
       else
 #endif
-      method_ptr = jpeg_idct_12x12;
+      if (jsimd_can_idct_scaled(12))
+        method_ptr = jsimd_idct_scaled;
+      else
+        method_ptr = jpeg_idct_12x12;
       method = JDCT_ISLOW;      /* jidctint uses islow-style table */
       break;
     case 13:
-      method_ptr = jpeg_idct_13x13;
+      if (jsimd_can_idct_scaled(13))
+        method_ptr = jsimd_idct_scaled;
+      else
+        method_ptr = jpeg_idct_13x13;
       method = JDCT_ISLOW;      /* jidctint uses islow-style table */
       break;
     case 14:
-      method_ptr = jpeg_idct_14x14;
+      if (jsimd_can_idct_scaled(14))
+        method_ptr = jsimd_idct_scaled;
+      else
+        method_ptr = jpeg_idct_14x14;
       method = JDCT_ISLOW;      /* jidctint uses islow-style table */
       break;
     case 15:
-      method_ptr = jpeg_idct_15x15;
+      if (jsimd_can_idct_scaled(15))
+        method_ptr = jsimd_idct_scaled;
+      else
+        method_ptr = jpeg_idct_15x15;
       method = JDCT_ISLOW;      /* jidctint uses islow-style table */
       break;
     case 16:
-      method_ptr = jpeg_idct_16x16;
+      if (jsimd_can_idct_scaled(16))
+        method_ptr = jsimd_idct_scaled;
+      else
+        method_ptr = jpeg_idct_16x16;
       method = JDCT_ISLOW;      /* jidctint uses islow-style table */
       break;
 #endif
@@ -226,6 +276,10 @@ start_pass(j_decompress_ptr cinfo)
       break;
     }
     idct->pub.inverse_DCT[ci] = method_ptr;
+    idct->pub.inverse_DCT_blocks[ci] = blocks_method_ptr;
+    idct->pub.inverse_DCT_sparse[ci][0] = sparse_method_ptr[0];
+    idct->pub.inverse_DCT_sparse[ci][1] = sparse_method_ptr[1];
+    idct->pub.inverse_DCT_sparse[ci][2] = sparse_method_ptr[2];
     /* Create multiplier table from quant table.
      * However, we can skip this if the component is uninteresting
      * or if we already built the table.  Also, if no quant table
@@ -28,6 +28,9 @@
 #include "jstdhuff.c"
 
 
+#define NEG_1  ((unsigned int)-1)
+
+
 /*
  * Expanded entropy decoder object for Huffman decoding.
  *
@@ -57,6 +60,54 @@ typedef struct {
 #endif
 
 
+/*
+ * An entropy checkpoint captures everything that the decoder needs in order to
+ * resume decoding at the start of a given MCU: the position of the next unread
+ * bit in the entropy-coded data and the DC predictions.  The position is kept
+ * as a byte offset from the start of the entropy-coded data, plus the number
+ * of bits of the data byte at that offset that belong to the previous MCU.
+ * Byte stuffing is accounted for, so this form does not depend on the size of
+ * the bit-extraction buffer.  This is the same form in which
+ * jpeg_speculate_mcu() reports MCU positions to the application.
+ */
+
+typedef jpeg_mcu_position huff_checkpoint;
+
+/* Maximum size of the serialized index header and of one serialized
+ * checkpoint (see jpeg_get_checkpoints())
+ */
+#define CKPT_MAGIC_LEN  5
+#define CKPT_CHECKSUM_LEN  4
+#define MAX_VARINT_LEN  10
+#define CKPT_HEADER_MAX  (CKPT_MAGIC_LEN + 8 * MAX_VARINT_LEN + \
+                          CKPT_CHECKSUM_LEN)
+#define CKPT_ENTRY_MAX  (2 * MAX_VARINT_LEN + 1 + \
+                         MAX_COMPS_IN_SCAN * MAX_VARINT_LEN)
+
+static const JOCTET ckpt_magic[CKPT_MAGIC_LEN] = { 'J', 'C', 'K', 'P', 2 };
+
+
+/*
+ * Combined lookahead table for AC coefficients, used by decode_mcu_fast().
+ * The ordinary lookahead table in d_derived_tbl resolves only the run/size
+ * symbol, after which the magnitude bits must be fetched separately.  This
+ * table is indexed by the next HUFF_AC_LOOKAHEAD bits of the input data
+ * stream, and if those bits hold both a complete run/size code with a nonzero
+ * size and all of its magnitude bits, it gives the run, the total number of
+ * bits and the sign-extended coefficient value at once.
+ *
+ * The lower 8 bits of each table entry contain the total number of bits, or 0
+ * if the ordinary lookahead must be used instead.  The next 8 bits contain the
+ * run length, and the upper 16 bits contain the coefficient value.
+ */
+
+#define HUFF_AC_LOOKAHEAD  10   /* # of bits of combined lookahead */
+
+typedef struct {
+  int lookup[1 << HUFF_AC_LOOKAHEAD];
+} d_ac_lookahead_tbl;
+
+
 typedef struct {
   struct jpeg_entropy_decoder pub; /* public fields */
 
@@ -72,20 +123,431 @@ typedef struct {
   /* Pointers to derived tables (these workspaces have image lifespan) */
   d_derived_tbl *dc_derived_tbls[NUM_HUFF_TBLS];
   d_derived_tbl *ac_derived_tbls[NUM_HUFF_TBLS];
+  d_ac_lookahead_tbl *ac_lookahead_tbls[NUM_HUFF_TBLS];
 
   /* Precalculated info set up by start_pass for use in decode_mcu: */
 
   /* Pointers to derived tables to be used for each block within an MCU */
   d_derived_tbl *dc_cur_tbls[D_MAX_BLOCKS_IN_MCU];
   d_derived_tbl *ac_cur_tbls[D_MAX_BLOCKS_IN_MCU];
+  d_ac_lookahead_tbl *ac_lookahead_cur_tbls[D_MAX_BLOCKS_IN_MCU];
   /* Whether we care about the DC and AC coefficient values for each block */
   boolean dc_needed[D_MAX_BLOCKS_IN_MCU];
   boolean ac_needed[D_MAX_BLOCKS_IN_MCU];
+  /* Zigzag index of the last nonzero coefficient of each block */
+  int last_nonzero[D_MAX_BLOCKS_IN_MCU];
+
+  /* Entropy checkpoint index (see jpeg_save_checkpoints()) */
+  JDIMENSION mcu_index;         /* index of next MCU to be decoded in scan */
+  const JOCTET *scan_start;     /* first byte of entropy-coded data */
+  size_t scan_size;             /* # of bytes available from scan_start */
+  JDIMENSION checkpoint_interval; /* # of MCUs between saved checkpoints */
+  JDIMENSION next_checkpoint;   /* MCU index at which to save a checkpoint */
+  huff_checkpoint *checkpoints; /* saved or loaded checkpoints */
+  JDIMENSION num_checkpoints;
+  JDIMENSION max_checkpoints;   /* space allocated when saving */
 } huff_entropy_decoder;
 
 typedef huff_entropy_decoder *huff_entropy_ptr;
 
 
+/*
+ * Variable-length integer coding for the serialized checkpoint index.  Each
+ * byte holds 7 bits of the value, least significant first, and the high bit
+ * is set in every byte but the last.
+ */
+
+LOCAL(JOCTET *)
+put_varint(JOCTET *ptr, size_t value)
+{
+  while (value >= 0x80) {
+    *ptr++ = (JOCTET)((value & 0x7F) | 0x80);
+    value >>= 7;
+  }
+  *ptr++ = (JOCTET)value;
+  return ptr;
+}
+
+
+LOCAL(boolean)
+get_varint(const JOCTET **ptr, const JOCTET *end, size_t *value)
+{
+  size_t result = 0;
+  int shift = 0, c;
+
+  do {
+    if (*ptr >= end || shift >= (int)(sizeof(size_t) * 8))
+      return FALSE;
+    c = GETJOCTET(*(*ptr)++);
+    result |= (size_t)(c & 0x7F) << shift;
+    shift += 7;
+  } while (c & 0x80);
+
+  *value = result;
+  return TRUE;
+}
+
+
+/*
+ * Adler-32 checksum of the serialized index.  It is stored (MSB first) after
+ * the last checkpoint, so that an index that has been corrupted in a way that
+ * still parses is rejected rather than trusted.
+ */
+
+LOCAL(unsigned long)
+ckpt_checksum(const JOCTET *data, size_t len)
+{
+  unsigned long a = 1, b = 0;
+
+  while (len-- > 0) {
+    a = (a + GETJOCTET(*data++)) % 65521;
+    b = (b + a) % 65521;
+  }
+  return (b << 16) | a;
+}
+
+
+/*
+ * Check that the position in a checkpoint lies within the current scan.
+ */
+
+LOCAL(boolean)
+valid_position(huff_entropy_ptr entropy, const huff_checkpoint *ckpt)
+{
+  if (ckpt->byte_offset > entropy->scan_size ||
+      ckpt->bit_index < 0 || ckpt->bit_index > 7)
+    return FALSE;
+  /* A partially consumed byte must be followed by at least one more byte
+   * (its stuffed zero, or the next data byte or marker.)
+   */
+  if (ckpt->bit_index > 0 && entropy->scan_size - ckpt->byte_offset < 2)
+    return FALSE;
+  return TRUE;
+}
+
+
+/*
+ * Parse the checkpoint index that the application passed to
+ * jpeg_use_checkpoints() and check that it matches the current scan.
+ * Returns FALSE if the index is corrupt or belongs to a different image.
+ */
+
+LOCAL(boolean)
+read_checkpoints(j_decompress_ptr cinfo, JDIMENSION total_mcus)
+{
+  huff_entropy_ptr entropy = (huff_entropy_ptr)cinfo->entropy;
+  const JOCTET *ptr = cinfo->master->checkpoint_data;
+  const JOCTET *end;
+  huff_checkpoint *ckpt;
+  size_t header[8], value, mcu_index = 0, byte_offset = 0;
+  unsigned long checksum = 0;
+  JDIMENSION i;
+  int ci;
+
+  if (cinfo->master->checkpoint_data_len < CKPT_MAGIC_LEN + CKPT_CHECKSUM_LEN)
+    return FALSE;
+  end = ptr + cinfo->master->checkpoint_data_len - CKPT_CHECKSUM_LEN;
+  for (i = 0; i < CKPT_CHECKSUM_LEN; i++)
+    checksum = (checksum << 8) | GETJOCTET(end[i]);
+  if (checksum != ckpt_checksum(ptr, (size_t)(end - ptr)))
+    return FALSE;
+  for (i = 0; i < CKPT_MAGIC_LEN; i++) {
+    if (GETJOCTET(*ptr++) != ckpt_magic[i])
+      return FALSE;
+  }
+  for (i = 0; i < 8; i++) {
+    if (!get_varint(&ptr, end, &header[i]))
+      return FALSE;
+  }
+  if (header[0] != (size_t)cinfo->image_width ||
+      header[1] != (size_t)cinfo->image_height ||
+      header[2] != (size_t)cinfo->comps_in_scan ||
+      header[3] != (size_t)cinfo->MCUs_per_row ||
+      header[4] != (size_t)cinfo->MCU_rows_in_scan ||
+      header[5] != (size_t)cinfo->restart_interval ||
+      header[6] != entropy->scan_size)
+    return FALSE;
+  /* Each checkpoint takes at least three bytes plus one per component, which
+   * bounds the allocation below even if the count is bogus.
+   */
+  if (header[7] == 0 || header[7] > (size_t)total_mcus ||
+      header[7] > (size_t)(end - ptr) / (3 + cinfo->comps_in_scan))
+    return FALSE;
+
+  entropy->checkpoints = (huff_checkpoint *)
+    (*cinfo->mem->alloc_large) ((j_common_ptr)cinfo, JPOOL_IMAGE,
+                                header[7] * sizeof(huff_checkpoint));
+  for (i = 0, ckpt = entropy->checkpoints; i < (JDIMENSION)header[7];
+       i++, ckpt++) {
+    if (!get_varint(&ptr, end, &value))
+      return FALSE;
+    /* MCU indices must be strictly increasing (except for the first one,
+     * which may be 0) and must lie within the scan.
+     */
+    if ((i > 0 && value == 0) || value >= (size_t)total_mcus - mcu_index)
+      return FALSE;
+    mcu_index += value;
+    if (!get_varint(&ptr, end, &value) || value > entropy->scan_size ||
+        byte_offset > entropy->scan_size - value || ptr >= end)
+      return FALSE;
+    byte_offset += value;
+    ckpt->mcu_index = (JDIMENSION)mcu_index;
+    ckpt->byte_offset = byte_offset;
+    ckpt->bit_index = GETJOCTET(*ptr++);
+    if (!valid_position(entropy, ckpt))
+      return FALSE;
+    for (ci = 0; ci < cinfo->comps_in_scan; ci++) {
+      if (!get_varint(&ptr, end, &value))
+        return FALSE;
+      /* Undo the zigzag mapping of signed to unsigned values */
+      ckpt->last_dc_val[ci] = (value & 1) ? -(int)(value >> 1) - 1 :
+                                            (int)(value >> 1);
+    }
+  }
+  if (ptr != end)
+    return FALSE;
+  entropy->num_checkpoints = (JDIMENSION)header[7];
+  return TRUE;
+}
+
+
+/*
+ * Check the MCU positions that the application passed to
+ * jpeg_use_mcu_positions().  Returns FALSE if any of them lie outside of the
+ * current scan or if they are out of order.
+ */
+
+LOCAL(boolean)
+use_positions(j_decompress_ptr cinfo, JDIMENSION total_mcus)
+{
+  huff_entropy_ptr entropy = (huff_entropy_ptr)cinfo->entropy;
+  huff_checkpoint *ckpt = cinfo->master->checkpoint_positions;
+  JDIMENSION i;
+
+  for (i = 0; i < cinfo->master->num_checkpoint_positions; i++, ckpt++) {
+    if (ckpt->mcu_index >= total_mcus ||
+        (i > 0 && ckpt->mcu_index <= ckpt[-1].mcu_index) ||
+        !valid_position(entropy, ckpt))
+      return FALSE;
+  }
+  entropy->checkpoints = cinfo->master->checkpoint_positions;
+  entropy->num_checkpoints = cinfo->master->num_checkpoint_positions;
+  return TRUE;
+}
+
+
+/*
+ * Get the decoder state at the start of the current MCU.  Returns FALSE if
+ * the position of the next unread bit cannot be determined.
+ */
+
+LOCAL(boolean)
+get_position(j_decompress_ptr cinfo, huff_checkpoint *ckpt)
+{
+  huff_entropy_ptr entropy = (huff_entropy_ptr)cinfo->entropy;
+  const JOCTET *ptr = cinfo->src->next_input_byte;
+  int nbytes, ci;
+
+  /* Give up if the bit buffer has been padded with zeroes, which happens when
+   * the decoder runs into a marker or out of data.
+   */
+  if (cinfo->unread_marker != 0 || entropy->pub.insufficient_data ||
+      ptr < entropy->scan_start || ptr > entropy->scan_start +
+                                         entropy->scan_size)
+    return FALSE;
+
+  /* Back up over the data bytes that still have unused bits in the bit
+   * buffer, skipping the zero byte that follows each FF data byte.  A zero
+   * byte preceded by FF is always a stuffed byte, since a zero data byte
+   * cannot directly follow an FF data byte.
+   */
+  for (nbytes = (entropy->bitstate.bits_left + 7) / 8; nbytes > 0;
+       nbytes--) {
+    if (ptr - entropy->scan_start >= 2 && ptr[-1] == 0 && ptr[-2] == 0xFF)
+      ptr -= 2;
+    else if (ptr > entropy->scan_start)
+      ptr--;
+    else
+      return FALSE;
+  }
+
+  ckpt->mcu_index = entropy->mcu_index;
+  ckpt->byte_offset = (size_t)(ptr - entropy->scan_start);
+  ckpt->bit_index = (8 - entropy->bitstate.bits_left % 8) % 8;
+  for (ci = 0; ci < cinfo->comps_in_scan; ci++)
+    ckpt->last_dc_val[ci] = entropy->saved.last_dc_val[ci];
+  return TRUE;
+}
+
+
+/*
+ * Record the decoder state at the start of the current MCU.
+ */
+
+LOCAL(void)
+save_checkpoint(j_decompress_ptr cinfo)
+{
+  huff_entropy_ptr entropy = (huff_entropy_ptr)cinfo->entropy;
+
+  entropy->next_checkpoint += entropy->checkpoint_interval;
+
+  if (entropy->num_checkpoints < entropy->max_checkpoints &&
+      get_position(cinfo, entropy->checkpoints + entropy->num_checkpoints))
+    entropy->num_checkpoints++;
+}
+
+
+/*
+ * Resume decoding at the MCU recorded in the given checkpoint.
+ */
+
+LOCAL(void)
+load_checkpoint(j_decompress_ptr cinfo, const huff_checkpoint *ckpt)
+{
+  huff_entropy_ptr entropy = (huff_entropy_ptr)cinfo->entropy;
+  const JOCTET *ptr = entropy->scan_start + ckpt->byte_offset;
+  int ci, c;
+
+  entropy->bitstate.get_buffer = 0;
+  entropy->bitstate.bits_left = 0;
+  if (ckpt->bit_index > 0) {
+    /* Preload the unused bits of the partially consumed byte */
+    c = GETJOCTET(*ptr++);
+    if (c == 0xFF)
+      ptr++;                    /* skip stuffed zero byte */
+    entropy->bitstate.get_buffer = c & ((1 << (8 - ckpt->bit_index)) - 1);
+    entropy->bitstate.bits_left = 8 - ckpt->bit_index;
+  }
+  cinfo->src->next_input_byte = ptr;
+  cinfo->src->bytes_in_buffer =
+    entropy->scan_size - (size_t)(ptr - entropy->scan_start);
+
+  for (ci = 0; ci < cinfo->comps_in_scan; ci++)
+    entropy->saved.last_dc_val[ci] = ckpt->last_dc_val[ci];
+  if (cinfo->restart_interval) {
+    entropy->restarts_to_go =
+      cinfo->restart_interval - ckpt->mcu_index % cinfo->restart_interval;
+    cinfo->marker->next_restart_num =
+      (int)(ckpt->mcu_index / cinfo->restart_interval) & 7;
+  }
+  cinfo->unread_marker = 0;
+  entropy->pub.insufficient_data = FALSE;
+  entropy->mcu_index = ckpt->mcu_index;
+}
+
+
+/* Forward declarations */
+METHODDEF(void) skip_mcus(j_decompress_ptr cinfo, JDIMENSION num_mcus);
+
+
+/*
+ * Set up the entropy checkpoint index for a new scan.  Checkpoints are
+ * supported only for single-scan images read with jpeg_mem_src(), since the
+ * index stores positions relative to the start of the entropy-coded data.
+ */
+
+LOCAL(void)
+start_checkpoints(j_decompress_ptr cinfo)
+{
+  huff_entropy_ptr entropy = (huff_entropy_ptr)cinfo->entropy;
+  JDIMENSION total_mcus = cinfo->MCUs_per_row * cinfo->MCU_rows_in_scan;
+  int blkn;
+
+  entropy->mcu_index = 0;
+  entropy->scan_start = cinfo->src->next_input_byte;
+  entropy->scan_size = cinfo->src->bytes_in_buffer;
+  entropy->num_checkpoints = entropy->max_checkpoints = 0;
+  entropy->pub.skip_mcus = NULL;
+
+  if (cinfo->master->checkpoint_data == NULL &&
+      cinfo->master->checkpoint_positions == NULL &&
+      !cinfo->master->save_checkpoints)
+    return;
+  if (cinfo->inputctl->has_multiple_scans || !jpeg_src_in_memory(cinfo) ||
+      total_mcus == 0) {
+    if (cinfo->master->checkpoint_data != NULL ||
+        cinfo->master->checkpoint_positions != NULL)
+      WARNMS(cinfo, JWRN_BAD_CHECKPOINTS);
+    return;
+  }
+
+  if (cinfo->master->checkpoint_data != NULL ||
+      cinfo->master->checkpoint_positions != NULL) {
+    if (cinfo->master->checkpoint_data != NULL ?
+        read_checkpoints(cinfo, total_mcus) :
+        use_positions(cinfo, total_mcus))
+      entropy->pub.skip_mcus = skip_mcus;
+    else {
+      entropy->num_checkpoints = 0;
+      WARNMS(cinfo, JWRN_BAD_CHECKPOINTS);
+    }
+  } else {
+    /* By default, save one checkpoint at the start of each MCU row */
+    entropy->checkpoint_interval = cinfo->master->checkpoint_interval;
+    if (entropy->checkpoint_interval == 0)
+      entropy->checkpoint_interval = cinfo->MCUs_per_row;
+    entropy->max_checkpoints =
+      (total_mcus - 1) / entropy->checkpoint_interval + 1;
+    entropy->checkpoints = (huff_checkpoint *)
+      (*cinfo->mem->alloc_large) ((j_common_ptr)cinfo, JPOOL_IMAGE,
+                                  entropy->max_checkpoints *
+                                  sizeof(huff_checkpoint));
+    entropy->next_checkpoint = 0;
+    /* The DC predictions have to be tracked for every component, even those
+     * that are not needed for this decode, so that the index can be used with
+     * any output colorspace.
+     */
+    for (blkn = 0; blkn < cinfo->blocks_in_MCU; blkn++)
+      entropy->dc_needed[blkn] = TRUE;
+  }
+}
+
+
+/*
+ * Compute the combined AC lookahead table from a derived Huffman table.
+ */
+
+LOCAL(void)
+make_ac_lookahead_tbl(j_decompress_ptr cinfo, d_derived_tbl *dtbl,
+                      d_ac_lookahead_tbl **patbl)
+{
+  d_ac_lookahead_tbl *atbl;
+  int lookbits, code, l, sym, r, s, value;
+
+  /* Allocate a workspace if we haven't already done so. */
+  if (*patbl == NULL)
+    *patbl = (d_ac_lookahead_tbl *)
+      (*cinfo->mem->alloc_small) ((j_common_ptr)cinfo, JPOOL_IMAGE,
+                                  sizeof(d_ac_lookahead_tbl));
+  atbl = *patbl;
+
+  for (lookbits = 0; lookbits < (1 << HUFF_AC_LOOKAHEAD); lookbits++) {
+    atbl->lookup[lookbits] = 0;
+    /* Find the code at the start of lookbits, as jpeg_huff_decode() does */
+    for (l = 1; l < HUFF_AC_LOOKAHEAD; l++) {
+      code = lookbits >> (HUFF_AC_LOOKAHEAD - l);
+      if (code <= dtbl->maxcode[l])
+        break;
+    }
+    if (l >= HUFF_AC_LOOKAHEAD)
+      continue;
+    sym = dtbl->pub->huffval[(int)(code + dtbl->valoffset[l]) & 0xFF];
+    r = sym >> 4;
+    s = sym & 15;
+    /* EOB and ZRL codes, and codes whose magnitude bits don't fit, are left
+     * to the ordinary lookahead.
+     */
+    if (s == 0 || l + s > HUFF_AC_LOOKAHEAD)
+      continue;
+    value = (lookbits >> (HUFF_AC_LOOKAHEAD - l - s)) & ((1 << s) - 1);
+    if (value < (1 << (s - 1)))
+      value += (int)(NEG_1 << s) + 1;
+    atbl->lookup[lookbits] = (int)(((unsigned int)value << 16) |
+                                   (r << 8) | (l + s));
+  }
+}
+
+
 /*
  * Initialize for a Huffman-compressed scan.
  */
@@ -116,6 +578,7 @@ start_pass_huff_decoder(j_decompress_ptr cinfo)
     jpeg_make_d_derived_tbl(cinfo, TRUE, dctbl, pdtbl);
     pdtbl = (d_derived_tbl **)(entropy->ac_derived_tbls) + actbl;
     jpeg_make_d_derived_tbl(cinfo, FALSE, actbl, pdtbl);
+    make_ac_lookahead_tbl(cinfo, *pdtbl, entropy->ac_lookahead_tbls + actbl);
     /* Initialize DC predictions to 0 */
     entropy->saved.last_dc_val[ci] = 0;
   }
@@ -127,6 +590,8 @@ start_pass_huff_decoder(j_decompress_ptr cinfo)
     /* Precalculate which table to use for each block */
     entropy->dc_cur_tbls[blkn] = entropy->dc_derived_tbls[compptr->dc_tbl_no];
     entropy->ac_cur_tbls[blkn] = entropy->ac_derived_tbls[compptr->ac_tbl_no];
+    entropy->ac_lookahead_cur_tbls[blkn] =
+      entropy->ac_lookahead_tbls[compptr->ac_tbl_no];
     /* Decide whether we really care about the coefficient values */
     if (compptr->component_needed) {
       entropy->dc_needed[blkn] = TRUE;
@@ -144,6 +609,8 @@ start_pass_huff_decoder(j_decompress_ptr cinfo)
 
   /* Initialize restart counter */
   entropy->restarts_to_go = cinfo->restart_interval;
+
+  start_checkpoints(cinfo);
 }
 
 
@@ -399,49 +866,6 @@ no_more_bytes:
 }
 
 
-/* Macro version of the above, which performs much better but does not
-   handle markers.  We have to hand off any blocks with markers to the
-   slower routines. */
-
-#define GET_BYTE { \
-  register int c0, c1; \
-  c0 = GETJOCTET(*buffer++); \
-  c1 = GETJOCTET(*buffer); \
-  /* Pre-execute most common case */ \
-  get_buffer = (get_buffer << 8) | c0; \
-  bits_left += 8; \
-  if (c0 == 0xFF) { \
-    /* Pre-execute case of FF/00, which represents an FF data byte */ \
-    buffer++; \
-    if (c1 != 0) { \
-      /* Oops, it's actually a marker indicating end of compressed data. */ \
-      cinfo->unread_marker = c1; \
-      /* Back out pre-execution and fill the buffer with zero bits */ \
-      buffer -= 2; \
-      get_buffer &= ~0xFF; \
-    } \
-  } \
-}
-
-#if SIZEOF_SIZE_T == 8 || defined(_WIN64)
-
-/* Pre-fetch 48 bytes, because the holding register is 64-bit */
-#define FILL_BIT_BUFFER_FAST \
-  if (bits_left <= 16) { \
-    GET_BYTE GET_BYTE GET_BYTE GET_BYTE GET_BYTE GET_BYTE \
-  }
-
-#else
-
-/* Pre-fetch 16 bytes, because the holding register is 32-bit */
-#define FILL_BIT_BUFFER_FAST \
-  if (bits_left <= 16) { \
-    GET_BYTE GET_BYTE \
-  }
-
-#endif
-
-
 /*
  * Out-of-line code for Huffman code decoding.
  * See jdhuff.h for info about usage.
@@ -494,7 +918,6 @@ jpeg_huff_decode(bitread_working_state *state,
 #define AVOID_TABLES
 #ifdef AVOID_TABLES
 
-#define NEG_1  ((unsigned int)-1)
 #define HUFF_EXTEND(x, s) \
   ((x) + ((((x) - (1 << ((s) - 1))) >> 31) & (((NEG_1) << (s)) + 1)))
 
@@ -575,6 +998,7 @@ decode_mcu_slow(j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
     d_derived_tbl *dctbl = entropy->dc_cur_tbls[blkn];
     d_derived_tbl *actbl = entropy->ac_cur_tbls[blkn];
     register int s, k, r;
+    int last = 0;
 
     /* Decode a single block's worth of coefficients */
 
@@ -617,6 +1041,7 @@ decode_mcu_slow(j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
            * if k >= DCTSIZE2, which could happen if the data is corrupted.
            */
           (*block)[jpeg_natural_order[k]] = (JCOEF)s;
+          last = k;
         } else {
           if (r != 15)
             break;
@@ -645,6 +1070,8 @@ decode_mcu_slow(j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
         }
       }
     }
+
+    entropy->last_nonzero[blkn] = last;
   }
 
   /* Completed MCU, so update state */
@@ -673,7 +1100,9 @@ decode_mcu_fast(j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
     JBLOCKROW block = MCU_data ? MCU_data[blkn] : NULL;
     d_derived_tbl *dctbl = entropy->dc_cur_tbls[blkn];
     d_derived_tbl *actbl = entropy->ac_cur_tbls[blkn];
+    d_ac_lookahead_tbl *atbl = entropy->ac_lookahead_cur_tbls[blkn];
     register int s, k, r, l;
+    int last = 0;
 
     HUFF_DECODE_FAST(s, l, dctbl, slow_decode_mcu);
     if (s) {
@@ -693,6 +1122,17 @@ decode_mcu_fast(j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
     if (entropy->ac_needed[blkn] && block) {
 
       for (k = 1; k < DCTSIZE2; k++) {
+        /* Try to resolve the code and the magnitude bits in one probe */
+        FILL_BIT_BUFFER_FAST
+        s = atbl->lookup[PEEK_BITS(HUFF_AC_LOOKAHEAD)];
+        if (s) {
+          DROP_BITS(s & 0xFF);
+          k += (s >> 8) & 0xFF;
+          (*block)[jpeg_natural_order[k]] = (JCOEF)(s >> 16);
+          last = k;
+          continue;
+        }
+
         HUFF_DECODE_FAST(s, l, actbl, slow_decode_mcu);
         r = s >> 4;
         s &= 15;
@@ -703,6 +1143,7 @@ decode_mcu_fast(j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
           r = GET_BITS(s);
           s = HUFF_EXTEND(r, s);
           (*block)[jpeg_natural_order[k]] = (JCOEF)s;
+          last = k;
         } else {
           if (r != 15) break;
           k += 15;
@@ -712,6 +1153,14 @@ decode_mcu_fast(j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
     } else {
 
       for (k = 1; k < DCTSIZE2; k++) {
+        FILL_BIT_BUFFER_FAST
+        s = atbl->lookup[PEEK_BITS(HUFF_AC_LOOKAHEAD)];
+        if (s) {
+          DROP_BITS(s & 0xFF);
+          k += (s >> 8) & 0xFF;
+          continue;
+        }
+
         HUFF_DECODE_FAST(s, l, actbl, slow_decode_mcu);
         r = s >> 4;
         s &= 15;
@@ -726,6 +1175,8 @@ decode_mcu_fast(j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
         }
       }
     }
+
+    entropy->last_nonzero[blkn] = last;
   }
 
   if (cinfo->unread_marker != 0) {
@@ -770,9 +1221,19 @@ decode_mcu(j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
     if (entropy->restarts_to_go == 0)
       if (!process_restart(cinfo))
         return FALSE;
-    usefast = 0;
+    /* The fast path is safe within a restart interval, since it backs out and
+     * hands the MCU to the slow path whenever its prefetch runs into a
+     * marker.  The last MCU of the interval is the one that abuts the RSTn
+     * marker, so decode it with the slow path to avoid a wasted attempt.
+     */
+    if (entropy->restarts_to_go == 1)
+      usefast = 0;
   }
 
+  if (entropy->mcu_index == entropy->next_checkpoint &&
+      entropy->max_checkpoints != 0)
+    save_checkpoint(cinfo);
+
   if (cinfo->src->bytes_in_buffer < BUFSIZE * (size_t)cinfo->blocks_in_MCU ||
       cinfo->unread_marker != 0)
     usefast = 0;
@@ -789,15 +1250,46 @@ use_slow:
       if (!decode_mcu_slow(cinfo, MCU_data)) return FALSE;
     }
 
-  }
+  } else
+    MEMZERO(entropy->last_nonzero, sizeof(entropy->last_nonzero));
 
   /* Account for restart interval (no-op if not using restarts) */
   entropy->restarts_to_go--;
+  entropy->mcu_index++;
 
   return TRUE;
 }
 
 
+/*
+ * Skip over the given number of MCUs, discarding their coefficients.  This
+ * resumes decoding at the last checkpoint that does not lie past the target
+ * MCU (if that is ahead of the current position) and decodes the rest.
+ */
+
+METHODDEF(void)
+skip_mcus(j_decompress_ptr cinfo, JDIMENSION num_mcus)
+{
+  huff_entropy_ptr entropy = (huff_entropy_ptr)cinfo->entropy;
+  JDIMENSION target = entropy->mcu_index + num_mcus;
+  JDIMENSION lo = 0, hi = entropy->num_checkpoints, mid;
+
+  /* Find the first checkpoint past the target MCU */
+  while (lo < hi) {
+    mid = lo + (hi - lo) / 2;
+    if (entropy->checkpoints[mid].mcu_index <= target)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  if (lo > 0 && entropy->checkpoints[lo - 1].mcu_index > entropy->mcu_index)
+    load_checkpoint(cinfo, &entropy->checkpoints[lo - 1]);
+
+  while (entropy->mcu_index < target)
+    (void)decode_mcu(cinfo, NULL);
+}
+
+
 /*
  * Module initialization routine for Huffman entropy decoding.
  */
@@ -820,9 +1312,256 @@ jinit_huff_decoder(j_decompress_ptr cinfo)
   cinfo->entropy = (struct jpeg_entropy_decoder *)entropy;
   entropy->pub.start_pass = start_pass_huff_decoder;
   entropy->pub.decode_mcu = decode_mcu;
+  entropy->pub.skip_mcus = NULL;
+  entropy->pub.last_nonzero = entropy->last_nonzero;
 
   /* Mark tables unallocated */
   for (i = 0; i < NUM_HUFF_TBLS; i++) {
     entropy->dc_derived_tbls[i] = entropy->ac_derived_tbls[i] = NULL;
+    entropy->ac_lookahead_tbls[i] = NULL;
+  }
+}
+
+
+/*
+ * Entropy checkpoint index
+ *
+ * A checkpoint index records the state of the Huffman decoder at regular MCU
+ * intervals during one full decode of a single-scan image.  Passing it to a
+ * later decode of the same image allows jpeg_skip_scanlines() and
+ * jpeg_crop_scanline() to resume entropy decoding at the nearest checkpoint
+ * rather than decoding every MCU that precedes the region of interest.  See
+ * libjpeg.txt for usage information.
+ */
+
+GLOBAL(void)
+jpeg_save_checkpoints(j_decompress_ptr cinfo, JDIMENSION mcu_interval)
+{
+  if (cinfo->global_state != DSTATE_READY)
+    ERREXIT1(cinfo, JERR_BAD_STATE, cinfo->global_state);
+
+  cinfo->master->save_checkpoints = TRUE;
+  cinfo->master->checkpoint_interval = mcu_interval;
+}
+
+
+GLOBAL(void)
+jpeg_use_checkpoints(j_decompress_ptr cinfo, const JOCTET *data,
+                     unsigned long data_len)
+{
+  if (data == NULL || data_len == 0)
+    ERREXIT(cinfo, JERR_BUFFER_SIZE);
+  if (cinfo->global_state != DSTATE_READY)
+    ERREXIT1(cinfo, JERR_BAD_STATE, cinfo->global_state);
+
+  /* Keep a copy, so that the caller need not hold on to the data */
+  cinfo->master->checkpoint_data = (JOCTET *)
+    (*cinfo->mem->alloc_large) ((j_common_ptr)cinfo, JPOOL_IMAGE,
+                                (size_t)data_len);
+  MEMCOPY(cinfo->master->checkpoint_data, data, (size_t)data_len);
+  cinfo->master->checkpoint_data_len = (size_t)data_len;
+}
+
+
+/*
+ * Like jpeg_use_checkpoints(), but the index is given as an array of MCU
+ * positions, such as those gathered with jpeg_speculate_mcu().  The MCU
+ * indices must be strictly increasing.
+ */
+
+GLOBAL(void)
+jpeg_use_mcu_positions(j_decompress_ptr cinfo,
+                       const jpeg_mcu_position *positions,
+                       JDIMENSION num_positions)
+{
+  if (positions == NULL || num_positions == 0)
+    ERREXIT(cinfo, JERR_BUFFER_SIZE);
+  if (cinfo->global_state != DSTATE_READY)
+    ERREXIT1(cinfo, JERR_BAD_STATE, cinfo->global_state);
+
+  cinfo->master->checkpoint_positions = (jpeg_mcu_position *)
+    (*cinfo->mem->alloc_large) ((j_common_ptr)cinfo, JPOOL_IMAGE,
+                                (size_t)num_positions *
+                                sizeof(jpeg_mcu_position));
+  MEMCOPY(cinfo->master->checkpoint_positions, positions,
+          (size_t)num_positions * sizeof(jpeg_mcu_position));
+  cinfo->master->num_checkpoint_positions = num_positions;
+}
+
+
+/*
+ * Serialize the checkpoint index that was saved while decoding the image.
+ * This must be called after the whole image has been decoded but before
+ * jpeg_finish_decompress().
+ *
+ * TRUE is returned if an index is available, FALSE if not (because
+ * jpeg_save_checkpoints() was not called, the image is progressive,
+ * arithmetic-coded, or has multiple scans, the data source is not a memory
+ * source, or decoding did not reach the end of the scan.)  If TRUE is
+ * returned, *data_ptr is set to point to the returned data, and *data_len is
+ * set to its length.
+ *
+ * IMPORTANT: the data at *data_ptr is allocated with malloc() and must be
+ * freed by the caller with free() when the caller no longer needs it.
+ */
+
+GLOBAL(boolean)
+jpeg_get_checkpoints(j_decompress_ptr cinfo, JOCTET **data_ptr,
+                     unsigned long *data_len)
+{
+  huff_entropy_ptr entropy = (huff_entropy_ptr)cinfo->entropy;
+  huff_checkpoint *ckpt;
+  JOCTET *data, *ptr;
+  size_t data_size, prev_offset = 0;
+  unsigned long checksum;
+  JDIMENSION i, prev_index = 0;
+  int ci, dc;
+
+  if (data_ptr == NULL || data_len == NULL)
+    ERREXIT(cinfo, JERR_BUFFER_SIZE);
+  if (cinfo->global_state <= DSTATE_READY ||
+      cinfo->global_state > DSTATE_STOPPING)
+    ERREXIT1(cinfo, JERR_BAD_STATE, cinfo->global_state);
+
+  *data_ptr = NULL;             /* avoid confusion if FALSE return */
+  *data_len = 0;
+
+  if (cinfo->entropy->decode_mcu != decode_mcu ||
+      entropy->max_checkpoints == 0 || entropy->num_checkpoints == 0 ||
+      entropy->mcu_index < cinfo->MCUs_per_row * cinfo->MCU_rows_in_scan)
+    return FALSE;
+
+  /* num_checkpoints is a JDIMENSION, so this can only overflow if size_t is
+   * no wider than JDIMENSION.
+   */
+  data_size = (size_t)entropy->num_checkpoints * CKPT_ENTRY_MAX;
+  if (data_size / CKPT_ENTRY_MAX != (size_t)entropy->num_checkpoints ||
+      data_size > (size_t)-1 - CKPT_HEADER_MAX)
+    ERREXIT1(cinfo, JERR_OUT_OF_MEMORY, 12);
+  data = (JOCTET *)malloc(CKPT_HEADER_MAX + data_size);
+  if (data == NULL)
+    ERREXIT1(cinfo, JERR_OUT_OF_MEMORY, 12);
+
+  ptr = data;
+  for (i = 0; i < CKPT_MAGIC_LEN; i++)
+    *ptr++ = ckpt_magic[i];
+  ptr = put_varint(ptr, (size_t)cinfo->image_width);
+  ptr = put_varint(ptr, (size_t)cinfo->image_height);
+  ptr = put_varint(ptr, (size_t)cinfo->comps_in_scan);
+  ptr = put_varint(ptr, (size_t)cinfo->MCUs_per_row);
+  ptr = put_varint(ptr, (size_t)cinfo->MCU_rows_in_scan);
+  ptr = put_varint(ptr, (size_t)cinfo->restart_interval);
+  ptr = put_varint(ptr, entropy->scan_size);
+  ptr = put_varint(ptr, (size_t)entropy->num_checkpoints);
+
+  /* MCU indices and byte offsets are delta-coded, and DC predictions are
+   * zigzag-coded so that small negative values also take a single byte.
+   */
+  for (i = 0, ckpt = entropy->checkpoints; i < entropy->num_checkpoints;
+       i++, ckpt++) {
+    ptr = put_varint(ptr, (size_t)(ckpt->mcu_index - prev_index));
+    ptr = put_varint(ptr, ckpt->byte_offset - prev_offset);
+    *ptr++ = (JOCTET)ckpt->bit_index;
+    for (ci = 0; ci < cinfo->comps_in_scan; ci++) {
+      dc = ckpt->last_dc_val[ci];
+      ptr = put_varint(ptr, dc < 0 ? ((size_t)(-(dc + 1)) << 1) | 1 :
+                                     (size_t)dc << 1);
+    }
+    prev_index = ckpt->mcu_index;
+    prev_offset = ckpt->byte_offset;
+  }
+  checksum = ckpt_checksum(data, (size_t)(ptr - data));
+  for (i = 0; i < CKPT_CHECKSUM_LEN; i++)
+    *ptr++ = (JOCTET)((checksum >> (8 * (CKPT_CHECKSUM_LEN - 1 - i))) & 0xFF);
+
+  *data_ptr = data;
+  *data_len = (unsigned long)(ptr - data);
+  return TRUE;
+}
+
+
+/*
+ * Speculative entropy decoding.  This lets an application find MCU boundaries
+ * in the middle of the entropy-coded data of an image without restart
+ * markers, without decoding all of the data that precedes them.
+ *
+ * jpeg_start_speculative() assumes that an MCU begins at the given byte offset
+ * from the start of the entropy-coded data and that all DC predictions are
+ * zero there.  Neither is likely to be true, but Huffman codes tend to
+ * resynchronize after a few MCUs, after which jpeg_speculate_mcu() returns the
+ * same positions as a decode from the start of the scan, with MCU indices and
+ * DC predictions that are off by a constant.  It is up to the application to
+ * confirm synchronization by matching up the positions from two decodes.
+ *
+ * jpeg_start_speculative() must be called after jpeg_start_decompress() and
+ * before any image data is read.  It returns FALSE if speculative decoding is
+ * not supported for the image, which must be a single-scan Huffman-coded
+ * image without restart markers that is read with jpeg_mem_src() and whose
+ * MCUs contain either a single block or blocks that use different Huffman
+ * tables.  After speculative decoding, the decompression object can only be
+ * aborted or destroyed.
+ */
+
+GLOBAL(boolean)
+jpeg_start_speculative(j_decompress_ptr cinfo, size_t byte_offset)
+{
+  huff_entropy_ptr entropy = (huff_entropy_ptr)cinfo->entropy;
+  huff_checkpoint start;
+  int blkn;
+
+  if (cinfo->global_state != DSTATE_SCANNING &&
+      cinfo->global_state != DSTATE_RAW_OK)
+    ERREXIT1(cinfo, JERR_BAD_STATE, cinfo->global_state);
+
+  if (cinfo->entropy->decode_mcu != decode_mcu ||
+      cinfo->inputctl->has_multiple_scans || !jpeg_src_in_memory(cinfo) ||
+      cinfo->restart_interval != 0 || byte_offset >= entropy->scan_size)
+    return FALSE;
+
+  /* If all blocks in an MCU use the same Huffman tables, then a decode that
+   * starts at the wrong block within an MCU is just as valid as the right one,
+   * so it never converges on the true MCU boundaries.
+   */
+  for (blkn = 1; blkn < cinfo->blocks_in_MCU; blkn++) {
+    if (entropy->dc_cur_tbls[blkn] != entropy->dc_cur_tbls[0] ||
+        entropy->ac_cur_tbls[blkn] != entropy->ac_cur_tbls[0])
+      break;
   }
+  if (cinfo->blocks_in_MCU > 1 && blkn == cinfo->blocks_in_MCU)
+    return FALSE;
+
+  MEMZERO(&start, sizeof(huff_checkpoint));
+  start.byte_offset = byte_offset;
+  load_checkpoint(cinfo, &start);
+  entropy->max_checkpoints = 0;
+  /* Track the DC predictions of all components, as start_checkpoints() does */
+  for (blkn = 0; blkn < cinfo->blocks_in_MCU; blkn++)
+    entropy->dc_needed[blkn] = TRUE;
+  return TRUE;
+}
+
+
+/*
+ * Return the position of the next MCU in *pos, and then skip over the MCU.
+ * pos->mcu_index counts the MCUs since jpeg_start_speculative() was called.
+ * Returns FALSE, without advancing, if the MCU cannot be decoded.  That
+ * happens near the end of the entropy-coded data, at a marker, and at data
+ * that is invalid (which is common before synchronization.)  No warnings are
+ * issued in any of these cases.
+ */
+
+GLOBAL(boolean)
+jpeg_speculate_mcu(j_decompress_ptr cinfo, jpeg_mcu_position *pos)
+{
+  huff_entropy_ptr entropy = (huff_entropy_ptr)cinfo->entropy;
+
+  /* Only the fast path is used, since the slow path issues warnings for bad
+   * data and for running into a marker.
+   */
+  if (cinfo->src->bytes_in_buffer < BUFSIZE * (size_t)cinfo->blocks_in_MCU ||
+      !get_position(cinfo, pos) || !decode_mcu_fast(cinfo, NULL))
+    return FALSE;
+
+  entropy->mcu_index++;
+  return TRUE;
 }
@@ -34,8 +34,11 @@ LOCAL(boolean)
 use_merged_upsample(j_decompress_ptr cinfo)
 {
 #ifdef UPSAMPLE_MERGING_SUPPORTED
-  /* Merging is the equivalent of plain box-filter upsampling */
-  if (cinfo->do_fancy_upsampling || cinfo->CCIR601_sampling)
+  /* jdmerge.c doesn't support CCIR601 sampling, and its YCC=>RGB565
+   * converters only do the equivalent of plain box-filter upsampling
+   */
+  if (cinfo->CCIR601_sampling ||
+      (cinfo->do_fancy_upsampling && cinfo->out_color_space == JCS_RGB565))
     return FALSE;
   /* jdmerge.c only supports YCC=>RGB and YCC=>RGB565 color conversion */
   if (cinfo->jpeg_color_space != JCS_YCbCr || cinfo->num_components != 3 ||
@@ -72,9 +75,14 @@ use_merged_upsample(j_decompress_ptr cinfo)
     return FALSE;
 #ifdef WITH_SIMD
   /* If YCbCr-to-RGB color conversion is SIMD-accelerated but merged upsampling
-     isn't, then disabling merged upsampling is likely to be faster when
+     (or fancy merged upsampling, if fancy upsampling was requested) isn't,
+     then disabling merged upsampling is likely to be faster when
      decompressing YCbCr JPEG images. */
-  if (!jsimd_can_h2v2_merged_upsample() && !jsimd_can_h2v1_merged_upsample() &&
+  if ((cinfo->do_fancy_upsampling ?
+       !jsimd_can_h2v2_fancy_merged_upsample() &&
+       !jsimd_can_h2v1_fancy_merged_upsample() :
+       !jsimd_can_h2v2_merged_upsample() &&
+       !jsimd_can_h2v1_merged_upsample()) &&
       jsimd_can_ycc_rgb() && cinfo->jpeg_color_space == JCS_YCbCr &&
       (cinfo->out_color_space == JCS_RGB ||
        (cinfo->out_color_space >= JCS_EXT_RGB &&
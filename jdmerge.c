@@ -35,46 +35,24 @@
  * Other special cases could be added, but in most applications these are
  * the only common cases.  (For uncommon cases we fall back on the more
  * general code in jdsample.c and jdcolor.c.)
+ *
+ * When fancy upsampling is requested, the chroma samples are instead
+ * interpolated with the same triangle filter that jdsample.c uses, one output
+ * pixel at a time, and converted without ever being stored in an upsampled
+ * row buffer.  The output is identical to that of the separate upsampling and
+ * color conversion steps.
  */
 
 #define JPEG_INTERNALS
 #include "jinclude.h"
 #include "jpeglib.h"
+#include "jdmerge.h"
 #include "jsimd.h"
+#include "jpegcomp.h"
 #include "jconfigint.h"
 
 #ifdef UPSAMPLE_MERGING_SUPPORTED
 
-
-/* Private subobject */
-
-typedef struct {
-  struct jpeg_upsampler pub;    /* public fields */
-
-  /* Pointer to routine to do actual upsampling/conversion of one row group */
-  void (*upmethod) (j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
-                    JDIMENSION in_row_group_ctr, JSAMPARRAY output_buf);
-
-  /* Private state for YCC->RGB conversion */
-  int *Cr_r_tab;                /* => table for Cr to R conversion */
-  int *Cb_b_tab;                /* => table for Cb to B conversion */
-  JLONG *Cr_g_tab;              /* => table for Cr to G conversion */
-  JLONG *Cb_g_tab;              /* => table for Cb to G conversion */
-
-  /* For 2:1 vertical sampling, we produce two output rows at a time.
-   * We need a "spare" row buffer to hold the second output row if the
-   * application provides just a one-row buffer; we also use the spare
-   * to discard the dummy last row if the image height is odd.
-   */
-  JSAMPROW spare_row;
-  boolean spare_full;           /* T if spare buffer is occupied */
-
-  JDIMENSION out_row_width;     /* samples per output row */
-  JDIMENSION rows_to_go;        /* counts rows remaining in image */
-} my_upsampler;
-
-typedef my_upsampler *my_upsample_ptr;
-
 #define SCALEBITS       16      /* speediest right-shift on some machines */
 #define ONE_HALF        ((JLONG)1 << (SCALEBITS - 1))
 #define FIX(x)          ((JLONG)((x) * (1L << SCALEBITS) + 0.5))
@@ -94,6 +72,12 @@ typedef my_upsampler *my_upsample_ptr;
 #define RGB_PIXELSIZE  EXT_RGB_PIXELSIZE
 #define h2v1_merged_upsample_internal  extrgb_h2v1_merged_upsample_internal
 #define h2v2_merged_upsample_internal  extrgb_h2v2_merged_upsample_internal
+#define fancy_merged_upsample_row_internal \
+  extrgb_fancy_merged_upsample_row_internal
+#define h2v1_fancy_merged_upsample_internal \
+  extrgb_h2v1_fancy_merged_upsample_internal
+#define h2v2_fancy_merged_upsample_internal \
+  extrgb_h2v2_fancy_merged_upsample_internal
 #include "jdmrgext.c"
 #undef RGB_RED
 #undef RGB_GREEN
@@ -101,6 +85,9 @@ typedef my_upsampler *my_upsample_ptr;
 #undef RGB_PIXELSIZE
 #undef h2v1_merged_upsample_internal
 #undef h2v2_merged_upsample_internal
+#undef fancy_merged_upsample_row_internal
+#undef h2v1_fancy_merged_upsample_internal
+#undef h2v2_fancy_merged_upsample_internal
 
 #define RGB_RED  EXT_RGBX_RED
 #define RGB_GREEN  EXT_RGBX_GREEN
@@ -109,6 +96,12 @@ typedef my_upsampler *my_upsample_ptr;
 #define RGB_PIXELSIZE  EXT_RGBX_PIXELSIZE
 #define h2v1_merged_upsample_internal  extrgbx_h2v1_merged_upsample_internal
 #define h2v2_merged_upsample_internal  extrgbx_h2v2_merged_upsample_internal
+#define fancy_merged_upsample_row_internal \
+  extrgbx_fancy_merged_upsample_row_internal
+#define h2v1_fancy_merged_upsample_internal \
+  extrgbx_h2v1_fancy_merged_upsample_internal
+#define h2v2_fancy_merged_upsample_internal \
+  extrgbx_h2v2_fancy_merged_upsample_internal
 #include "jdmrgext.c"
 #undef RGB_RED
 #undef RGB_GREEN
@@ -117,6 +110,9 @@ typedef my_upsampler *my_upsample_ptr;
 #undef RGB_PIXELSIZE
 #undef h2v1_merged_upsample_internal
 #undef h2v2_merged_upsample_internal
+#undef fancy_merged_upsample_row_internal
+#undef h2v1_fancy_merged_upsample_internal
+#undef h2v2_fancy_merged_upsample_internal
 
 #define RGB_RED  EXT_BGR_RED
 #define RGB_GREEN  EXT_BGR_GREEN
@@ -124,6 +120,12 @@ typedef my_upsampler *my_upsample_ptr;
 #define RGB_PIXELSIZE  EXT_BGR_PIXELSIZE
 #define h2v1_merged_upsample_internal  extbgr_h2v1_merged_upsample_internal
 #define h2v2_merged_upsample_internal  extbgr_h2v2_merged_upsample_internal
+#define fancy_merged_upsample_row_internal \
+  extbgr_fancy_merged_upsample_row_internal
+#define h2v1_fancy_merged_upsample_internal \
+  extbgr_h2v1_fancy_merged_upsample_internal
+#define h2v2_fancy_merged_upsample_internal \
+  extbgr_h2v2_fancy_merged_upsample_internal
 #include "jdmrgext.c"
 #undef RGB_RED
 #undef RGB_GREEN
@@ -131,6 +133,9 @@ typedef my_upsampler *my_upsample_ptr;
 #undef RGB_PIXELSIZE
 #undef h2v1_merged_upsample_internal
 #undef h2v2_merged_upsample_internal
+#undef fancy_merged_upsample_row_internal
+#undef h2v1_fancy_merged_upsample_internal
+#undef h2v2_fancy_merged_upsample_internal
 
 #define RGB_RED  EXT_BGRX_RED
 #define RGB_GREEN  EXT_BGRX_GREEN
@@ -139,6 +144,12 @@ typedef my_upsampler *my_upsample_ptr;
 #define RGB_PIXELSIZE  EXT_BGRX_PIXELSIZE
 #define h2v1_merged_upsample_internal  extbgrx_h2v1_merged_upsample_internal
 #define h2v2_merged_upsample_internal  extbgrx_h2v2_merged_upsample_internal
+#define fancy_merged_upsample_row_internal \
+  extbgrx_fancy_merged_upsample_row_internal
+#define h2v1_fancy_merged_upsample_internal \
+  extbgrx_h2v1_fancy_merged_upsample_internal
+#define h2v2_fancy_merged_upsample_internal \
+  extbgrx_h2v2_fancy_merged_upsample_internal
 #include "jdmrgext.c"
 #undef RGB_RED
 #undef RGB_GREEN
@@ -147,6 +158,9 @@ typedef my_upsampler *my_upsample_ptr;
 #undef RGB_PIXELSIZE
 #undef h2v1_merged_upsample_internal
 #undef h2v2_merged_upsample_internal
+#undef fancy_merged_upsample_row_internal
+#undef h2v1_fancy_merged_upsample_internal
+#undef h2v2_fancy_merged_upsample_internal
 
 #define RGB_RED  EXT_XBGR_RED
 #define RGB_GREEN  EXT_XBGR_GREEN
@@ -155,6 +169,12 @@ typedef my_upsampler *my_upsample_ptr;
 #define RGB_PIXELSIZE  EXT_XBGR_PIXELSIZE
 #define h2v1_merged_upsample_internal  extxbgr_h2v1_merged_upsample_internal
 #define h2v2_merged_upsample_internal  extxbgr_h2v2_merged_upsample_internal
+#define fancy_merged_upsample_row_internal \
+  extxbgr_fancy_merged_upsample_row_internal
+#define h2v1_fancy_merged_upsample_internal \
+  extxbgr_h2v1_fancy_merged_upsample_internal
+#define h2v2_fancy_merged_upsample_internal \
+  extxbgr_h2v2_fancy_merged_upsample_internal
 #include "jdmrgext.c"
 #undef RGB_RED
 #undef RGB_GREEN
@@ -163,6 +183,9 @@ typedef my_upsampler *my_upsample_ptr;
 #undef RGB_PIXELSIZE
 #undef h2v1_merged_upsample_internal
 #undef h2v2_merged_upsample_internal
+#undef fancy_merged_upsample_row_internal
+#undef h2v1_fancy_merged_upsample_internal
+#undef h2v2_fancy_merged_upsample_internal
 
 #define RGB_RED  EXT_XRGB_RED
 #define RGB_GREEN  EXT_XRGB_GREEN
@@ -171,6 +194,12 @@ typedef my_upsampler *my_upsample_ptr;
 #define RGB_PIXELSIZE  EXT_XRGB_PIXELSIZE
 #define h2v1_merged_upsample_internal  extxrgb_h2v1_merged_upsample_internal
 #define h2v2_merged_upsample_internal  extxrgb_h2v2_merged_upsample_internal
+#define fancy_merged_upsample_row_internal \
+  extxrgb_fancy_merged_upsample_row_internal
+#define h2v1_fancy_merged_upsample_internal \
+  extxrgb_h2v1_fancy_merged_upsample_internal
+#define h2v2_fancy_merged_upsample_internal \
+  extxrgb_h2v2_fancy_merged_upsample_internal
 #include "jdmrgext.c"
 #undef RGB_RED
 #undef RGB_GREEN
@@ -179,6 +208,9 @@ typedef my_upsampler *my_upsample_ptr;
 #undef RGB_PIXELSIZE
 #undef h2v1_merged_upsample_internal
 #undef h2v2_merged_upsample_internal
+#undef fancy_merged_upsample_row_internal
+#undef h2v1_fancy_merged_upsample_internal
+#undef h2v2_fancy_merged_upsample_internal
 
 
 /*
@@ -189,7 +221,7 @@ typedef my_upsampler *my_upsample_ptr;
 LOCAL(void)
 build_ycc_rgb_table(j_decompress_ptr cinfo)
 {
-  my_upsample_ptr upsample = (my_upsample_ptr)cinfo->upsample;
+  my_merged_upsample_ptr upsample = (my_merged_upsample_ptr)cinfo->upsample;
   int i;
   JLONG x;
   SHIFT_TEMPS
@@ -232,7 +264,7 @@ build_ycc_rgb_table(j_decompress_ptr cinfo)
 METHODDEF(void)
 start_pass_merged_upsample(j_decompress_ptr cinfo)
 {
-  my_upsample_ptr upsample = (my_upsample_ptr)cinfo->upsample;
+  my_merged_upsample_ptr upsample = (my_merged_upsample_ptr)cinfo->upsample;
 
   /* Mark the spare buffer empty */
   upsample->spare_full = FALSE;
@@ -254,11 +286,18 @@ merged_2v_upsample(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
                    JDIMENSION *out_row_ctr, JDIMENSION out_rows_avail)
 /* 2:1 vertical sampling case: may need a spare row. */
 {
-  my_upsample_ptr upsample = (my_upsample_ptr)cinfo->upsample;
+  my_merged_upsample_ptr upsample = (my_merged_upsample_ptr)cinfo->upsample;
   JSAMPROW work_ptrs[2];
   JDIMENSION num_rows;          /* number of rows returned to caller */
 
-  if (upsample->spare_full) {
+  if (upsample->spare_full && upsample->independent_rows) {
+    /* Produce the second row of the row group straight into the output. */
+    work_ptrs[0] = NULL;
+    work_ptrs[1] = output_buf[*out_row_ctr];
+    (*upsample->upmethod) (cinfo, input_buf, *in_row_group_ctr, work_ptrs);
+    num_rows = 1;
+    upsample->spare_full = FALSE;
+  } else if (upsample->spare_full) {
     /* If we have a spare row saved from a previous cycle, just return it. */
     JDIMENSION size = upsample->out_row_width;
     if (cinfo->out_color_space == JCS_RGB565)
@@ -282,7 +321,7 @@ merged_2v_upsample(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
     if (num_rows > 1) {
       work_ptrs[1] = output_buf[*out_row_ctr + 1];
     } else {
-      work_ptrs[1] = upsample->spare_row;
+      work_ptrs[1] = upsample->independent_rows ? NULL : upsample->spare_row;
       upsample->spare_full = TRUE;
     }
     /* Now do the upsampling. */
@@ -305,7 +344,7 @@ merged_1v_upsample(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
                    JDIMENSION *out_row_ctr, JDIMENSION out_rows_avail)
 /* 1:1 vertical sampling case: much easier, never need a spare row. */
 {
-  my_upsample_ptr upsample = (my_upsample_ptr)cinfo->upsample;
+  my_merged_upsample_ptr upsample = (my_merged_upsample_ptr)cinfo->upsample;
 
   /* Just do the upsampling. */
   (*upsample->upmethod) (cinfo, input_buf, *in_row_group_ctr,
@@ -416,6 +455,98 @@ h2v2_merged_upsample(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
 }
 
 
+/*
+ * Fancy upsample and color convert for the case of 2:1 horizontal and 1:1
+ * vertical.
+ */
+
+METHODDEF(void)
+h2v1_fancy_merged_upsample(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                           JDIMENSION in_row_group_ctr, JSAMPARRAY output_buf)
+{
+  switch (cinfo->out_color_space) {
+  case JCS_EXT_RGB:
+    extrgb_h2v1_fancy_merged_upsample_internal(cinfo, input_buf,
+                                               in_row_group_ctr, output_buf);
+    break;
+  case JCS_EXT_RGBX:
+  case JCS_EXT_RGBA:
+    extrgbx_h2v1_fancy_merged_upsample_internal(cinfo, input_buf,
+                                                in_row_group_ctr, output_buf);
+    break;
+  case JCS_EXT_BGR:
+    extbgr_h2v1_fancy_merged_upsample_internal(cinfo, input_buf,
+                                               in_row_group_ctr, output_buf);
+    break;
+  case JCS_EXT_BGRX:
+  case JCS_EXT_BGRA:
+    extbgrx_h2v1_fancy_merged_upsample_internal(cinfo, input_buf,
+                                                in_row_group_ctr, output_buf);
+    break;
+  case JCS_EXT_XBGR:
+  case JCS_EXT_ABGR:
+    extxbgr_h2v1_fancy_merged_upsample_internal(cinfo, input_buf,
+                                                in_row_group_ctr, output_buf);
+    break;
+  case JCS_EXT_XRGB:
+  case JCS_EXT_ARGB:
+    extxrgb_h2v1_fancy_merged_upsample_internal(cinfo, input_buf,
+                                                in_row_group_ctr, output_buf);
+    break;
+  default:
+    h2v1_fancy_merged_upsample_internal(cinfo, input_buf, in_row_group_ctr,
+                                        output_buf);
+    break;
+  }
+}
+
+
+/*
+ * Fancy upsample and color convert for the case of 2:1 horizontal and 2:1
+ * vertical.
+ */
+
+METHODDEF(void)
+h2v2_fancy_merged_upsample(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                           JDIMENSION in_row_group_ctr, JSAMPARRAY output_buf)
+{
+  switch (cinfo->out_color_space) {
+  case JCS_EXT_RGB:
+    extrgb_h2v2_fancy_merged_upsample_internal(cinfo, input_buf,
+                                               in_row_group_ctr, output_buf);
+    break;
+  case JCS_EXT_RGBX:
+  case JCS_EXT_RGBA:
+    extrgbx_h2v2_fancy_merged_upsample_internal(cinfo, input_buf,
+                                                in_row_group_ctr, output_buf);
+    break;
+  case JCS_EXT_BGR:
+    extbgr_h2v2_fancy_merged_upsample_internal(cinfo, input_buf,
+                                               in_row_group_ctr, output_buf);
+    break;
+  case JCS_EXT_BGRX:
+  case JCS_EXT_BGRA:
+    extbgrx_h2v2_fancy_merged_upsample_internal(cinfo, input_buf,
+                                                in_row_group_ctr, output_buf);
+    break;
+  case JCS_EXT_XBGR:
+  case JCS_EXT_ABGR:
+    extxbgr_h2v2_fancy_merged_upsample_internal(cinfo, input_buf,
+                                                in_row_group_ctr, output_buf);
+    break;
+  case JCS_EXT_XRGB:
+  case JCS_EXT_ARGB:
+    extxrgb_h2v2_fancy_merged_upsample_internal(cinfo, input_buf,
+                                                in_row_group_ctr, output_buf);
+    break;
+  default:
+    h2v2_fancy_merged_upsample_internal(cinfo, input_buf, in_row_group_ctr,
+                                        output_buf);
+    break;
+  }
+}
+
+
 /*
  * RGB565 conversion
  */
@@ -563,47 +694,87 @@ h2v2_merged_upsample_565D(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
  * NB: this is called under the conditions determined by use_merged_upsample()
  * in jdmaster.c.  That routine MUST correspond to the actual capabilities
  * of this module; no safety checks are made here.
+ *
+ * jpeg_crop_scanline() calls this again with jinit_upsampler_no_alloc set if
+ * cropping has made the chroma components too narrow for the triangle filter,
+ * just as it calls jinit_upsampler() in that case.
  */
 
 GLOBAL(void)
 jinit_merged_upsampler(j_decompress_ptr cinfo)
 {
-  my_upsample_ptr upsample;
-
-  upsample = (my_upsample_ptr)
-    (*cinfo->mem->alloc_small) ((j_common_ptr)cinfo, JPOOL_IMAGE,
-                                sizeof(my_upsampler));
-  cinfo->upsample = (struct jpeg_upsampler *)upsample;
-  upsample->pub.start_pass = start_pass_merged_upsample;
-  upsample->pub.need_context_rows = FALSE;
+  my_merged_upsample_ptr upsample;
+  boolean do_fancy;
+
+  if (!cinfo->master->jinit_upsampler_no_alloc) {
+    upsample = (my_merged_upsample_ptr)
+      (*cinfo->mem->alloc_small) ((j_common_ptr)cinfo, JPOOL_IMAGE,
+                                  sizeof(my_merged_upsampler));
+    cinfo->upsample = (struct jpeg_upsampler *)upsample;
+    upsample->pub.start_pass = start_pass_merged_upsample;
+    upsample->pub.need_context_rows = FALSE;
+  } else
+    upsample = (my_merged_upsample_ptr)cinfo->upsample;
 
   upsample->out_row_width = cinfo->output_width * cinfo->out_color_components;
 
+  /* Use the triangle filter under the same conditions as jinit_upsampler()
+   * does for the chroma components.  Otherwise, merging is the equivalent of
+   * plain box-filter upsampling.
+   */
+  do_fancy = cinfo->do_fancy_upsampling && cinfo->_min_DCT_scaled_size > 1 &&
+             cinfo->comp_info[1].downsampled_width > 2;
+
+  upsample->independent_rows = FALSE;
+
   if (cinfo->max_v_samp_factor == 2) {
     upsample->pub.upsample = merged_2v_upsample;
-    if (jsimd_can_h2v2_merged_upsample())
+    if (do_fancy) {
+      if (jsimd_can_h2v2_fancy_merged_upsample())
+        upsample->upmethod = jsimd_h2v2_fancy_merged_upsample;
+      else
+        upsample->upmethod = h2v2_fancy_merged_upsample;
+      upsample->pub.need_context_rows = TRUE;
+      upsample->independent_rows = TRUE;
+    } else if (jsimd_can_h2v2_merged_upsample())
       upsample->upmethod = jsimd_h2v2_merged_upsample;
     else
       upsample->upmethod = h2v2_merged_upsample;
     if (cinfo->out_color_space == JCS_RGB565) {
-      if (cinfo->dither_mode != JDITHER_NONE) {
+      if (jsimd_can_h2v2_merged_upsample_565()) {
+        if (cinfo->dither_mode != JDITHER_NONE)
+          upsample->upmethod = jsimd_h2v2_merged_upsample_565D;
+        else
+          upsample->upmethod = jsimd_h2v2_merged_upsample_565;
+      } else if (cinfo->dither_mode != JDITHER_NONE) {
         upsample->upmethod = h2v2_merged_upsample_565D;
       } else {
         upsample->upmethod = h2v2_merged_upsample_565;
       }
     }
     /* Allocate a spare row buffer */
-    upsample->spare_row = (JSAMPROW)
-      (*cinfo->mem->alloc_large) ((j_common_ptr)cinfo, JPOOL_IMAGE,
-                (size_t)(upsample->out_row_width * sizeof(JSAMPLE)));
+    if (!cinfo->master->jinit_upsampler_no_alloc)
+      upsample->spare_row = (JSAMPROW)
+        (*cinfo->mem->alloc_large) ((j_common_ptr)cinfo, JPOOL_IMAGE,
+                  (size_t)(upsample->out_row_width * sizeof(JSAMPLE)));
   } else {
     upsample->pub.upsample = merged_1v_upsample;
-    if (jsimd_can_h2v1_merged_upsample())
+    if (do_fancy) {
+      if (jsimd_can_h2v1_fancy_merged_upsample())
+        upsample->upmethod = jsimd_h2v1_fancy_merged_upsample;
+      else
+        upsample->upmethod = h2v1_fancy_merged_upsample;
+    } else if (jsimd_can_h2v1_merged_upsample())
       upsample->upmethod = jsimd_h2v1_merged_upsample;
     else
       upsample->upmethod = h2v1_merged_upsample;
     if (cinfo->out_color_space == JCS_RGB565) {
-      if (cinfo->dither_mode != JDITHER_NONE) {
+      if (jsimd_can_h2v1_merged_upsample_565()) {
+        if (cinfo->dither_mode != JDITHER_NONE)
+          upsample->upmethod = jsimd_h2v1_merged_upsample_565D;
+        else
+          upsample->upmethod = jsimd_h2v1_merged_upsample_565;
+      } else if (cinfo->dither_mode != JDITHER_NONE) {
         upsample->upmethod = h2v1_merged_upsample_565D;
       } else {
         upsample->upmethod = h2v1_merged_upsample_565;
@@ -613,7 +784,8 @@ jinit_merged_upsampler(j_decompress_ptr cinfo)
     upsample->spare_row = NULL;
   }
 
-  build_ycc_rgb_table(cinfo);
+  if (!cinfo->master->jinit_upsampler_no_alloc)
+    build_ycc_rgb_table(cinfo);
 }
 
 #endif /* UPSAMPLE_MERGING_SUPPORTED */
@@ -25,7 +25,7 @@ h2v1_merged_upsample_internal(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
                               JDIMENSION in_row_group_ctr,
                               JSAMPARRAY output_buf)
 {
-  my_upsample_ptr upsample = (my_upsample_ptr)cinfo->upsample;
+  my_merged_upsample_ptr upsample = (my_merged_upsample_ptr)cinfo->upsample;
   register int y, cred, cgreen, cblue;
   int cb, cr;
   register JSAMPROW outptr;
@@ -97,7 +97,7 @@ h2v2_merged_upsample_internal(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
                               JDIMENSION in_row_group_ctr,
                               JSAMPARRAY output_buf)
 {
-  my_upsample_ptr upsample = (my_upsample_ptr)cinfo->upsample;
+  my_merged_upsample_ptr upsample = (my_merged_upsample_ptr)cinfo->upsample;
   register int y, cred, cgreen, cblue;
   int cb, cr;
   register JSAMPROW outptr0, outptr1;
@@ -182,3 +182,161 @@ h2v2_merged_upsample_internal(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
 #endif
   }
 }
+
+
+/*
+ * Upsample and color convert one output row using the triangle filter of
+ * h2v1_fancy_upsample() and h2v2_fancy_upsample() in jdsample.c.
+ *
+ * Each chroma column sum is 3 * the nearer chroma sample + the farther one
+ * (for 1:1 vertical sampling, both are the same sample, so the sum is 4 *
+ * the sample.)  Each output pixel then gets 3/4 * its own column sum +
+ * 1/4 * the column sum of its horizontal neighbor, which is exactly what the
+ * separate upsampling step computes.  The bias values alternate as they do
+ * there: 8 and 7 for h2v2, or 4 and 8 (1 and 2 before the sums were scaled
+ * up by 4) for h2v1.
+ */
+
+INLINE
+LOCAL(void)
+fancy_merged_upsample_row_internal(j_decompress_ptr cinfo, JSAMPROW inptr0,
+                                   JSAMPROW inptr1, JSAMPROW inptr1f,
+                                   JSAMPROW inptr2, JSAMPROW inptr2f,
+                                   JSAMPROW outptr, int v_samp_factor)
+{
+  my_merged_upsample_ptr upsample = (my_merged_upsample_ptr)cinfo->upsample;
+  register int y, cred, cgreen, cblue;
+  int cb, cr;
+  int thiscbsum, lastcbsum, nextcbsum, thiscrsum, lastcrsum, nextcrsum;
+  int bias_even = (v_samp_factor == 2) ? 8 : 4;
+  int bias_odd = (v_samp_factor == 2) ? 7 : 8;
+  JDIMENSION col, lastcol;
+  /* copy these pointers into registers if possible */
+  register JSAMPLE *range_limit = cinfo->sample_range_limit;
+  int *Crrtab = upsample->Cr_r_tab;
+  int *Cbbtab = upsample->Cb_b_tab;
+  JLONG *Crgtab = upsample->Cr_g_tab;
+  JLONG *Cbgtab = upsample->Cb_g_tab;
+  SHIFT_TEMPS
+
+  lastcol = cinfo->comp_info[1].downsampled_width - 1;
+  thiscbsum = GETJSAMPLE(inptr1[0]) * 3 + GETJSAMPLE(inptr1f[0]);
+  thiscrsum = GETJSAMPLE(inptr2[0]) * 3 + GETJSAMPLE(inptr2f[0]);
+  /* The column to the left of the first one is a copy of it */
+  lastcbsum = thiscbsum;
+  lastcrsum = thiscrsum;
+  /* Loop for each pair of output pixels */
+  for (col = 0; col < (cinfo->output_width >> 1); col++) {
+    /* The column to the right of the last one is a copy of it */
+    if (col < lastcol) {
+      nextcbsum = GETJSAMPLE(inptr1[col + 1]) * 3 +
+                  GETJSAMPLE(inptr1f[col + 1]);
+      nextcrsum = GETJSAMPLE(inptr2[col + 1]) * 3 +
+                  GETJSAMPLE(inptr2f[col + 1]);
+    } else {
+      nextcbsum = thiscbsum;
+      nextcrsum = thiscrsum;
+    }
+    /* Upsample the chroma for the left pixel and emit it */
+    cb = (thiscbsum * 3 + lastcbsum + bias_even) >> 4;
+    cr = (thiscrsum * 3 + lastcrsum + bias_even) >> 4;
+    cred = Crrtab[cr];
+    cgreen = (int)RIGHT_SHIFT(Cbgtab[cb] + Crgtab[cr], SCALEBITS);
+    cblue = Cbbtab[cb];
+    y  = GETJSAMPLE(*inptr0++);
+    outptr[RGB_RED] =   range_limit[y + cred];
+    outptr[RGB_GREEN] = range_limit[y + cgreen];
+    outptr[RGB_BLUE] =  range_limit[y + cblue];
+#ifdef RGB_ALPHA
+    outptr[RGB_ALPHA] = 0xFF;
+#endif
+    outptr += RGB_PIXELSIZE;
+    /* Upsample the chroma for the right pixel and emit it */
+    cb = (thiscbsum * 3 + nextcbsum + bias_odd) >> 4;
+    cr = (thiscrsum * 3 + nextcrsum + bias_odd) >> 4;
+    cred = Crrtab[cr];
+    cgreen = (int)RIGHT_SHIFT(Cbgtab[cb] + Crgtab[cr], SCALEBITS);
+    cblue = Cbbtab[cb];
+    y  = GETJSAMPLE(*inptr0++);
+    outptr[RGB_RED] =   range_limit[y + cred];
+    outptr[RGB_GREEN] = range_limit[y + cgreen];
+    outptr[RGB_BLUE] =  range_limit[y + cblue];
+#ifdef RGB_ALPHA
+    outptr[RGB_ALPHA] = 0xFF;
+#endif
+    outptr += RGB_PIXELSIZE;
+    lastcbsum = thiscbsum;  thiscbsum = nextcbsum;
+    lastcrsum = thiscrsum;  thiscrsum = nextcrsum;
+  }
+  /* If image width is odd, do the last output column separately */
+  if (cinfo->output_width & 1) {
+    cb = (thiscbsum * 3 + lastcbsum + bias_even) >> 4;
+    cr = (thiscrsum * 3 + lastcrsum + bias_even) >> 4;
+    cred = Crrtab[cr];
+    cgreen = (int)RIGHT_SHIFT(Cbgtab[cb] + Crgtab[cr], SCALEBITS);
+    cblue = Cbbtab[cb];
+    y  = GETJSAMPLE(*inptr0);
+    outptr[RGB_RED] =   range_limit[y + cred];
+    outptr[RGB_GREEN] = range_limit[y + cgreen];
+    outptr[RGB_BLUE] =  range_limit[y + cblue];
+#ifdef RGB_ALPHA
+    outptr[RGB_ALPHA] = 0xFF;
+#endif
+  }
+}
+
+
+/*
+ * Fancy upsample and color convert for the case of 2:1 horizontal and 1:1
+ * vertical.
+ */
+
+INLINE
+LOCAL(void)
+h2v1_fancy_merged_upsample_internal(j_decompress_ptr cinfo,
+                                    JSAMPIMAGE input_buf,
+                                    JDIMENSION in_row_group_ctr,
+                                    JSAMPARRAY output_buf)
+{
+  JSAMPROW inptr1 = input_buf[1][in_row_group_ctr];
+  JSAMPROW inptr2 = input_buf[2][in_row_group_ctr];
+
+  fancy_merged_upsample_row_internal(cinfo, input_buf[0][in_row_group_ctr],
+                                     inptr1, inptr1, inptr2, inptr2,
+                                     output_buf[0], 1);
+}
+
+
+/*
+ * Fancy upsample and color convert for the case of 2:1 horizontal and 2:1
+ * vertical.  The chroma row above and the one below the current row group
+ * are provided by the main buffer controller's context mode.
+ */
+
+INLINE
+LOCAL(void)
+h2v2_fancy_merged_upsample_internal(j_decompress_ptr cinfo,
+                                    JSAMPIMAGE input_buf,
+                                    JDIMENSION in_row_group_ctr,
+                                    JSAMPARRAY output_buf)
+{
+  JSAMPARRAY inrows1 = input_buf[1] + in_row_group_ctr;
+  JSAMPARRAY inrows2 = input_buf[2] + in_row_group_ctr;
+
+  /* The upper output row uses the chroma row above as its farther row */
+  if (output_buf[0] != NULL)
+    fancy_merged_upsample_row_internal(cinfo,
+                                       input_buf[0][in_row_group_ctr * 2],
+                                       inrows1[0], inrows1[-1],
+                                       inrows2[0], inrows2[-1],
+                                       output_buf[0], 2);
+  /* and the lower output row uses the chroma row below.  Either one may be
+   * skipped (see independent_rows in jdmerge.h.)
+   */
+  if (output_buf[1] != NULL)
+    fancy_merged_upsample_row_internal(cinfo,
+                                       input_buf[0][in_row_group_ctr * 2 + 1],
+                                       inrows1[0], inrows1[1],
+                                       inrows2[0], inrows2[1],
+                                       output_buf[1], 2);
+}
@@ -274,6 +274,13 @@ process_restart(j_decompress_ptr cinfo)
 }
 
 
+/* The fast paths are used only if at least this many bytes are left in the
+ * source buffer, which is enough for any single block (see jdhuff.c.)
+ */
+
+#define BUFSIZE  (DCTSIZE2 * 8)
+
+
 /*
  * Huffman MCU decoding.
  * Each of these routines decodes and returns one MCU's worth of
@@ -371,76 +378,168 @@ decode_mcu_DC_first(j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
  * or first pass of successive approximation).
  */
 
-METHODDEF(boolean)
-decode_mcu_AC_first(j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
+LOCAL(boolean)
+decode_mcu_AC_first_slow(j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
 {
   phuff_entropy_ptr entropy = (phuff_entropy_ptr)cinfo->entropy;
   int Se = cinfo->Se;
   int Al = cinfo->Al;
   register int s, k, r;
-  unsigned int EOBRUN;
+  unsigned int EOBRUN = 0;
+  JBLOCKROW block;
+  BITREAD_STATE_VARS;
+  d_derived_tbl *tbl;
+
+  /* Load up working state */
+  BITREAD_LOAD_STATE(cinfo, entropy->bitstate);
+  block = MCU_data[0];
+  tbl = entropy->ac_derived_tbl;
+
+  for (k = cinfo->Ss; k <= Se; k++) {
+    HUFF_DECODE(s, br_state, tbl, return FALSE, label2);
+    r = s >> 4;
+    s &= 15;
+    if (s) {
+      k += r;
+      CHECK_BIT_BUFFER(br_state, s, return FALSE);
+      r = GET_BITS(s);
+      s = HUFF_EXTEND(r, s);
+      /* Scale and output coefficient in natural (dezigzagged) order */
+      (*block)[jpeg_natural_order[k]] = (JCOEF)LEFT_SHIFT(s, Al);
+    } else {
+      if (r == 15) {            /* ZRL */
+        k += 15;                /* skip 15 zeroes in band */
+      } else {                  /* EOBr, run length is 2^r + appended bits */
+        EOBRUN = 1 << r;
+        if (r) {                /* EOBr, r > 0 */
+          CHECK_BIT_BUFFER(br_state, r, return FALSE);
+          r = GET_BITS(r);
+          EOBRUN += r;
+        }
+        EOBRUN--;               /* this band is processed at this moment */
+        break;                  /* force end-of-band */
+      }
+    }
+  }
+
+  /* Completed MCU, so update state */
+  BITREAD_SAVE_STATE(cinfo, entropy->bitstate);
+  entropy->saved.EOBRUN = EOBRUN;       /* only part of saved state we need */
+  return TRUE;
+}
+
+
+/*
+ * Fast path for the above.  This is equivalent, but it uses the in-line
+ * bit buffer refill and Huffman lookahead from jdhuff.h, which do not handle
+ * markers.  If the MCU must be handed off to the slow path, it re-zeroes the
+ * coefficients that it output and returns FALSE without updating the
+ * permanent state.
+ */
+
+LOCAL(boolean)
+decode_mcu_AC_first_fast(j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
+{
+  phuff_entropy_ptr entropy = (phuff_entropy_ptr)cinfo->entropy;
+  int Se = cinfo->Se;
+  int Al = cinfo->Al;
+  register int s, k, r, l;
+  unsigned int EOBRUN = 0;
   JBLOCKROW block;
   BITREAD_STATE_VARS;
+  JOCTET *buffer;
   d_derived_tbl *tbl;
+  int num_newnz = 0;
+  int newnz_pos[DCTSIZE2];
+
+  /* Load up working state */
+  BITREAD_LOAD_STATE(cinfo, entropy->bitstate);
+  buffer = (JOCTET *)br_state.next_input_byte;
+  block = MCU_data[0];
+  tbl = entropy->ac_derived_tbl;
+
+  for (k = cinfo->Ss; k <= Se; k++) {
+    HUFF_DECODE_FAST(s, l, tbl, slow_decode_mcu);
+    r = s >> 4;
+    s &= 15;
+    if (s) {
+      k += r;
+      FILL_BIT_BUFFER_FAST
+      r = GET_BITS(s);
+      s = HUFF_EXTEND(r, s);
+      r = jpeg_natural_order[k];
+      (*block)[r] = (JCOEF)LEFT_SHIFT(s, Al);
+      newnz_pos[num_newnz++] = r;
+    } else {
+      if (r == 15) {
+        k += 15;
+      } else {
+        EOBRUN = 1 << r;
+        if (r) {
+          FILL_BIT_BUFFER_FAST
+          r = GET_BITS(r);
+          EOBRUN += r;
+        }
+        EOBRUN--;
+        break;
+      }
+    }
+  }
+
+  if (cinfo->unread_marker != 0) {
+slow_decode_mcu:
+    /* With corrupt data, the slow path might not assign them all again */
+    while (num_newnz > 0)
+      (*block)[newnz_pos[--num_newnz]] = 0;
+    cinfo->unread_marker = 0;
+    return FALSE;
+  }
+
+  /* Completed MCU, so update state */
+  br_state.bytes_in_buffer -= (buffer - br_state.next_input_byte);
+  br_state.next_input_byte = buffer;
+  BITREAD_SAVE_STATE(cinfo, entropy->bitstate);
+  entropy->saved.EOBRUN = EOBRUN;
+  return TRUE;
+}
+
+
+METHODDEF(boolean)
+decode_mcu_AC_first(j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
+{
+  phuff_entropy_ptr entropy = (phuff_entropy_ptr)cinfo->entropy;
+  int usefast = 1;
 
   /* Process restart marker if needed; may have to suspend */
   if (cinfo->restart_interval) {
     if (entropy->restarts_to_go == 0)
       if (!process_restart(cinfo))
         return FALSE;
+    /* The last MCU of a restart interval abuts the RSTn marker */
+    if (entropy->restarts_to_go == 1)
+      usefast = 0;
   }
 
+  if (cinfo->src->bytes_in_buffer < BUFSIZE || cinfo->unread_marker != 0)
+    usefast = 0;
+
   /* If we've run out of data, just leave the MCU set to zeroes.
    * This way, we return uniform gray for the remainder of the segment.
    */
   if (!entropy->pub.insufficient_data) {
 
-    /* Load up working state.
+    /* There is always only one block per MCU.
      * We can avoid loading/saving bitread state if in an EOB run.
      */
-    EOBRUN = entropy->saved.EOBRUN;     /* only part of saved state we need */
-
-    /* There is always only one block per MCU */
-
-    if (EOBRUN > 0)             /* if it's a band of zeroes... */
-      EOBRUN--;                 /* ...process it now (we do nothing) */
-    else {
-      BITREAD_LOAD_STATE(cinfo, entropy->bitstate);
-      block = MCU_data[0];
-      tbl = entropy->ac_derived_tbl;
-
-      for (k = cinfo->Ss; k <= Se; k++) {
-        HUFF_DECODE(s, br_state, tbl, return FALSE, label2);
-        r = s >> 4;
-        s &= 15;
-        if (s) {
-          k += r;
-          CHECK_BIT_BUFFER(br_state, s, return FALSE);
-          r = GET_BITS(s);
-          s = HUFF_EXTEND(r, s);
-          /* Scale and output coefficient in natural (dezigzagged) order */
-          (*block)[jpeg_natural_order[k]] = (JCOEF)LEFT_SHIFT(s, Al);
-        } else {
-          if (r == 15) {        /* ZRL */
-            k += 15;            /* skip 15 zeroes in band */
-          } else {              /* EOBr, run length is 2^r + appended bits */
-            EOBRUN = 1 << r;
-            if (r) {            /* EOBr, r > 0 */
-              CHECK_BIT_BUFFER(br_state, r, return FALSE);
-              r = GET_BITS(r);
-              EOBRUN += r;
-            }
-            EOBRUN--;           /* this band is processed at this moment */
-            break;              /* force end-of-band */
-          }
-        }
-      }
-
-      BITREAD_SAVE_STATE(cinfo, entropy->bitstate);
+    if (entropy->saved.EOBRUN > 0)      /* if it's a band of zeroes... */
+      entropy->saved.EOBRUN--;          /* ...process it now (we do nothing) */
+    else if (usefast) {
+      if (!decode_mcu_AC_first_fast(cinfo, MCU_data)) goto use_slow;
+    } else {
+use_slow:
+      if (!decode_mcu_AC_first_slow(cinfo, MCU_data)) return FALSE;
     }
 
-    /* Completed MCU, so update state */
-    entropy->saved.EOBRUN = EOBRUN;     /* only part of saved state we need */
   }
 
   /* Account for restart interval (no-op if not using restarts) */
@@ -505,8 +604,8 @@ decode_mcu_DC_refine(j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
  * MCU decoding for AC successive approximation refinement scan.
  */
 
-METHODDEF(boolean)
-decode_mcu_AC_refine(j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
+LOCAL(boolean)
+decode_mcu_AC_refine_slow(j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
 {
   phuff_entropy_ptr entropy = (phuff_entropy_ptr)cinfo->entropy;
   int Se = cinfo->Se;
@@ -521,125 +620,226 @@ decode_mcu_AC_refine(j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
   int num_newnz;
   int newnz_pos[DCTSIZE2];
 
-  /* Process restart marker if needed; may have to suspend */
-  if (cinfo->restart_interval) {
-    if (entropy->restarts_to_go == 0)
-      if (!process_restart(cinfo))
-        return FALSE;
-  }
+  /* Load up working state */
+  BITREAD_LOAD_STATE(cinfo, entropy->bitstate);
+  EOBRUN = entropy->saved.EOBRUN; /* only part of saved state we need */
 
-  /* If we've run out of data, don't modify the MCU.
-   */
-  if (!entropy->pub.insufficient_data) {
+  /* There is always only one block per MCU */
+  block = MCU_data[0];
+  tbl = entropy->ac_derived_tbl;
 
-    /* Load up working state */
-    BITREAD_LOAD_STATE(cinfo, entropy->bitstate);
-    EOBRUN = entropy->saved.EOBRUN; /* only part of saved state we need */
+  /* If we are forced to suspend, we must undo the assignments to any newly
+   * nonzero coefficients in the block, because otherwise we'd get confused
+   * next time about which coefficients were already nonzero.
+   * But we need not undo addition of bits to already-nonzero coefficients;
+   * instead, we can test the current bit to see if we already did it.
+   */
+  num_newnz = 0;
 
-    /* There is always only one block per MCU */
-    block = MCU_data[0];
-    tbl = entropy->ac_derived_tbl;
+  /* initialize coefficient loop counter to start of band */
+  k = cinfo->Ss;
 
-    /* If we are forced to suspend, we must undo the assignments to any newly
-     * nonzero coefficients in the block, because otherwise we'd get confused
-     * next time about which coefficients were already nonzero.
-     * But we need not undo addition of bits to already-nonzero coefficients;
-     * instead, we can test the current bit to see if we already did it.
-     */
-    num_newnz = 0;
-
-    /* initialize coefficient loop counter to start of band */
-    k = cinfo->Ss;
-
-    if (EOBRUN == 0) {
-      for (; k <= Se; k++) {
-        HUFF_DECODE(s, br_state, tbl, goto undoit, label3);
-        r = s >> 4;
-        s &= 15;
-        if (s) {
-          if (s != 1)           /* size of new coef should always be 1 */
-            WARNMS(cinfo, JWRN_HUFF_BAD_CODE);
-          CHECK_BIT_BUFFER(br_state, 1, goto undoit);
-          if (GET_BITS(1))
-            s = p1;             /* newly nonzero coef is positive */
-          else
-            s = m1;             /* newly nonzero coef is negative */
-        } else {
-          if (r != 15) {
-            EOBRUN = 1 << r;    /* EOBr, run length is 2^r + appended bits */
-            if (r) {
-              CHECK_BIT_BUFFER(br_state, r, goto undoit);
-              r = GET_BITS(r);
-              EOBRUN += r;
-            }
-            break;              /* rest of block is handled by EOB logic */
-          }
-          /* note s = 0 for processing ZRL */
-        }
-        /* Advance over already-nonzero coefs and r still-zero coefs,
-         * appending correction bits to the nonzeroes.  A correction bit is 1
-         * if the absolute value of the coefficient must be increased.
-         */
-        do {
-          thiscoef = *block + jpeg_natural_order[k];
-          if (*thiscoef != 0) {
-            CHECK_BIT_BUFFER(br_state, 1, goto undoit);
-            if (GET_BITS(1)) {
-              if ((*thiscoef & p1) == 0) { /* do nothing if already set it */
-                if (*thiscoef >= 0)
-                  *thiscoef += p1;
-                else
-                  *thiscoef += m1;
-              }
-            }
-          } else {
-            if (--r < 0)
-              break;            /* reached target zero coefficient */
+  if (EOBRUN == 0) {
+    for (; k <= Se; k++) {
+      HUFF_DECODE(s, br_state, tbl, goto undoit, label3);
+      r = s >> 4;
+      s &= 15;
+      if (s) {
+        if (s != 1)             /* size of new coef should always be 1 */
+          WARNMS(cinfo, JWRN_HUFF_BAD_CODE);
+        CHECK_BIT_BUFFER(br_state, 1, goto undoit);
+        if (GET_BITS(1))
+          s = p1;               /* newly nonzero coef is positive */
+        else
+          s = m1;               /* newly nonzero coef is negative */
+      } else {
+        if (r != 15) {
+          EOBRUN = 1 << r;      /* EOBr, run length is 2^r + appended bits */
+          if (r) {
+            CHECK_BIT_BUFFER(br_state, r, goto undoit);
+            r = GET_BITS(r);
+            EOBRUN += r;
           }
-          k++;
-        } while (k <= Se);
-        if (s) {
-          int pos = jpeg_natural_order[k];
-          /* Output newly nonzero coefficient */
-          (*block)[pos] = (JCOEF)s;
-          /* Remember its position in case we have to suspend */
-          newnz_pos[num_newnz++] = pos;
+          break;                /* rest of block is handled by EOB logic */
         }
+        /* note s = 0 for processing ZRL */
       }
-    }
-
-    if (EOBRUN > 0) {
-      /* Scan any remaining coefficient positions after the end-of-band
-       * (the last newly nonzero coefficient, if any).  Append a correction
-       * bit to each already-nonzero coefficient.  A correction bit is 1
+      /* Advance over already-nonzero coefs and r still-zero coefs,
+       * appending correction bits to the nonzeroes.  A correction bit is 1
        * if the absolute value of the coefficient must be increased.
        */
-      for (; k <= Se; k++) {
+      do {
         thiscoef = *block + jpeg_natural_order[k];
         if (*thiscoef != 0) {
           CHECK_BIT_BUFFER(br_state, 1, goto undoit);
           if (GET_BITS(1)) {
-            if ((*thiscoef & p1) == 0) { /* do nothing if already changed it */
+            if ((*thiscoef & p1) == 0) { /* do nothing if already set it */
               if (*thiscoef >= 0)
                 *thiscoef += p1;
               else
                 *thiscoef += m1;
             }
           }
+        } else {
+          if (--r < 0)
+            break;              /* reached target zero coefficient */
         }
+        k++;
+      } while (k <= Se);
+      if (s) {
+        int pos = jpeg_natural_order[k];
+        /* Output newly nonzero coefficient */
+        (*block)[pos] = (JCOEF)s;
+        /* Remember its position in case we have to suspend */
+        newnz_pos[num_newnz++] = pos;
       }
-      /* Count one block completed in EOB run */
-      EOBRUN--;
     }
+  }
 
-    /* Completed MCU, so update state */
-    BITREAD_SAVE_STATE(cinfo, entropy->bitstate);
-    entropy->saved.EOBRUN = EOBRUN; /* only part of saved state we need */
+  if (EOBRUN > 0) {
+    /* Scan any remaining coefficient positions after the end-of-band
+     * (the last newly nonzero coefficient, if any).  Append a correction
+     * bit to each already-nonzero coefficient.  A correction bit is 1
+     * if the absolute value of the coefficient must be increased.
+     */
+    for (; k <= Se; k++) {
+      thiscoef = *block + jpeg_natural_order[k];
+      if (*thiscoef != 0) {
+        CHECK_BIT_BUFFER(br_state, 1, goto undoit);
+        if (GET_BITS(1)) {
+          if ((*thiscoef & p1) == 0) { /* do nothing if already changed it */
+            if (*thiscoef >= 0)
+              *thiscoef += p1;
+            else
+              *thiscoef += m1;
+          }
+        }
+      }
+    }
+    /* Count one block completed in EOB run */
+    EOBRUN--;
   }
 
-  /* Account for restart interval (no-op if not using restarts) */
-  entropy->restarts_to_go--;
+  /* Completed MCU, so update state */
+  BITREAD_SAVE_STATE(cinfo, entropy->bitstate);
+  entropy->saved.EOBRUN = EOBRUN; /* only part of saved state we need */
+  return TRUE;
+
+undoit:
+  /* Re-zero any output coefficients that we made newly nonzero */
+  while (num_newnz > 0)
+    (*block)[newnz_pos[--num_newnz]] = 0;
+
+  return FALSE;
+}
+
+
+/*
+ * Fast path for the above, using the in-line bit buffer refill and Huffman
+ * lookahead from jdhuff.h.  If the MCU must be handed off to the slow path,
+ * the newly nonzero coefficients are re-zeroed just as they are when the slow
+ * path suspends.  Corrections to already-nonzero coefficients are left in
+ * place, since the slow path will see that they have already been applied.
+ */
+
+/* Correction bits are close to random, so the fast path applies them without
+ * branching on their values.  This is equivalent to the test in the slow path.
+ */
+
+#define APPLY_CORRECTION_BIT(coefptr) { \
+  int bit = GET_BITS(1) & ((*(coefptr) & p1) == 0); \
+  *(coefptr) += (JCOEF)((*(coefptr) >= 0 ? p1 : m1) & -bit); \
+}
+
+LOCAL(boolean)
+decode_mcu_AC_refine_fast(j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
+{
+  phuff_entropy_ptr entropy = (phuff_entropy_ptr)cinfo->entropy;
+  int Se = cinfo->Se;
+  int p1 = 1 << cinfo->Al;        /* 1 in the bit position being coded */
+  int m1 = (NEG_1) << cinfo->Al;  /* -1 in the bit position being coded */
+  register int s, k, r, l;
+  unsigned int EOBRUN;
+  JBLOCKROW block;
+  JCOEFPTR thiscoef;
+  BITREAD_STATE_VARS;
+  JOCTET *buffer;
+  d_derived_tbl *tbl;
+  int num_newnz;
+  int newnz_pos[DCTSIZE2];
+
+  /* Load up working state */
+  BITREAD_LOAD_STATE(cinfo, entropy->bitstate);
+  buffer = (JOCTET *)br_state.next_input_byte;
+  EOBRUN = entropy->saved.EOBRUN;
+  block = MCU_data[0];
+  tbl = entropy->ac_derived_tbl;
+  num_newnz = 0;
+  k = cinfo->Ss;
+
+  if (EOBRUN == 0) {
+    for (; k <= Se; k++) {
+      HUFF_DECODE_FAST(s, l, tbl, undoit);
+      r = s >> 4;
+      s &= 15;
+      if (s) {
+        /* Let the slow path issue the warning for a bad coefficient size */
+        if (s != 1)
+          goto undoit;
+        FILL_BIT_BUFFER_FAST
+        if (GET_BITS(1))
+          s = p1;
+        else
+          s = m1;
+      } else {
+        if (r != 15) {
+          EOBRUN = 1 << r;
+          if (r) {
+            FILL_BIT_BUFFER_FAST
+            r = GET_BITS(r);
+            EOBRUN += r;
+          }
+          break;
+        }
+      }
+      do {
+        thiscoef = *block + jpeg_natural_order[k];
+        if (*thiscoef != 0) {
+          FILL_BIT_BUFFER_FAST
+          APPLY_CORRECTION_BIT(thiscoef);
+        } else {
+          if (--r < 0)
+            break;
+        }
+        k++;
+      } while (k <= Se);
+      if (s) {
+        int pos = jpeg_natural_order[k];
+        (*block)[pos] = (JCOEF)s;
+        newnz_pos[num_newnz++] = pos;
+      }
+    }
+  }
+
+  if (EOBRUN > 0) {
+    for (; k <= Se; k++) {
+      thiscoef = *block + jpeg_natural_order[k];
+      if (*thiscoef != 0) {
+        FILL_BIT_BUFFER_FAST
+        APPLY_CORRECTION_BIT(thiscoef);
+      }
+    }
+    EOBRUN--;
+  }
 
+  if (cinfo->unread_marker != 0)
+    goto undoit;
+
+  /* Completed MCU, so update state */
+  br_state.bytes_in_buffer -= (buffer - br_state.next_input_byte);
+  br_state.next_input_byte = buffer;
+  BITREAD_SAVE_STATE(cinfo, entropy->bitstate);
+  entropy->saved.EOBRUN = EOBRUN;
   return TRUE;
 
 undoit:
@@ -647,10 +847,50 @@ undoit:
   while (num_newnz > 0)
     (*block)[newnz_pos[--num_newnz]] = 0;
 
+  cinfo->unread_marker = 0;
   return FALSE;
 }
 
 
+METHODDEF(boolean)
+decode_mcu_AC_refine(j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
+{
+  phuff_entropy_ptr entropy = (phuff_entropy_ptr)cinfo->entropy;
+  int usefast = 1;
+
+  /* Process restart marker if needed; may have to suspend */
+  if (cinfo->restart_interval) {
+    if (entropy->restarts_to_go == 0)
+      if (!process_restart(cinfo))
+        return FALSE;
+    /* The last MCU of a restart interval abuts the RSTn marker */
+    if (entropy->restarts_to_go == 1)
+      usefast = 0;
+  }
+
+  if (cinfo->src->bytes_in_buffer < BUFSIZE || cinfo->unread_marker != 0)
+    usefast = 0;
+
+  /* If we've run out of data, don't modify the MCU.
+   */
+  if (!entropy->pub.insufficient_data) {
+
+    if (usefast) {
+      if (!decode_mcu_AC_refine_fast(cinfo, MCU_data)) goto use_slow;
+    } else {
+use_slow:
+      if (!decode_mcu_AC_refine_slow(cinfo, MCU_data)) return FALSE;
+    }
+
+  }
+
+  /* Account for restart interval (no-op if not using restarts) */
+  entropy->restarts_to_go--;
+
+  return TRUE;
+}
+
+
 /*
  * Module initialization routine for progressive Huffman entropy decoding.
  */
@@ -667,6 +907,8 @@ jinit_phuff_decoder(j_decompress_ptr cinfo)
                                 sizeof(phuff_entropy_decoder));
   cinfo->entropy = (struct jpeg_entropy_decoder *)entropy;
   entropy->pub.start_pass = start_pass_phuff_decoder;
+  entropy->pub.skip_mcus = NULL;
+  entropy->pub.last_nonzero = NULL;
 
   /* Mark derived tables unallocated */
   for (i = 0; i < NUM_HUFF_TBLS; i++) {
@@ -498,7 +498,21 @@ jinit_upsampler(j_decompress_ptr cinfo)
       }
     } else if ((h_out_group % h_in_group) == 0 &&
                (v_out_group % v_in_group) == 0) {
-      /* Generic integral-factors upsampling method */
+      /* Generic integral-factors upsampling method, with SIMD versions for
+       * some of the less common factors
+       */
+      int h_expand = h_out_group / h_in_group;
+      int v_expand = v_out_group / v_in_group;
+
+      if (h_expand == 4 && v_expand == 1 && jsimd_can_h4v1_upsample())
+        upsample->methods[ci] = jsimd_h4v1_upsample;
+      else if (h_expand == 4 && v_expand == 2 && jsimd_can_h4v2_upsample())
+        upsample->methods[ci] = jsimd_h4v2_upsample;
+      else if (h_expand == 1 && v_expand == 2 && jsimd_can_h1v2_upsample())
+        upsample->methods[ci] = jsimd_h1v2_upsample;
+      else if (h_expand == 2 && v_expand == 4 && jsimd_can_h2v4_upsample())
+        upsample->methods[ci] = jsimd_h2v4_upsample;
+      else
 #if defined(__mips__)
       if (jsimd_can_int_upsample())
         upsample->methods[ci] = jsimd_int_upsample;
@@ -207,6 +207,8 @@ JMESSAGE(JWRN_ARITH_BAD_CODE, "Corrupt JPEG data: bad arithmetic code")
 #endif
 #endif
 JMESSAGE(JWRN_BOGUS_ICC, "Corrupt JPEG data: bad ICC marker")
+JMESSAGE(JWRN_BAD_CHECKPOINTS,
+         "Entropy checkpoint index does not match this image; ignored")
 
 #ifdef JMAKE_ENUM_LIST
 
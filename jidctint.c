@@ -412,6 +412,354 @@ jpeg_idct_islow(j_decompress_ptr cinfo, jpeg_component_info *compptr,
   }
 }
 
+
+/*
+ * The following routines produce the same output as jpeg_idct_islow() for
+ * blocks whose nonzero coefficients all lie within the top left corner of the
+ * block, which the entropy decoder can tell from the zigzag index of the last
+ * nonzero coefficient.  They are jpeg_idct_islow() with the terms that
+ * involve the other coefficients left out, and the integer arithmetic is
+ * otherwise the same, so the results are identical.
+ */
+
+/*
+ * Perform dequantization and inverse DCT on a block of coefficients in which
+ * only the DC coefficient can be nonzero.  This is the case in which both
+ * passes of jpeg_idct_islow() take their short cut for all-zero AC terms.
+ */
+
+GLOBAL(void)
+jpeg_idct_islow_dc(j_decompress_ptr cinfo, jpeg_component_info *compptr,
+                   JCOEFPTR coef_block, JSAMPARRAY output_buf,
+                   JDIMENSION output_col)
+{
+  ISLOW_MULT_TYPE *quantptr = (ISLOW_MULT_TYPE *)compptr->dct_table;
+  JSAMPROW outptr;
+  JSAMPLE *range_limit = IDCT_range_limit(cinfo);
+  JSAMPLE outval;
+  int dcval, ctr;
+  SHIFT_TEMPS
+
+  dcval = LEFT_SHIFT(DEQUANTIZE(coef_block[0], quantptr[0]), PASS1_BITS);
+  outval = range_limit[(int)DESCALE((JLONG)dcval, PASS1_BITS + 3) &
+                       RANGE_MASK];
+
+  for (ctr = 0; ctr < DCTSIZE; ctr++) {
+    outptr = output_buf[ctr] + output_col;
+    outptr[0] = outval;
+    outptr[1] = outval;
+    outptr[2] = outval;
+    outptr[3] = outval;
+    outptr[4] = outval;
+    outptr[5] = outval;
+    outptr[6] = outval;
+    outptr[7] = outval;
+  }
+}
+
+
+/*
+ * Perform dequantization and inverse DCT on a block of coefficients in which
+ * only the top left 2x2 coefficients can be nonzero.
+ */
+
+GLOBAL(void)
+jpeg_idct_islow_corner2(j_decompress_ptr cinfo, jpeg_component_info *compptr,
+                        JCOEFPTR coef_block, JSAMPARRAY output_buf,
+                        JDIMENSION output_col)
+{
+  JLONG tmp0, tmp1, tmp2, tmp3;
+  JLONG tmp10, tmp11, tmp12, tmp13;
+  JLONG z1, z4, z5;
+  JCOEFPTR inptr;
+  ISLOW_MULT_TYPE *quantptr;
+  int *wsptr;
+  JSAMPROW outptr;
+  JSAMPLE *range_limit = IDCT_range_limit(cinfo);
+  int ctr;
+  int workspace[DCTSIZE * 2];   /* buffers data between passes */
+  SHIFT_TEMPS
+
+  /* Pass 1: process columns 0-1 from input, store into work array. */
+  /* Columns 2-7 of the work array would be all zero. */
+
+  inptr = coef_block;
+  quantptr = (ISLOW_MULT_TYPE *)compptr->dct_table;
+  wsptr = workspace;
+  for (ctr = 2; ctr > 0; ctr--) {
+    /* Even part: y2, y4 and y6 are zero. */
+
+    tmp10 = tmp11 = tmp12 = tmp13 =
+      LEFT_SHIFT(DEQUANTIZE(inptr[DCTSIZE * 0], quantptr[DCTSIZE * 0]),
+                 CONST_BITS);
+
+    /* Odd part: y3, y5 and y7 are zero. */
+
+    tmp3 = DEQUANTIZE(inptr[DCTSIZE * 1], quantptr[DCTSIZE * 1]);
+
+    z5 = MULTIPLY(tmp3, FIX_1_175875602); /* sqrt(2) * c3 */
+    z1 = MULTIPLY(tmp3, -FIX_0_899976223); /* sqrt(2) * ( c7-c3) */
+    z4 = MULTIPLY(tmp3, -FIX_0_390180644) + z5; /* sqrt(2) * ( c5-c3) */
+
+    tmp0 = z1 + z5;
+    tmp1 = z4;
+    tmp2 = z5;
+    tmp3 = MULTIPLY(tmp3, FIX_1_501321110) + z1 + z4;
+
+    /* Final output stage: inputs are tmp10..tmp13, tmp0..tmp3 */
+
+    wsptr[2 * 0] = (int)DESCALE(tmp10 + tmp3, CONST_BITS - PASS1_BITS);
+    wsptr[2 * 7] = (int)DESCALE(tmp10 - tmp3, CONST_BITS - PASS1_BITS);
+    wsptr[2 * 1] = (int)DESCALE(tmp11 + tmp2, CONST_BITS - PASS1_BITS);
+    wsptr[2 * 6] = (int)DESCALE(tmp11 - tmp2, CONST_BITS - PASS1_BITS);
+    wsptr[2 * 2] = (int)DESCALE(tmp12 + tmp1, CONST_BITS - PASS1_BITS);
+    wsptr[2 * 5] = (int)DESCALE(tmp12 - tmp1, CONST_BITS - PASS1_BITS);
+    wsptr[2 * 3] = (int)DESCALE(tmp13 + tmp0, CONST_BITS - PASS1_BITS);
+    wsptr[2 * 4] = (int)DESCALE(tmp13 - tmp0, CONST_BITS - PASS1_BITS);
+
+    inptr++;                    /* advance pointers to next column */
+    quantptr++;
+    wsptr++;
+  }
+
+  /* Pass 2: process rows from work array, store into output array. */
+
+  wsptr = workspace;
+  for (ctr = 0; ctr < DCTSIZE; ctr++) {
+    outptr = output_buf[ctr] + output_col;
+
+#ifndef NO_ZERO_ROW_TEST
+    if (wsptr[1] == 0) {
+      /* AC terms all zero */
+      JSAMPLE dcval = range_limit[(int)DESCALE((JLONG)wsptr[0],
+                                               PASS1_BITS + 3) & RANGE_MASK];
+
+      outptr[0] = dcval;
+      outptr[1] = dcval;
+      outptr[2] = dcval;
+      outptr[3] = dcval;
+      outptr[4] = dcval;
+      outptr[5] = dcval;
+      outptr[6] = dcval;
+      outptr[7] = dcval;
+
+      wsptr += 2;               /* advance pointer to next row */
+      continue;
+    }
+#endif
+
+    /* Even part */
+
+    tmp10 = tmp11 = tmp12 = tmp13 = LEFT_SHIFT((JLONG)wsptr[0], CONST_BITS);
+
+    /* Odd part */
+
+    tmp3 = (JLONG)wsptr[1];
+
+    z5 = MULTIPLY(tmp3, FIX_1_175875602);
+    z1 = MULTIPLY(tmp3, -FIX_0_899976223);
+    z4 = MULTIPLY(tmp3, -FIX_0_390180644) + z5;
+
+    tmp0 = z1 + z5;
+    tmp1 = z4;
+    tmp2 = z5;
+    tmp3 = MULTIPLY(tmp3, FIX_1_501321110) + z1 + z4;
+
+    /* Final output stage: inputs are tmp10..tmp13, tmp0..tmp3 */
+
+    outptr[0] = range_limit[(int)DESCALE(tmp10 + tmp3,
+                                         CONST_BITS + PASS1_BITS + 3) &
+                            RANGE_MASK];
+    outptr[7] = range_limit[(int)DESCALE(tmp10 - tmp3,
+                                         CONST_BITS + PASS1_BITS + 3) &
+                            RANGE_MASK];
+    outptr[1] = range_limit[(int)DESCALE(tmp11 + tmp2,
+                                         CONST_BITS + PASS1_BITS + 3) &
+                            RANGE_MASK];
+    outptr[6] = range_limit[(int)DESCALE(tmp11 - tmp2,
+                                         CONST_BITS + PASS1_BITS + 3) &
+                            RANGE_MASK];
+    outptr[2] = range_limit[(int)DESCALE(tmp12 + tmp1,
+                                         CONST_BITS + PASS1_BITS + 3) &
+                            RANGE_MASK];
+    outptr[5] = range_limit[(int)DESCALE(tmp12 - tmp1,
+                                         CONST_BITS + PASS1_BITS + 3) &
+                            RANGE_MASK];
+    outptr[3] = range_limit[(int)DESCALE(tmp13 + tmp0,
+                                         CONST_BITS + PASS1_BITS + 3) &
+                            RANGE_MASK];
+    outptr[4] = range_limit[(int)DESCALE(tmp13 - tmp0,
+                                         CONST_BITS + PASS1_BITS + 3) &
+                            RANGE_MASK];
+
+    wsptr += 2;                 /* advance pointer to next row */
+  }
+}
+
+
+/*
+ * Perform dequantization and inverse DCT on a block of coefficients in which
+ * only the top left 4x4 coefficients can be nonzero.
+ */
+
+GLOBAL(void)
+jpeg_idct_islow_corner4(j_decompress_ptr cinfo, jpeg_component_info *compptr,
+                        JCOEFPTR coef_block, JSAMPARRAY output_buf,
+                        JDIMENSION output_col)
+{
+  JLONG tmp0, tmp1, tmp2, tmp3;
+  JLONG tmp10, tmp11, tmp12, tmp13;
+  JLONG z1, z2, z3, z4, z5;
+  JCOEFPTR inptr;
+  ISLOW_MULT_TYPE *quantptr;
+  int *wsptr;
+  JSAMPROW outptr;
+  JSAMPLE *range_limit = IDCT_range_limit(cinfo);
+  int ctr;
+  int workspace[DCTSIZE * 4];   /* buffers data between passes */
+  SHIFT_TEMPS
+
+  /* Pass 1: process columns 0-3 from input, store into work array. */
+  /* Columns 4-7 of the work array would be all zero. */
+
+  inptr = coef_block;
+  quantptr = (ISLOW_MULT_TYPE *)compptr->dct_table;
+  wsptr = workspace;
+  for (ctr = 4; ctr > 0; ctr--) {
+    /* Even part: y4 and y6 are zero. */
+
+    z2 = DEQUANTIZE(inptr[DCTSIZE * 2], quantptr[DCTSIZE * 2]);
+
+    tmp2 = MULTIPLY(z2, FIX_0_541196100);
+    tmp3 = tmp2 + MULTIPLY(z2, FIX_0_765366865);
+
+    tmp0 = LEFT_SHIFT(DEQUANTIZE(inptr[DCTSIZE * 0], quantptr[DCTSIZE * 0]),
+                      CONST_BITS);
+
+    tmp10 = tmp0 + tmp3;
+    tmp13 = tmp0 - tmp3;
+    tmp11 = tmp0 + tmp2;
+    tmp12 = tmp0 - tmp2;
+
+    /* Odd part: y5 and y7 are zero. */
+
+    tmp2 = DEQUANTIZE(inptr[DCTSIZE * 3], quantptr[DCTSIZE * 3]);
+    tmp3 = DEQUANTIZE(inptr[DCTSIZE * 1], quantptr[DCTSIZE * 1]);
+
+    z5 = MULTIPLY(tmp2 + tmp3, FIX_1_175875602); /* sqrt(2) * c3 */
+    z1 = MULTIPLY(tmp3, -FIX_0_899976223); /* sqrt(2) * ( c7-c3) */
+    z2 = MULTIPLY(tmp2, -FIX_2_562915447); /* sqrt(2) * (-c1-c3) */
+    z3 = MULTIPLY(tmp2, -FIX_1_961570560) + z5; /* sqrt(2) * (-c3-c5) */
+    z4 = MULTIPLY(tmp3, -FIX_0_390180644) + z5; /* sqrt(2) * ( c5-c3) */
+
+    tmp0 = z1 + z3;
+    tmp1 = z2 + z4;
+    tmp2 = MULTIPLY(tmp2, FIX_3_072711026) + z2 + z3;
+    tmp3 = MULTIPLY(tmp3, FIX_1_501321110) + z1 + z4;
+
+    /* Final output stage: inputs are tmp10..tmp13, tmp0..tmp3 */
+
+    wsptr[4 * 0] = (int)DESCALE(tmp10 + tmp3, CONST_BITS - PASS1_BITS);
+    wsptr[4 * 7] = (int)DESCALE(tmp10 - tmp3, CONST_BITS - PASS1_BITS);
+    wsptr[4 * 1] = (int)DESCALE(tmp11 + tmp2, CONST_BITS - PASS1_BITS);
+    wsptr[4 * 6] = (int)DESCALE(tmp11 - tmp2, CONST_BITS - PASS1_BITS);
+    wsptr[4 * 2] = (int)DESCALE(tmp12 + tmp1, CONST_BITS - PASS1_BITS);
+    wsptr[4 * 5] = (int)DESCALE(tmp12 - tmp1, CONST_BITS - PASS1_BITS);
+    wsptr[4 * 3] = (int)DESCALE(tmp13 + tmp0, CONST_BITS - PASS1_BITS);
+    wsptr[4 * 4] = (int)DESCALE(tmp13 - tmp0, CONST_BITS - PASS1_BITS);
+
+    inptr++;                    /* advance pointers to next column */
+    quantptr++;
+    wsptr++;
+  }
+
+  /* Pass 2: process rows from work array, store into output array. */
+
+  wsptr = workspace;
+  for (ctr = 0; ctr < DCTSIZE; ctr++) {
+    outptr = output_buf[ctr] + output_col;
+
+#ifndef NO_ZERO_ROW_TEST
+    if (wsptr[1] == 0 && wsptr[2] == 0 && wsptr[3] == 0) {
+      /* AC terms all zero */
+      JSAMPLE dcval = range_limit[(int)DESCALE((JLONG)wsptr[0],
+                                               PASS1_BITS + 3) & RANGE_MASK];
+
+      outptr[0] = dcval;
+      outptr[1] = dcval;
+      outptr[2] = dcval;
+      outptr[3] = dcval;
+      outptr[4] = dcval;
+      outptr[5] = dcval;
+      outptr[6] = dcval;
+      outptr[7] = dcval;
+
+      wsptr += 4;               /* advance pointer to next row */
+      continue;
+    }
+#endif
+
+    /* Even part */
+
+    z2 = (JLONG)wsptr[2];
+
+    tmp2 = MULTIPLY(z2, FIX_0_541196100);
+    tmp3 = tmp2 + MULTIPLY(z2, FIX_0_765366865);
+
+    tmp0 = LEFT_SHIFT((JLONG)wsptr[0], CONST_BITS);
+
+    tmp10 = tmp0 + tmp3;
+    tmp13 = tmp0 - tmp3;
+    tmp11 = tmp0 + tmp2;
+    tmp12 = tmp0 - tmp2;
+
+    /* Odd part */
+
+    tmp2 = (JLONG)wsptr[3];
+    tmp3 = (JLONG)wsptr[1];
+
+    z5 = MULTIPLY(tmp2 + tmp3, FIX_1_175875602);
+    z1 = MULTIPLY(tmp3, -FIX_0_899976223);
+    z2 = MULTIPLY(tmp2, -FIX_2_562915447);
+    z3 = MULTIPLY(tmp2, -FIX_1_961570560) + z5;
+    z4 = MULTIPLY(tmp3, -FIX_0_390180644) + z5;
+
+    tmp0 = z1 + z3;
+    tmp1 = z2 + z4;
+    tmp2 = MULTIPLY(tmp2, FIX_3_072711026) + z2 + z3;
+    tmp3 = MULTIPLY(tmp3, FIX_1_501321110) + z1 + z4;
+
+    /* Final output stage: inputs are tmp10..tmp13, tmp0..tmp3 */
+
+    outptr[0] = range_limit[(int)DESCALE(tmp10 + tmp3,
+                                         CONST_BITS + PASS1_BITS + 3) &
+                            RANGE_MASK];
+    outptr[7] = range_limit[(int)DESCALE(tmp10 - tmp3,
+                                         CONST_BITS + PASS1_BITS + 3) &
+                            RANGE_MASK];
+    outptr[1] = range_limit[(int)DESCALE(tmp11 + tmp2,
+                                         CONST_BITS + PASS1_BITS + 3) &
+                            RANGE_MASK];
+    outptr[6] = range_limit[(int)DESCALE(tmp11 - tmp2,
+                                         CONST_BITS + PASS1_BITS + 3) &
+                            RANGE_MASK];
+    outptr[2] = range_limit[(int)DESCALE(tmp12 + tmp1,
+                                         CONST_BITS + PASS1_BITS + 3) &
+                            RANGE_MASK];
+    outptr[5] = range_limit[(int)DESCALE(tmp12 - tmp1,
+                                         CONST_BITS + PASS1_BITS + 3) &
+                            RANGE_MASK];
+    outptr[3] = range_limit[(int)DESCALE(tmp13 + tmp0,
+                                         CONST_BITS + PASS1_BITS + 3) &
+                            RANGE_MASK];
+    outptr[4] = range_limit[(int)DESCALE(tmp13 - tmp0,
+                                         CONST_BITS + PASS1_BITS + 3) &
+                            RANGE_MASK];
+
+    wsptr += 4;                 /* advance pointer to next row */
+  }
+}
+
 #ifdef IDCT_SCALING_SUPPORTED
 
 
@@ -67,6 +67,14 @@ struct jpeg_comp_master {
   /* State variables made visible to other modules */
   boolean call_pass_startup;    /* True if pass_startup must be called */
   boolean is_last_pass;         /* True during last pass */
+
+  /* Multi-threaded encoding (see jcmaster.c and jchuff.c) */
+  int num_scan_threads;         /* max # of threads to use */
+  void (*encode_scans) (j_compress_ptr cinfo);
+
+  /* Sampled Huffman optimization (see jcmaster.c) */
+  JDIMENSION sample_iMCU_rows;  /* # of iMCU rows in the sample, or 0 */
+  void (*finish_sample) (j_compress_ptr cinfo);
 };
 
 /* Main buffer control (downsampled-data buffer) */
@@ -158,6 +166,14 @@ struct jpeg_decomp_master {
   JDIMENSION first_MCU_col[MAX_COMPONENTS];
   JDIMENSION last_MCU_col[MAX_COMPONENTS];
   boolean jinit_upsampler_no_alloc;
+
+  /* Entropy checkpoint index parameters (see jdhuff.c) */
+  boolean save_checkpoints;      /* TRUE=save a checkpoint index */
+  JDIMENSION checkpoint_interval; /* # of MCUs between checkpoints, or 0 */
+  JOCTET *checkpoint_data;      /* serialized index to use, or NULL */
+  size_t checkpoint_data_len;
+  jpeg_mcu_position *checkpoint_positions; /* unserialized index, or NULL */
+  JDIMENSION num_checkpoint_positions;
 };
 
 /* Input control module */
@@ -223,6 +239,13 @@ struct jpeg_marker_reader {
 struct jpeg_entropy_decoder {
   void (*start_pass) (j_decompress_ptr cinfo);
   boolean (*decode_mcu) (j_decompress_ptr cinfo, JBLOCKROW *MCU_data);
+  /* Skip MCUs using an entropy checkpoint index; NULL if none is loaded */
+  void (*skip_mcus) (j_decompress_ptr cinfo, JDIMENSION num_mcus);
+  /* Zigzag index of the last nonzero coefficient of each block of the MCU
+   * most recently decoded (0 if only the DC coefficient can be nonzero), or
+   * NULL if the entropy decoder does not keep track of it
+   */
+  int *last_nonzero;
 
   /* This is here to share code between baseline and progressive decoders; */
   /* other modules probably should not use it */
@@ -235,11 +258,28 @@ typedef void (*inverse_DCT_method_ptr) (j_decompress_ptr cinfo,
                                         JCOEFPTR coef_block,
                                         JSAMPARRAY output_buf,
                                         JDIMENSION output_col);
+/* Inverse DCT of a horizontal run of blocks, which are contiguous in
+ * coef_blocks and produce contiguous output columns starting at output_col.
+ */
+typedef void (*inverse_DCT_blocks_method_ptr) (j_decompress_ptr cinfo,
+                                               jpeg_component_info *compptr,
+                                               JCOEFPTR coef_blocks,
+                                               JSAMPARRAY output_buf,
+                                               JDIMENSION output_col,
+                                               JDIMENSION num_blocks);
 
 struct jpeg_inverse_dct {
   void (*start_pass) (j_decompress_ptr cinfo);
   /* It is useful to allow each component to have a separate IDCT method. */
   inverse_DCT_method_ptr inverse_DCT[MAX_COMPONENTS];
+  /* Optional method for runs of blocks; NULL if not available */
+  inverse_DCT_blocks_method_ptr inverse_DCT_blocks[MAX_COMPONENTS];
+  /* Optional methods for blocks whose nonzero coefficients all lie within
+   * the top left 1x1, 2x2 or 4x4 corner (those whose last nonzero
+   * coefficient in zigzag order is at index 0, 2 or 9 or below); NULL if not
+   * available
+   */
+  inverse_DCT_method_ptr inverse_DCT_sparse[MAX_COMPONENTS][3];
 };
 
 /* Upsampling (note that upsampler must also call color converter) */
@@ -340,6 +380,12 @@ EXTERN(void) jinit_merged_upsampler(j_decompress_ptr cinfo);
 /* Memory manager initialization */
 EXTERN(void) jinit_memory_mgr(j_common_ptr cinfo);
 
+/* Coefficient controller copy for multi-threaded scan encoding */
+EXTERN(void) jcopy_c_coef_controller(j_compress_ptr cinfo);
+
+/* Data source query in jdatasrc.c */
+EXTERN(boolean) jpeg_src_in_memory(j_decompress_ptr cinfo);
+
 /* Utility routines in jutils.c */
 EXTERN(long) jdiv_round_up(long a, long b);
 EXTERN(long) jround_up(long a, long b);
@@ -984,6 +984,13 @@ EXTERN(void) jpeg_write_icc_profile(j_compress_ptr cinfo,
                                     const JOCTET *icc_data_ptr,
                                     unsigned int icc_data_len);
 
+/* Encode buffered scans on several threads.  See libjpeg.txt. */
+EXTERN(void) jpeg_set_scan_threads(j_compress_ptr cinfo, int num_threads);
+
+/* Optimize Huffman tables from a sample of the image.  See libjpeg.txt. */
+EXTERN(void) jpeg_set_huffman_sample(j_compress_ptr cinfo,
+                                     JDIMENSION num_lines);
+
 
 /* Decompression startup: read start of JPEG datastream to see what's there */
 EXTERN(int) jpeg_read_header(j_decompress_ptr cinfo, boolean require_image);
@@ -1071,6 +1078,31 @@ EXTERN(boolean) jpeg_read_icc_profile(j_decompress_ptr cinfo,
                                       JOCTET **icc_data_ptr,
                                       unsigned int *icc_data_len);
 
+/* Entropy checkpoint index.  See libjpeg.txt for usage information. */
+EXTERN(void) jpeg_save_checkpoints(j_decompress_ptr cinfo,
+                                   JDIMENSION mcu_interval);
+EXTERN(boolean) jpeg_get_checkpoints(j_decompress_ptr cinfo,
+                                     JOCTET **data_ptr,
+                                     unsigned long *data_len);
+EXTERN(void) jpeg_use_checkpoints(j_decompress_ptr cinfo, const JOCTET *data,
+                                  unsigned long data_len);
+
+/* Speculative entropy decoding.  See libjpeg.txt for usage information. */
+typedef struct {
+  JDIMENSION mcu_index;         /* index of MCU within scan */
+  size_t byte_offset;           /* offset of data byte holding next bit */
+  int bit_index;                /* # of bits of that byte already consumed */
+  int last_dc_val[MAX_COMPS_IN_SCAN]; /* DC predictions */
+} jpeg_mcu_position;
+
+EXTERN(boolean) jpeg_start_speculative(j_decompress_ptr cinfo,
+                                       size_t byte_offset);
+EXTERN(boolean) jpeg_speculate_mcu(j_decompress_ptr cinfo,
+                                   jpeg_mcu_position *pos);
+EXTERN(void) jpeg_use_mcu_positions(j_decompress_ptr cinfo,
+                                    const jpeg_mcu_position *positions,
+                                    JDIMENSION num_positions);
+
 
 /* These marker codes are exported since applications and data source modules
  * are likely to want to use them.
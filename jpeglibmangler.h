@@ -19,6 +19,9 @@
 #define jpeg_idct_islow chromium_jpeg_idct_islow
 #define jpeg_idct_ifast chromium_jpeg_idct_ifast
 #define jpeg_idct_float chromium_jpeg_idct_float
+#define jpeg_idct_islow_dc chromium_jpeg_idct_islow_dc
+#define jpeg_idct_islow_corner2 chromium_jpeg_idct_islow_corner2
+#define jpeg_idct_islow_corner4 chromium_jpeg_idct_islow_corner4
 #define jpeg_idct_16x16 chromium_jpeg_idct_16x16
 #define jpeg_idct_15x15 chromium_jpeg_idct_15x15
 #define jpeg_idct_14x14 chromium_jpeg_idct_14x14
@@ -60,11 +63,15 @@
 #define jinit_2pass_quantizer chromium_jinit_2pass_quantizer
 #define jinit_merged_upsampler chromium_jinit_merged_upsampler
 #define jinit_memory_mgr chromium_jinit_memory_mgr
+#define jcopy_c_coef_controller chromium_jcopy_c_coef_controller
 #define jdiv_round_up chromium_jdiv_round_up
 #define jround_up chromium_jround_up
 #define jcopy_sample_rows chromium_jcopy_sample_rows
 #define jcopy_block_row chromium_jcopy_block_row
 #define jzero_far chromium_jzero_far
+#define jthread_num_cpus chromium_jthread_num_cpus
+#define jthread_run chromium_jthread_run
+#define jthread_once chromium_jthread_once
 #define jpeg_std_error chromium_jpeg_std_error
 #define jpeg_CreateCompress chromium_jpeg_CreateCompress
 #define jpeg_CreateDecompress chromium_jpeg_CreateDecompress
@@ -86,7 +93,16 @@
 #define jpeg_start_compress chromium_jpeg_start_compress
 #define jpeg_write_scanlines chromium_jpeg_write_scanlines
 #define jpeg_finish_compress chromium_jpeg_finish_compress
+#define jpeg_set_scan_threads chromium_jpeg_set_scan_threads
+#define jpeg_set_huffman_sample chromium_jpeg_set_huffman_sample
 #define jpeg_read_icc_profile chromium_jpeg_read_icc_profile
+#define jpeg_save_checkpoints chromium_jpeg_save_checkpoints
+#define jpeg_get_checkpoints chromium_jpeg_get_checkpoints
+#define jpeg_use_checkpoints chromium_jpeg_use_checkpoints
+#define jpeg_start_speculative chromium_jpeg_start_speculative
+#define jpeg_speculate_mcu chromium_jpeg_speculate_mcu
+#define jpeg_use_mcu_positions chromium_jpeg_use_mcu_positions
+#define jpeg_src_in_memory chromium_jpeg_src_in_memory
 #define jpeg_write_icc_profile chromium_jpeg_write_icc_profile
 #define jpeg_write_raw_data chromium_jpeg_write_raw_data
 #define jpeg_write_marker chromium_jpeg_write_marker
@@ -13,10 +13,30 @@
 
 #include "jchuff.h"             /* Declarations shared with jcphuff.c */
 
+/* Instruction set restrictions for jsimd_force().  Each has the same effect
+ * as the environment variable of the same name.
+ */
+#define JSIMD_FORCEMMX   1
+#define JSIMD_FORCESSE   2
+#define JSIMD_FORCESSE2  3
+
+/* The SIMD extensions are selected once per process, so this only has an
+ * effect if it is called before any image is compressed or decompressed.
+ */
+EXTERN(void) jsimd_force(int level);
+
 EXTERN(int) jsimd_can_rgb_ycc(void);
 EXTERN(int) jsimd_can_rgb_gray(void);
 EXTERN(int) jsimd_can_ycc_rgb(void);
 EXTERN(int) jsimd_can_ycc_rgb565(void);
+EXTERN(int) jsimd_can_ycc_rgb565D(void);
+EXTERN(int) jsimd_can_cmyk_ycck(void);
+EXTERN(int) jsimd_can_ycck_cmyk(void);
+EXTERN(int) jsimd_can_cmyk_rgb(void);
+EXTERN(int) jsimd_can_ycck_rgb(void);
+EXTERN(int) jsimd_c_can_rgb_rgb(void);
+EXTERN(int) jsimd_can_gray_rgb(void);
+EXTERN(int) jsimd_can_rgb_rgb(void);
 EXTERN(int) jsimd_c_can_null_convert(void);
 
 EXTERN(void) jsimd_rgb_ycc_convert(j_compress_ptr cinfo, JSAMPARRAY input_buf,
@@ -32,6 +52,34 @@ EXTERN(void) jsimd_ycc_rgb565_convert(j_decompress_ptr cinfo,
                                       JSAMPIMAGE input_buf,
                                       JDIMENSION input_row,
                                       JSAMPARRAY output_buf, int num_rows);
+EXTERN(void) jsimd_ycc_rgb565D_convert(j_decompress_ptr cinfo,
+                                       JSAMPIMAGE input_buf,
+                                       JDIMENSION input_row,
+                                       JSAMPARRAY output_buf, int num_rows);
+EXTERN(void) jsimd_cmyk_ycck_convert(j_compress_ptr cinfo,
+                                     JSAMPARRAY input_buf,
+                                     JSAMPIMAGE output_buf,
+                                     JDIMENSION output_row, int num_rows);
+EXTERN(void) jsimd_ycck_cmyk_convert(j_decompress_ptr cinfo,
+                                     JSAMPIMAGE input_buf,
+                                     JDIMENSION input_row,
+                                     JSAMPARRAY output_buf, int num_rows);
+EXTERN(void) jsimd_cmyk_rgb_convert(j_decompress_ptr cinfo,
+                                    JSAMPIMAGE input_buf, JDIMENSION input_row,
+                                    JSAMPARRAY output_buf, int num_rows);
+EXTERN(void) jsimd_ycck_rgb_convert(j_decompress_ptr cinfo,
+                                    JSAMPIMAGE input_buf, JDIMENSION input_row,
+                                    JSAMPARRAY output_buf, int num_rows);
+EXTERN(void) jsimd_c_rgb_rgb_convert(j_compress_ptr cinfo,
+                                     JSAMPARRAY input_buf,
+                                     JSAMPIMAGE output_buf,
+                                     JDIMENSION output_row, int num_rows);
+EXTERN(void) jsimd_gray_rgb_convert(j_decompress_ptr cinfo,
+                                    JSAMPIMAGE input_buf, JDIMENSION input_row,
+                                    JSAMPARRAY output_buf, int num_rows);
+EXTERN(void) jsimd_rgb_rgb_convert(j_decompress_ptr cinfo,
+                                   JSAMPIMAGE input_buf, JDIMENSION input_row,
+                                   JSAMPARRAY output_buf, int num_rows);
 EXTERN(void) jsimd_c_null_convert(j_compress_ptr cinfo, JSAMPARRAY input_buf,
                                   JSAMPIMAGE output_buf, JDIMENSION output_row,
                                   int num_rows);
@@ -51,11 +99,40 @@ EXTERN(void) jsimd_h2v2_smooth_downsample(j_compress_ptr cinfo,
                                           JSAMPARRAY input_data,
                                           JSAMPARRAY output_data);
 
+EXTERN(int) jsimd_can_fullsize_smooth_downsample(void);
+
+EXTERN(void) jsimd_fullsize_smooth_downsample(j_compress_ptr cinfo,
+                                              jpeg_component_info *compptr,
+                                              JSAMPARRAY input_data,
+                                              JSAMPARRAY output_data);
+
 EXTERN(void) jsimd_h2v1_downsample(j_compress_ptr cinfo,
                                    jpeg_component_info *compptr,
                                    JSAMPARRAY input_data,
                                    JSAMPARRAY output_data);
 
+EXTERN(int) jsimd_can_h4v1_downsample(void);
+EXTERN(int) jsimd_can_h4v2_downsample(void);
+EXTERN(int) jsimd_can_h1v2_downsample(void);
+EXTERN(int) jsimd_can_h2v4_downsample(void);
+
+EXTERN(void) jsimd_h4v1_downsample(j_compress_ptr cinfo,
+                                   jpeg_component_info *compptr,
+                                   JSAMPARRAY input_data,
+                                   JSAMPARRAY output_data);
+EXTERN(void) jsimd_h4v2_downsample(j_compress_ptr cinfo,
+                                   jpeg_component_info *compptr,
+                                   JSAMPARRAY input_data,
+                                   JSAMPARRAY output_data);
+EXTERN(void) jsimd_h1v2_downsample(j_compress_ptr cinfo,
+                                   jpeg_component_info *compptr,
+                                   JSAMPARRAY input_data,
+                                   JSAMPARRAY output_data);
+EXTERN(void) jsimd_h2v4_downsample(j_compress_ptr cinfo,
+                                   jpeg_component_info *compptr,
+                                   JSAMPARRAY input_data,
+                                   JSAMPARRAY output_data);
+
 EXTERN(int) jsimd_can_h2v2_upsample(void);
 EXTERN(int) jsimd_can_h2v1_upsample(void);
 EXTERN(int) jsimd_can_int_upsample(void);
@@ -73,6 +150,28 @@ EXTERN(void) jsimd_int_upsample(j_decompress_ptr cinfo,
                                 JSAMPARRAY input_data,
                                 JSAMPARRAY *output_data_ptr);
 
+EXTERN(int) jsimd_can_h4v1_upsample(void);
+EXTERN(int) jsimd_can_h4v2_upsample(void);
+EXTERN(int) jsimd_can_h1v2_upsample(void);
+EXTERN(int) jsimd_can_h2v4_upsample(void);
+
+EXTERN(void) jsimd_h4v1_upsample(j_decompress_ptr cinfo,
+                                 jpeg_component_info *compptr,
+                                 JSAMPARRAY input_data,
+                                 JSAMPARRAY *output_data_ptr);
+EXTERN(void) jsimd_h4v2_upsample(j_decompress_ptr cinfo,
+                                 jpeg_component_info *compptr,
+                                 JSAMPARRAY input_data,
+                                 JSAMPARRAY *output_data_ptr);
+EXTERN(void) jsimd_h1v2_upsample(j_decompress_ptr cinfo,
+                                 jpeg_component_info *compptr,
+                                 JSAMPARRAY input_data,
+                                 JSAMPARRAY *output_data_ptr);
+EXTERN(void) jsimd_h2v4_upsample(j_decompress_ptr cinfo,
+                                 jpeg_component_info *compptr,
+                                 JSAMPARRAY input_data,
+                                 JSAMPARRAY *output_data_ptr);
+
 EXTERN(int) jsimd_can_h2v2_fancy_upsample(void);
 EXTERN(int) jsimd_can_h2v1_fancy_upsample(void);
 EXTERN(int) jsimd_can_h1v2_fancy_upsample(void);
@@ -92,6 +191,10 @@ EXTERN(void) jsimd_h1v2_fancy_upsample(j_decompress_ptr cinfo,
 
 EXTERN(int) jsimd_can_h2v2_merged_upsample(void);
 EXTERN(int) jsimd_can_h2v1_merged_upsample(void);
+EXTERN(int) jsimd_can_h2v2_merged_upsample_565(void);
+EXTERN(int) jsimd_can_h2v1_merged_upsample_565(void);
+EXTERN(int) jsimd_can_h2v2_fancy_merged_upsample(void);
+EXTERN(int) jsimd_can_h2v1_fancy_merged_upsample(void);
 
 EXTERN(void) jsimd_h2v2_merged_upsample(j_decompress_ptr cinfo,
                                         JSAMPIMAGE input_buf,
@@ -101,6 +204,30 @@ EXTERN(void) jsimd_h2v1_merged_upsample(j_decompress_ptr cinfo,
                                         JSAMPIMAGE input_buf,
                                         JDIMENSION in_row_group_ctr,
                                         JSAMPARRAY output_buf);
+EXTERN(void) jsimd_h2v2_merged_upsample_565(j_decompress_ptr cinfo,
+                                            JSAMPIMAGE input_buf,
+                                            JDIMENSION in_row_group_ctr,
+                                            JSAMPARRAY output_buf);
+EXTERN(void) jsimd_h2v2_merged_upsample_565D(j_decompress_ptr cinfo,
+                                             JSAMPIMAGE input_buf,
+                                             JDIMENSION in_row_group_ctr,
+                                             JSAMPARRAY output_buf);
+EXTERN(void) jsimd_h2v1_merged_upsample_565(j_decompress_ptr cinfo,
+                                            JSAMPIMAGE input_buf,
+                                            JDIMENSION in_row_group_ctr,
+                                            JSAMPARRAY output_buf);
+EXTERN(void) jsimd_h2v1_merged_upsample_565D(j_decompress_ptr cinfo,
+                                             JSAMPIMAGE input_buf,
+                                             JDIMENSION in_row_group_ctr,
+                                             JSAMPARRAY output_buf);
+EXTERN(void) jsimd_h2v2_fancy_merged_upsample(j_decompress_ptr cinfo,
+                                              JSAMPIMAGE input_buf,
+                                              JDIMENSION in_row_group_ctr,
+                                              JSAMPARRAY output_buf);
+EXTERN(void) jsimd_h2v1_fancy_merged_upsample(j_decompress_ptr cinfo,
+                                              JSAMPIMAGE input_buf,
+                                              JDIMENSION in_row_group_ctr,
+                                              JSAMPARRAY output_buf);
 
 EXTERN(int) jsimd_can_huff_encode_one_block(void);
 
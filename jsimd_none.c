@@ -19,6 +19,11 @@
 #include "jdct.h"
 #include "jsimddct.h"
 
+GLOBAL(void)
+jsimd_force(int level)
+{
+}
+
 GLOBAL(int)
 jsimd_can_rgb_ycc(void)
 {
@@ -43,6 +48,54 @@ jsimd_can_ycc_rgb565(void)
   return 0;
 }
 
+GLOBAL(int)
+jsimd_can_ycc_rgb565D(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_cmyk_ycck(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_ycck_cmyk(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_cmyk_rgb(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_ycck_rgb(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_c_can_rgb_rgb(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_gray_rgb(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_rgb_rgb(void)
+{
+  return 0;
+}
+
 GLOBAL(int)
 jsimd_c_can_null_convert(void)
 {
@@ -77,6 +130,62 @@ jsimd_ycc_rgb565_convert(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
 {
 }
 
+GLOBAL(void)
+jsimd_ycc_rgb565D_convert(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                          JDIMENSION input_row, JSAMPARRAY output_buf,
+                          int num_rows)
+{
+}
+
+GLOBAL(void)
+jsimd_cmyk_ycck_convert(j_compress_ptr cinfo, JSAMPARRAY input_buf,
+                        JSAMPIMAGE output_buf, JDIMENSION output_row,
+                        int num_rows)
+{
+}
+
+GLOBAL(void)
+jsimd_ycck_cmyk_convert(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                        JDIMENSION input_row, JSAMPARRAY output_buf,
+                        int num_rows)
+{
+}
+
+GLOBAL(void)
+jsimd_cmyk_rgb_convert(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                       JDIMENSION input_row, JSAMPARRAY output_buf,
+                       int num_rows)
+{
+}
+
+GLOBAL(void)
+jsimd_ycck_rgb_convert(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                       JDIMENSION input_row, JSAMPARRAY output_buf,
+                       int num_rows)
+{
+}
+
+GLOBAL(void)
+jsimd_c_rgb_rgb_convert(j_compress_ptr cinfo, JSAMPARRAY input_buf,
+                        JSAMPIMAGE output_buf, JDIMENSION output_row,
+                        int num_rows)
+{
+}
+
+GLOBAL(void)
+jsimd_gray_rgb_convert(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                       JDIMENSION input_row, JSAMPARRAY output_buf,
+                       int num_rows)
+{
+}
+
+GLOBAL(void)
+jsimd_rgb_rgb_convert(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                      JDIMENSION input_row, JSAMPARRAY output_buf,
+                      int num_rows)
+{
+}
+
 GLOBAL(void)
 jsimd_c_null_convert(j_compress_ptr cinfo, JSAMPARRAY input_buf,
                      JSAMPIMAGE output_buf, JDIMENSION output_row,
@@ -115,12 +224,74 @@ jsimd_h2v2_smooth_downsample(j_compress_ptr cinfo,
 {
 }
 
+GLOBAL(int)
+jsimd_can_fullsize_smooth_downsample(void)
+{
+  return 0;
+}
+
+GLOBAL(void)
+jsimd_fullsize_smooth_downsample(j_compress_ptr cinfo,
+                                 jpeg_component_info *compptr,
+                                 JSAMPARRAY input_data,
+                                 JSAMPARRAY output_data)
+{
+}
+
 GLOBAL(void)
 jsimd_h2v1_downsample(j_compress_ptr cinfo, jpeg_component_info *compptr,
                       JSAMPARRAY input_data, JSAMPARRAY output_data)
 {
 }
 
+GLOBAL(int)
+jsimd_can_h4v1_downsample(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_h4v2_downsample(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_h1v2_downsample(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_h2v4_downsample(void)
+{
+  return 0;
+}
+
+GLOBAL(void)
+jsimd_h4v1_downsample(j_compress_ptr cinfo, jpeg_component_info *compptr,
+                      JSAMPARRAY input_data, JSAMPARRAY output_data)
+{
+}
+
+GLOBAL(void)
+jsimd_h4v2_downsample(j_compress_ptr cinfo, jpeg_component_info *compptr,
+                      JSAMPARRAY input_data, JSAMPARRAY output_data)
+{
+}
+
+GLOBAL(void)
+jsimd_h1v2_downsample(j_compress_ptr cinfo, jpeg_component_info *compptr,
+                      JSAMPARRAY input_data, JSAMPARRAY output_data)
+{
+}
+
+GLOBAL(void)
+jsimd_h2v4_downsample(j_compress_ptr cinfo, jpeg_component_info *compptr,
+                      JSAMPARRAY input_data, JSAMPARRAY output_data)
+{
+}
+
 GLOBAL(int)
 jsimd_can_h2v2_upsample(void)
 {
@@ -157,6 +328,54 @@ jsimd_h2v1_upsample(j_decompress_ptr cinfo, jpeg_component_info *compptr,
 {
 }
 
+GLOBAL(int)
+jsimd_can_h4v1_upsample(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_h4v2_upsample(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_h1v2_upsample(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_h2v4_upsample(void)
+{
+  return 0;
+}
+
+GLOBAL(void)
+jsimd_h4v1_upsample(j_decompress_ptr cinfo, jpeg_component_info *compptr,
+                    JSAMPARRAY input_data, JSAMPARRAY *output_data_ptr)
+{
+}
+
+GLOBAL(void)
+jsimd_h4v2_upsample(j_decompress_ptr cinfo, jpeg_component_info *compptr,
+                    JSAMPARRAY input_data, JSAMPARRAY *output_data_ptr)
+{
+}
+
+GLOBAL(void)
+jsimd_h1v2_upsample(j_decompress_ptr cinfo, jpeg_component_info *compptr,
+                    JSAMPARRAY input_data, JSAMPARRAY *output_data_ptr)
+{
+}
+
+GLOBAL(void)
+jsimd_h2v4_upsample(j_decompress_ptr cinfo, jpeg_component_info *compptr,
+                    JSAMPARRAY input_data, JSAMPARRAY *output_data_ptr)
+{
+}
+
 GLOBAL(int)
 jsimd_can_h2v2_fancy_upsample(void)
 {
@@ -205,6 +424,30 @@ jsimd_can_h2v1_merged_upsample(void)
   return 0;
 }
 
+GLOBAL(int)
+jsimd_can_h2v2_merged_upsample_565(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_h2v1_merged_upsample_565(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_h2v2_fancy_merged_upsample(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_h2v1_fancy_merged_upsample(void)
+{
+  return 0;
+}
+
 GLOBAL(void)
 jsimd_h2v2_merged_upsample(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
                            JDIMENSION in_row_group_ctr, JSAMPARRAY output_buf)
@@ -217,6 +460,48 @@ jsimd_h2v1_merged_upsample(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
 {
 }
 
+GLOBAL(void)
+jsimd_h2v2_merged_upsample_565(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                               JDIMENSION in_row_group_ctr,
+                               JSAMPARRAY output_buf)
+{
+}
+
+GLOBAL(void)
+jsimd_h2v2_merged_upsample_565D(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                                JDIMENSION in_row_group_ctr,
+                                JSAMPARRAY output_buf)
+{
+}
+
+GLOBAL(void)
+jsimd_h2v1_merged_upsample_565(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                               JDIMENSION in_row_group_ctr,
+                               JSAMPARRAY output_buf)
+{
+}
+
+GLOBAL(void)
+jsimd_h2v1_merged_upsample_565D(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                                JDIMENSION in_row_group_ctr,
+                                JSAMPARRAY output_buf)
+{
+}
+
+GLOBAL(void)
+jsimd_h2v2_fancy_merged_upsample(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                                 JDIMENSION in_row_group_ctr,
+                                 JSAMPARRAY output_buf)
+{
+}
+
+GLOBAL(void)
+jsimd_h2v1_fancy_merged_upsample(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                                 JDIMENSION in_row_group_ctr,
+                                 JSAMPARRAY output_buf)
+{
+}
+
 GLOBAL(int)
 jsimd_can_convsamp(void)
 {
@@ -349,6 +634,19 @@ jsimd_idct_12x12(j_decompress_ptr cinfo, jpeg_component_info *compptr,
 {
 }
 
+GLOBAL(int)
+jsimd_can_idct_scaled(int scaled_size)
+{
+  return 0;
+}
+
+GLOBAL(void)
+jsimd_idct_scaled(j_decompress_ptr cinfo, jpeg_component_info *compptr,
+                  JCOEFPTR coef_block, JSAMPARRAY output_buf,
+                  JDIMENSION output_col)
+{
+}
+
 GLOBAL(int)
 jsimd_can_idct_islow(void)
 {
@@ -388,6 +686,32 @@ jsimd_idct_float(j_decompress_ptr cinfo, jpeg_component_info *compptr,
 {
 }
 
+GLOBAL(int)
+jsimd_can_idct_islow_corner4(void)
+{
+  return 0;
+}
+
+GLOBAL(void)
+jsimd_idct_islow_corner4(j_decompress_ptr cinfo, jpeg_component_info *compptr,
+                         JCOEFPTR coef_block, JSAMPARRAY output_buf,
+                         JDIMENSION output_col)
+{
+}
+
+GLOBAL(int)
+jsimd_can_idct_islow_blocks(void)
+{
+  return 0;
+}
+
+GLOBAL(void)
+jsimd_idct_islow_blocks(j_decompress_ptr cinfo, jpeg_component_info *compptr,
+                        JCOEFPTR coef_blocks, JSAMPARRAY output_buf,
+                        JDIMENSION output_col, JDIMENSION num_blocks)
+{
+}
+
 GLOBAL(int)
 jsimd_can_huff_encode_one_block(void)
 {
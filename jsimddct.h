@@ -52,6 +52,17 @@ EXTERN(void) jsimd_idct_12x12(j_decompress_ptr cinfo,
                               JCOEFPTR coef_block, JSAMPARRAY output_buf,
                               JDIMENSION output_col);
 
+/* The IDCT for any of the sizes 3, 5, 6, 7 and 9 ... 16 that
+ * jsimd_can_idct_scaled() accepts.  It is selected by
+ * compptr->_DCT_scaled_size.
+ */
+EXTERN(int) jsimd_can_idct_scaled(int scaled_size);
+
+EXTERN(void) jsimd_idct_scaled(j_decompress_ptr cinfo,
+                               jpeg_component_info *compptr,
+                               JCOEFPTR coef_block, JSAMPARRAY output_buf,
+                               JDIMENSION output_col);
+
 EXTERN(int) jsimd_can_idct_islow(void);
 EXTERN(int) jsimd_can_idct_ifast(void);
 EXTERN(int) jsimd_can_idct_float(void);
@@ -68,3 +79,20 @@ EXTERN(void) jsimd_idct_float(j_decompress_ptr cinfo,
                               jpeg_component_info *compptr,
                               JCOEFPTR coef_block, JSAMPARRAY output_buf,
                               JDIMENSION output_col);
+
+EXTERN(int) jsimd_can_idct_islow_corner4(void);
+
+EXTERN(void) jsimd_idct_islow_corner4(j_decompress_ptr cinfo,
+                                      jpeg_component_info *compptr,
+                                      JCOEFPTR coef_block,
+                                      JSAMPARRAY output_buf,
+                                      JDIMENSION output_col);
+
+EXTERN(int) jsimd_can_idct_islow_blocks(void);
+
+EXTERN(void) jsimd_idct_islow_blocks(j_decompress_ptr cinfo,
+                                     jpeg_component_info *compptr,
+                                     JCOEFPTR coef_blocks,
+                                     JSAMPARRAY output_buf,
+                                     JDIMENSION output_col,
+                                     JDIMENSION num_blocks);
@@ -8,8 +8,10 @@
  * For conditions of distribution and use, see the accompanying README.ijg
  * file.
  *
- * This file contains routines to set the default Huffman tables, if they are
- * not already set.
+ * This file contains routines to set the default Huffman tables.  The
+ * decompressor only sets those that are not already set, whereas the
+ * compressor replaces any tables (such as optimal ones) left by a previous
+ * image.
  */
 
 /*
@@ -25,8 +27,8 @@ add_huff_table(j_common_ptr cinfo, JHUFF_TBL **htblptr, const UINT8 *bits,
 
   if (*htblptr == NULL)
     *htblptr = jpeg_alloc_huff_table(cinfo);
-  else
-    return;
+  else if (cinfo->is_decompressor)
+    return;             /* keep the tables that were read from the file */
 
   /* Copy the number-of-symbols-of-each-code-length counts */
   MEMCOPY((*htblptr)->bits, bits, sizeof((*htblptr)->bits));
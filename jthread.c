@@ -0,0 +1,234 @@
+/*
+ * jthread.c
+ *
+ * Copyright 2026 The Chromium Authors. All Rights Reserved.
+ * For conditions of distribution and use, see the accompanying README.ijg
+ * file.
+ *
+ * This file contains the minimal worker-thread support used by the
+ * multi-threaded code paths.  It uses Win32 threads on Windows and POSIX
+ * threads elsewhere.  Defining NO_THREADS builds a serial implementation.
+ * It also provides the one-time initialization used by the SIMD dispatch
+ * code.
+ */
+
+#define JPEG_INTERNALS
+#include "jinclude.h"
+#include "jpeglib.h"
+#include "jthread.h"
+
+#if defined(NO_THREADS)
+/* no thread support */
+#elif defined(_WIN32)
+#include <windows.h>
+#include <process.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+
+/* Shared state for one jthread_run() call */
+
+typedef struct {
+  jthread_task_fn fn;
+  void *arg;
+  int num_tasks;
+  int next_task;                /* index of the next task to hand out */
+  boolean use_lock;             /* TRUE if worker threads may be running */
+#if defined(NO_THREADS)
+#elif defined(_WIN32)
+  CRITICAL_SECTION lock;
+#else
+  pthread_mutex_t lock;
+#endif
+} task_queue;
+
+
+LOCAL(int)
+get_next_task(task_queue *queue)
+{
+  int task = -1;
+
+#if defined(NO_THREADS)
+#elif defined(_WIN32)
+  if (queue->use_lock)
+    EnterCriticalSection(&queue->lock);
+#else
+  if (queue->use_lock)
+    pthread_mutex_lock(&queue->lock);
+#endif
+  if (queue->next_task < queue->num_tasks)
+    task = queue->next_task++;
+#if defined(NO_THREADS)
+#elif defined(_WIN32)
+  if (queue->use_lock)
+    LeaveCriticalSection(&queue->lock);
+#else
+  if (queue->use_lock)
+    pthread_mutex_unlock(&queue->lock);
+#endif
+  return task;
+}
+
+
+LOCAL(void)
+run_tasks(task_queue *queue)
+{
+  int task;
+
+  while ((task = get_next_task(queue)) >= 0)
+    (*queue->fn) (queue->arg, task);
+}
+
+
+#if defined(NO_THREADS)
+#elif defined(_WIN32)
+
+static unsigned __stdcall
+worker_thread(void *param)
+{
+  run_tasks((task_queue *)param);
+  return 0;
+}
+
+#else
+
+static void *
+worker_thread(void *param)
+{
+  run_tasks((task_queue *)param);
+  return NULL;
+}
+
+#endif
+
+
+GLOBAL(int)
+jthread_num_cpus(void)
+{
+  int num_cpus = 1;
+
+#if defined(NO_THREADS)
+#elif defined(_WIN32)
+  SYSTEM_INFO sysinfo;
+
+  GetSystemInfo(&sysinfo);
+  num_cpus = (int)sysinfo.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+  num_cpus = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+
+  if (num_cpus < 1)
+    num_cpus = 1;
+  if (num_cpus > JTHREAD_MAX_THREADS)
+    num_cpus = JTHREAD_MAX_THREADS;
+  return num_cpus;
+}
+
+
+GLOBAL(void)
+jthread_run(int num_tasks, int num_threads, jthread_task_fn fn, void *arg)
+{
+  task_queue queue;
+#if defined(NO_THREADS)
+#elif defined(_WIN32)
+  HANDLE threads[JTHREAD_MAX_THREADS];
+#else
+  pthread_t threads[JTHREAD_MAX_THREADS];
+#endif
+  int i, num_started = 0;
+
+  queue.fn = fn;
+  queue.arg = arg;
+  queue.num_tasks = num_tasks;
+  queue.next_task = 0;
+  queue.use_lock = FALSE;
+
+  if (num_threads > num_tasks)
+    num_threads = num_tasks;
+  if (num_threads > JTHREAD_MAX_THREADS)
+    num_threads = JTHREAD_MAX_THREADS;
+
+#if defined(NO_THREADS)
+  (void)i;
+#elif defined(_WIN32)
+  if (num_threads > 1) {
+    InitializeCriticalSection(&queue.lock);
+    queue.use_lock = TRUE;
+  }
+  for (i = 1; i < num_threads; i++) {
+    threads[num_started] =
+      (HANDLE)_beginthreadex(NULL, 0, worker_thread, &queue, 0, NULL);
+    if (threads[num_started] == 0)
+      break;
+    num_started++;
+  }
+#else
+  if (num_threads > 1) {
+    if (pthread_mutex_init(&queue.lock, NULL) == 0)
+      queue.use_lock = TRUE;
+    else
+      num_threads = 1;
+  }
+  for (i = 1; i < num_threads; i++) {
+    if (pthread_create(&threads[num_started], NULL, worker_thread,
+                       &queue) != 0)
+      break;
+    num_started++;
+  }
+#endif
+
+  /* The calling thread works on the queue too, which also takes care of any
+   * tasks that would have been run by threads we failed to create.
+   */
+  run_tasks(&queue);
+
+#if defined(NO_THREADS)
+  (void)num_started;
+#elif defined(_WIN32)
+  for (i = 0; i < num_started; i++) {
+    WaitForSingleObject(threads[i], INFINITE);
+    CloseHandle(threads[i]);
+  }
+  if (queue.use_lock)
+    DeleteCriticalSection(&queue.lock);
+#else
+  for (i = 0; i < num_started; i++)
+    pthread_join(threads[i], NULL);
+  if (queue.use_lock)
+    pthread_mutex_destroy(&queue.lock);
+#endif
+}
+
+
+#if defined(NO_THREADS)
+#elif defined(_WIN32)
+
+static BOOL CALLBACK
+once_callback(PINIT_ONCE once, PVOID param, PVOID *context)
+{
+  void (**init_fn) (void) = (void (**) (void))param;
+
+  (**init_fn) ();
+  return TRUE;
+}
+
+#endif
+
+
+GLOBAL(void)
+jthread_once(jthread_once_t *once_control, void (*init_fn) (void))
+{
+#if defined(NO_THREADS)
+  if (!*once_control) {
+    *once_control = 1;
+    (*init_fn) ();
+  }
+#elif defined(_WIN32)
+  InitOnceExecuteOnce((PINIT_ONCE)once_control, once_callback,
+                      (PVOID)&init_fn, NULL);
+#else
+  pthread_once(once_control, init_fn);
+#endif
+}
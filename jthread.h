@@ -0,0 +1,52 @@
+/*
+ * jthread.h
+ *
+ * Copyright 2026 The Chromium Authors. All Rights Reserved.
+ * For conditions of distribution and use, see the accompanying README.ijg
+ * file.
+ *
+ * This file contains declarations for the minimal worker-thread support used
+ * by the multi-threaded code paths in the library and in the TurboJPEG API
+ * wrapper and by the SIMD dispatch code.  No other modules need to see these.
+ */
+
+
+#if defined(NO_THREADS)
+typedef int jthread_once_t;
+#define JTHREAD_ONCE_INIT  0
+#elif defined(_WIN32)
+typedef void *jthread_once_t;           /* same layout as an INIT_ONCE */
+#define JTHREAD_ONCE_INIT  NULL
+#else
+#include <pthread.h>
+typedef pthread_once_t jthread_once_t;
+#define JTHREAD_ONCE_INIT  PTHREAD_ONCE_INIT
+#endif
+
+/* A task function is called once for each task index in [0, num_tasks). */
+typedef void (*jthread_task_fn) (void *arg, int task);
+
+/* Upper bound on the number of threads that jthread_run() will use */
+#define JTHREAD_MAX_THREADS  64
+
+/* Return the number of online CPU cores, or 1 if this cannot be determined
+ * or if the library was built without thread support.
+ */
+EXTERN(int) jthread_num_cpus(void);
+
+/* Run fn(arg, i) for every i in [0, num_tasks), distributing the calls across
+ * at most num_threads threads (the calling thread is one of them), and return
+ * once all tasks have completed.  Tasks are handed out in increasing order.
+ * If worker threads cannot be created, the remaining tasks are run on the
+ * calling thread, so the caller never needs to handle a failure.
+ */
+EXTERN(void) jthread_run(int num_tasks, int num_threads, jthread_task_fn fn,
+                         void *arg);
+
+/* Call init_fn() exactly once for a given once_control, which must have been
+ * statically initialized to JTHREAD_ONCE_INIT.  Callers that race with the
+ * first call block until init_fn() has returned, so anything it wrote is
+ * visible to every caller once jthread_once() returns.
+ */
+EXTERN(void) jthread_once(jthread_once_t *once_control,
+                          void (*init_fn) (void));
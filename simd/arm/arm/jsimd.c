@@ -22,6 +22,7 @@
 #include "../../../jsimd.h"
 #include "../../../jdct.h"
 #include "../../../jsimddct.h"
+#include "../../../jthread.h"
 #include "../../jsimd.h"
 
 #include <stdio.h>
@@ -30,6 +31,7 @@
 
 static unsigned int simd_support = ~0;
 static unsigned int simd_huffman = 1;
+static jthread_once_t simd_once = JTHREAD_ONCE_INIT;
 
 #if !defined(__ARM_NEON__) && (defined(__linux__) || defined(ANDROID) || defined(__ANDROID__))
 
@@ -96,12 +98,11 @@ parse_proc_cpuinfo(int bufsize)
 #endif
 
 /*
- * Check what SIMD accelerations are supported.
- *
- * FIXME: This code is racy under a multi-threaded environment.
+ * Check what SIMD accelerations are supported.  This is only ever called
+ * through jthread_once(), so it runs once per process.
  */
 LOCAL(void)
-init_simd(void)
+detect_simd(void)
 {
 #ifndef NO_GETENV
   char *env = NULL;
@@ -110,9 +111,6 @@ init_simd(void)
   int bufsize = 1024; /* an initial guess for the line buffer size limit */
 #endif
 
-  if (simd_support != ~0U)
-    return;
-
   simd_support = 0;
 
 #if defined(__ARM_NEON__)
@@ -142,6 +140,20 @@ init_simd(void)
 #endif
 }
 
+LOCAL(void)
+init_simd(void)
+{
+  jthread_once(&simd_once, detect_simd);
+}
+
+/*
+ * None of the jsimd_force() levels applies to NEON.
+ */
+GLOBAL(void)
+jsimd_force(int level)
+{
+}
+
 GLOBAL(int)
 jsimd_can_rgb_ycc(void)
 {
@@ -203,6 +215,54 @@ jsimd_can_ycc_rgb565(void)
   return 0;
 }
 
+GLOBAL(int)
+jsimd_can_ycc_rgb565D(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_cmyk_ycck(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_ycck_cmyk(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_cmyk_rgb(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_ycck_rgb(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_c_can_rgb_rgb(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_gray_rgb(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_rgb_rgb(void)
+{
+  return 0;
+}
+
 GLOBAL(void)
 jsimd_rgb_ycc_convert(j_compress_ptr cinfo, JSAMPARRAY input_buf,
                       JSAMPIMAGE output_buf, JDIMENSION output_row,
@@ -295,6 +355,62 @@ jsimd_ycc_rgb565_convert(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
                                 output_buf, num_rows);
 }
 
+GLOBAL(void)
+jsimd_ycc_rgb565D_convert(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                          JDIMENSION input_row, JSAMPARRAY output_buf,
+                          int num_rows)
+{
+}
+
+GLOBAL(void)
+jsimd_cmyk_ycck_convert(j_compress_ptr cinfo, JSAMPARRAY input_buf,
+                        JSAMPIMAGE output_buf, JDIMENSION output_row,
+                        int num_rows)
+{
+}
+
+GLOBAL(void)
+jsimd_ycck_cmyk_convert(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                        JDIMENSION input_row, JSAMPARRAY output_buf,
+                        int num_rows)
+{
+}
+
+GLOBAL(void)
+jsimd_cmyk_rgb_convert(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                       JDIMENSION input_row, JSAMPARRAY output_buf,
+                       int num_rows)
+{
+}
+
+GLOBAL(void)
+jsimd_ycck_rgb_convert(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                       JDIMENSION input_row, JSAMPARRAY output_buf,
+                       int num_rows)
+{
+}
+
+GLOBAL(void)
+jsimd_c_rgb_rgb_convert(j_compress_ptr cinfo, JSAMPARRAY input_buf,
+                        JSAMPIMAGE output_buf, JDIMENSION output_row,
+                        int num_rows)
+{
+}
+
+GLOBAL(void)
+jsimd_gray_rgb_convert(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                       JDIMENSION input_row, JSAMPARRAY output_buf,
+                       int num_rows)
+{
+}
+
+GLOBAL(void)
+jsimd_rgb_rgb_convert(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                      JDIMENSION input_row, JSAMPARRAY output_buf,
+                      int num_rows)
+{
+}
+
 GLOBAL(int)
 jsimd_can_h2v2_downsample(void)
 {
@@ -319,6 +435,81 @@ jsimd_h2v1_downsample(j_compress_ptr cinfo, jpeg_component_info *compptr,
 {
 }
 
+GLOBAL(int)
+jsimd_can_h4v1_downsample(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_h4v2_downsample(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_h1v2_downsample(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_h2v4_downsample(void)
+{
+  return 0;
+}
+
+GLOBAL(void)
+jsimd_h4v1_downsample(j_compress_ptr cinfo, jpeg_component_info *compptr,
+                      JSAMPARRAY input_data, JSAMPARRAY output_data)
+{
+}
+
+GLOBAL(void)
+jsimd_h4v2_downsample(j_compress_ptr cinfo, jpeg_component_info *compptr,
+                      JSAMPARRAY input_data, JSAMPARRAY output_data)
+{
+}
+
+GLOBAL(void)
+jsimd_h1v2_downsample(j_compress_ptr cinfo, jpeg_component_info *compptr,
+                      JSAMPARRAY input_data, JSAMPARRAY output_data)
+{
+}
+
+GLOBAL(void)
+jsimd_h2v4_downsample(j_compress_ptr cinfo, jpeg_component_info *compptr,
+                      JSAMPARRAY input_data, JSAMPARRAY output_data)
+{
+}
+
+GLOBAL(int)
+jsimd_can_h2v2_smooth_downsample(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_fullsize_smooth_downsample(void)
+{
+  return 0;
+}
+
+GLOBAL(void)
+jsimd_h2v2_smooth_downsample(j_compress_ptr cinfo,
+                             jpeg_component_info *compptr,
+                             JSAMPARRAY input_data, JSAMPARRAY output_data)
+{
+}
+
+GLOBAL(void)
+jsimd_fullsize_smooth_downsample(j_compress_ptr cinfo,
+                                 jpeg_component_info *compptr,
+                                 JSAMPARRAY input_data,
+                                 JSAMPARRAY output_data)
+{
+}
+
 GLOBAL(int)
 jsimd_can_h2v2_upsample(void)
 {
@@ -343,6 +534,54 @@ jsimd_h2v1_upsample(j_decompress_ptr cinfo, jpeg_component_info *compptr,
 {
 }
 
+GLOBAL(int)
+jsimd_can_h4v1_upsample(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_h4v2_upsample(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_h1v2_upsample(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_h2v4_upsample(void)
+{
+  return 0;
+}
+
+GLOBAL(void)
+jsimd_h4v1_upsample(j_decompress_ptr cinfo, jpeg_component_info *compptr,
+                    JSAMPARRAY input_data, JSAMPARRAY *output_data_ptr)
+{
+}
+
+GLOBAL(void)
+jsimd_h4v2_upsample(j_decompress_ptr cinfo, jpeg_component_info *compptr,
+                    JSAMPARRAY input_data, JSAMPARRAY *output_data_ptr)
+{
+}
+
+GLOBAL(void)
+jsimd_h1v2_upsample(j_decompress_ptr cinfo, jpeg_component_info *compptr,
+                    JSAMPARRAY input_data, JSAMPARRAY *output_data_ptr)
+{
+}
+
+GLOBAL(void)
+jsimd_h2v4_upsample(j_decompress_ptr cinfo, jpeg_component_info *compptr,
+                    JSAMPARRAY input_data, JSAMPARRAY *output_data_ptr)
+{
+}
+
 GLOBAL(int)
 jsimd_can_h2v2_fancy_upsample(void)
 {
@@ -433,6 +672,30 @@ jsimd_can_h2v1_merged_upsample(void)
   return 0;
 }
 
+GLOBAL(int)
+jsimd_can_h2v2_merged_upsample_565(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_h2v1_merged_upsample_565(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_h2v2_fancy_merged_upsample(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_h2v1_fancy_merged_upsample(void)
+{
+  return 0;
+}
+
 GLOBAL(void)
 jsimd_h2v2_merged_upsample(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
                            JDIMENSION in_row_group_ctr, JSAMPARRAY output_buf)
@@ -445,6 +708,48 @@ jsimd_h2v1_merged_upsample(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
 {
 }
 
+GLOBAL(void)
+jsimd_h2v2_merged_upsample_565(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                               JDIMENSION in_row_group_ctr,
+                               JSAMPARRAY output_buf)
+{
+}
+
+GLOBAL(void)
+jsimd_h2v2_merged_upsample_565D(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                                JDIMENSION in_row_group_ctr,
+                                JSAMPARRAY output_buf)
+{
+}
+
+GLOBAL(void)
+jsimd_h2v1_merged_upsample_565(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                               JDIMENSION in_row_group_ctr,
+                               JSAMPARRAY output_buf)
+{
+}
+
+GLOBAL(void)
+jsimd_h2v1_merged_upsample_565D(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                                JDIMENSION in_row_group_ctr,
+                                JSAMPARRAY output_buf)
+{
+}
+
+GLOBAL(void)
+jsimd_h2v2_fancy_merged_upsample(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                                 JDIMENSION in_row_group_ctr,
+                                 JSAMPARRAY output_buf)
+{
+}
+
+GLOBAL(void)
+jsimd_h2v1_fancy_merged_upsample(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                                 JDIMENSION in_row_group_ctr,
+                                 JSAMPARRAY output_buf)
+{
+}
+
 GLOBAL(int)
 jsimd_can_convsamp(void)
 {
@@ -629,6 +934,19 @@ jsimd_idct_4x4(j_decompress_ptr cinfo, jpeg_component_info *compptr,
   jsimd_idct_4x4_neon(compptr->dct_table, coef_block, output_buf, output_col);
 }
 
+GLOBAL(int)
+jsimd_can_idct_scaled(int scaled_size)
+{
+  return 0;
+}
+
+GLOBAL(void)
+jsimd_idct_scaled(j_decompress_ptr cinfo, jpeg_component_info *compptr,
+                  JCOEFPTR coef_block, JSAMPARRAY output_buf,
+                  JDIMENSION output_col)
+{
+}
+
 GLOBAL(int)
 jsimd_can_idct_islow(void)
 {
@@ -708,6 +1026,32 @@ jsimd_idct_float(j_decompress_ptr cinfo, jpeg_component_info *compptr,
 {
 }
 
+GLOBAL(int)
+jsimd_can_idct_islow_corner4(void)
+{
+  return 0;
+}
+
+GLOBAL(void)
+jsimd_idct_islow_corner4(j_decompress_ptr cinfo, jpeg_component_info *compptr,
+                         JCOEFPTR coef_block, JSAMPARRAY output_buf,
+                         JDIMENSION output_col)
+{
+}
+
+GLOBAL(int)
+jsimd_can_idct_islow_blocks(void)
+{
+  return 0;
+}
+
+GLOBAL(void)
+jsimd_idct_islow_blocks(j_decompress_ptr cinfo, jpeg_component_info *compptr,
+                        JCOEFPTR coef_blocks, JSAMPARRAY output_buf,
+                        JDIMENSION output_col, JDIMENSION num_blocks)
+{
+}
+
 GLOBAL(int)
 jsimd_can_huff_encode_one_block(void)
 {
@@ -20,6 +20,7 @@
 #include "../../jsimd.h"
 #include "../../jdct.h"
 #include "../../jsimddct.h"
+#include "../../jthread.h"
 #include "../jsimd.h"
 #include "jconfigint.h"
 
@@ -34,23 +35,21 @@
 
 static unsigned int simd_support = (unsigned int)(~0);
 static unsigned int simd_huffman = 1;
+static jthread_once_t simd_once = JTHREAD_ONCE_INIT;
 
 /*
- * Check what SIMD accelerations are supported.
- *
- * FIXME: This code is racy under a multi-threaded environment.
+ * Check what SIMD accelerations are supported, and keep only those in
+ * force_mask.  This is only ever called through jthread_once(), so it runs
+ * once per process.
  */
 LOCAL(void)
-init_simd(void)
+detect_simd_masked(unsigned int force_mask)
 {
 #ifndef NO_GETENV
   char *env = NULL;
 #endif
 
-  if (simd_support != ~0U)
-    return;
-
-  simd_support = jpeg_simd_cpu_support();
+  simd_support = jpeg_simd_cpu_support() & force_mask;
 
 #ifndef NO_GETENV
   /* Force different settings through environment variables */
@@ -78,6 +77,51 @@ init_simd(void)
 #endif
 }
 
+LOCAL(void)
+detect_simd(void)
+{
+  detect_simd_masked(~0U);
+}
+
+LOCAL(void)
+detect_simd_forcemmx(void)
+{
+  detect_simd_masked(JSIMD_MMX);
+}
+
+LOCAL(void)
+detect_simd_forcesse(void)
+{
+  detect_simd_masked(JSIMD_SSE | JSIMD_MMX);
+}
+
+LOCAL(void)
+detect_simd_forcesse2(void)
+{
+  detect_simd_masked(JSIMD_SSE2);
+}
+
+LOCAL(void)
+init_simd(void)
+{
+  jthread_once(&simd_once, detect_simd);
+}
+
+/*
+ * Whichever of these calls reaches jthread_once() first determines the
+ * SIMD accelerations for the rest of the process.
+ */
+GLOBAL(void)
+jsimd_force(int level)
+{
+  if (level == JSIMD_FORCEMMX)
+    jthread_once(&simd_once, detect_simd_forcemmx);
+  else if (level == JSIMD_FORCESSE)
+    jthread_once(&simd_once, detect_simd_forcesse);
+  else if (level == JSIMD_FORCESSE2)
+    jthread_once(&simd_once, detect_simd_forcesse2);
+}
+
 GLOBAL(int)
 jsimd_can_rgb_ycc(void)
 {
@@ -159,6 +203,54 @@ jsimd_can_ycc_rgb565(void)
   return 0;
 }
 
+GLOBAL(int)
+jsimd_can_ycc_rgb565D(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_cmyk_ycck(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_ycck_cmyk(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_cmyk_rgb(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_ycck_rgb(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_c_can_rgb_rgb(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_gray_rgb(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_rgb_rgb(void)
+{
+  return 0;
+}
+
 GLOBAL(void)
 jsimd_rgb_ycc_convert(j_compress_ptr cinfo, JSAMPARRAY input_buf,
                       JSAMPIMAGE output_buf, JDIMENSION output_row,
@@ -343,6 +435,62 @@ jsimd_ycc_rgb565_convert(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
 {
 }
 
+GLOBAL(void)
+jsimd_ycc_rgb565D_convert(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                          JDIMENSION input_row, JSAMPARRAY output_buf,
+                          int num_rows)
+{
+}
+
+GLOBAL(void)
+jsimd_cmyk_ycck_convert(j_compress_ptr cinfo, JSAMPARRAY input_buf,
+                        JSAMPIMAGE output_buf, JDIMENSION output_row,
+                        int num_rows)
+{
+}
+
+GLOBAL(void)
+jsimd_ycck_cmyk_convert(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                        JDIMENSION input_row, JSAMPARRAY output_buf,
+                        int num_rows)
+{
+}
+
+GLOBAL(void)
+jsimd_cmyk_rgb_convert(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                       JDIMENSION input_row, JSAMPARRAY output_buf,
+                       int num_rows)
+{
+}
+
+GLOBAL(void)
+jsimd_ycck_rgb_convert(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                       JDIMENSION input_row, JSAMPARRAY output_buf,
+                       int num_rows)
+{
+}
+
+GLOBAL(void)
+jsimd_c_rgb_rgb_convert(j_compress_ptr cinfo, JSAMPARRAY input_buf,
+                        JSAMPIMAGE output_buf, JDIMENSION output_row,
+                        int num_rows)
+{
+}
+
+GLOBAL(void)
+jsimd_gray_rgb_convert(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                       JDIMENSION input_row, JSAMPARRAY output_buf,
+                       int num_rows)
+{
+}
+
+GLOBAL(void)
+jsimd_rgb_rgb_convert(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                      JDIMENSION input_row, JSAMPARRAY output_buf,
+                      int num_rows)
+{
+}
+
 GLOBAL(int)
 jsimd_can_h2v2_downsample(void)
 {
@@ -425,6 +573,81 @@ jsimd_h2v1_downsample(j_compress_ptr cinfo, jpeg_component_info *compptr,
                               input_data, output_data);
 }
 
+GLOBAL(int)
+jsimd_can_h4v1_downsample(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_h4v2_downsample(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_h1v2_downsample(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_h2v4_downsample(void)
+{
+  return 0;
+}
+
+GLOBAL(void)
+jsimd_h4v1_downsample(j_compress_ptr cinfo, jpeg_component_info *compptr,
+                      JSAMPARRAY input_data, JSAMPARRAY output_data)
+{
+}
+
+GLOBAL(void)
+jsimd_h4v2_downsample(j_compress_ptr cinfo, jpeg_component_info *compptr,
+                      JSAMPARRAY input_data, JSAMPARRAY output_data)
+{
+}
+
+GLOBAL(void)
+jsimd_h1v2_downsample(j_compress_ptr cinfo, jpeg_component_info *compptr,
+                      JSAMPARRAY input_data, JSAMPARRAY output_data)
+{
+}
+
+GLOBAL(void)
+jsimd_h2v4_downsample(j_compress_ptr cinfo, jpeg_component_info *compptr,
+                      JSAMPARRAY input_data, JSAMPARRAY output_data)
+{
+}
+
+GLOBAL(int)
+jsimd_can_h2v2_smooth_downsample(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_fullsize_smooth_downsample(void)
+{
+  return 0;
+}
+
+GLOBAL(void)
+jsimd_h2v2_smooth_downsample(j_compress_ptr cinfo,
+                             jpeg_component_info *compptr,
+                             JSAMPARRAY input_data, JSAMPARRAY output_data)
+{
+}
+
+GLOBAL(void)
+jsimd_fullsize_smooth_downsample(j_compress_ptr cinfo,
+                                 jpeg_component_info *compptr,
+                                 JSAMPARRAY input_data,
+                                 JSAMPARRAY output_data)
+{
+}
+
 GLOBAL(int)
 jsimd_can_h2v2_upsample(void)
 {
@@ -497,6 +720,54 @@ jsimd_h2v1_upsample(j_decompress_ptr cinfo, jpeg_component_info *compptr,
                             input_data, output_data_ptr);
 }
 
+GLOBAL(int)
+jsimd_can_h4v1_upsample(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_h4v2_upsample(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_h1v2_upsample(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_h2v4_upsample(void)
+{
+  return 0;
+}
+
+GLOBAL(void)
+jsimd_h4v1_upsample(j_decompress_ptr cinfo, jpeg_component_info *compptr,
+                    JSAMPARRAY input_data, JSAMPARRAY *output_data_ptr)
+{
+}
+
+GLOBAL(void)
+jsimd_h4v2_upsample(j_decompress_ptr cinfo, jpeg_component_info *compptr,
+                    JSAMPARRAY input_data, JSAMPARRAY *output_data_ptr)
+{
+}
+
+GLOBAL(void)
+jsimd_h1v2_upsample(j_decompress_ptr cinfo, jpeg_component_info *compptr,
+                    JSAMPARRAY input_data, JSAMPARRAY *output_data_ptr)
+{
+}
+
+GLOBAL(void)
+jsimd_h2v4_upsample(j_decompress_ptr cinfo, jpeg_component_info *compptr,
+                    JSAMPARRAY input_data, JSAMPARRAY *output_data_ptr)
+{
+}
+
 GLOBAL(int)
 jsimd_can_h2v2_fancy_upsample(void)
 {
@@ -637,6 +908,30 @@ jsimd_can_h2v1_merged_upsample(void)
   return 0;
 }
 
+GLOBAL(int)
+jsimd_can_h2v2_merged_upsample_565(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_h2v1_merged_upsample_565(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_h2v2_fancy_merged_upsample(void)
+{
+  return 0;
+}
+
+GLOBAL(int)
+jsimd_can_h2v1_fancy_merged_upsample(void)
+{
+  return 0;
+}
+
 GLOBAL(void)
 jsimd_h2v2_merged_upsample(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
                            JDIMENSION in_row_group_ctr, JSAMPARRAY output_buf)
@@ -753,6 +1048,48 @@ jsimd_h2v1_merged_upsample(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
     mmxfct(cinfo->output_width, input_buf, in_row_group_ctr, output_buf);
 }
 
+GLOBAL(void)
+jsimd_h2v2_merged_upsample_565(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                               JDIMENSION in_row_group_ctr,
+                               JSAMPARRAY output_buf)
+{
+}
+
+GLOBAL(void)
+jsimd_h2v2_merged_upsample_565D(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                                JDIMENSION in_row_group_ctr,
+                                JSAMPARRAY output_buf)
+{
+}
+
+GLOBAL(void)
+jsimd_h2v1_merged_upsample_565(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                               JDIMENSION in_row_group_ctr,
+                               JSAMPARRAY output_buf)
+{
+}
+
+GLOBAL(void)
+jsimd_h2v1_merged_upsample_565D(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                                JDIMENSION in_row_group_ctr,
+                                JSAMPARRAY output_buf)
+{
+}
+
+GLOBAL(void)
+jsimd_h2v2_fancy_merged_upsample(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                                 JDIMENSION in_row_group_ctr,
+                                 JSAMPARRAY output_buf)
+{
+}
+
+GLOBAL(void)
+jsimd_h2v1_fancy_merged_upsample(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                                 JDIMENSION in_row_group_ctr,
+                                 JSAMPARRAY output_buf)
+{
+}
+
 GLOBAL(int)
 jsimd_can_convsamp(void)
 {
@@ -1058,6 +1395,19 @@ jsimd_idct_4x4(j_decompress_ptr cinfo, jpeg_component_info *compptr,
     jsimd_idct_4x4_mmx(compptr->dct_table, coef_block, output_buf, output_col);
 }
 
+GLOBAL(int)
+jsimd_can_idct_scaled(int scaled_size)
+{
+  return 0;
+}
+
+GLOBAL(void)
+jsimd_idct_scaled(j_decompress_ptr cinfo, jpeg_component_info *compptr,
+                  JCOEFPTR coef_block, JSAMPARRAY output_buf,
+                  JDIMENSION output_col)
+{
+}
+
 GLOBAL(int)
 jsimd_can_idct_islow(void)
 {
@@ -1185,6 +1535,32 @@ jsimd_idct_float(j_decompress_ptr cinfo, jpeg_component_info *compptr,
                            output_col);
 }
 
+GLOBAL(int)
+jsimd_can_idct_islow_corner4(void)
+{
+  return 0;
+}
+
+GLOBAL(void)
+jsimd_idct_islow_corner4(j_decompress_ptr cinfo, jpeg_component_info *compptr,
+                         JCOEFPTR coef_block, JSAMPARRAY output_buf,
+                         JDIMENSION output_col)
+{
+}
+
+GLOBAL(int)
+jsimd_can_idct_islow_blocks(void)
+{
+  return 0;
+}
+
+GLOBAL(void)
+jsimd_idct_islow_blocks(j_decompress_ptr cinfo, jpeg_component_info *compptr,
+                        JCOEFPTR coef_blocks, JSAMPARRAY output_buf,
+                        JDIMENSION output_col, JDIMENSION num_blocks)
+{
+}
+
 GLOBAL(int)
 jsimd_can_huff_encode_one_block(void)
 {
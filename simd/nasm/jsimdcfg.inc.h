@@ -129,3 +129,5 @@
 %define _cpp_protection_JSIMD_SSE    JSIMD_SSE
 %define _cpp_protection_JSIMD_SSE2   JSIMD_SSE2
 %define _cpp_protection_JSIMD_AVX2   JSIMD_AVX2
+%define _cpp_protection_JSIMD_BMI2   JSIMD_BMI2
+%define _cpp_protection_JSIMD_AVX512 JSIMD_AVX512
@@ -33,6 +33,13 @@
 ; r12 = JSAMPIMAGE output_buf
 ; r13d = JDIMENSION output_row
 ; r14d = int num_rows
+;
+; With CMYK_YCCK defined, this converts Adobe-style CMYK (RGBX with X=K and
+; RGB_RED=0, RGB_GREEN=1, RGB_BLUE=2) to YCCK instead: R=1-C, G=1-M and B=1-Y
+; are converted to YCbCr, and K is passed through to the fourth plane.
+;
+; With RGB_RGB defined, R, G and B are instead stored unchanged to the three
+; planes, as in rgb_rgb_convert() in jccolor.c.
 
 %define wk(i)   rbp - (WK_NUM - (i)) * SIZEOF_YMMWORD  ; ymmword wk[WK_NUM]
 %define WK_NUM  8
@@ -65,6 +72,10 @@ EXTN(jsimd_rgb_ycc_convert_avx2):
     lea         rdi, [rdi+rcx*SIZEOF_JSAMPROW]
     lea         rbx, [rbx+rcx*SIZEOF_JSAMPROW]
     lea         rdx, [rdx+rcx*SIZEOF_JSAMPROW]
+%ifdef CMYK_YCCK
+    mov         r8, JSAMPARRAY [rsi+3*SIZEOF_JSAMPARRAY]
+    lea         r8, [r8+rcx*SIZEOF_JSAMPROW]
+%endif
 
     pop         rcx
 
@@ -73,6 +84,9 @@ EXTN(jsimd_rgb_ycc_convert_avx2):
     test        rax, rax
     jle         near .return
 .rowloop:
+%ifdef CMYK_YCCK
+    push        r8
+%endif
     push        rdx
     push        rbx
     push        rdi
@@ -83,6 +97,9 @@ EXTN(jsimd_rgb_ycc_convert_avx2):
     mov         rdi, JSAMPROW [rdi]     ; outptr0
     mov         rbx, JSAMPROW [rbx]     ; outptr1
     mov         rdx, JSAMPROW [rdx]     ; outptr2
+%ifdef CMYK_YCCK
+    mov         r8, JSAMPROW [r8]       ; outptr3
+%endif
 
     cmp         rcx, byte SIZEOF_YMMWORD
     jae         near .columnloop
@@ -351,9 +368,40 @@ EXTN(jsimd_rgb_ycc_convert_avx2):
 
 %endif  ; RGB_PIXELSIZE ; ---------------
 
+%ifdef CMYK_YCCK
+    ; ymm6=K(02468ACEGIKMOQSU)=KE, ymm7=K(13579BDFHJLNPRTV)=KO
+
+    vpsllw      ymm7, ymm7, BYTE_BIT
+    vpor        ymm6, ymm6, ymm7        ; ymm6=K
+    vmovdqu     YMMWORD [r8], ymm6      ; Save K
+
+    vpcmpeqw    ymm7, ymm7, ymm7
+    vpsrlw      ymm7, ymm7, BYTE_BIT    ; ymm7={0xFF 0x00 0xFF 0x00 ..}
+    vpxor       ymm0, ymm0, ymm7        ; ymm0=(MAXJSAMPLE-CE)=RE
+    vpxor       ymm1, ymm1, ymm7        ; ymm1=(MAXJSAMPLE-CO)=RO
+    vpxor       ymm2, ymm2, ymm7        ; ymm2=(MAXJSAMPLE-ME)=GE
+    vpxor       ymm3, ymm3, ymm7        ; ymm3=(MAXJSAMPLE-MO)=GO
+    vpxor       ymm4, ymm4, ymm7        ; ymm4=(MAXJSAMPLE-YE)=BE
+    vpxor       ymm5, ymm5, ymm7        ; ymm5=(MAXJSAMPLE-YO)=BO
+%endif
+
     ; ymm0=R(02468ACEGIKMOQSU)=RE, ymm2=G(02468ACEGIKMOQSU)=GE, ymm4=B(02468ACEGIKMOQSU)=BE
     ; ymm1=R(13579BDFHJLNPRTV)=RO, ymm3=G(13579BDFHJLNPRTV)=GO, ymm5=B(13579BDFHJLNPRTV)=BO
 
+%ifdef RGB_RGB
+
+    vpsllw      ymm1, ymm1, BYTE_BIT
+    vpsllw      ymm3, ymm3, BYTE_BIT
+    vpsllw      ymm5, ymm5, BYTE_BIT
+    vpor        ymm0, ymm0, ymm1        ; ymm0=R
+    vpor        ymm2, ymm2, ymm3        ; ymm2=G
+    vpor        ymm4, ymm4, ymm5        ; ymm4=B
+    vmovdqu     YMMWORD [rdi], ymm0     ; Save R
+    vmovdqu     YMMWORD [rbx], ymm2     ; Save G
+    vmovdqu     YMMWORD [rdx], ymm4     ; Save B
+
+%else  ; RGB_RGB
+
     ; (Original)
     ; Y  =  0.29900 * R + 0.58700 * G + 0.11400 * B
     ; Cb = -0.16874 * R - 0.33126 * G + 0.50000 * B + CENTERJSAMPLE
@@ -523,11 +571,16 @@ EXTN(jsimd_rgb_ycc_convert_avx2):
     vpor        ymm1, ymm1, ymm7        ; ymm1=Cr
     vmovdqu     YMMWORD [rdx], ymm1     ; Save Cr
 
+%endif  ; RGB_RGB
+
     sub         rcx, byte SIZEOF_YMMWORD
     add         rsi, RGB_PIXELSIZE*SIZEOF_YMMWORD  ; inptr
     add         rdi, byte SIZEOF_YMMWORD           ; outptr0
     add         rbx, byte SIZEOF_YMMWORD           ; outptr1
     add         rdx, byte SIZEOF_YMMWORD           ; outptr2
+%ifdef CMYK_YCCK
+    add         r8, byte SIZEOF_YMMWORD            ; outptr3
+%endif
     cmp         rcx, byte SIZEOF_YMMWORD
     jae         near .columnloop
     test        rcx, rcx
@@ -538,6 +591,10 @@ EXTN(jsimd_rgb_ycc_convert_avx2):
     pop         rdi
     pop         rbx
     pop         rdx
+%ifdef CMYK_YCCK
+    pop         r8
+    add         r8, byte SIZEOF_JSAMPROW
+%endif
 
     add         rsi, byte SIZEOF_JSAMPROW  ; input_buf
     add         rdi, byte SIZEOF_JSAMPROW
@@ -32,6 +32,13 @@
 ; r12 = JSAMPIMAGE output_buf
 ; r13d = JDIMENSION output_row
 ; r14d = int num_rows
+;
+; With CMYK_YCCK defined, this converts Adobe-style CMYK (RGBX with X=K and
+; RGB_RED=0, RGB_GREEN=1, RGB_BLUE=2) to YCCK instead: R=1-C, G=1-M and B=1-Y
+; are converted to YCbCr, and K is passed through to the fourth plane.
+;
+; With RGB_RGB defined, R, G and B are instead stored unchanged to the three
+; planes, as in rgb_rgb_convert() in jccolor.c.
 
 %define wk(i)   rbp - (WK_NUM - (i)) * SIZEOF_XMMWORD  ; xmmword wk[WK_NUM]
 %define WK_NUM  8
@@ -64,6 +71,10 @@ EXTN(jsimd_rgb_ycc_convert_sse2):
     lea         rdi, [rdi+rcx*SIZEOF_JSAMPROW]
     lea         rbx, [rbx+rcx*SIZEOF_JSAMPROW]
     lea         rdx, [rdx+rcx*SIZEOF_JSAMPROW]
+%ifdef CMYK_YCCK
+    mov         r8, JSAMPARRAY [rsi+3*SIZEOF_JSAMPARRAY]
+    lea         r8, [r8+rcx*SIZEOF_JSAMPROW]
+%endif
 
     pop         rcx
 
@@ -72,6 +83,9 @@ EXTN(jsimd_rgb_ycc_convert_sse2):
     test        rax, rax
     jle         near .return
 .rowloop:
+%ifdef CMYK_YCCK
+    push        r8
+%endif
     push        rdx
     push        rbx
     push        rdi
@@ -82,6 +96,9 @@ EXTN(jsimd_rgb_ycc_convert_sse2):
     mov         rdi, JSAMPROW [rdi]     ; outptr0
     mov         rbx, JSAMPROW [rbx]     ; outptr1
     mov         rdx, JSAMPROW [rdx]     ; outptr2
+%ifdef CMYK_YCCK
+    mov         r8, JSAMPROW [r8]       ; outptr3
+%endif
 
     cmp         rcx, byte SIZEOF_XMMWORD
     jae         near .columnloop
@@ -277,9 +294,40 @@ EXTN(jsimd_rgb_ycc_convert_sse2):
 
 %endif  ; RGB_PIXELSIZE ; ---------------
 
+%ifdef CMYK_YCCK
+    ; xmm6=K(02468ACE)=KE, xmm7=K(13579BDF)=KO
+
+    psllw       xmm7, BYTE_BIT
+    por         xmm6, xmm7              ; xmm6=K
+    movdqa      XMMWORD [r8], xmm6      ; Save K
+
+    pcmpeqw     xmm7, xmm7
+    psrlw       xmm7, BYTE_BIT          ; xmm7={0xFF 0x00 0xFF 0x00 ..}
+    pxor        xmm0, xmm7              ; xmm0=(MAXJSAMPLE-CE)=RE
+    pxor        xmm1, xmm7              ; xmm1=(MAXJSAMPLE-CO)=RO
+    pxor        xmm2, xmm7              ; xmm2=(MAXJSAMPLE-ME)=GE
+    pxor        xmm3, xmm7              ; xmm3=(MAXJSAMPLE-MO)=GO
+    pxor        xmm4, xmm7              ; xmm4=(MAXJSAMPLE-YE)=BE
+    pxor        xmm5, xmm7              ; xmm5=(MAXJSAMPLE-YO)=BO
+%endif
+
     ; xmm0=R(02468ACE)=RE, xmm2=G(02468ACE)=GE, xmm4=B(02468ACE)=BE
     ; xmm1=R(13579BDF)=RO, xmm3=G(13579BDF)=GO, xmm5=B(13579BDF)=BO
 
+%ifdef RGB_RGB
+
+    psllw       xmm1, BYTE_BIT
+    psllw       xmm3, BYTE_BIT
+    psllw       xmm5, BYTE_BIT
+    por         xmm0, xmm1              ; xmm0=R
+    por         xmm2, xmm3              ; xmm2=G
+    por         xmm4, xmm5              ; xmm4=B
+    movdqa      XMMWORD [rdi], xmm0     ; Save R
+    movdqa      XMMWORD [rbx], xmm2     ; Save G
+    movdqa      XMMWORD [rdx], xmm4     ; Save B
+
+%else  ; RGB_RGB
+
     ; (Original)
     ; Y  =  0.29900 * R + 0.58700 * G + 0.11400 * B
     ; Cb = -0.16874 * R - 0.33126 * G + 0.50000 * B + CENTERJSAMPLE
@@ -449,11 +497,16 @@ EXTN(jsimd_rgb_ycc_convert_sse2):
     por         xmm1, xmm7              ; xmm1=Cr
     movdqa      XMMWORD [rdx], xmm1     ; Save Cr
 
+%endif  ; RGB_RGB
+
     sub         rcx, byte SIZEOF_XMMWORD
     add         rsi, byte RGB_PIXELSIZE*SIZEOF_XMMWORD  ; inptr
     add         rdi, byte SIZEOF_XMMWORD                ; outptr0
     add         rbx, byte SIZEOF_XMMWORD                ; outptr1
     add         rdx, byte SIZEOF_XMMWORD                ; outptr2
+%ifdef CMYK_YCCK
+    add         r8, byte SIZEOF_XMMWORD                 ; outptr3
+%endif
     cmp         rcx, byte SIZEOF_XMMWORD
     jae         near .columnloop
     test        rcx, rcx
@@ -464,6 +517,10 @@ EXTN(jsimd_rgb_ycc_convert_sse2):
     pop         rdi
     pop         rbx
     pop         rdx
+%ifdef CMYK_YCCK
+    pop         r8
+    add         r8, byte SIZEOF_JSAMPROW
+%endif
 
     add         rsi, byte SIZEOF_JSAMPROW  ; input_buf
     add         rdi, byte SIZEOF_JSAMPROW
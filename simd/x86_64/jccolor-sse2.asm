@@ -120,3 +120,15 @@ PD_ONEHALF      times 4 dd  (1 << (SCALEBITS - 1))
 %define RGB_PIXELSIZE  EXT_XRGB_PIXELSIZE
 %define jsimd_rgb_ycc_convert_sse2  jsimd_extxrgb_ycc_convert_sse2
 %include "jccolext-sse2.asm"
+
+%undef RGB_RED
+%undef RGB_GREEN
+%undef RGB_BLUE
+%undef RGB_PIXELSIZE
+%define RGB_RED  0
+%define RGB_GREEN  1
+%define RGB_BLUE  2
+%define RGB_PIXELSIZE  4
+%define CMYK_YCCK
+%define jsimd_rgb_ycc_convert_sse2  jsimd_cmyk_ycck_convert_sse2
+%include "jccolext-sse2.asm"
@@ -0,0 +1,294 @@
+;
+; jchuff-avx2.asm - Huffman entropy encoding (64-bit AVX2 & BMI2)
+;
+; Copyright (C) 2009-2011, 2014-2016, D. R. Commander.
+; Copyright (C) 2015, Matthieu Darbois.
+;
+; Based on the x86 SIMD extension for IJG JPEG library
+; Copyright (C) 1999-2006, MIYASAKA Masaru.
+; For conditions of distribution and use, see copyright notice in jsimdext.inc
+;
+; This file should be assembled with NASM (Netwide Assembler),
+; can *not* be assembled with Microsoft's MASM or any compatible
+; assembler (including Borland's Turbo Assembler).
+; NASM is available from http://nasm.sourceforge.net/ or
+; http://sourceforge.net/project/showfiles.php?group_id=6208
+;
+; This file contains an AVX2 & BMI2 implementation for Huffman coding of one
+; block.  The following code is based directly on jchuff.c and
+; jchuff-sse2.asm; see jchuff.c for more details.
+;
+; [TAB8]
+
+%include "jsimdext.inc"
+
+; --------------------------------------------------------------------------
+    SECTION     SEG_CONST
+
+    alignz      32
+    GLOBAL_DATA(jconst_huff_encode_one_block_avx2)
+
+EXTN(jconst_huff_encode_one_block_avx2):
+
+; vpshufb masks that gather the zero flags of the coefficients into zigzag
+; order.  PB_ZIGZAG_zq picks, for the 32 zigzag positions in half z of the
+; block, the flags that live in 128-bit quarter q of the packed flag vectors
+; (see below.)  All other positions are cleared.
+
+PB_ZIGZAG_00   db 0x00,0x01,0x80,0x08,0x80,0x02,0x03,0x80,0x09,0x80,0x80,0x80,0x0A,0x80,0x04,0x05
+               db 0x80,0x0B,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x0C,0x80,0x06,0x07,0x80,0x0D,0x80
+PB_ZIGZAG_01   db 0x80,0x80,0x00,0x80,0x01,0x80,0x80,0x02,0x80,0x08,0x80,0x09,0x80,0x03,0x80,0x80
+               db 0x04,0x80,0x0A,0x80,0x80,0x80,0x80,0x80,0x0B,0x80,0x05,0x80,0x80,0x06,0x80,0x0C
+PB_ZIGZAG_02   db 0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x00,0x80,0x80,0x80,0x80,0x80
+               db 0x80,0x80,0x80,0x01,0x80,0x08,0x80,0x02,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80
+PB_ZIGZAG_03   db 0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80
+               db 0x80,0x80,0x80,0x80,0x00,0x80,0x01,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80
+PB_ZIGZAG_10   db 0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x0E,0x80,0x0F,0x80,0x80,0x80,0x80
+               db 0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80
+PB_ZIGZAG_11   db 0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x0D,0x80,0x07,0x80,0x0E,0x80,0x80,0x80
+               db 0x80,0x80,0x80,0x80,0x80,0x0F,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80
+PB_ZIGZAG_12   db 0x03,0x80,0x09,0x80,0x80,0x0A,0x80,0x04,0x80,0x80,0x80,0x80,0x80,0x05,0x80,0x0B
+               db 0x80,0x80,0x0C,0x80,0x06,0x80,0x07,0x80,0x0D,0x80,0x80,0x0E,0x80,0x0F,0x80,0x80
+PB_ZIGZAG_13   db 0x80,0x02,0x80,0x08,0x09,0x80,0x03,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x04,0x80
+               db 0x0A,0x0B,0x80,0x05,0x80,0x80,0x80,0x06,0x80,0x0C,0x0D,0x80,0x07,0x80,0x0E,0x0F
+
+; jpeg_natural_order[], as bytes
+
+PB_NATURAL     db  0, 1, 8,16, 9, 2, 3,10,17,24,32,25,18,11, 4, 5
+               db 12,19,26,33,40,48,41,34,27,20,13, 6, 7,14,21,28
+               db 35,42,49,56,57,50,43,36,29,22,15,23,30,37,44,51
+               db 58,59,52,45,38,31,39,46,53,60,61,54,47,55,62,63
+
+    alignz      32
+
+; --------------------------------------------------------------------------
+    SECTION     SEG_TEXT
+    BITS        64
+
+; Unlike jchuff-sse2.asm, which empties the bit buffer one byte at a time,
+; these macros keep put_bits <= 31 between symbols and, once 32 or more bits
+; are pending, write 4 bytes with a single store.  The byte-by-byte path is
+; used only if one of those bytes is 0xFF and needs a zero byte stuffed after
+; it.  Since a Huffman code and its magnitude bits never need more than 32
+; bits, each symbol can then be inserted into the 64-bit bit buffer as one
+; combined bit string.
+
+%macro EMIT_BYTE 0
+    rol         edx, 8                  ; c = next byte of the 32-bit chunk;
+    mov         byte [buffer], dl       ; *buffer++ = c;
+    add         buffer, 1
+    cmp         dl, 0xFF                ; need to stuff a zero byte?
+    jne         %%.EMIT_BYTE_END
+    mov         byte [buffer], 0        ; *buffer++ = 0;
+    add         buffer, 1
+%%.EMIT_BYTE_END:
+%endmacro
+
+%macro PUT_BITS 2
+    shlx        put_buffer, put_buffer, %2  ; put_buffer = (put_buffer << size);
+    or          put_buffer, %1              ; put_buffer |= code;
+    add         put_bits, %2                ; put_bits += size;
+%endmacro
+
+%macro CHECKBUF31 0                     ; uses rcx, rdx
+    cmp         put_bits, 32            ; if (put_bits > 31) {
+    jb          %%.CHECKBUF31_END
+    sub         put_bits, 32            ;   put_bits -= 32;
+    shrx        rdx, put_buffer, put_bits
+    ; Does any of the 4 bytes in edx equal 0xFF?  (This is the well-known
+    ; "has a zero byte" test, applied to ~edx.)
+    mov         ecx, edx
+    not         ecx
+    sub         ecx, 0x01010101
+    and         ecx, edx
+    test        ecx, 0x80808080
+    jnz         %%.CHECKBUF31_STUFF
+    bswap       edx
+    mov         DWORD [buffer], edx     ;   emit 4 bytes at once
+    add         buffer, 4
+    jmp         %%.CHECKBUF31_END
+%%.CHECKBUF31_STUFF:
+    EMIT_BYTE
+    EMIT_BYTE
+    EMIT_BYTE
+    EMIT_BYTE
+%%.CHECKBUF31_END:
+%endmacro
+
+;
+; Encode a single block's worth of coefficients.
+;
+; GLOBAL(JOCTET *)
+; jsimd_huff_encode_one_block_avx2(working_state *state, JOCTET *buffer,
+;                                  JCOEFPTR block, int last_dc_val,
+;                                  c_derived_tbl *dctbl, c_derived_tbl *actbl)
+;
+
+; r10 = working_state *state
+; r11 = JOCTET *buffer
+; r12 = JCOEFPTR block
+; r13d = int last_dc_val
+; r14 = c_derived_tbl *dctbl
+; r15 = c_derived_tbl *actbl
+
+%define put_buffer  r8
+%define put_bits    r9
+%define buffer      rax
+%define index       r11
+
+    align       32
+    GLOBAL_FUNCTION(jsimd_huff_encode_one_block_avx2)
+
+EXTN(jsimd_huff_encode_one_block_avx2):
+    push        rbp
+    mov         rax, rsp                ; rax = original rbp
+    mov         rbp, rsp
+    collect_args 6
+    push        rbx
+
+    mov         buffer, r11             ; r11 is now scratch
+
+    mov         put_buffer, MMWORD [r10+16]  ; put_buffer = state->cur.put_buffer;
+    mov         r9d,         DWORD [r10+24]  ; put_bits = state->cur.put_bits;
+    push        r10                          ; r10 is now scratch
+
+    ; The caller may leave up to 63 bits in the bit buffer.
+    CHECKBUF31
+
+    ; Compute a 64-bit map of the nonzero coefficients in zigzag order.
+    ; Packing the cmpeq results to bytes interleaves the rows, so
+    ; ymm0=(00-07 16-23 08-15 24-31) and ymm2=(32-39 48-55 40-47 56-63).
+    ; Each 128-bit quarter is broadcast to both lanes, and the PB_ZIGZAG
+    ; masks move its flags to their zigzag positions.
+
+    vpxor       ymm4, ymm4, ymm4
+    vpcmpeqw    ymm0, ymm4, YMMWORD [r12+0*SIZEOF_YMMWORD]
+    vpcmpeqw    ymm1, ymm4, YMMWORD [r12+1*SIZEOF_YMMWORD]
+    vpcmpeqw    ymm2, ymm4, YMMWORD [r12+2*SIZEOF_YMMWORD]
+    vpcmpeqw    ymm3, ymm4, YMMWORD [r12+3*SIZEOF_YMMWORD]
+    vpacksswb   ymm0, ymm0, ymm1
+    vpacksswb   ymm2, ymm2, ymm3
+
+    vpermq      ymm4, ymm0, 0x44        ; ymm4=(00-07 16-23 00-07 16-23)
+    vpermq      ymm5, ymm0, 0xEE        ; ymm5=(08-15 24-31 08-15 24-31)
+    vpermq      ymm6, ymm2, 0x44        ; ymm6=(32-39 48-55 32-39 48-55)
+    vpermq      ymm7, ymm2, 0xEE        ; ymm7=(40-47 56-63 40-47 56-63)
+
+    vpshufb     ymm0, ymm4, [rel PB_ZIGZAG_00]
+    vpshufb     ymm1, ymm5, [rel PB_ZIGZAG_01]
+    vpshufb     ymm2, ymm6, [rel PB_ZIGZAG_02]
+    vpshufb     ymm3, ymm7, [rel PB_ZIGZAG_03]
+    vpor        ymm0, ymm0, ymm1
+    vpor        ymm2, ymm2, ymm3
+    vpor        ymm0, ymm0, ymm2        ; ymm0=zero flags of zigzag 0-31
+
+    vpshufb     ymm4, ymm4, [rel PB_ZIGZAG_10]
+    vpshufb     ymm5, ymm5, [rel PB_ZIGZAG_11]
+    vpshufb     ymm6, ymm6, [rel PB_ZIGZAG_12]
+    vpshufb     ymm7, ymm7, [rel PB_ZIGZAG_13]
+    vpor        ymm4, ymm4, ymm5
+    vpor        ymm6, ymm6, ymm7
+    vpor        ymm4, ymm4, ymm6        ; ymm4=zero flags of zigzag 32-63
+
+    vpmovmskb   r11d, ymm0
+    vpmovmskb   esi, ymm4
+    shl         rsi, 32
+    or          index, rsi
+    not         index                   ; index = ~index;
+    and         index, byte -2          ; skip the DC coefficient
+    vzeroupper
+
+    ; Encode the DC coefficient difference per section F.1.2.1
+    movsx       edi, word [r12]         ; temp = temp2 = block[0] - last_dc_val;
+    sub         edi, r13d               ; r13 is not used anymore
+    mov         esi, edi
+    neg         esi
+    cmovl       esi, edi                ; temp = abs(temp);
+    lea         esi, [rsi+rsi+1]
+    bsr         esi, esi                ; nbits = JPEG_NBITS(temp);
+    ; For a negative input, want temp2 = bitwise complement of abs(input)
+    mov         ecx, edi
+    sar         ecx, 31
+    add         edi, ecx                ; temp2 += temp >> 31;
+    bzhi        edi, edi, esi           ; temp2 &= (((JLONG)1)<<nbits) - 1;
+
+    ; Emit the Huffman-coded symbol for the number of bits, followed by that
+    ; number of bits of the value
+    mov         edx,  INT [r14 + rsi * 4]     ; code = dctbl->ehufco[nbits];
+    movzx       ecx, byte [r14 + rsi + 1024]  ; size = dctbl->ehufsi[nbits];
+    shlx        edx, edx, esi
+    or          edx, edi
+    add         ecx, esi
+    PUT_BITS    rdx, rcx                ; EMIT_BITS(code << nbits | temp2)
+    CHECKBUF31
+
+    lea         r14, [rel PB_NATURAL]   ; r14 is not used anymore
+    xor         r13d, r13d              ; k = 0;
+.BLOOP:
+    tzcnt       rcx, index              ; kk = __builtin_ctzl(index);
+    jc          .ELOOP
+    blsr        index, index            ; index &= index - 1;
+    mov         esi, ecx
+    sub         esi, r13d
+    sub         esi, 1                  ; r = kk - k - 1;
+    mov         r13d, ecx               ; k = kk;
+    movzx       ecx, byte [r14 + rcx]
+    movsx       edi, word [r12 + rcx * 2]  ; temp = block[jpeg_natural_order[k]];
+    cmp         esi, 16                 ; while (r > 15) {
+    jae         .BRLOOP
+.ERLOOP:
+    mov         ebx, edi
+    neg         ebx
+    cmovl       ebx, edi                ; temp = abs(temp);
+    lea         ebx, [rbx+rbx+1]
+    bsr         ebx, ebx                ; nbits = JPEG_NBITS(temp);
+    mov         ecx, edi
+    sar         ecx, 31
+    add         edi, ecx                ; temp2 += temp >> 31;
+    bzhi        edi, edi, ebx           ; temp2 &= (((JLONG)1)<<nbits) - 1;
+
+    ; Emit Huffman symbol for run length / number of bits, followed by the
+    ; magnitude bits
+    shl         esi, 4                        ; temp3 = (r << 4) + nbits;
+    add         esi, ebx
+    mov         edx,  INT [r15 + rsi * 4]     ; code = actbl->ehufco[temp3];
+    movzx       ecx, byte [r15 + rsi + 1024]  ; size = actbl->ehufsi[temp3];
+    shlx        edx, edx, ebx
+    or          edx, edi
+    add         ecx, ebx
+    PUT_BITS    rdx, rcx                ; EMIT_BITS(code << nbits | temp2)
+    CHECKBUF31
+    jmp         .BLOOP
+
+.BRLOOP:
+    mov         edx,  INT [r15 + 240 * 4]     ; code_0xf0 = actbl->ehufco[0xf0];
+    movzx       ecx, byte [r15 + 1024 + 240]  ; size_0xf0 = actbl->ehufsi[0xf0];
+    PUT_BITS    rdx, rcx                ; EMIT_BITS(code_0xf0, size_0xf0)
+    CHECKBUF31
+    sub         esi, 16                 ; r -= 16;
+    cmp         esi, 16
+    jae         .BRLOOP
+    jmp         .ERLOOP
+
+.ELOOP:
+    ; If the last coef(s) were zero, emit an end-of-block code
+    cmp         r13d, DCTSIZE2-1        ; if (k < DCTSIZE2 - 1) {
+    je          .EFN
+    mov         edx,  INT [r15]         ; code = actbl->ehufco[0];
+    movzx       ecx, byte [r15 + 1024]  ; size = actbl->ehufsi[0];
+    PUT_BITS    rdx, rcx                ; EMIT_BITS(code, size)
+    CHECKBUF31
+.EFN:
+    pop         r10
+    ; Save put_buffer & put_bits
+    mov         MMWORD [r10+16], put_buffer  ; state->cur.put_buffer = put_buffer;
+    mov         DWORD  [r10+24], r9d         ; state->cur.put_bits = put_bits;
+
+    pop         rbx
+    uncollect_args 6
+    pop         rbp
+    ret
+
+; For some reason, the OS X linker does not honor the request to align the
+; segment unless we do this.
+    align       32
@@ -363,6 +363,426 @@ EXTN(jsimd_h2v2_downsample_avx2):
     pop         rbp
     ret
 
+; --------------------------------------------------------------------------
+;
+; Downsample pixel values of a single component.
+; This version handles the standard case of 2:1 horizontal and 2:1 vertical,
+; with smoothing.  One row of context is required.
+;
+; As in h2v2_smooth_downsample() in jcsample.c, each output sample is the sum
+; of the four member samples, scaled by (1-5*SF)/4, and of the twelve
+; neighboring samples, scaled by SF/2 (edge-adjacent) or SF/4
+; (corner-adjacent), where SF = smoothing_factor / 1024.  The right edge is
+; expanded to a multiple of 32 input columns, so the column right of the last
+; group of 16 output samples is the last column of that group.
+;
+; GLOBAL(void)
+; jsimd_h2v2_smooth_downsample_avx2(JDIMENSION image_width,
+;                                   JDIMENSION v_samp_factor,
+;                                   int smoothing_factor,
+;                                   JDIMENSION width_in_blocks,
+;                                   JSAMPARRAY input_data,
+;                                   JSAMPARRAY output_data);
+;
+; max_v_samp_factor is 2 * v_samp_factor.
+;
+
+; r10d = JDIMENSION image_width
+; r11d = JDIMENSION v_samp_factor
+; r12d = int smoothing_factor
+; r13d = JDIMENSION width_in_blocks
+; r14 = JSAMPARRAY input_data
+; r15 = JSAMPARRAY output_data
+
+    align       32
+    GLOBAL_FUNCTION(jsimd_h2v2_smooth_downsample_avx2)
+
+EXTN(jsimd_h2v2_smooth_downsample_avx2):
+    push        rbp
+    mov         rax, rsp
+    mov         rbp, rsp
+    push_xmm    2
+    collect_args 6
+    push        rbx
+
+    mov         ecx, r13d
+    shl         rcx, 3                  ; imul rcx,DCTSIZE (rcx = output_cols)
+    jz          near .return
+
+    mov         edx, r10d
+
+    ; -- expand_right_edge (rows -1 .. max_v_samp_factor)
+
+    push        rcx
+    lea         rcx, [rcx*2+SIZEOF_YMMWORD-1]
+    and         rcx, byte -SIZEOF_YMMWORD  ; output_cols * 2, rounded up
+    sub         rcx, rdx
+    jle         short .expand_end
+
+    mov         eax, r11d
+    lea         rax, [rax*2+2]          ; max_v_samp_factor + 2
+    cld
+    mov         rsi, r14
+    sub         rsi, byte SIZEOF_JSAMPROW  ; input_data - 1
+.expandloop:
+    push        rax
+    push        rcx
+
+    mov         rdi, JSAMPROW [rsi]
+    add         rdi, rdx
+    mov         al, JSAMPLE [rdi-1]
+
+    rep stosb
+
+    pop         rcx
+    pop         rax
+
+    add         rsi, byte SIZEOF_JSAMPROW
+    dec         rax
+    jg          short .expandloop
+
+.expand_end:
+    pop         rcx                     ; output_cols
+
+    ; -- h2v2_smooth_downsample
+
+    test        r11d, r11d              ; rowctr
+    jz          near .return
+
+    mov         eax, r12d
+    imul        edx, eax, 16            ; neighscale = SF/4 scaled by 2^16
+    imul        eax, eax, -80
+    add         eax, 16384              ; memberscale = (1-5*SF)/4 scaled
+    shl         edx, WORD_BIT
+    or          eax, edx
+    vmovd       xmm7, eax
+    mov         eax, 1 << 15
+    vmovd       xmm6, eax
+    vpbroadcastd ymm7, xmm7             ; ymm7={memberscale, neighscale, ..}
+    vpbroadcastd ymm6, xmm6             ; ymm6={32768, 32768, ..}
+    vpcmpeqw    ymm5, ymm5, ymm5
+    vpsrlw      ymm5, ymm5, BYTE_BIT    ; ymm5={0xFF 0x00 0xFF 0x00 ..}
+
+    mov         rsi, r14                ; input_data
+    mov         rdi, r15                ; output_data
+.rowloop:
+    push        rcx
+    push        rdi
+    push        rsi
+
+    mov         rbx, JSAMPROW [rsi-1*SIZEOF_JSAMPROW]  ; above_ptr
+    mov         rdx, JSAMPROW [rsi+0*SIZEOF_JSAMPROW]  ; inptr0
+    mov         r8,  JSAMPROW [rsi+1*SIZEOF_JSAMPROW]  ; inptr1
+    mov         r9,  JSAMPROW [rsi+2*SIZEOF_JSAMPROW]  ; below_ptr
+    mov         rdi, JSAMPROW [rdi]                    ; outptr
+
+    ; The column left of the first one is the first one itself.
+    movzx       eax, JSAMPLE [rdx]
+    movzx       esi, JSAMPLE [r8]
+    add         eax, esi
+    add         eax, eax
+    movzx       esi, JSAMPLE [rbx]
+    add         eax, esi
+    movzx       esi, JSAMPLE [r9]
+    add         eax, esi
+    vmovd       xmm4, eax               ; ymm4=(-1 -- -- .. --)
+
+.columnloop:
+    vmovdqu     ymm0, YMMWORD [rbx]     ; ymm0=above
+    vmovdqu     ymm1, YMMWORD [rdx]     ; ymm1=row0
+    vmovdqu     ymm2, YMMWORD [r8]      ; ymm2=row1
+    vmovdqu     ymm3, YMMWORD [r9]      ; ymm3=below
+
+    vpand       ymm8, ymm1, ymm5
+    vpsrlw      ymm1, ymm1, BYTE_BIT
+    vpand       ymm9, ymm2, ymm5
+    vpsrlw      ymm2, ymm2, BYTE_BIT
+    vpaddw      ymm1, ymm1, ymm2        ; ymm1=MidO=row0+row1 (odd columns)
+    vpaddw      ymm8, ymm8, ymm9        ; ymm8=MidE=row0+row1 (even columns)
+
+    vpand       ymm2, ymm0, ymm5
+    vpsrlw      ymm0, ymm0, BYTE_BIT
+    vpand       ymm9, ymm3, ymm5
+    vpsrlw      ymm3, ymm3, BYTE_BIT
+    vpaddw      ymm0, ymm0, ymm3        ; ymm0=OutO=above+below (odd columns)
+    vpaddw      ymm2, ymm2, ymm9        ; ymm2=OutE=above+below (even columns)
+
+    vpaddw      ymm3, ymm8, ymm1        ; ymm3=membersum
+    vpaddw      ymm9, ymm0, ymm2
+    vpaddw      ymm9, ymm9, ymm9        ; ymm9=2*(above+below)
+
+    ; The columns left and right of each pair of member columns count as
+    ; 2*(row0+row1)+(above+below).
+
+    vpaddw      ymm1, ymm1, ymm1
+    vpaddw      ymm8, ymm8, ymm8
+    vpaddw      ymm1, ymm1, ymm0        ; ymm1=SideO=( 1  3  5 .. 29 31)
+    vpaddw      ymm8, ymm8, ymm2        ; ymm8=SideE=( 0  2  4 .. 28 30)
+
+    vperm2i128  ymm0, ymm1, ymm1, 0x08  ; ymm0=(-- .. -- 1 3 .. 15)
+    vpalignr    ymm0, ymm1, ymm0, 14
+    vpor        ymm0, ymm0, ymm4        ; ymm0=(-1  1  3 .. 27 29)
+    vperm2i128  ymm4, ymm1, ymm1, 0x81
+    vpsrldq     ymm4, ymm4, (SIZEOF_XMMWORD-2)  ; ymm4=(31 -- -- .. --)
+    vperm2i128  ymm2, ymm8, ymm8, 0x81  ; ymm2=(16 18 .. 30 -- .. --)
+    vpalignr    ymm8, ymm2, ymm8, 2     ; ymm8=( 2  4 .. 30 --)
+    vpaddw      ymm9, ymm9, ymm0
+    vpaddw      ymm9, ymm9, ymm8
+
+    sub         rcx, byte SIZEOF_YMMWORD/2  ; outcol
+    jle         short .lastcolumn
+
+    movzx       eax, JSAMPLE [rdx+SIZEOF_YMMWORD]
+    movzx       esi, JSAMPLE [r8+SIZEOF_YMMWORD]
+    add         eax, esi
+    add         eax, eax
+    movzx       esi, JSAMPLE [rbx+SIZEOF_YMMWORD]
+    add         eax, esi
+    movzx       esi, JSAMPLE [r9+SIZEOF_YMMWORD]
+    add         eax, esi
+    vmovd       xmm0, eax
+    jmp         short .neighsum
+
+.lastcolumn:
+    ; The column right of the last one is the last one itself.
+    vmovdqa     xmm0, xmm4
+
+.neighsum:
+    vpslldq     xmm0, xmm0, (SIZEOF_XMMWORD-2)
+    vperm2i128  ymm0, ymm0, ymm0, 0x08  ; ymm0=(-- -- .. -- 32)
+    vpaddw      ymm9, ymm9, ymm0        ; ymm9=neighsum
+
+    vpunpckhwd  ymm0, ymm3, ymm9
+    vpunpcklwd  ymm3, ymm3, ymm9
+    vpmaddwd    ymm0, ymm0, ymm7
+    vpmaddwd    ymm3, ymm3, ymm7
+    vpaddd      ymm0, ymm0, ymm6
+    vpaddd      ymm3, ymm3, ymm6
+    vpsrld      ymm0, ymm0, WORD_BIT
+    vpsrld      ymm3, ymm3, WORD_BIT
+    vpackssdw   ymm3, ymm3, ymm0
+    vpackuswb   ymm3, ymm3, ymm3
+    vpermq      ymm3, ymm3, 0x08
+
+    vmovdqu     XMMWORD [rdi], xmm3
+
+    add         rbx, byte SIZEOF_YMMWORD    ; above_ptr
+    add         rdx, byte SIZEOF_YMMWORD    ; inptr0
+    add         r8,  byte SIZEOF_YMMWORD    ; inptr1
+    add         r9,  byte SIZEOF_YMMWORD    ; below_ptr
+    add         rdi, byte SIZEOF_YMMWORD/2  ; outptr
+    test        rcx, rcx
+    jg          near .columnloop
+
+    pop         rsi
+    pop         rdi
+    pop         rcx
+
+    add         rsi, byte 2*SIZEOF_JSAMPROW  ; input_data
+    add         rdi, byte 1*SIZEOF_JSAMPROW  ; output_data
+    dec         r11d                         ; rowctr
+    jg          near .rowloop
+
+.return:
+    vzeroupper
+    pop         rbx
+    uncollect_args 6
+    pop_xmm     2
+    pop         rbp
+    ret
+
+; --------------------------------------------------------------------------
+;
+; Downsample pixel values of a single component.
+; This version handles the special case of a full-size component, with
+; smoothing.  One row of context is required.
+;
+; As in fullsize_smooth_downsample() in jcsample.c, each output sample is the
+; input sample scaled by 1-8*SF plus its eight neighbors scaled by SF.  The
+; scale factors, which are multiples of 64 when expressed in units of 2^-16,
+; are divided by 64 so that they fit in a word.  The right edge is expanded to
+; a multiple of 16 columns.
+;
+; GLOBAL(void)
+; jsimd_fullsize_smooth_downsample_avx2(JDIMENSION image_width,
+;                                       JDIMENSION v_samp_factor,
+;                                       int smoothing_factor,
+;                                       JDIMENSION width_in_blocks,
+;                                       JSAMPARRAY input_data,
+;                                       JSAMPARRAY output_data);
+;
+; max_v_samp_factor is v_samp_factor.
+;
+
+; r10d = JDIMENSION image_width
+; r11d = JDIMENSION v_samp_factor
+; r12d = int smoothing_factor
+; r13d = JDIMENSION width_in_blocks
+; r14 = JSAMPARRAY input_data
+; r15 = JSAMPARRAY output_data
+
+    align       32
+    GLOBAL_FUNCTION(jsimd_fullsize_smooth_downsample_avx2)
+
+EXTN(jsimd_fullsize_smooth_downsample_avx2):
+    push        rbp
+    mov         rax, rsp
+    mov         rbp, rsp
+    collect_args 6
+    push        rbx
+
+    mov         ecx, r13d
+    shl         rcx, 3                  ; imul rcx,DCTSIZE (rcx = output_cols)
+    jz          near .return
+
+    mov         edx, r10d
+
+    ; -- expand_right_edge (rows -1 .. max_v_samp_factor)
+
+    push        rcx
+    add         rcx, byte SIZEOF_XMMWORD-1
+    and         rcx, byte -SIZEOF_XMMWORD  ; output_cols, rounded up
+    sub         rcx, rdx
+    jle         short .expand_end
+
+    mov         eax, r11d
+    add         rax, byte 2             ; max_v_samp_factor + 2
+    cld
+    mov         rsi, r14
+    sub         rsi, byte SIZEOF_JSAMPROW  ; input_data - 1
+.expandloop:
+    push        rax
+    push        rcx
+
+    mov         rdi, JSAMPROW [rsi]
+    add         rdi, rdx
+    mov         al, JSAMPLE [rdi-1]
+
+    rep stosb
+
+    pop         rcx
+    pop         rax
+
+    add         rsi, byte SIZEOF_JSAMPROW
+    dec         rax
+    jg          short .expandloop
+
+.expand_end:
+    pop         rcx                     ; output_cols
+
+    ; -- fullsize_smooth_downsample
+
+    test        r11d, r11d              ; rowctr
+    jz          near .return
+
+    mov         eax, r12d
+    mov         edx, eax                ; neighscale = SF scaled by 2^10
+    imul        eax, eax, -8
+    add         eax, 1024               ; memberscale = 1-8*SF scaled by 2^10
+    shl         edx, WORD_BIT
+    or          eax, edx
+    vmovd       xmm7, eax
+    mov         eax, 1 << 9
+    vmovd       xmm6, eax
+    vpbroadcastd ymm7, xmm7             ; ymm7={memberscale, neighscale, ..}
+    vpbroadcastd ymm6, xmm6             ; ymm6={512, 512, ..}
+
+    mov         rsi, r14                ; input_data
+    mov         rdi, r15                ; output_data
+.rowloop:
+    push        rcx
+    push        rdi
+    push        rsi
+
+    mov         rbx, JSAMPROW [rsi-1*SIZEOF_JSAMPROW]  ; above_ptr
+    mov         rdx, JSAMPROW [rsi+0*SIZEOF_JSAMPROW]  ; inptr
+    mov         r9,  JSAMPROW [rsi+1*SIZEOF_JSAMPROW]  ; below_ptr
+    mov         rdi, JSAMPROW [rdi]                    ; outptr
+
+    ; The column left of the first one is the first one itself.
+    movzx       eax, JSAMPLE [rdx]
+    movzx       esi, JSAMPLE [rbx]
+    add         eax, esi
+    movzx       esi, JSAMPLE [r9]
+    add         eax, esi
+    vmovd       xmm4, eax               ; ymm4=(-1 -- -- .. --)
+
+.columnloop:
+    vpmovzxbw   ymm0, XMMWORD [rbx]     ; ymm0=above
+    vpmovzxbw   ymm1, XMMWORD [rdx]     ; ymm1=row=membersum
+    vpmovzxbw   ymm2, XMMWORD [r9]      ; ymm2=below
+
+    vpaddw      ymm0, ymm0, ymm2
+    vpaddw      ymm0, ymm0, ymm1        ; ymm0=colsum=( 0  1  2 .. 14 15)
+    vpsubw      ymm3, ymm0, ymm1        ; ymm3=colsum-membersum
+
+    vperm2i128  ymm2, ymm0, ymm0, 0x08  ; ymm2=(-- .. --  0  1 ..  7)
+    vpalignr    ymm2, ymm0, ymm2, 14
+    vpor        ymm2, ymm2, ymm4        ; ymm2=(-1  0  1 .. 13 14)
+    vperm2i128  ymm4, ymm0, ymm0, 0x81
+    vpsrldq     ymm4, ymm4, (SIZEOF_XMMWORD-2)  ; ymm4=(15 -- -- .. --)
+    vperm2i128  ymm5, ymm0, ymm0, 0x81  ; ymm5=( 8  9 .. 15 -- .. --)
+    vpalignr    ymm0, ymm5, ymm0, 2     ; ymm0=( 1  2 .. 15 --)
+    vpaddw      ymm3, ymm3, ymm2
+    vpaddw      ymm3, ymm3, ymm0
+
+    sub         rcx, byte SIZEOF_XMMWORD  ; outcol
+    jle         short .lastcolumn
+
+    movzx       eax, JSAMPLE [rdx+SIZEOF_XMMWORD]
+    movzx       esi, JSAMPLE [rbx+SIZEOF_XMMWORD]
+    add         eax, esi
+    movzx       esi, JSAMPLE [r9+SIZEOF_XMMWORD]
+    add         eax, esi
+    vmovd       xmm0, eax
+    jmp         short .neighsum
+
+.lastcolumn:
+    ; The column right of the last one is the last one itself.
+    vmovdqa     xmm0, xmm4
+
+.neighsum:
+    vpslldq     xmm0, xmm0, (SIZEOF_XMMWORD-2)
+    vperm2i128  ymm0, ymm0, ymm0, 0x08  ; ymm0=(-- -- .. -- 16)
+    vpaddw      ymm3, ymm3, ymm0        ; ymm3=neighsum
+
+    vpunpckhwd  ymm0, ymm1, ymm3
+    vpunpcklwd  ymm1, ymm1, ymm3
+    vpmaddwd    ymm0, ymm0, ymm7
+    vpmaddwd    ymm1, ymm1, ymm7
+    vpaddd      ymm0, ymm0, ymm6
+    vpaddd      ymm1, ymm1, ymm6
+    vpsrld      ymm0, ymm0, 10
+    vpsrld      ymm1, ymm1, 10
+    vpackssdw   ymm1, ymm1, ymm0
+    vpackuswb   ymm1, ymm1, ymm1
+    vpermq      ymm1, ymm1, 0x08
+
+    vmovdqu     XMMWORD [rdi], xmm1
+
+    add         rbx, byte SIZEOF_XMMWORD  ; above_ptr
+    add         rdx, byte SIZEOF_XMMWORD  ; inptr
+    add         r9,  byte SIZEOF_XMMWORD  ; below_ptr
+    add         rdi, byte SIZEOF_XMMWORD  ; outptr
+    test        rcx, rcx
+    jg          near .columnloop
+
+    pop         rsi
+    pop         rdi
+    pop         rcx
+
+    add         rsi, byte SIZEOF_JSAMPROW  ; input_data
+    add         rdi, byte SIZEOF_JSAMPROW  ; output_data
+    dec         r11d                       ; rowctr
+    jg          near .rowloop
+
+.return:
+    vzeroupper
+    pop         rbx
+    uncollect_args 6
+    pop         rbp
+    ret
+
 ; For some reason, the OS X linker does not honor the request to align the
 ; segment unless we do this.
     align       32
@@ -326,6 +326,1125 @@ EXTN(jsimd_h2v2_downsample_sse2):
     pop         rbp
     ret
 
+; --------------------------------------------------------------------------
+;
+; Downsample pixel values of a single component.
+; This version handles the case of 4:1 horizontal and 1:1 vertical (4:1:1),
+; without smoothing.  Like int_downsample() in jcsample.c, it rounds the
+; average of each group of samples half up.
+;
+; GLOBAL(void)
+; jsimd_h4v1_downsample_sse2(JDIMENSION image_width, int max_v_samp_factor,
+;                            JDIMENSION v_samp_factor,
+;                            JDIMENSION width_in_blocks, JSAMPARRAY input_data,
+;                            JSAMPARRAY output_data);
+;
+
+; r10d = JDIMENSION image_width
+; r11 = int max_v_samp_factor
+; r12d = JDIMENSION v_samp_factor
+; r13d = JDIMENSION width_in_blocks
+; r14 = JSAMPARRAY input_data
+; r15 = JSAMPARRAY output_data
+
+    align       32
+    GLOBAL_FUNCTION(jsimd_h4v1_downsample_sse2)
+
+EXTN(jsimd_h4v1_downsample_sse2):
+    push        rbp
+    mov         rax, rsp
+    mov         rbp, rsp
+    collect_args 6
+
+    mov         ecx, r13d
+    shl         rcx, 3                  ; imul rcx,DCTSIZE (rcx = output_cols)
+    jz          near .return
+
+    mov         edx, r10d
+
+    ; -- expand_right_edge
+
+    push        rcx
+    shl         rcx, 2                  ; output_cols * 4
+    sub         rcx, rdx
+    jle         short .expand_end
+
+    mov         rax, r11
+    test        rax, rax
+    jle         short .expand_end
+
+    cld
+    mov         rsi, r14                ; input_data
+.expandloop:
+    push        rax
+    push        rcx
+
+    mov         rdi, JSAMPROW [rsi]
+    add         rdi, rdx
+    mov         al, JSAMPLE [rdi-1]
+
+    rep stosb
+
+    pop         rcx
+    pop         rax
+
+    add         rsi, byte SIZEOF_JSAMPROW
+    dec         rax
+    jg          short .expandloop
+
+.expand_end:
+    pop         rcx                     ; output_cols
+
+    ; -- h4v1_downsample
+
+    mov         eax, r12d               ; rowctr
+    test        eax, eax
+    jle         near .return
+
+    mov         edx, 2                  ; bias
+    movd        xmm7, edx
+    pcmpeqw     xmm6, xmm6
+    pcmpeqw     xmm5, xmm5
+    pshufd      xmm7, xmm7, 0x00        ; xmm7={2, 2, 2, 2}
+    psrlw       xmm6, BYTE_BIT          ; xmm6={0xFF 0x00 0xFF 0x00 ..}
+    psrlw       xmm5, WORD_BIT-1        ; xmm5={1, 1, 1, 1, 1, 1, 1, 1}
+
+    mov         rsi, r14                ; input_data
+    mov         rdi, r15                ; output_data
+.rowloop:
+    push        rcx
+    push        rdi
+    push        rsi
+
+    mov         rsi, JSAMPROW [rsi]     ; inptr
+    mov         rdi, JSAMPROW [rdi]     ; outptr
+
+    cmp         rcx, byte SIZEOF_XMMWORD
+    jae         short .columnloop
+
+.columnloop_r8:
+    movdqa      xmm0, XMMWORD [rsi+0*SIZEOF_XMMWORD]
+    movdqa      xmm1, XMMWORD [rsi+1*SIZEOF_XMMWORD]
+    pxor        xmm2, xmm2
+    pxor        xmm3, xmm3
+    mov         rcx, SIZEOF_XMMWORD
+    jmp         short .downsample
+
+.columnloop:
+    movdqa      xmm0, XMMWORD [rsi+0*SIZEOF_XMMWORD]
+    movdqa      xmm1, XMMWORD [rsi+1*SIZEOF_XMMWORD]
+    movdqa      xmm2, XMMWORD [rsi+2*SIZEOF_XMMWORD]
+    movdqa      xmm3, XMMWORD [rsi+3*SIZEOF_XMMWORD]
+
+.downsample:
+    movdqa      xmm4, xmm0
+    pand        xmm0, xmm6
+    psrlw       xmm4, BYTE_BIT
+    paddw       xmm0, xmm4
+    movdqa      xmm4, xmm1
+    pand        xmm1, xmm6
+    psrlw       xmm4, BYTE_BIT
+    paddw       xmm1, xmm4
+    movdqa      xmm4, xmm2
+    pand        xmm2, xmm6
+    psrlw       xmm4, BYTE_BIT
+    paddw       xmm2, xmm4
+    movdqa      xmm4, xmm3
+    pand        xmm3, xmm6
+    psrlw       xmm4, BYTE_BIT
+    paddw       xmm3, xmm4
+
+    pmaddwd     xmm0, xmm5              ; sum each group of 4 samples
+    pmaddwd     xmm1, xmm5
+    pmaddwd     xmm2, xmm5
+    pmaddwd     xmm3, xmm5
+    paddd       xmm0, xmm7
+    paddd       xmm1, xmm7
+    paddd       xmm2, xmm7
+    paddd       xmm3, xmm7
+    psrld       xmm0, 2
+    psrld       xmm1, 2
+    psrld       xmm2, 2
+    psrld       xmm3, 2
+
+    packssdw    xmm0, xmm1
+    packssdw    xmm2, xmm3
+    packuswb    xmm0, xmm2
+
+    movdqa      XMMWORD [rdi+0*SIZEOF_XMMWORD], xmm0
+
+    sub         rcx, byte SIZEOF_XMMWORD    ; outcol
+    add         rsi, byte 4*SIZEOF_XMMWORD  ; inptr
+    add         rdi, byte 1*SIZEOF_XMMWORD  ; outptr
+    cmp         rcx, byte SIZEOF_XMMWORD
+    jae         short .columnloop
+    test        rcx, rcx
+    jnz         short .columnloop_r8
+
+    pop         rsi
+    pop         rdi
+    pop         rcx
+
+    add         rsi, byte SIZEOF_JSAMPROW  ; input_data
+    add         rdi, byte SIZEOF_JSAMPROW  ; output_data
+    dec         rax                        ; rowctr
+    jg          near .rowloop
+
+.return:
+    uncollect_args 6
+    pop         rbp
+    ret
+
+; --------------------------------------------------------------------------
+;
+; Downsample pixel values of a single component.
+; This version handles the case of 4:1 horizontal and 2:1 vertical (4:1:0),
+; without smoothing.  Like int_downsample() in jcsample.c, it rounds the
+; average of each group of samples half up.
+;
+; GLOBAL(void)
+; jsimd_h4v2_downsample_sse2(JDIMENSION image_width, int max_v_samp_factor,
+;                            JDIMENSION v_samp_factor,
+;                            JDIMENSION width_in_blocks, JSAMPARRAY input_data,
+;                            JSAMPARRAY output_data);
+;
+
+; r10d = JDIMENSION image_width
+; r11 = int max_v_samp_factor
+; r12d = JDIMENSION v_samp_factor
+; r13d = JDIMENSION width_in_blocks
+; r14 = JSAMPARRAY input_data
+; r15 = JSAMPARRAY output_data
+
+    align       32
+    GLOBAL_FUNCTION(jsimd_h4v2_downsample_sse2)
+
+EXTN(jsimd_h4v2_downsample_sse2):
+    push        rbp
+    mov         rax, rsp
+    mov         rbp, rsp
+    push_xmm    4
+    collect_args 6
+
+    mov         ecx, r13d
+    shl         rcx, 3                  ; imul rcx,DCTSIZE (rcx = output_cols)
+    jz          near .return
+
+    mov         edx, r10d
+
+    ; -- expand_right_edge
+
+    push        rcx
+    shl         rcx, 2                  ; output_cols * 4
+    sub         rcx, rdx
+    jle         short .expand_end
+
+    mov         rax, r11
+    test        rax, rax
+    jle         short .expand_end
+
+    cld
+    mov         rsi, r14                ; input_data
+.expandloop:
+    push        rax
+    push        rcx
+
+    mov         rdi, JSAMPROW [rsi]
+    add         rdi, rdx
+    mov         al, JSAMPLE [rdi-1]
+
+    rep stosb
+
+    pop         rcx
+    pop         rax
+
+    add         rsi, byte SIZEOF_JSAMPROW
+    dec         rax
+    jg          short .expandloop
+
+.expand_end:
+    pop         rcx                     ; output_cols
+
+    ; -- h4v2_downsample
+
+    mov         eax, r12d               ; rowctr
+    test        rax, rax
+    jle         near .return
+
+    mov         edx, 4                  ; bias
+    movd        xmm7, edx
+    pcmpeqw     xmm6, xmm6
+    pcmpeqw     xmm5, xmm5
+    pshufd      xmm7, xmm7, 0x00        ; xmm7={4, 4, 4, 4}
+    psrlw       xmm6, BYTE_BIT          ; xmm6={0xFF 0x00 0xFF 0x00 ..}
+    psrlw       xmm5, WORD_BIT-1        ; xmm5={1, 1, 1, 1, 1, 1, 1, 1}
+
+    mov         rsi, r14                ; input_data
+    mov         rdi, r15                ; output_data
+.rowloop:
+    push        rcx
+    push        rdi
+    push        rsi
+
+    mov         rdx, JSAMPROW [rsi+0*SIZEOF_JSAMPROW]  ; inptr0
+    mov         rsi, JSAMPROW [rsi+1*SIZEOF_JSAMPROW]  ; inptr1
+    mov         rdi, JSAMPROW [rdi]                    ; outptr
+
+    cmp         rcx, byte SIZEOF_XMMWORD
+    jae         short .columnloop
+
+.columnloop_r8:
+    movdqa      xmm0, XMMWORD [rdx+0*SIZEOF_XMMWORD]
+    movdqa      xmm8, XMMWORD [rsi+0*SIZEOF_XMMWORD]
+    movdqa      xmm1, XMMWORD [rdx+1*SIZEOF_XMMWORD]
+    movdqa      xmm9, XMMWORD [rsi+1*SIZEOF_XMMWORD]
+    pxor        xmm2, xmm2
+    pxor        xmm10, xmm10
+    pxor        xmm3, xmm3
+    pxor        xmm11, xmm11
+    mov         rcx, SIZEOF_XMMWORD
+    jmp         near .downsample
+
+.columnloop:
+    movdqa      xmm0, XMMWORD [rdx+0*SIZEOF_XMMWORD]
+    movdqa      xmm8, XMMWORD [rsi+0*SIZEOF_XMMWORD]
+    movdqa      xmm1, XMMWORD [rdx+1*SIZEOF_XMMWORD]
+    movdqa      xmm9, XMMWORD [rsi+1*SIZEOF_XMMWORD]
+    movdqa      xmm2, XMMWORD [rdx+2*SIZEOF_XMMWORD]
+    movdqa      xmm10, XMMWORD [rsi+2*SIZEOF_XMMWORD]
+    movdqa      xmm3, XMMWORD [rdx+3*SIZEOF_XMMWORD]
+    movdqa      xmm11, XMMWORD [rsi+3*SIZEOF_XMMWORD]
+
+.downsample:
+    movdqa      xmm4, xmm0
+    pand        xmm0, xmm6
+    psrlw       xmm4, BYTE_BIT
+    paddw       xmm0, xmm4
+    movdqa      xmm4, xmm8
+    pand        xmm8, xmm6
+    psrlw       xmm4, BYTE_BIT
+    paddw       xmm0, xmm8
+    paddw       xmm0, xmm4
+
+    movdqa      xmm4, xmm1
+    pand        xmm1, xmm6
+    psrlw       xmm4, BYTE_BIT
+    paddw       xmm1, xmm4
+    movdqa      xmm4, xmm9
+    pand        xmm9, xmm6
+    psrlw       xmm4, BYTE_BIT
+    paddw       xmm1, xmm9
+    paddw       xmm1, xmm4
+
+    movdqa      xmm4, xmm2
+    pand        xmm2, xmm6
+    psrlw       xmm4, BYTE_BIT
+    paddw       xmm2, xmm4
+    movdqa      xmm4, xmm10
+    pand        xmm10, xmm6
+    psrlw       xmm4, BYTE_BIT
+    paddw       xmm2, xmm10
+    paddw       xmm2, xmm4
+
+    movdqa      xmm4, xmm3
+    pand        xmm3, xmm6
+    psrlw       xmm4, BYTE_BIT
+    paddw       xmm3, xmm4
+    movdqa      xmm4, xmm11
+    pand        xmm11, xmm6
+    psrlw       xmm4, BYTE_BIT
+    paddw       xmm3, xmm11
+    paddw       xmm3, xmm4
+
+    pmaddwd     xmm0, xmm5              ; sum each group of 8 samples
+    pmaddwd     xmm1, xmm5
+    pmaddwd     xmm2, xmm5
+    pmaddwd     xmm3, xmm5
+    paddd       xmm0, xmm7
+    paddd       xmm1, xmm7
+    paddd       xmm2, xmm7
+    paddd       xmm3, xmm7
+    psrld       xmm0, 3
+    psrld       xmm1, 3
+    psrld       xmm2, 3
+    psrld       xmm3, 3
+
+    packssdw    xmm0, xmm1
+    packssdw    xmm2, xmm3
+    packuswb    xmm0, xmm2
+
+    movdqa      XMMWORD [rdi+0*SIZEOF_XMMWORD], xmm0
+
+    sub         rcx, byte SIZEOF_XMMWORD    ; outcol
+    add         rdx, byte 4*SIZEOF_XMMWORD  ; inptr0
+    add         rsi, byte 4*SIZEOF_XMMWORD  ; inptr1
+    add         rdi, byte 1*SIZEOF_XMMWORD  ; outptr
+    cmp         rcx, byte SIZEOF_XMMWORD
+    jae         near .columnloop
+    test        rcx, rcx
+    jnz         near .columnloop_r8
+
+    pop         rsi
+    pop         rdi
+    pop         rcx
+
+    add         rsi, byte 2*SIZEOF_JSAMPROW  ; input_data
+    add         rdi, byte 1*SIZEOF_JSAMPROW  ; output_data
+    dec         rax                          ; rowctr
+    jg          near .rowloop
+
+.return:
+    uncollect_args 6
+    pop_xmm     4
+    pop         rbp
+    ret
+
+; --------------------------------------------------------------------------
+;
+; Downsample pixel values of a single component.
+; This version handles the case of 1:1 horizontal and 2:1 vertical (4:4:0),
+; without smoothing.  Like int_downsample() in jcsample.c, it rounds the
+; average of each pair of samples half up, which is what pavgb does.
+;
+; GLOBAL(void)
+; jsimd_h1v2_downsample_sse2(JDIMENSION image_width, int max_v_samp_factor,
+;                            JDIMENSION v_samp_factor,
+;                            JDIMENSION width_in_blocks, JSAMPARRAY input_data,
+;                            JSAMPARRAY output_data);
+;
+
+; r10d = JDIMENSION image_width
+; r11 = int max_v_samp_factor
+; r12d = JDIMENSION v_samp_factor
+; r13d = JDIMENSION width_in_blocks
+; r14 = JSAMPARRAY input_data
+; r15 = JSAMPARRAY output_data
+
+    align       32
+    GLOBAL_FUNCTION(jsimd_h1v2_downsample_sse2)
+
+EXTN(jsimd_h1v2_downsample_sse2):
+    push        rbp
+    mov         rax, rsp
+    mov         rbp, rsp
+    collect_args 6
+
+    mov         ecx, r13d
+    shl         rcx, 3                  ; imul rcx,DCTSIZE (rcx = output_cols)
+    jz          near .return
+
+    mov         edx, r10d
+
+    ; -- expand_right_edge
+
+    push        rcx
+    sub         rcx, rdx                ; output_cols * 1
+    jle         short .expand_end
+
+    mov         rax, r11
+    test        rax, rax
+    jle         short .expand_end
+
+    cld
+    mov         rsi, r14                ; input_data
+.expandloop:
+    push        rax
+    push        rcx
+
+    mov         rdi, JSAMPROW [rsi]
+    add         rdi, rdx
+    mov         al, JSAMPLE [rdi-1]
+
+    rep stosb
+
+    pop         rcx
+    pop         rax
+
+    add         rsi, byte SIZEOF_JSAMPROW
+    dec         rax
+    jg          short .expandloop
+
+.expand_end:
+    pop         rcx                     ; output_cols
+
+    ; -- h1v2_downsample
+
+    mov         eax, r12d               ; rowctr
+    test        rax, rax
+    jle         near .return
+
+    mov         rsi, r14                ; input_data
+    mov         rdi, r15                ; output_data
+.rowloop:
+    push        rcx
+    push        rdi
+    push        rsi
+
+    mov         rdx, JSAMPROW [rsi+0*SIZEOF_JSAMPROW]  ; inptr0
+    mov         rsi, JSAMPROW [rsi+1*SIZEOF_JSAMPROW]  ; inptr1
+    mov         rdi, JSAMPROW [rdi]                    ; outptr
+
+    cmp         rcx, byte SIZEOF_XMMWORD
+    jae         short .columnloop
+
+.columnloop_r8:
+    movq        xmm0, XMM_MMWORD [rdx+0*SIZEOF_XMMWORD]
+    movq        xmm1, XMM_MMWORD [rsi+0*SIZEOF_XMMWORD]
+    mov         rcx, SIZEOF_XMMWORD
+    jmp         short .downsample
+
+.columnloop:
+    movdqa      xmm0, XMMWORD [rdx+0*SIZEOF_XMMWORD]
+    movdqa      xmm1, XMMWORD [rsi+0*SIZEOF_XMMWORD]
+
+.downsample:
+    pavgb       xmm0, xmm1
+
+    movdqa      XMMWORD [rdi+0*SIZEOF_XMMWORD], xmm0
+
+    sub         rcx, byte SIZEOF_XMMWORD    ; outcol
+    add         rdx, byte 1*SIZEOF_XMMWORD  ; inptr0
+    add         rsi, byte 1*SIZEOF_XMMWORD  ; inptr1
+    add         rdi, byte 1*SIZEOF_XMMWORD  ; outptr
+    cmp         rcx, byte SIZEOF_XMMWORD
+    jae         short .columnloop
+    test        rcx, rcx
+    jnz         short .columnloop_r8
+
+    pop         rsi
+    pop         rdi
+    pop         rcx
+
+    add         rsi, byte 2*SIZEOF_JSAMPROW  ; input_data
+    add         rdi, byte 1*SIZEOF_JSAMPROW  ; output_data
+    dec         rax                          ; rowctr
+    jg          near .rowloop
+
+.return:
+    uncollect_args 6
+    pop         rbp
+    ret
+
+; --------------------------------------------------------------------------
+;
+; Downsample pixel values of a single component.
+; This version handles the case of 2:1 horizontal and 4:1 vertical, without
+; smoothing.  Like int_downsample() in jcsample.c, it rounds the average of
+; each group of samples half up.
+;
+; GLOBAL(void)
+; jsimd_h2v4_downsample_sse2(JDIMENSION image_width, int max_v_samp_factor,
+;                            JDIMENSION v_samp_factor,
+;                            JDIMENSION width_in_blocks, JSAMPARRAY input_data,
+;                            JSAMPARRAY output_data);
+;
+
+; r10d = JDIMENSION image_width
+; r11 = int max_v_samp_factor
+; r12d = JDIMENSION v_samp_factor
+; r13d = JDIMENSION width_in_blocks
+; r14 = JSAMPARRAY input_data
+; r15 = JSAMPARRAY output_data
+
+    align       32
+    GLOBAL_FUNCTION(jsimd_h2v4_downsample_sse2)
+
+EXTN(jsimd_h2v4_downsample_sse2):
+    push        rbp
+    mov         rax, rsp
+    mov         rbp, rsp
+    push_xmm    4
+    collect_args 6
+
+    mov         ecx, r13d
+    shl         rcx, 3                  ; imul rcx,DCTSIZE (rcx = output_cols)
+    jz          near .return
+
+    mov         edx, r10d
+
+    ; -- expand_right_edge
+
+    push        rcx
+    shl         rcx, 1                  ; output_cols * 2
+    sub         rcx, rdx
+    jle         short .expand_end
+
+    mov         rax, r11
+    test        rax, rax
+    jle         short .expand_end
+
+    cld
+    mov         rsi, r14                ; input_data
+.expandloop:
+    push        rax
+    push        rcx
+
+    mov         rdi, JSAMPROW [rsi]
+    add         rdi, rdx
+    mov         al, JSAMPLE [rdi-1]
+
+    rep stosb
+
+    pop         rcx
+    pop         rax
+
+    add         rsi, byte SIZEOF_JSAMPROW
+    dec         rax
+    jg          short .expandloop
+
+.expand_end:
+    pop         rcx                     ; output_cols
+
+    ; -- h2v4_downsample
+
+    mov         eax, r12d               ; rowctr
+    test        rax, rax
+    jle         near .return
+
+    mov         edx, 0x00040004         ; bias
+    movd        xmm7, edx
+    pcmpeqw     xmm6, xmm6
+    pshufd      xmm7, xmm7, 0x00        ; xmm7={4, 4, 4, 4, 4, 4, 4, 4}
+    psrlw       xmm6, BYTE_BIT          ; xmm6={0xFF 0x00 0xFF 0x00 ..}
+
+    mov         rsi, r14                ; input_data
+    mov         rdi, r15                ; output_data
+.rowloop:
+    push        rcx
+    push        rdi
+    push        rsi
+
+    mov         rdx, JSAMPROW [rsi+0*SIZEOF_JSAMPROW]  ; inptr0
+    mov         r8,  JSAMPROW [rsi+1*SIZEOF_JSAMPROW]  ; inptr1
+    mov         r9,  JSAMPROW [rsi+2*SIZEOF_JSAMPROW]  ; inptr2
+    mov         rsi, JSAMPROW [rsi+3*SIZEOF_JSAMPROW]  ; inptr3
+    mov         rdi, JSAMPROW [rdi]                    ; outptr
+
+    cmp         rcx, byte SIZEOF_XMMWORD
+    jae         short .columnloop
+
+.columnloop_r8:
+    movdqa      xmm0, XMMWORD [rdx+0*SIZEOF_XMMWORD]
+    movdqa      xmm1, XMMWORD [r8+0*SIZEOF_XMMWORD]
+    movdqa      xmm2, XMMWORD [r9+0*SIZEOF_XMMWORD]
+    movdqa      xmm3, XMMWORD [rsi+0*SIZEOF_XMMWORD]
+    pxor        xmm8, xmm8
+    pxor        xmm9, xmm9
+    pxor        xmm10, xmm10
+    pxor        xmm11, xmm11
+    mov         rcx, SIZEOF_XMMWORD
+    jmp         short .downsample
+
+.columnloop:
+    movdqa      xmm0, XMMWORD [rdx+0*SIZEOF_XMMWORD]
+    movdqa      xmm1, XMMWORD [r8+0*SIZEOF_XMMWORD]
+    movdqa      xmm2, XMMWORD [r9+0*SIZEOF_XMMWORD]
+    movdqa      xmm3, XMMWORD [rsi+0*SIZEOF_XMMWORD]
+    movdqa      xmm8, XMMWORD [rdx+1*SIZEOF_XMMWORD]
+    movdqa      xmm9, XMMWORD [r8+1*SIZEOF_XMMWORD]
+    movdqa      xmm10, XMMWORD [r9+1*SIZEOF_XMMWORD]
+    movdqa      xmm11, XMMWORD [rsi+1*SIZEOF_XMMWORD]
+
+.downsample:
+    movdqa      xmm4, xmm0
+    movdqa      xmm5, xmm1
+    pand        xmm0, xmm6
+    psrlw       xmm4, BYTE_BIT
+    pand        xmm1, xmm6
+    psrlw       xmm5, BYTE_BIT
+    paddw       xmm0, xmm4
+    paddw       xmm1, xmm5
+    movdqa      xmm4, xmm2
+    movdqa      xmm5, xmm3
+    pand        xmm2, xmm6
+    psrlw       xmm4, BYTE_BIT
+    pand        xmm3, xmm6
+    psrlw       xmm5, BYTE_BIT
+    paddw       xmm2, xmm4
+    paddw       xmm3, xmm5
+    paddw       xmm0, xmm1
+    paddw       xmm2, xmm3
+    paddw       xmm0, xmm2              ; xmm0=( 0  1  2  3  4  5  6  7)
+
+    movdqa      xmm4, xmm8
+    movdqa      xmm5, xmm9
+    pand        xmm8, xmm6
+    psrlw       xmm4, BYTE_BIT
+    pand        xmm9, xmm6
+    psrlw       xmm5, BYTE_BIT
+    paddw       xmm8, xmm4
+    paddw       xmm9, xmm5
+    movdqa      xmm4, xmm10
+    movdqa      xmm5, xmm11
+    pand        xmm10, xmm6
+    psrlw       xmm4, BYTE_BIT
+    pand        xmm11, xmm6
+    psrlw       xmm5, BYTE_BIT
+    paddw       xmm10, xmm4
+    paddw       xmm11, xmm5
+    paddw       xmm8, xmm9
+    paddw       xmm10, xmm11
+    paddw       xmm8, xmm10             ; xmm8=( 8  9 10 11 12 13 14 15)
+
+    paddw       xmm0, xmm7
+    paddw       xmm8, xmm7
+    psrlw       xmm0, 3
+    psrlw       xmm8, 3
+
+    packuswb    xmm0, xmm8
+
+    movdqa      XMMWORD [rdi+0*SIZEOF_XMMWORD], xmm0
+
+    sub         rcx, byte SIZEOF_XMMWORD    ; outcol
+    add         rdx, byte 2*SIZEOF_XMMWORD  ; inptr0
+    add         r8,  byte 2*SIZEOF_XMMWORD  ; inptr1
+    add         r9,  byte 2*SIZEOF_XMMWORD  ; inptr2
+    add         rsi, byte 2*SIZEOF_XMMWORD  ; inptr3
+    add         rdi, byte 1*SIZEOF_XMMWORD  ; outptr
+    cmp         rcx, byte SIZEOF_XMMWORD
+    jae         near .columnloop
+    test        rcx, rcx
+    jnz         near .columnloop_r8
+
+    pop         rsi
+    pop         rdi
+    pop         rcx
+
+    add         rsi, byte 4*SIZEOF_JSAMPROW  ; input_data
+    add         rdi, byte 1*SIZEOF_JSAMPROW  ; output_data
+    dec         rax                          ; rowctr
+    jg          near .rowloop
+
+.return:
+    uncollect_args 6
+    pop_xmm     4
+    pop         rbp
+    ret
+
+; --------------------------------------------------------------------------
+;
+; Downsample pixel values of a single component.
+; This version handles the standard case of 2:1 horizontal and 2:1 vertical,
+; with smoothing.  One row of context is required.
+;
+; As in h2v2_smooth_downsample() in jcsample.c, each output sample is the sum
+; of the four member samples, scaled by (1-5*SF)/4, and of the twelve
+; neighboring samples, scaled by SF/2 (edge-adjacent) or SF/4
+; (corner-adjacent), where SF = smoothing_factor / 1024.  The column just
+; left of each group of 8 output samples is carried over from the previous
+; group, and the one just right of it is read from the next group; the first
+; and last columns of each row are replicated.
+;
+; GLOBAL(void)
+; jsimd_h2v2_smooth_downsample_sse2(JDIMENSION image_width,
+;                                   JDIMENSION v_samp_factor,
+;                                   int smoothing_factor,
+;                                   JDIMENSION width_in_blocks,
+;                                   JSAMPARRAY input_data,
+;                                   JSAMPARRAY output_data);
+;
+; max_v_samp_factor is 2 * v_samp_factor.
+;
+
+; r10d = JDIMENSION image_width
+; r11d = JDIMENSION v_samp_factor
+; r12d = int smoothing_factor
+; r13d = JDIMENSION width_in_blocks
+; r14 = JSAMPARRAY input_data
+; r15 = JSAMPARRAY output_data
+
+    align       32
+    GLOBAL_FUNCTION(jsimd_h2v2_smooth_downsample_sse2)
+
+EXTN(jsimd_h2v2_smooth_downsample_sse2):
+    push        rbp
+    mov         rax, rsp
+    mov         rbp, rsp
+    push_xmm    2
+    collect_args 6
+    push        rbx
+
+    mov         ecx, r13d
+    shl         rcx, 3                  ; imul rcx,DCTSIZE (rcx = output_cols)
+    jz          near .return
+
+    mov         edx, r10d
+
+    ; -- expand_right_edge (rows -1 .. max_v_samp_factor)
+
+    push        rcx
+    shl         rcx, 1                  ; output_cols * 2
+    sub         rcx, rdx
+    jle         short .expand_end
+
+    mov         eax, r11d
+    lea         rax, [rax*2+2]          ; max_v_samp_factor + 2
+    cld
+    mov         rsi, r14
+    sub         rsi, byte SIZEOF_JSAMPROW  ; input_data - 1
+.expandloop:
+    push        rax
+    push        rcx
+
+    mov         rdi, JSAMPROW [rsi]
+    add         rdi, rdx
+    mov         al, JSAMPLE [rdi-1]
+
+    rep stosb
+
+    pop         rcx
+    pop         rax
+
+    add         rsi, byte SIZEOF_JSAMPROW
+    dec         rax
+    jg          short .expandloop
+
+.expand_end:
+    pop         rcx                     ; output_cols
+
+    ; -- h2v2_smooth_downsample
+
+    test        r11d, r11d              ; rowctr
+    jz          near .return
+
+    mov         eax, r12d
+    imul        edx, eax, 16            ; neighscale = SF/4 scaled by 2^16
+    imul        eax, eax, -80
+    add         eax, 16384              ; memberscale = (1-5*SF)/4 scaled
+    shl         edx, WORD_BIT
+    or          eax, edx
+    movd        xmm7, eax
+    mov         eax, 1 << 15
+    movd        xmm6, eax
+    pshufd      xmm7, xmm7, 0x00        ; xmm7={memberscale, neighscale, ..}
+    pshufd      xmm6, xmm6, 0x00        ; xmm6={32768, 32768, 32768, 32768}
+    pcmpeqw     xmm5, xmm5
+    psrlw       xmm5, BYTE_BIT          ; xmm5={0xFF 0x00 0xFF 0x00 ..}
+
+    mov         rsi, r14                ; input_data
+    mov         rdi, r15                ; output_data
+.rowloop:
+    push        rcx
+    push        rdi
+    push        rsi
+
+    mov         rbx, JSAMPROW [rsi-1*SIZEOF_JSAMPROW]  ; above_ptr
+    mov         rdx, JSAMPROW [rsi+0*SIZEOF_JSAMPROW]  ; inptr0
+    mov         r8,  JSAMPROW [rsi+1*SIZEOF_JSAMPROW]  ; inptr1
+    mov         r9,  JSAMPROW [rsi+2*SIZEOF_JSAMPROW]  ; below_ptr
+    mov         rdi, JSAMPROW [rdi]                    ; outptr
+
+    ; The column left of the first one is the first one itself.
+    movzx       eax, JSAMPLE [rdx]
+    movzx       esi, JSAMPLE [r8]
+    add         eax, esi
+    add         eax, eax
+    movzx       esi, JSAMPLE [rbx]
+    add         eax, esi
+    movzx       esi, JSAMPLE [r9]
+    add         eax, esi
+    movd        xmm4, eax               ; xmm4=(-1 -- -- -- -- -- -- --)
+
+.columnloop:
+    movdqa      xmm0, XMMWORD [rbx]     ; xmm0=above
+    movdqa      xmm1, XMMWORD [rdx]     ; xmm1=row0
+    movdqa      xmm2, XMMWORD [r8]      ; xmm2=row1
+    movdqa      xmm3, XMMWORD [r9]      ; xmm3=below
+
+    movdqa      xmm8, xmm1
+    movdqa      xmm9, xmm2
+    psrlw       xmm1, BYTE_BIT
+    pand        xmm8, xmm5
+    psrlw       xmm2, BYTE_BIT
+    pand        xmm9, xmm5
+    paddw       xmm1, xmm2              ; xmm1=MidO=row0+row1 (odd columns)
+    paddw       xmm8, xmm9              ; xmm8=MidE=row0+row1 (even columns)
+
+    movdqa      xmm2, xmm0
+    movdqa      xmm9, xmm3
+    psrlw       xmm0, BYTE_BIT
+    pand        xmm2, xmm5
+    psrlw       xmm3, BYTE_BIT
+    pand        xmm9, xmm5
+    paddw       xmm0, xmm3              ; xmm0=OutO=above+below (odd columns)
+    paddw       xmm2, xmm9              ; xmm2=OutE=above+below (even columns)
+
+    movdqa      xmm3, xmm8
+    paddw       xmm3, xmm1              ; xmm3=membersum
+    movdqa      xmm9, xmm0
+    paddw       xmm9, xmm2
+    paddw       xmm9, xmm9              ; xmm9=2*(above+below)
+
+    ; The columns left and right of each pair of member columns count as
+    ; 2*(row0+row1)+(above+below).
+
+    paddw       xmm1, xmm1
+    paddw       xmm8, xmm8
+    paddw       xmm1, xmm0              ; xmm1=SideO=( 1  3  5  7  9 11 13 15)
+    paddw       xmm8, xmm2              ; xmm8=SideE=( 0  2  4  6  8 10 12 14)
+
+    movdqa      xmm0, xmm1
+    pslldq      xmm0, 2
+    por         xmm0, xmm4              ; xmm0=(-1  1  3  5  7  9 11 13)
+    movdqa      xmm4, xmm1
+    psrldq      xmm4, (SIZEOF_XMMWORD-2)  ; xmm4=(15 -- -- -- -- -- -- --)
+    psrldq      xmm8, 2                 ; xmm8=( 2  4  6  8 10 12 14 --)
+    paddw       xmm9, xmm0
+    paddw       xmm9, xmm8
+
+    sub         rcx, byte SIZEOF_XMMWORD/2  ; outcol
+    jz          short .lastcolumn
+
+    movzx       eax, JSAMPLE [rdx+SIZEOF_XMMWORD]
+    movzx       esi, JSAMPLE [r8+SIZEOF_XMMWORD]
+    add         eax, esi
+    add         eax, eax
+    movzx       esi, JSAMPLE [rbx+SIZEOF_XMMWORD]
+    add         eax, esi
+    movzx       esi, JSAMPLE [r9+SIZEOF_XMMWORD]
+    add         eax, esi
+    movd        xmm0, eax
+    pslldq      xmm0, (SIZEOF_XMMWORD-2)  ; xmm0=(-- -- -- -- -- -- -- 16)
+    jmp         short .neighsum
+
+.lastcolumn:
+    ; The column right of the last one is the last one itself.
+    movdqa      xmm0, xmm4
+    pslldq      xmm0, (SIZEOF_XMMWORD-2)  ; xmm0=(-- -- -- -- -- -- -- 15)
+
+.neighsum:
+    paddw       xmm9, xmm0              ; xmm9=neighsum
+
+    movdqa      xmm0, xmm3
+    punpcklwd   xmm3, xmm9
+    punpckhwd   xmm0, xmm9
+    pmaddwd     xmm3, xmm7
+    pmaddwd     xmm0, xmm7
+    paddd       xmm3, xmm6
+    paddd       xmm0, xmm6
+    psrld       xmm3, WORD_BIT
+    psrld       xmm0, WORD_BIT
+    packssdw    xmm3, xmm0
+    packuswb    xmm3, xmm3
+
+    movq        XMM_MMWORD [rdi], xmm3
+
+    add         rbx, byte SIZEOF_XMMWORD    ; above_ptr
+    add         rdx, byte SIZEOF_XMMWORD    ; inptr0
+    add         r8,  byte SIZEOF_XMMWORD    ; inptr1
+    add         r9,  byte SIZEOF_XMMWORD    ; below_ptr
+    add         rdi, byte SIZEOF_XMMWORD/2  ; outptr
+    test        rcx, rcx
+    jnz         near .columnloop
+
+    pop         rsi
+    pop         rdi
+    pop         rcx
+
+    add         rsi, byte 2*SIZEOF_JSAMPROW  ; input_data
+    add         rdi, byte 1*SIZEOF_JSAMPROW  ; output_data
+    dec         r11d                         ; rowctr
+    jg          near .rowloop
+
+.return:
+    pop         rbx
+    uncollect_args 6
+    pop_xmm     2
+    pop         rbp
+    ret
+
+; --------------------------------------------------------------------------
+;
+; Downsample pixel values of a single component.
+; This version handles the special case of a full-size component, with
+; smoothing.  One row of context is required.
+;
+; As in fullsize_smooth_downsample() in jcsample.c, each output sample is the
+; input sample scaled by 1-8*SF plus its eight neighbors scaled by SF.  The
+; scale factors, which are multiples of 64 when expressed in units of 2^-16,
+; are divided by 64 so that they fit in a word.
+;
+; GLOBAL(void)
+; jsimd_fullsize_smooth_downsample_sse2(JDIMENSION image_width,
+;                                       JDIMENSION v_samp_factor,
+;                                       int smoothing_factor,
+;                                       JDIMENSION width_in_blocks,
+;                                       JSAMPARRAY input_data,
+;                                       JSAMPARRAY output_data);
+;
+; max_v_samp_factor is v_samp_factor.
+;
+
+; r10d = JDIMENSION image_width
+; r11d = JDIMENSION v_samp_factor
+; r12d = int smoothing_factor
+; r13d = JDIMENSION width_in_blocks
+; r14 = JSAMPARRAY input_data
+; r15 = JSAMPARRAY output_data
+
+    align       32
+    GLOBAL_FUNCTION(jsimd_fullsize_smooth_downsample_sse2)
+
+EXTN(jsimd_fullsize_smooth_downsample_sse2):
+    push        rbp
+    mov         rax, rsp
+    mov         rbp, rsp
+    collect_args 6
+    push        rbx
+
+    mov         ecx, r13d
+    shl         rcx, 3                  ; imul rcx,DCTSIZE (rcx = output_cols)
+    jz          near .return
+
+    mov         edx, r10d
+
+    ; -- expand_right_edge (rows -1 .. max_v_samp_factor)
+
+    push        rcx
+    sub         rcx, rdx                ; output_cols * 1
+    jle         short .expand_end
+
+    mov         eax, r11d
+    add         rax, byte 2             ; max_v_samp_factor + 2
+    cld
+    mov         rsi, r14
+    sub         rsi, byte SIZEOF_JSAMPROW  ; input_data - 1
+.expandloop:
+    push        rax
+    push        rcx
+
+    mov         rdi, JSAMPROW [rsi]
+    add         rdi, rdx
+    mov         al, JSAMPLE [rdi-1]
+
+    rep stosb
+
+    pop         rcx
+    pop         rax
+
+    add         rsi, byte SIZEOF_JSAMPROW
+    dec         rax
+    jg          short .expandloop
+
+.expand_end:
+    pop         rcx                     ; output_cols
+
+    ; -- fullsize_smooth_downsample
+
+    test        r11d, r11d              ; rowctr
+    jz          near .return
+
+    mov         eax, r12d
+    mov         edx, eax                ; neighscale = SF scaled by 2^10
+    imul        eax, eax, -8
+    add         eax, 1024               ; memberscale = 1-8*SF scaled by 2^10
+    shl         edx, WORD_BIT
+    or          eax, edx
+    movd        xmm7, eax
+    mov         eax, 1 << 9
+    movd        xmm6, eax
+    pshufd      xmm7, xmm7, 0x00        ; xmm7={memberscale, neighscale, ..}
+    pshufd      xmm6, xmm6, 0x00        ; xmm6={512, 512, 512, 512}
+    pxor        xmm5, xmm5              ; xmm5=(all 0's)
+
+    mov         rsi, r14                ; input_data
+    mov         rdi, r15                ; output_data
+.rowloop:
+    push        rcx
+    push        rdi
+    push        rsi
+
+    mov         rbx, JSAMPROW [rsi-1*SIZEOF_JSAMPROW]  ; above_ptr
+    mov         rdx, JSAMPROW [rsi+0*SIZEOF_JSAMPROW]  ; inptr
+    mov         r9,  JSAMPROW [rsi+1*SIZEOF_JSAMPROW]  ; below_ptr
+    mov         rdi, JSAMPROW [rdi]                    ; outptr
+
+    ; The column left of the first one is the first one itself.
+    movzx       eax, JSAMPLE [rdx]
+    movzx       esi, JSAMPLE [rbx]
+    add         eax, esi
+    movzx       esi, JSAMPLE [r9]
+    add         eax, esi
+    movd        xmm4, eax               ; xmm4=(-1 -- -- -- -- -- -- --)
+
+.columnloop:
+    movq        xmm0, XMM_MMWORD [rbx]  ; xmm0=above
+    movq        xmm1, XMM_MMWORD [rdx]  ; xmm1=row
+    movq        xmm2, XMM_MMWORD [r9]   ; xmm2=below
+    punpcklbw   xmm0, xmm5
+    punpcklbw   xmm1, xmm5              ; xmm1=membersum
+    punpcklbw   xmm2, xmm5
+
+    paddw       xmm0, xmm2
+    paddw       xmm0, xmm1              ; xmm0=colsum=( 0  1  2  3  4  5  6  7)
+    movdqa      xmm3, xmm0
+    psubw       xmm3, xmm1              ; xmm3=colsum-membersum
+
+    movdqa      xmm2, xmm0
+    pslldq      xmm2, 2
+    por         xmm2, xmm4              ; xmm2=(-1  0  1  2  3  4  5  6)
+    movdqa      xmm4, xmm0
+    psrldq      xmm4, (SIZEOF_XMMWORD-2)  ; xmm4=( 7 -- -- -- -- -- -- --)
+    psrldq      xmm0, 2                 ; xmm0=( 1  2  3  4  5  6  7 --)
+    paddw       xmm3, xmm2
+    paddw       xmm3, xmm0
+
+    sub         rcx, byte SIZEOF_MMWORD  ; outcol
+    jz          short .lastcolumn
+
+    movzx       eax, JSAMPLE [rdx+SIZEOF_MMWORD]
+    movzx       esi, JSAMPLE [rbx+SIZEOF_MMWORD]
+    add         eax, esi
+    movzx       esi, JSAMPLE [r9+SIZEOF_MMWORD]
+    add         eax, esi
+    movd        xmm0, eax
+    pslldq      xmm0, (SIZEOF_XMMWORD-2)  ; xmm0=(-- -- -- -- -- -- --  8)
+    jmp         short .neighsum
+
+.lastcolumn:
+    ; The column right of the last one is the last one itself.
+    movdqa      xmm0, xmm4
+    pslldq      xmm0, (SIZEOF_XMMWORD-2)  ; xmm0=(-- -- -- -- -- -- --  7)
+
+.neighsum:
+    paddw       xmm3, xmm0              ; xmm3=neighsum
+
+    movdqa      xmm0, xmm1
+    punpcklwd   xmm1, xmm3
+    punpckhwd   xmm0, xmm3
+    pmaddwd     xmm1, xmm7
+    pmaddwd     xmm0, xmm7
+    paddd       xmm1, xmm6
+    paddd       xmm0, xmm6
+    psrld       xmm1, 10
+    psrld       xmm0, 10
+    packssdw    xmm1, xmm0
+    packuswb    xmm1, xmm1
+
+    movq        XMM_MMWORD [rdi], xmm1
+
+    add         rbx, byte SIZEOF_MMWORD  ; above_ptr
+    add         rdx, byte SIZEOF_MMWORD  ; inptr
+    add         r9,  byte SIZEOF_MMWORD  ; below_ptr
+    add         rdi, byte SIZEOF_MMWORD  ; outptr
+    test        rcx, rcx
+    jnz         near .columnloop
+
+    pop         rsi
+    pop         rdi
+    pop         rcx
+
+    add         rsi, byte SIZEOF_JSAMPROW  ; input_data
+    add         rdi, byte SIZEOF_JSAMPROW  ; output_data
+    dec         r11d                       ; rowctr
+    jg          near .rowloop
+
+.return:
+    pop         rbx
+    uncollect_args 6
+    pop         rbp
+    ret
+
 ; For some reason, the OS X linker does not honor the request to align the
 ; segment unless we do this.
     align       32
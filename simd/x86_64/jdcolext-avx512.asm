@@ -0,0 +1,395 @@
+;
+; jdcolext.asm - colorspace conversion (64-bit AVX-512)
+;
+; Copyright 2009, 2012 Pierre Ossman <ossman@cendio.se> for Cendio AB
+; Copyright (C) 2009, 2012, 2016, D. R. Commander.
+; Copyright (C) 2015, Intel Corporation.
+;
+; Based on the x86 SIMD extension for IJG JPEG library
+; Copyright (C) 1999-2006, MIYASAKA Masaru.
+; For conditions of distribution and use, see copyright notice in jsimdext.inc
+;
+; This file should be assembled with NASM (Netwide Assembler),
+; can *not* be assembled with Microsoft's MASM or any compatible
+; assembler (including Borland's Turbo Assembler).
+; NASM is available from http://nasm.sourceforge.net/ or
+; http://sourceforge.net/project/showfiles.php?group_id=6208
+;
+; [TAB8]
+
+%include "jcolsamp.inc"
+
+; --------------------------------------------------------------------------
+;
+; Convert some rows of samples to the output colorspace.
+;
+; GLOBAL(void)
+; jsimd_ycc_rgb_convert_avx512(JDIMENSION out_width, JSAMPIMAGE input_buf,
+;                              JDIMENSION input_row, JSAMPARRAY output_buf,
+;                              int num_rows)
+;
+; The arithmetic is the same as that of jsimd_ycc_rgb_convert_avx2(), applied
+; to 64 pixels at a time.  The last (partial) group of pixels in each row is
+; read and written with masked loads and stores, so no more than out_width
+; samples are accessed.
+;
+
+; r10d = JDIMENSION out_width
+; r11 = JSAMPIMAGE input_buf
+; r12d = JDIMENSION input_row
+; r13 = JSAMPARRAY output_buf
+; r14d = int num_rows
+
+    align       32
+    GLOBAL_FUNCTION(jsimd_ycc_rgb_convert_avx512)
+
+EXTN(jsimd_ycc_rgb_convert_avx512):
+    push        rbp
+    mov         rax, rsp                ; rax = original rbp
+    mov         rbp, rsp
+    collect_args 5
+    push        rbx
+
+    mov         ecx, r10d               ; num_cols
+    test        rcx, rcx
+    jz          near .return
+
+    push        rcx
+
+    mov         rdi, r11
+    mov         ecx, r12d
+    mov         rsi, JSAMPARRAY [rdi+0*SIZEOF_JSAMPARRAY]
+    mov         rbx, JSAMPARRAY [rdi+1*SIZEOF_JSAMPARRAY]
+    mov         rdx, JSAMPARRAY [rdi+2*SIZEOF_JSAMPARRAY]
+    lea         rsi, [rsi+rcx*SIZEOF_JSAMPROW]
+    lea         rbx, [rbx+rcx*SIZEOF_JSAMPROW]
+    lea         rdx, [rdx+rcx*SIZEOF_JSAMPROW]
+
+    pop         rcx
+
+    vpternlogd  zmm18, zmm18, zmm18, 0xFF
+    vpsllw      zmm19, zmm18, 7         ; zmm19={0xFF80 0xFF80 ..}
+    vpsrlw      zmm18, zmm18, BYTE_BIT  ; zmm18={0xFF 0x00 0xFF 0x00 ..}
+    vmovdqu64   zmm20, [rel PB_INTERLEAVE]
+%if RGB_PIXELSIZE == 3
+    vmovdqu64   zmm21, [rel PQ_RGB3_SEL0]
+    vmovdqu64   zmm22, [rel PQ_RGB3_SEL1]
+    vmovdqu64   zmm23, [rel PQ_RGB3_SEL2]
+    vmovdqu64   zmm24, [rel PQ_RGB3_OUT0]
+    vmovdqu64   zmm25, [rel PQ_RGB3_OUT1]
+    vmovdqu64   zmm26, [rel PQ_RGB3_OUT2]
+%endif
+
+    mov         rdi, r13
+    mov         eax, r14d
+    test        rax, rax
+    jle         near .return
+.rowloop:
+    push        rax
+    push        rdi
+    push        rdx
+    push        rbx
+    push        rsi
+    push        rcx                     ; col
+
+    mov         rsi, JSAMPROW [rsi]     ; inptr0
+    mov         rbx, JSAMPROW [rbx]     ; inptr1
+    mov         rdx, JSAMPROW [rdx]     ; inptr2
+    mov         rdi, JSAMPROW [rdi]     ; outptr
+.columnloop:
+
+    ; k1 = mask of the columns to load (all of them unless this is the last,
+    ; partial group of pixels in the row)
+    mov         rax, -1
+    cmp         rcx, byte SIZEOF_ZMMWORD
+    jae         short .columnload
+    xor         eax, eax
+    bts         rax, rcx
+    dec         rax
+.columnload:
+    kmovq       k1, rax
+
+    vmovdqu8    zmm5{k1}{z}, ZMMWORD [rbx]  ; zmm5=Cb
+    vmovdqu8    zmm1{k1}{z}, ZMMWORD [rdx]  ; zmm1=Cr
+
+    vpandd      zmm4, zmm18, zmm5       ; zmm4=CbE
+    vpsrlw      zmm5, zmm5, BYTE_BIT    ; zmm5=CbO
+    vpandd      zmm0, zmm18, zmm1       ; zmm0=CrE
+    vpsrlw      zmm1, zmm1, BYTE_BIT    ; zmm1=CrO
+
+    vpaddw      zmm2, zmm4, zmm19
+    vpaddw      zmm3, zmm5, zmm19
+    vpaddw      zmm6, zmm0, zmm19
+    vpaddw      zmm7, zmm1, zmm19
+
+    ; (Original)
+    ; R = Y                + 1.40200 * Cr
+    ; G = Y - 0.34414 * Cb - 0.71414 * Cr
+    ; B = Y + 1.77200 * Cb
+    ;
+    ; (This implementation)
+    ; R = Y                + 0.40200 * Cr + Cr
+    ; G = Y - 0.34414 * Cb + 0.28586 * Cr - Cr
+    ; B = Y - 0.22800 * Cb + Cb + Cb
+
+    vpaddw      zmm4, zmm2, zmm2             ; zmm4=2*CbE
+    vpaddw      zmm5, zmm3, zmm3             ; zmm5=2*CbO
+    vpaddw      zmm0, zmm6, zmm6             ; zmm0=2*CrE
+    vpaddw      zmm1, zmm7, zmm7             ; zmm1=2*CrO
+
+    vpmulhw     zmm4, zmm4, [rel PW_MF0228]  ; zmm4=(2*CbE * -FIX(0.22800))
+    vpmulhw     zmm5, zmm5, [rel PW_MF0228]  ; zmm5=(2*CbO * -FIX(0.22800))
+    vpmulhw     zmm0, zmm0, [rel PW_F0402]   ; zmm0=(2*CrE * FIX(0.40200))
+    vpmulhw     zmm1, zmm1, [rel PW_F0402]   ; zmm1=(2*CrO * FIX(0.40200))
+
+    vpaddw      zmm4, zmm4, [rel PW_ONE]
+    vpaddw      zmm5, zmm5, [rel PW_ONE]
+    vpsraw      zmm4, zmm4, 1                ; zmm4=(CbE * -FIX(0.22800))
+    vpsraw      zmm5, zmm5, 1                ; zmm5=(CbO * -FIX(0.22800))
+    vpaddw      zmm0, zmm0, [rel PW_ONE]
+    vpaddw      zmm1, zmm1, [rel PW_ONE]
+    vpsraw      zmm0, zmm0, 1                ; zmm0=(CrE * FIX(0.40200))
+    vpsraw      zmm1, zmm1, 1                ; zmm1=(CrO * FIX(0.40200))
+
+    vpaddw      zmm4, zmm4, zmm2
+    vpaddw      zmm5, zmm5, zmm3
+    vpaddw      zmm16, zmm4, zmm2            ; zmm16=(CbE * FIX(1.77200))=(B-Y)E
+    vpaddw      zmm17, zmm5, zmm3            ; zmm17=(CbO * FIX(1.77200))=(B-Y)O
+    vpaddw      zmm0, zmm0, zmm6             ; zmm0=(CrE * FIX(1.40200))=(R-Y)E
+    vpaddw      zmm1, zmm1, zmm7             ; zmm1=(CrO * FIX(1.40200))=(R-Y)O
+
+    vpunpckhwd  zmm4, zmm2, zmm6
+    vpunpcklwd  zmm2, zmm2, zmm6
+    vpmaddwd    zmm2, zmm2, [rel PW_MF0344_F0285]
+    vpmaddwd    zmm4, zmm4, [rel PW_MF0344_F0285]
+    vpunpckhwd  zmm5, zmm3, zmm7
+    vpunpcklwd  zmm3, zmm3, zmm7
+    vpmaddwd    zmm3, zmm3, [rel PW_MF0344_F0285]
+    vpmaddwd    zmm5, zmm5, [rel PW_MF0344_F0285]
+
+    vpaddd      zmm2, zmm2, [rel PD_ONEHALF]
+    vpaddd      zmm4, zmm4, [rel PD_ONEHALF]
+    vpsrad      zmm2, zmm2, SCALEBITS
+    vpsrad      zmm4, zmm4, SCALEBITS
+    vpaddd      zmm3, zmm3, [rel PD_ONEHALF]
+    vpaddd      zmm5, zmm5, [rel PD_ONEHALF]
+    vpsrad      zmm3, zmm3, SCALEBITS
+    vpsrad      zmm5, zmm5, SCALEBITS
+
+    vpackssdw   zmm2, zmm2, zmm4             ; zmm2=CbE*-FIX(0.344)+CrE*FIX(0.285)
+    vpackssdw   zmm3, zmm3, zmm5             ; zmm3=CbO*-FIX(0.344)+CrO*FIX(0.285)
+    vpsubw      zmm2, zmm2, zmm6             ; zmm2=(G-Y)E
+    vpsubw      zmm3, zmm3, zmm7             ; zmm3=(G-Y)O
+
+    vmovdqu8    zmm5{k1}{z}, ZMMWORD [rsi]   ; zmm5=Y
+
+    vpandd      zmm4, zmm18, zmm5            ; zmm4=YE
+    vpsrlw      zmm5, zmm5, BYTE_BIT         ; zmm5=YO
+
+    ; Each 128-bit lane of a component register holds 8 even samples followed
+    ; by 8 odd samples after vpackuswb, and vpshufb puts them back in order.
+
+    vpaddw      zmm0, zmm0, zmm4             ; zmm0=((R-Y)E+YE)=RE
+    vpaddw      zmm1, zmm1, zmm5             ; zmm1=((R-Y)O+YO)=RO
+    vpackuswb   zmm0, zmm0, zmm1
+    vpshufb     zmm0, zmm0, zmm20            ; zmm0=R
+
+    vpaddw      zmm2, zmm2, zmm4             ; zmm2=((G-Y)E+YE)=GE
+    vpaddw      zmm3, zmm3, zmm5             ; zmm3=((G-Y)O+YO)=GO
+    vpackuswb   zmm2, zmm2, zmm3
+    vpshufb     zmm2, zmm2, zmm20            ; zmm2=G
+
+    vpaddw      zmm4, zmm4, zmm16            ; zmm4=(YE+(B-Y)E)=BE
+    vpaddw      zmm5, zmm5, zmm17            ; zmm5=(YO+(B-Y)O)=BO
+    vpackuswb   zmm4, zmm4, zmm5
+    vpshufb     zmm4, zmm4, zmm20            ; zmm4=B
+
+%if RGB_PIXELSIZE == 3  ; ---------------
+
+    ; zmmA, zmmC and zmmE hold the first, second and third components of the
+    ; 64 pixels.  Each 128-bit lane n of the output is split into three
+    ; parts, which receive bytes 48*n+0..15, 48*n+16..31 and 48*n+32..47.
+
+    vpshufb     zmm1, zmmA, [rel PB_RGB3_0A]
+    vpshufb     zmm16, zmmC, [rel PB_RGB3_0C]
+    vpshufb     zmm17, zmmE, [rel PB_RGB3_0E]
+    vpternlogd  zmm1, zmm16, zmm17, 0xFE     ; zmm1=part 0 (a0 a1 a2 a3)
+    vpshufb     zmm3, zmmA, [rel PB_RGB3_1A]
+    vpshufb     zmm16, zmmC, [rel PB_RGB3_1C]
+    vpshufb     zmm17, zmmE, [rel PB_RGB3_1E]
+    vpternlogd  zmm3, zmm16, zmm17, 0xFE     ; zmm3=part 1 (b0 b1 b2 b3)
+    vpshufb     zmm5, zmmA, [rel PB_RGB3_2A]
+    vpshufb     zmm16, zmmC, [rel PB_RGB3_2C]
+    vpshufb     zmm17, zmmE, [rel PB_RGB3_2E]
+    vpternlogd  zmm5, zmm16, zmm17, 0xFE     ; zmm5=part 2 (c0 c1 c2 c3)
+
+    vmovdqa64   zmm7, zmm1
+    vpermt2q    zmm7, zmm21, zmm3            ; zmm7=(a0 b0 -- a1)
+    vpermt2q    zmm7, zmm24, zmm5            ; zmm7=(a0 b0 c0 a1)
+    vmovdqa64   zmm16, zmm1
+    vpermt2q    zmm16, zmm22, zmm3           ; zmm16=(b1 -- a2 b2)
+    vpermt2q    zmm16, zmm25, zmm5           ; zmm16=(b1 c1 a2 b2)
+    vpermt2q    zmm1, zmm23, zmm3            ; zmm1=(-- a3 b3 --)
+    vpermt2q    zmm1, zmm26, zmm5            ; zmm1=(c2 a3 b3 c3)
+
+    cmp         rcx, byte SIZEOF_ZMMWORD
+    jb          short .column_st128
+
+    test        rdi, SIZEOF_ZMMWORD-1
+    jnz         short .out1
+    ; --(aligned)-------------------
+    vmovntdq    ZMMWORD [rdi+0*SIZEOF_ZMMWORD], zmm7
+    vmovntdq    ZMMWORD [rdi+1*SIZEOF_ZMMWORD], zmm16
+    vmovntdq    ZMMWORD [rdi+2*SIZEOF_ZMMWORD], zmm1
+    jmp         short .out0
+.out1:  ; --(unaligned)-----------------
+    vmovdqu64   ZMMWORD [rdi+0*SIZEOF_ZMMWORD], zmm7
+    vmovdqu64   ZMMWORD [rdi+1*SIZEOF_ZMMWORD], zmm16
+    vmovdqu64   ZMMWORD [rdi+2*SIZEOF_ZMMWORD], zmm1
+.out0:
+    add         rdi, RGB_PIXELSIZE*SIZEOF_ZMMWORD  ; outptr
+    sub         rcx, byte SIZEOF_ZMMWORD
+    jz          near .nextrow
+
+    add         rsi, byte SIZEOF_ZMMWORD  ; inptr0
+    add         rbx, byte SIZEOF_ZMMWORD  ; inptr1
+    add         rdx, byte SIZEOF_ZMMWORD  ; inptr2
+    jmp         near .columnloop
+
+.column_st128:
+    lea         rcx, [rcx+rcx*2]        ; imul ecx, RGB_PIXELSIZE
+    cmp         rcx, 2*SIZEOF_ZMMWORD
+    jb          short .column_st64
+    vmovdqu64   ZMMWORD [rdi+0*SIZEOF_ZMMWORD], zmm7
+    vmovdqu64   ZMMWORD [rdi+1*SIZEOF_ZMMWORD], zmm16
+    add         rdi, 2*SIZEOF_ZMMWORD   ; outptr
+    vmovdqa64   zmm7, zmm1
+    sub         rcx, 2*SIZEOF_ZMMWORD
+    jmp         short .column_st63
+.column_st64:
+    cmp         rcx, byte SIZEOF_ZMMWORD
+    jb          short .column_st63
+    vmovdqu64   ZMMWORD [rdi+0*SIZEOF_ZMMWORD], zmm7
+    add         rdi, byte SIZEOF_ZMMWORD  ; outptr
+    vmovdqa64   zmm7, zmm16
+    sub         rcx, byte SIZEOF_ZMMWORD
+.column_st63:
+    ; Store the remaining (fewer than 64) bytes of zmm7 to the output.
+    xor         eax, eax
+    bts         rax, rcx
+    dec         rax
+    kmovq       k1, rax
+    vmovdqu8    ZMMWORD [rdi]{k1}, zmm7
+
+%else  ; RGB_PIXELSIZE == 4 ; -----------
+
+%ifdef RGBX_FILLER_0XFF
+    vpternlogd  zmm6, zmm6, zmm6, 0xFF  ; zmm6=X
+%else
+    vpxord      zmm6, zmm6, zmm6        ; zmm6=X
+%endif
+    ; zmmA, zmmC, zmmE and zmmG hold the first, second, third and fourth
+    ; components of the 64 pixels.  Within each 128-bit lane n, the unpacks
+    ; build pixels 16*n+0..3, 4..7, 8..11 and 12..15, and the 128-bit lanes
+    ; of the results are then transposed.
+
+    vpunpcklbw  zmm1, zmmA, zmmC
+    vpunpckhbw  zmm3, zmmA, zmmC
+    vpunpcklbw  zmm5, zmmE, zmmG
+    vpunpckhbw  zmm7, zmmE, zmmG
+
+    vpunpcklwd  zmm16, zmm1, zmm5       ; zmm16=(p0 p16 p32 p48)
+    vpunpckhwd  zmm17, zmm1, zmm5       ; zmm17=(p4 p20 p36 p52)
+    vpunpcklwd  zmm1, zmm3, zmm7        ; zmm1=(p8 p24 p40 p56)
+    vpunpckhwd  zmm3, zmm3, zmm7        ; zmm3=(p12 p28 p44 p60)
+
+    vshufi64x2  zmm5, zmm16, zmm17, 0x44  ; zmm5=(p0 p16 p4 p20)
+    vshufi64x2  zmm7, zmm16, zmm17, 0xEE  ; zmm7=(p32 p48 p36 p52)
+    vshufi64x2  zmm16, zmm1, zmm3, 0x44   ; zmm16=(p8 p24 p12 p28)
+    vshufi64x2  zmm17, zmm1, zmm3, 0xEE   ; zmm17=(p40 p56 p44 p60)
+
+    vshufi64x2  zmm1, zmm5, zmm16, 0x88   ; zmm1=(p0 p4 p8 p12)
+    vshufi64x2  zmm3, zmm5, zmm16, 0xDD   ; zmm3=(p16 p20 p24 p28)
+    vshufi64x2  zmm5, zmm7, zmm17, 0x88   ; zmm5=(p32 p36 p40 p44)
+    vshufi64x2  zmm7, zmm7, zmm17, 0xDD   ; zmm7=(p48 p52 p56 p60)
+
+    cmp         rcx, byte SIZEOF_ZMMWORD
+    jb          short .column_st128
+
+    test        rdi, SIZEOF_ZMMWORD-1
+    jnz         short .out1
+    ; --(aligned)-------------------
+    vmovntdq    ZMMWORD [rdi+0*SIZEOF_ZMMWORD], zmm1
+    vmovntdq    ZMMWORD [rdi+1*SIZEOF_ZMMWORD], zmm3
+    vmovntdq    ZMMWORD [rdi+2*SIZEOF_ZMMWORD], zmm5
+    vmovntdq    ZMMWORD [rdi+3*SIZEOF_ZMMWORD], zmm7
+    jmp         short .out0
+.out1:  ; --(unaligned)-----------------
+    vmovdqu64   ZMMWORD [rdi+0*SIZEOF_ZMMWORD], zmm1
+    vmovdqu64   ZMMWORD [rdi+1*SIZEOF_ZMMWORD], zmm3
+    vmovdqu64   ZMMWORD [rdi+2*SIZEOF_ZMMWORD], zmm5
+    vmovdqu64   ZMMWORD [rdi+3*SIZEOF_ZMMWORD], zmm7
+.out0:
+    add         rdi, RGB_PIXELSIZE*SIZEOF_ZMMWORD  ; outptr
+    sub         rcx, byte SIZEOF_ZMMWORD
+    jz          near .nextrow
+
+    add         rsi, byte SIZEOF_ZMMWORD  ; inptr0
+    add         rbx, byte SIZEOF_ZMMWORD  ; inptr1
+    add         rdx, byte SIZEOF_ZMMWORD  ; inptr2
+    jmp         near .columnloop
+
+.column_st128:
+    shl         rcx, 2                  ; imul ecx, RGB_PIXELSIZE
+    cmp         rcx, 2*SIZEOF_ZMMWORD
+    jb          short .column_st64
+    vmovdqu64   ZMMWORD [rdi+0*SIZEOF_ZMMWORD], zmm1
+    vmovdqu64   ZMMWORD [rdi+1*SIZEOF_ZMMWORD], zmm3
+    add         rdi, 2*SIZEOF_ZMMWORD   ; outptr
+    vmovdqa64   zmm1, zmm5
+    vmovdqa64   zmm3, zmm7
+    sub         rcx, 2*SIZEOF_ZMMWORD
+.column_st64:
+    cmp         rcx, byte SIZEOF_ZMMWORD
+    jb          short .column_st63
+    vmovdqu64   ZMMWORD [rdi+0*SIZEOF_ZMMWORD], zmm1
+    add         rdi, byte SIZEOF_ZMMWORD  ; outptr
+    vmovdqa64   zmm1, zmm3
+    sub         rcx, byte SIZEOF_ZMMWORD
+.column_st63:
+    ; Store the remaining (fewer than 64) bytes of zmm1 to the output.
+    xor         eax, eax
+    bts         rax, rcx
+    dec         rax
+    kmovq       k1, rax
+    vmovdqu8    ZMMWORD [rdi]{k1}, zmm1
+
+%endif  ; RGB_PIXELSIZE ; ---------------
+
+.nextrow:
+    pop         rcx
+    pop         rsi
+    pop         rbx
+    pop         rdx
+    pop         rdi
+    pop         rax
+
+    add         rsi, byte SIZEOF_JSAMPROW
+    add         rbx, byte SIZEOF_JSAMPROW
+    add         rdx, byte SIZEOF_JSAMPROW
+    add         rdi, byte SIZEOF_JSAMPROW  ; output_buf
+    dec         rax                        ; num_rows
+    jg          near .rowloop
+
+    sfence                              ; flush the write buffer
+
+.return:
+    pop         rbx
+    vzeroupper
+    uncollect_args 5
+    pop         rbp
+    ret
+
+; For some reason, the OS X linker does not honor the request to align the
+; segment unless we do this.
+    align       32
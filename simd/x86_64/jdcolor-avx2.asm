@@ -44,6 +44,10 @@ PW_MF0228       times 16 dw -F_0_228
 PW_MF0344_F0285 times 8  dw -F_0_344, F_0_285
 PW_ONE          times 16 dw  1
 PD_ONEHALF      times 8  dd  1 << (SCALEBITS - 1)
+PB_F8           times 32 db  0xF8
+PB_07           times 32 db  0x07
+PB_E0           times 32 db  0xE0
+PB_1F           times 32 db  0x1F
 
     alignz      32
 
@@ -118,3 +122,5 @@ PD_ONEHALF      times 8  dd  1 << (SCALEBITS - 1)
 %define RGB_PIXELSIZE  EXT_XRGB_PIXELSIZE
 %define jsimd_ycc_rgb_convert_avx2  jsimd_ycc_extxrgb_convert_avx2
 %include "jdcolext-avx2.asm"
+
+%include "jdcol565-avx2.asm"
@@ -43,6 +43,10 @@ PW_MF0228       times 8 dw -F_0_228
 PW_MF0344_F0285 times 4 dw -F_0_344, F_0_285
 PW_ONE          times 8 dw  1
 PD_ONEHALF      times 4 dd  1 << (SCALEBITS - 1)
+PB_F8           times 16 db 0xF8
+PB_07           times 16 db 0x07
+PB_E0           times 16 db 0xE0
+PB_1F           times 16 db 0x1F
 
     alignz      32
 
@@ -117,3 +121,5 @@ PD_ONEHALF      times 4 dd  1 << (SCALEBITS - 1)
 %define RGB_PIXELSIZE  EXT_XRGB_PIXELSIZE
 %define jsimd_ycc_rgb_convert_sse2  jsimd_ycc_extxrgb_convert_sse2
 %include "jdcolext-sse2.asm"
+
+%include "jdcol565-sse2.asm"
@@ -0,0 +1,210 @@
+;
+; jdmerge.asm - merged upsampling/color conversion (64-bit AVX-512)
+;
+; Copyright 2009 Pierre Ossman <ossman@cendio.se> for Cendio AB
+; Copyright (C) 2009, 2016, D. R. Commander.
+; Copyright (C) 2015, Intel Corporation.
+;
+; Based on the x86 SIMD extension for IJG JPEG library
+; Copyright (C) 1999-2006, MIYASAKA Masaru.
+; For conditions of distribution and use, see copyright notice in jsimdext.inc
+;
+; This file should be assembled with NASM (Netwide Assembler),
+; can *not* be assembled with Microsoft's MASM or any compatible
+; assembler (including Borland's Turbo Assembler).
+; NASM is available from http://nasm.sourceforge.net/ or
+; http://sourceforge.net/project/showfiles.php?group_id=6208
+;
+; [TAB8]
+
+%include "jsimdext.inc"
+
+; --------------------------------------------------------------------------
+
+%define SCALEBITS  16
+
+F_0_344 equ  22554              ; FIX(0.34414)
+F_0_714 equ  46802              ; FIX(0.71414)
+F_1_402 equ  91881              ; FIX(1.40200)
+F_1_772 equ 116130              ; FIX(1.77200)
+F_0_402 equ (F_1_402 - 65536)   ; FIX(1.40200) - FIX(1)
+F_0_285 equ ( 65536 - F_0_714)  ; FIX(1) - FIX(0.71414)
+F_0_228 equ (131072 - F_1_772)  ; FIX(2) - FIX(1.77200)
+
+; --------------------------------------------------------------------------
+    SECTION     SEG_CONST
+
+    alignz      64
+    GLOBAL_DATA(jconst_merged_upsample_avx512)
+
+EXTN(jconst_merged_upsample_avx512):
+
+PW_F0402        times 32 dw  F_0_402
+PW_MF0228       times 32 dw -F_0_228
+PW_MF0344_F0285 times 16 dw -F_0_344, F_0_285
+PW_ONE          times 32 dw  1
+PD_ONEHALF      times 16 dd  1 << (SCALEBITS - 1)
+
+; vpshufb mask that puts the even and odd samples of each 128-bit lane (as
+; packed by vpackuswb) back in order
+PB_INTERLEAVE:
+%rep 4
+                db  0,  8,  1,  9,  2, 10,  3, 11
+                db  4, 12,  5, 13,  6, 14,  7, 15
+%endrep
+
+; vpshufb masks that scatter the samples of one component into part n (bytes
+; 16*n to 16*n+15) of each 48-byte group of 3-byte pixels
+PB_RGB3_0A:
+%rep 4
+                db  0, -1, -1,  1, -1, -1,  2, -1
+                db -1,  3, -1, -1,  4, -1, -1,  5
+%endrep
+
+PB_RGB3_0C:
+%rep 4
+                db -1,  0, -1, -1,  1, -1, -1,  2
+                db -1, -1,  3, -1, -1,  4, -1, -1
+%endrep
+
+PB_RGB3_0E:
+%rep 4
+                db -1, -1,  0, -1, -1,  1, -1, -1
+                db  2, -1, -1,  3, -1, -1,  4, -1
+%endrep
+
+PB_RGB3_1A:
+%rep 4
+                db -1, -1,  6, -1, -1,  7, -1, -1
+                db  8, -1, -1,  9, -1, -1, 10, -1
+%endrep
+
+PB_RGB3_1C:
+%rep 4
+                db  5, -1, -1,  6, -1, -1,  7, -1
+                db -1,  8, -1, -1,  9, -1, -1, 10
+%endrep
+
+PB_RGB3_1E:
+%rep 4
+                db -1,  5, -1, -1,  6, -1, -1,  7
+                db -1, -1,  8, -1, -1,  9, -1, -1
+%endrep
+
+PB_RGB3_2A:
+%rep 4
+                db -1, 11, -1, -1, 12, -1, -1, 13
+                db -1, -1, 14, -1, -1, 15, -1, -1
+%endrep
+
+PB_RGB3_2C:
+%rep 4
+                db -1, -1, 11, -1, -1, 12, -1, -1
+                db 13, -1, -1, 14, -1, -1, 15, -1
+%endrep
+
+PB_RGB3_2E:
+%rep 4
+                db 10, -1, -1, 11, -1, -1, 12, -1
+                db -1, 13, -1, -1, 14, -1, -1, 15
+%endrep
+
+; vpermt2q indices that assemble the 3-byte pixels from the 128-bit parts
+PQ_RGB3_SEL0    dq  0,  1,  8,  9,  0,  1,  2,  3
+PQ_RGB3_SEL1    dq 10, 11, 10, 11,  4,  5, 12, 13
+PQ_RGB3_SEL2    dq  6,  7,  6,  7, 14, 15, 14, 15
+PQ_RGB3_OUT0    dq  0,  1,  2,  3,  8,  9,  6,  7
+PQ_RGB3_OUT1    dq  0,  1, 10, 11,  4,  5,  6,  7
+PQ_RGB3_OUT2    dq 12, 13,  2,  3,  4,  5, 14, 15
+
+    alignz      32
+
+; --------------------------------------------------------------------------
+    SECTION     SEG_TEXT
+    BITS        64
+
+%include "jdmrgext-avx512.asm"
+
+%undef RGB_RED
+%undef RGB_GREEN
+%undef RGB_BLUE
+%undef RGB_PIXELSIZE
+%define RGB_RED  EXT_RGB_RED
+%define RGB_GREEN  EXT_RGB_GREEN
+%define RGB_BLUE  EXT_RGB_BLUE
+%define RGB_PIXELSIZE  EXT_RGB_PIXELSIZE
+%define jsimd_h2v1_merged_upsample_avx512 \
+  jsimd_h2v1_extrgb_merged_upsample_avx512
+%define jsimd_h2v2_merged_upsample_avx512 \
+  jsimd_h2v2_extrgb_merged_upsample_avx512
+%include "jdmrgext-avx512.asm"
+
+%undef RGB_RED
+%undef RGB_GREEN
+%undef RGB_BLUE
+%undef RGB_PIXELSIZE
+%define RGB_RED  EXT_RGBX_RED
+%define RGB_GREEN  EXT_RGBX_GREEN
+%define RGB_BLUE  EXT_RGBX_BLUE
+%define RGB_PIXELSIZE  EXT_RGBX_PIXELSIZE
+%define jsimd_h2v1_merged_upsample_avx512 \
+  jsimd_h2v1_extrgbx_merged_upsample_avx512
+%define jsimd_h2v2_merged_upsample_avx512 \
+  jsimd_h2v2_extrgbx_merged_upsample_avx512
+%include "jdmrgext-avx512.asm"
+
+%undef RGB_RED
+%undef RGB_GREEN
+%undef RGB_BLUE
+%undef RGB_PIXELSIZE
+%define RGB_RED  EXT_BGR_RED
+%define RGB_GREEN  EXT_BGR_GREEN
+%define RGB_BLUE  EXT_BGR_BLUE
+%define RGB_PIXELSIZE  EXT_BGR_PIXELSIZE
+%define jsimd_h2v1_merged_upsample_avx512 \
+  jsimd_h2v1_extbgr_merged_upsample_avx512
+%define jsimd_h2v2_merged_upsample_avx512 \
+  jsimd_h2v2_extbgr_merged_upsample_avx512
+%include "jdmrgext-avx512.asm"
+
+%undef RGB_RED
+%undef RGB_GREEN
+%undef RGB_BLUE
+%undef RGB_PIXELSIZE
+%define RGB_RED  EXT_BGRX_RED
+%define RGB_GREEN  EXT_BGRX_GREEN
+%define RGB_BLUE  EXT_BGRX_BLUE
+%define RGB_PIXELSIZE  EXT_BGRX_PIXELSIZE
+%define jsimd_h2v1_merged_upsample_avx512 \
+  jsimd_h2v1_extbgrx_merged_upsample_avx512
+%define jsimd_h2v2_merged_upsample_avx512 \
+  jsimd_h2v2_extbgrx_merged_upsample_avx512
+%include "jdmrgext-avx512.asm"
+
+%undef RGB_RED
+%undef RGB_GREEN
+%undef RGB_BLUE
+%undef RGB_PIXELSIZE
+%define RGB_RED  EXT_XBGR_RED
+%define RGB_GREEN  EXT_XBGR_GREEN
+%define RGB_BLUE  EXT_XBGR_BLUE
+%define RGB_PIXELSIZE  EXT_XBGR_PIXELSIZE
+%define jsimd_h2v1_merged_upsample_avx512 \
+  jsimd_h2v1_extxbgr_merged_upsample_avx512
+%define jsimd_h2v2_merged_upsample_avx512 \
+  jsimd_h2v2_extxbgr_merged_upsample_avx512
+%include "jdmrgext-avx512.asm"
+
+%undef RGB_RED
+%undef RGB_GREEN
+%undef RGB_BLUE
+%undef RGB_PIXELSIZE
+%define RGB_RED  EXT_XRGB_RED
+%define RGB_GREEN  EXT_XRGB_GREEN
+%define RGB_BLUE  EXT_XRGB_BLUE
+%define RGB_PIXELSIZE  EXT_XRGB_PIXELSIZE
+%define jsimd_h2v1_merged_upsample_avx512 \
+  jsimd_h2v1_extxrgb_merged_upsample_avx512
+%define jsimd_h2v2_merged_upsample_avx512 \
+  jsimd_h2v2_extxrgb_merged_upsample_avx512
+%include "jdmrgext-avx512.asm"
@@ -42,7 +42,14 @@ PW_F0402        times 8 dw  F_0_402
 PW_MF0228       times 8 dw -F_0_228
 PW_MF0344_F0285 times 4 dw -F_0_344, F_0_285
 PW_ONE          times 8 dw  1
+PW_FOUR         times 8 dw  4
+PW_EIGHT        times 8 dw  8
+PW_SEVEN        times 8 dw  7
 PD_ONEHALF      times 4 dd  1 << (SCALEBITS - 1)
+PB_F8           times 16 db 0xF8
+PB_07           times 16 db 0x07
+PB_E0           times 16 db 0xE0
+PB_1F           times 16 db 0x1F
 
     alignz      32
 
@@ -64,6 +71,8 @@ PD_ONEHALF      times 4 dd  1 << (SCALEBITS - 1)
   jsimd_h2v1_extrgb_merged_upsample_sse2
 %define jsimd_h2v2_merged_upsample_sse2 \
   jsimd_h2v2_extrgb_merged_upsample_sse2
+%define jsimd_fancy_merged_upsample_row_sse2 \
+  jsimd_extrgb_fancy_merged_upsample_row_sse2
 %include "jdmrgext-sse2.asm"
 
 %undef RGB_RED
@@ -78,6 +87,8 @@ PD_ONEHALF      times 4 dd  1 << (SCALEBITS - 1)
   jsimd_h2v1_extrgbx_merged_upsample_sse2
 %define jsimd_h2v2_merged_upsample_sse2 \
   jsimd_h2v2_extrgbx_merged_upsample_sse2
+%define jsimd_fancy_merged_upsample_row_sse2 \
+  jsimd_extrgbx_fancy_merged_upsample_row_sse2
 %include "jdmrgext-sse2.asm"
 
 %undef RGB_RED
@@ -92,6 +103,8 @@ PD_ONEHALF      times 4 dd  1 << (SCALEBITS - 1)
   jsimd_h2v1_extbgr_merged_upsample_sse2
 %define jsimd_h2v2_merged_upsample_sse2 \
   jsimd_h2v2_extbgr_merged_upsample_sse2
+%define jsimd_fancy_merged_upsample_row_sse2 \
+  jsimd_extbgr_fancy_merged_upsample_row_sse2
 %include "jdmrgext-sse2.asm"
 
 %undef RGB_RED
@@ -106,6 +119,8 @@ PD_ONEHALF      times 4 dd  1 << (SCALEBITS - 1)
   jsimd_h2v1_extbgrx_merged_upsample_sse2
 %define jsimd_h2v2_merged_upsample_sse2 \
   jsimd_h2v2_extbgrx_merged_upsample_sse2
+%define jsimd_fancy_merged_upsample_row_sse2 \
+  jsimd_extbgrx_fancy_merged_upsample_row_sse2
 %include "jdmrgext-sse2.asm"
 
 %undef RGB_RED
@@ -120,6 +135,8 @@ PD_ONEHALF      times 4 dd  1 << (SCALEBITS - 1)
   jsimd_h2v1_extxbgr_merged_upsample_sse2
 %define jsimd_h2v2_merged_upsample_sse2 \
   jsimd_h2v2_extxbgr_merged_upsample_sse2
+%define jsimd_fancy_merged_upsample_row_sse2 \
+  jsimd_extxbgr_fancy_merged_upsample_row_sse2
 %include "jdmrgext-sse2.asm"
 
 %undef RGB_RED
@@ -134,4 +151,8 @@ PD_ONEHALF      times 4 dd  1 << (SCALEBITS - 1)
   jsimd_h2v1_extxrgb_merged_upsample_sse2
 %define jsimd_h2v2_merged_upsample_sse2 \
   jsimd_h2v2_extxrgb_merged_upsample_sse2
+%define jsimd_fancy_merged_upsample_row_sse2 \
+  jsimd_extxrgb_fancy_merged_upsample_row_sse2
 %include "jdmrgext-sse2.asm"
+
+%include "jdmrg565-sse2.asm"
@@ -0,0 +1,452 @@
+;
+; jdmrgext.asm - merged upsampling/color conversion (64-bit AVX-512)
+;
+; Copyright 2009, 2012 Pierre Ossman <ossman@cendio.se> for Cendio AB
+; Copyright (C) 2009, 2012, 2016, D. R. Commander.
+; Copyright (C) 2015, Intel Corporation.
+;
+; Based on the x86 SIMD extension for IJG JPEG library
+; Copyright (C) 1999-2006, MIYASAKA Masaru.
+; For conditions of distribution and use, see copyright notice in jsimdext.inc
+;
+; This file should be assembled with NASM (Netwide Assembler),
+; can *not* be assembled with Microsoft's MASM or any compatible
+; assembler (including Borland's Turbo Assembler).
+; NASM is available from http://nasm.sourceforge.net/ or
+; http://sourceforge.net/project/showfiles.php?group_id=6208
+;
+; [TAB8]
+
+%include "jcolsamp.inc"
+
+; --------------------------------------------------------------------------
+;
+; Upsample and color convert for the case of 2:1 horizontal and 1:1 vertical.
+;
+; GLOBAL(void)
+; jsimd_h2v1_merged_upsample_avx512(JDIMENSION output_width,
+;                                   JSAMPIMAGE input_buf,
+;                                   JDIMENSION in_row_group_ctr,
+;                                   JSAMPARRAY output_buf);
+;
+; The arithmetic is the same as that of jsimd_h2v1_merged_upsample_avx2().
+; Each group of 32 chroma samples is zero-extended to words as it is loaded,
+; and the resulting chroma terms are added to the even and odd samples of the
+; corresponding 64 luma samples.  The last (partial) group is read and written
+; with masked loads and stores, as in jsimd_ycc_rgb_convert_avx512().
+;
+
+; r10d = JDIMENSION output_width
+; r11 = JSAMPIMAGE input_buf
+; r12d = JDIMENSION in_row_group_ctr
+; r13 = JSAMPARRAY output_buf
+
+    align       32
+    GLOBAL_FUNCTION(jsimd_h2v1_merged_upsample_avx512)
+
+EXTN(jsimd_h2v1_merged_upsample_avx512):
+    push        rbp
+    mov         rax, rsp                ; rax = original rbp
+    mov         rbp, rsp
+    collect_args 4
+    push        rbx
+
+    mov         ecx, r10d               ; col
+    test        rcx, rcx
+    jz          near .return
+
+    push        rcx
+
+    mov         rdi, r11
+    mov         ecx, r12d
+    mov         rsi, JSAMPARRAY [rdi+0*SIZEOF_JSAMPARRAY]
+    mov         rbx, JSAMPARRAY [rdi+1*SIZEOF_JSAMPARRAY]
+    mov         rdx, JSAMPARRAY [rdi+2*SIZEOF_JSAMPARRAY]
+    mov         rdi, r13
+    mov         rsi, JSAMPROW [rsi+rcx*SIZEOF_JSAMPROW]  ; inptr0
+    mov         rbx, JSAMPROW [rbx+rcx*SIZEOF_JSAMPROW]  ; inptr1
+    mov         rdx, JSAMPROW [rdx+rcx*SIZEOF_JSAMPROW]  ; inptr2
+    mov         rdi, JSAMPROW [rdi]                      ; outptr
+
+    pop         rcx                     ; col
+
+    vpternlogd  zmm18, zmm18, zmm18, 0xFF
+    vpsllw      zmm19, zmm18, 7         ; zmm19={0xFF80 0xFF80 ..}
+    vpsrlw      zmm18, zmm18, BYTE_BIT  ; zmm18={0xFF 0x00 0xFF 0x00 ..}
+    vmovdqu64   zmm20, [rel PB_INTERLEAVE]
+%if RGB_PIXELSIZE == 3
+    vmovdqu64   zmm21, [rel PQ_RGB3_SEL0]
+    vmovdqu64   zmm22, [rel PQ_RGB3_SEL1]
+    vmovdqu64   zmm23, [rel PQ_RGB3_SEL2]
+    vmovdqu64   zmm24, [rel PQ_RGB3_OUT0]
+    vmovdqu64   zmm25, [rel PQ_RGB3_OUT1]
+    vmovdqu64   zmm26, [rel PQ_RGB3_OUT2]
+%endif
+
+.columnloop:
+
+    ; k1 = mask of the luma samples to load and k2 = mask of the chroma
+    ; samples to load (all of them unless this is the last, partial group of
+    ; pixels in the row)
+    mov         rax, -1
+    mov         r8d, -1
+    cmp         rcx, byte SIZEOF_ZMMWORD
+    jae         short .columnload
+    xor         eax, eax
+    bts         rax, rcx
+    dec         rax
+    lea         r9, [rcx+1]
+    shr         r9, 1
+    xor         r8d, r8d
+    bts         r8, r9
+    dec         r8
+.columnload:
+    kmovq       k1, rax
+    kmovd       k2, r8d
+
+    vpmovzxbw   zmm6{k2}{z}, YMMWORD [rbx]  ; zmm6=Cb
+    vpmovzxbw   zmm7{k2}{z}, YMMWORD [rdx]  ; zmm7=Cr
+
+    vpaddw      zmm2, zmm6, zmm19
+    vpaddw      zmm3, zmm7, zmm19
+
+    ; (Original)
+    ; R = Y                + 1.40200 * Cr
+    ; G = Y - 0.34414 * Cb - 0.71414 * Cr
+    ; B = Y + 1.77200 * Cb
+    ;
+    ; (This implementation)
+    ; R = Y                + 0.40200 * Cr + Cr
+    ; G = Y - 0.34414 * Cb + 0.28586 * Cr - Cr
+    ; B = Y - 0.22800 * Cb + Cb + Cb
+
+    vpaddw      zmm4, zmm2, zmm2             ; zmm4=2*Cb
+    vpaddw      zmm0, zmm3, zmm3             ; zmm0=2*Cr
+
+    vpmulhw     zmm4, zmm4, [rel PW_MF0228]  ; zmm4=(2*Cb * -FIX(0.22800))
+    vpmulhw     zmm0, zmm0, [rel PW_F0402]   ; zmm0=(2*Cr * FIX(0.40200))
+
+    vpaddw      zmm4, zmm4, [rel PW_ONE]
+    vpsraw      zmm4, zmm4, 1                ; zmm4=(Cb * -FIX(0.22800))
+    vpaddw      zmm0, zmm0, [rel PW_ONE]
+    vpsraw      zmm0, zmm0, 1                ; zmm0=(Cr * FIX(0.40200))
+
+    vpaddw      zmm4, zmm4, zmm2
+    vpaddw      zmm4, zmm4, zmm2             ; zmm4=(Cb * FIX(1.77200))=(B-Y)
+    vpaddw      zmm0, zmm0, zmm3             ; zmm0=(Cr * FIX(1.40200))=(R-Y)
+
+    vpunpckhwd  zmm7, zmm2, zmm3
+    vpunpcklwd  zmm2, zmm2, zmm3
+    vpmaddwd    zmm2, zmm2, [rel PW_MF0344_F0285]
+    vpmaddwd    zmm7, zmm7, [rel PW_MF0344_F0285]
+
+    vpaddd      zmm2, zmm2, [rel PD_ONEHALF]
+    vpaddd      zmm7, zmm7, [rel PD_ONEHALF]
+    vpsrad      zmm2, zmm2, SCALEBITS
+    vpsrad      zmm7, zmm7, SCALEBITS
+
+    vpackssdw   zmm2, zmm2, zmm7        ; zmm2=Cb*-FIX(0.344)+Cr*FIX(0.285)
+    vpsubw      zmm2, zmm2, zmm3        ; zmm2=(G-Y)
+
+    vmovdqu8    zmm7{k1}{z}, ZMMWORD [rsi]  ; zmm7=Y
+
+    vpandd      zmm6, zmm18, zmm7       ; zmm6=YE
+    vpsrlw      zmm7, zmm7, BYTE_BIT    ; zmm7=YO
+
+    ; Each 128-bit lane of a component register holds 8 even samples followed
+    ; by 8 odd samples after vpackuswb, and vpshufb puts them back in order.
+
+    vpaddw      zmm1, zmm0, zmm7        ; zmm1=((R-Y)+YO)=RO
+    vpaddw      zmm0, zmm0, zmm6        ; zmm0=((R-Y)+YE)=RE
+    vpackuswb   zmm0, zmm0, zmm1
+    vpshufb     zmm0, zmm0, zmm20       ; zmm0=R
+
+    vpaddw      zmm3, zmm2, zmm7        ; zmm3=((G-Y)+YO)=GO
+    vpaddw      zmm2, zmm2, zmm6        ; zmm2=((G-Y)+YE)=GE
+    vpackuswb   zmm2, zmm2, zmm3
+    vpshufb     zmm2, zmm2, zmm20       ; zmm2=G
+
+    vpaddw      zmm5, zmm4, zmm7        ; zmm5=((B-Y)+YO)=BO
+    vpaddw      zmm4, zmm4, zmm6        ; zmm4=((B-Y)+YE)=BE
+    vpackuswb   zmm4, zmm4, zmm5
+    vpshufb     zmm4, zmm4, zmm20       ; zmm4=B
+
+%if RGB_PIXELSIZE == 3  ; ---------------
+
+    ; zmmA, zmmC and zmmE hold the first, second and third components of the
+    ; 64 pixels.  Each 128-bit lane n of the output is split into three
+    ; parts, which receive bytes 48*n+0..15, 48*n+16..31 and 48*n+32..47.
+
+    vpshufb     zmm1, zmmA, [rel PB_RGB3_0A]
+    vpshufb     zmm16, zmmC, [rel PB_RGB3_0C]
+    vpshufb     zmm17, zmmE, [rel PB_RGB3_0E]
+    vpternlogd  zmm1, zmm16, zmm17, 0xFE     ; zmm1=part 0 (a0 a1 a2 a3)
+    vpshufb     zmm3, zmmA, [rel PB_RGB3_1A]
+    vpshufb     zmm16, zmmC, [rel PB_RGB3_1C]
+    vpshufb     zmm17, zmmE, [rel PB_RGB3_1E]
+    vpternlogd  zmm3, zmm16, zmm17, 0xFE     ; zmm3=part 1 (b0 b1 b2 b3)
+    vpshufb     zmm5, zmmA, [rel PB_RGB3_2A]
+    vpshufb     zmm16, zmmC, [rel PB_RGB3_2C]
+    vpshufb     zmm17, zmmE, [rel PB_RGB3_2E]
+    vpternlogd  zmm5, zmm16, zmm17, 0xFE     ; zmm5=part 2 (c0 c1 c2 c3)
+
+    vmovdqa64   zmm7, zmm1
+    vpermt2q    zmm7, zmm21, zmm3            ; zmm7=(a0 b0 -- a1)
+    vpermt2q    zmm7, zmm24, zmm5            ; zmm7=(a0 b0 c0 a1)
+    vmovdqa64   zmm16, zmm1
+    vpermt2q    zmm16, zmm22, zmm3           ; zmm16=(b1 -- a2 b2)
+    vpermt2q    zmm16, zmm25, zmm5           ; zmm16=(b1 c1 a2 b2)
+    vpermt2q    zmm1, zmm23, zmm3            ; zmm1=(-- a3 b3 --)
+    vpermt2q    zmm1, zmm26, zmm5            ; zmm1=(c2 a3 b3 c3)
+
+    cmp         rcx, byte SIZEOF_ZMMWORD
+    jb          short .column_st128
+
+    test        rdi, SIZEOF_ZMMWORD-1
+    jnz         short .out1
+    ; --(aligned)-------------------
+    vmovntdq    ZMMWORD [rdi+0*SIZEOF_ZMMWORD], zmm7
+    vmovntdq    ZMMWORD [rdi+1*SIZEOF_ZMMWORD], zmm16
+    vmovntdq    ZMMWORD [rdi+2*SIZEOF_ZMMWORD], zmm1
+    jmp         short .out0
+.out1:  ; --(unaligned)-----------------
+    vmovdqu64   ZMMWORD [rdi+0*SIZEOF_ZMMWORD], zmm7
+    vmovdqu64   ZMMWORD [rdi+1*SIZEOF_ZMMWORD], zmm16
+    vmovdqu64   ZMMWORD [rdi+2*SIZEOF_ZMMWORD], zmm1
+.out0:
+    add         rdi, RGB_PIXELSIZE*SIZEOF_ZMMWORD  ; outptr
+    sub         rcx, byte SIZEOF_ZMMWORD
+    jz          near .endcolumn
+
+    add         rsi, byte SIZEOF_ZMMWORD  ; inptr0
+    add         rbx, byte SIZEOF_YMMWORD  ; inptr1
+    add         rdx, byte SIZEOF_YMMWORD  ; inptr2
+    jmp         near .columnloop
+
+.column_st128:
+    lea         rcx, [rcx+rcx*2]        ; imul ecx, RGB_PIXELSIZE
+    cmp         rcx, 2*SIZEOF_ZMMWORD
+    jb          short .column_st64
+    vmovdqu64   ZMMWORD [rdi+0*SIZEOF_ZMMWORD], zmm7
+    vmovdqu64   ZMMWORD [rdi+1*SIZEOF_ZMMWORD], zmm16
+    add         rdi, 2*SIZEOF_ZMMWORD   ; outptr
+    vmovdqa64   zmm7, zmm1
+    sub         rcx, 2*SIZEOF_ZMMWORD
+    jmp         short .column_st63
+.column_st64:
+    cmp         rcx, byte SIZEOF_ZMMWORD
+    jb          short .column_st63
+    vmovdqu64   ZMMWORD [rdi+0*SIZEOF_ZMMWORD], zmm7
+    add         rdi, byte SIZEOF_ZMMWORD  ; outptr
+    vmovdqa64   zmm7, zmm16
+    sub         rcx, byte SIZEOF_ZMMWORD
+.column_st63:
+    ; Store the remaining (fewer than 64) bytes of zmm7 to the output.
+    xor         eax, eax
+    bts         rax, rcx
+    dec         rax
+    kmovq       k1, rax
+    vmovdqu8    ZMMWORD [rdi]{k1}, zmm7
+
+%else  ; RGB_PIXELSIZE == 4 ; -----------
+
+%ifdef RGBX_FILLER_0XFF
+    vpternlogd  zmm6, zmm6, zmm6, 0xFF  ; zmm6=X
+%else
+    vpxord      zmm6, zmm6, zmm6        ; zmm6=X
+%endif
+    ; zmmA, zmmC, zmmE and zmmG hold the first, second, third and fourth
+    ; components of the 64 pixels.  Within each 128-bit lane n, the unpacks
+    ; build pixels 16*n+0..3, 4..7, 8..11 and 12..15, and the 128-bit lanes
+    ; of the results are then transposed.
+
+    vpunpcklbw  zmm1, zmmA, zmmC
+    vpunpckhbw  zmm3, zmmA, zmmC
+    vpunpcklbw  zmm5, zmmE, zmmG
+    vpunpckhbw  zmm7, zmmE, zmmG
+
+    vpunpcklwd  zmm16, zmm1, zmm5       ; zmm16=(p0 p16 p32 p48)
+    vpunpckhwd  zmm17, zmm1, zmm5       ; zmm17=(p4 p20 p36 p52)
+    vpunpcklwd  zmm1, zmm3, zmm7        ; zmm1=(p8 p24 p40 p56)
+    vpunpckhwd  zmm3, zmm3, zmm7        ; zmm3=(p12 p28 p44 p60)
+
+    vshufi64x2  zmm5, zmm16, zmm17, 0x44  ; zmm5=(p0 p16 p4 p20)
+    vshufi64x2  zmm7, zmm16, zmm17, 0xEE  ; zmm7=(p32 p48 p36 p52)
+    vshufi64x2  zmm16, zmm1, zmm3, 0x44   ; zmm16=(p8 p24 p12 p28)
+    vshufi64x2  zmm17, zmm1, zmm3, 0xEE   ; zmm17=(p40 p56 p44 p60)
+
+    vshufi64x2  zmm1, zmm5, zmm16, 0x88   ; zmm1=(p0 p4 p8 p12)
+    vshufi64x2  zmm3, zmm5, zmm16, 0xDD   ; zmm3=(p16 p20 p24 p28)
+    vshufi64x2  zmm5, zmm7, zmm17, 0x88   ; zmm5=(p32 p36 p40 p44)
+    vshufi64x2  zmm7, zmm7, zmm17, 0xDD   ; zmm7=(p48 p52 p56 p60)
+
+    cmp         rcx, byte SIZEOF_ZMMWORD
+    jb          short .column_st128
+
+    test        rdi, SIZEOF_ZMMWORD-1
+    jnz         short .out1
+    ; --(aligned)-------------------
+    vmovntdq    ZMMWORD [rdi+0*SIZEOF_ZMMWORD], zmm1
+    vmovntdq    ZMMWORD [rdi+1*SIZEOF_ZMMWORD], zmm3
+    vmovntdq    ZMMWORD [rdi+2*SIZEOF_ZMMWORD], zmm5
+    vmovntdq    ZMMWORD [rdi+3*SIZEOF_ZMMWORD], zmm7
+    jmp         short .out0
+.out1:  ; --(unaligned)-----------------
+    vmovdqu64   ZMMWORD [rdi+0*SIZEOF_ZMMWORD], zmm1
+    vmovdqu64   ZMMWORD [rdi+1*SIZEOF_ZMMWORD], zmm3
+    vmovdqu64   ZMMWORD [rdi+2*SIZEOF_ZMMWORD], zmm5
+    vmovdqu64   ZMMWORD [rdi+3*SIZEOF_ZMMWORD], zmm7
+.out0:
+    add         rdi, RGB_PIXELSIZE*SIZEOF_ZMMWORD  ; outptr
+    sub         rcx, byte SIZEOF_ZMMWORD
+    jz          near .endcolumn
+
+    add         rsi, byte SIZEOF_ZMMWORD  ; inptr0
+    add         rbx, byte SIZEOF_YMMWORD  ; inptr1
+    add         rdx, byte SIZEOF_YMMWORD  ; inptr2
+    jmp         near .columnloop
+
+.column_st128:
+    shl         rcx, 2                  ; imul ecx, RGB_PIXELSIZE
+    cmp         rcx, 2*SIZEOF_ZMMWORD
+    jb          short .column_st64
+    vmovdqu64   ZMMWORD [rdi+0*SIZEOF_ZMMWORD], zmm1
+    vmovdqu64   ZMMWORD [rdi+1*SIZEOF_ZMMWORD], zmm3
+    add         rdi, 2*SIZEOF_ZMMWORD   ; outptr
+    vmovdqa64   zmm1, zmm5
+    vmovdqa64   zmm3, zmm7
+    sub         rcx, 2*SIZEOF_ZMMWORD
+.column_st64:
+    cmp         rcx, byte SIZEOF_ZMMWORD
+    jb          short .column_st63
+    vmovdqu64   ZMMWORD [rdi+0*SIZEOF_ZMMWORD], zmm1
+    add         rdi, byte SIZEOF_ZMMWORD  ; outptr
+    vmovdqa64   zmm1, zmm3
+    sub         rcx, byte SIZEOF_ZMMWORD
+.column_st63:
+    ; Store the remaining (fewer than 64) bytes of zmm1 to the output.
+    xor         eax, eax
+    bts         rax, rcx
+    dec         rax
+    kmovq       k1, rax
+    vmovdqu8    ZMMWORD [rdi]{k1}, zmm1
+
+%endif  ; RGB_PIXELSIZE ; ---------------
+
+.endcolumn:
+    sfence                              ; flush the write buffer
+
+.return:
+    pop         rbx
+    vzeroupper
+    uncollect_args 4
+    pop         rbp
+    ret
+
+; --------------------------------------------------------------------------
+;
+; Upsample and color convert for the case of 2:1 horizontal and 2:1 vertical.
+;
+; GLOBAL(void)
+; jsimd_h2v2_merged_upsample_avx512(JDIMENSION output_width,
+;                                   JSAMPIMAGE input_buf,
+;                                   JDIMENSION in_row_group_ctr,
+;                                   JSAMPARRAY output_buf);
+;
+
+; r10d = JDIMENSION output_width
+; r11 = JSAMPIMAGE input_buf
+; r12d = JDIMENSION in_row_group_ctr
+; r13 = JSAMPARRAY output_buf
+
+    align       32
+    GLOBAL_FUNCTION(jsimd_h2v2_merged_upsample_avx512)
+
+EXTN(jsimd_h2v2_merged_upsample_avx512):
+    push        rbp
+    mov         rax, rsp
+    mov         rbp, rsp
+    collect_args 4
+    push        rbx
+
+    mov         eax, r10d
+
+    mov         rdi, r11
+    mov         ecx, r12d
+    mov         rsi, JSAMPARRAY [rdi+0*SIZEOF_JSAMPARRAY]
+    mov         rbx, JSAMPARRAY [rdi+1*SIZEOF_JSAMPARRAY]
+    mov         rdx, JSAMPARRAY [rdi+2*SIZEOF_JSAMPARRAY]
+    mov         rdi, r13
+    lea         rsi, [rsi+rcx*SIZEOF_JSAMPROW]
+
+    push        rdx                     ; inptr2
+    push        rbx                     ; inptr1
+    push        rsi                     ; inptr00
+    mov         rbx, rsp
+
+    push        rdi
+    push        rcx
+    push        rax
+
+    %ifdef WIN64
+    mov         r8, rcx
+    mov         r9, rdi
+    mov         rcx, rax
+    mov         rdx, rbx
+    %else
+    mov         rdx, rcx
+    mov         rcx, rdi
+    mov         rdi, rax
+    mov         rsi, rbx
+    %endif
+
+    call        EXTN(jsimd_h2v1_merged_upsample_avx512)
+
+    pop         rax
+    pop         rcx
+    pop         rdi
+    pop         rsi
+    pop         rbx
+    pop         rdx
+
+    add         rdi, byte SIZEOF_JSAMPROW  ; outptr1
+    add         rsi, byte SIZEOF_JSAMPROW  ; inptr01
+
+    push        rdx                     ; inptr2
+    push        rbx                     ; inptr1
+    push        rsi                     ; inptr00
+    mov         rbx, rsp
+
+    push        rdi
+    push        rcx
+    push        rax
+
+    %ifdef WIN64
+    mov         r8, rcx
+    mov         r9, rdi
+    mov         rcx, rax
+    mov         rdx, rbx
+    %else
+    mov         rdx, rcx
+    mov         rcx, rdi
+    mov         rdi, rax
+    mov         rsi, rbx
+    %endif
+
+    call        EXTN(jsimd_h2v1_merged_upsample_avx512)
+
+    pop         rax
+    pop         rcx
+    pop         rdi
+    pop         rsi
+    pop         rbx
+    pop         rdx
+
+    pop         rbx
+    uncollect_args 4
+    pop         rbp
+    ret
+
+; For some reason, the OS X linker does not honor the request to align the
+; segment unless we do this.
+    align       32
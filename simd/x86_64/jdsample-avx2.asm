@@ -506,6 +506,132 @@ EXTN(jsimd_h2v2_fancy_upsample_avx2):
     pop         rbp
     ret
 
+; --------------------------------------------------------------------------
+;
+; Fancy processing for the less common case of 1:1 horizontal and 2:1
+; vertical.  Again a triangle filter; see comments for h1v2 case in
+; jdsample-sse2.asm.
+;
+; GLOBAL(void)
+; jsimd_h1v2_fancy_upsample_avx2(int max_v_samp_factor,
+;                                JDIMENSION downsampled_width,
+;                                JSAMPARRAY input_data,
+;                                JSAMPARRAY *output_data_ptr);
+;
+
+; r10 = int max_v_samp_factor
+; r11d = JDIMENSION downsampled_width
+; r12 = JSAMPARRAY input_data
+; r13 = JSAMPARRAY *output_data_ptr
+
+    align       32
+    GLOBAL_FUNCTION(jsimd_h1v2_fancy_upsample_avx2)
+
+EXTN(jsimd_h1v2_fancy_upsample_avx2):
+    push        rbp
+    mov         rax, rsp
+    mov         rbp, rsp
+    collect_args 4
+    push        rbx
+
+    mov         eax, r11d               ; colctr
+    test        rax, rax
+    jz          near .return
+
+    mov         rcx, r10                ; rowctr
+    test        rcx, rcx
+    jz          near .return
+
+    mov         rsi, r12                ; input_data
+    mov         rdi, r13
+    mov         rdi, JSAMPARRAY [rdi]   ; output_data
+.rowloop:
+    push        rax                     ; colctr
+    push        rcx
+    push        rdi
+    push        rsi
+
+    mov         rcx, JSAMPROW [rsi-1*SIZEOF_JSAMPROW]  ; inptr1(above)
+    mov         rbx, JSAMPROW [rsi+0*SIZEOF_JSAMPROW]  ; inptr0
+    mov         rsi, JSAMPROW [rsi+1*SIZEOF_JSAMPROW]  ; inptr1(below)
+    mov         rdx, JSAMPROW [rdi+0*SIZEOF_JSAMPROW]  ; outptr0
+    mov         rdi, JSAMPROW [rdi+1*SIZEOF_JSAMPROW]  ; outptr1
+
+    vpxor       ymm3, ymm3, ymm3        ; ymm3=(all 0's)
+.columnloop:
+    vmovdqu     ymm0, YMMWORD [rbx]     ; ymm0=row[ 0][0]
+    vmovdqu     ymm1, YMMWORD [rcx]     ; ymm1=row[-1][0]
+    vmovdqu     ymm2, YMMWORD [rsi]     ; ymm2=row[+1][0]
+
+    ; The unpacks and packs below operate within each 128-bit lane, so the
+    ; samples end up in their original order without any permutes.
+
+    vpunpckhbw  ymm4, ymm0, ymm3        ; ymm4=row[ 0]( 8  9 10 11 12 13 14 15
+                                        ;              24 25 26 27 28 29 30 31)
+    vpunpcklbw  ymm0, ymm0, ymm3        ; ymm0=row[ 0]( 0  1  2  3  4  5  6  7
+                                        ;              16 17 18 19 20 21 22 23)
+    vpunpckhbw  ymm5, ymm1, ymm3        ; ymm5=row[-1]( 8  9 10 11 12 13 14 15
+                                        ;              24 25 26 27 28 29 30 31)
+    vpunpcklbw  ymm1, ymm1, ymm3        ; ymm1=row[-1]( 0  1  2  3  4  5  6  7
+                                        ;              16 17 18 19 20 21 22 23)
+
+    vpmullw     ymm0, ymm0, [rel PW_THREE]
+    vpmullw     ymm4, ymm4, [rel PW_THREE]
+
+    ; -- process the upper row
+
+    vpaddw      ymm1, ymm1, ymm0
+    vpaddw      ymm5, ymm5, ymm4
+    vpaddw      ymm1, ymm1, [rel PW_ONE]
+    vpaddw      ymm5, ymm5, [rel PW_ONE]
+    vpsrlw      ymm1, ymm1, 2
+    vpsrlw      ymm5, ymm5, 2
+
+    vpackuswb   ymm1, ymm1, ymm5        ; ymm1=Out0=( 0  1  2 ... 29 30 31)
+    vmovdqu     YMMWORD [rdx], ymm1
+
+    ; -- process the lower row
+
+    vpunpckhbw  ymm5, ymm2, ymm3        ; ymm5=row[+1]( 8  9 10 11 12 13 14 15
+                                        ;              24 25 26 27 28 29 30 31)
+    vpunpcklbw  ymm2, ymm2, ymm3        ; ymm2=row[+1]( 0  1  2  3  4  5  6  7
+                                        ;              16 17 18 19 20 21 22 23)
+
+    vpaddw      ymm2, ymm2, ymm0
+    vpaddw      ymm5, ymm5, ymm4
+    vpaddw      ymm2, ymm2, [rel PW_TWO]
+    vpaddw      ymm5, ymm5, [rel PW_TWO]
+    vpsrlw      ymm2, ymm2, 2
+    vpsrlw      ymm5, ymm5, 2
+
+    vpackuswb   ymm2, ymm2, ymm5        ; ymm2=Out1=( 0  1  2 ... 29 30 31)
+    vmovdqu     YMMWORD [rdi], ymm2
+
+    add         rcx, byte SIZEOF_YMMWORD  ; inptr1(above)
+    add         rbx, byte SIZEOF_YMMWORD  ; inptr0
+    add         rsi, byte SIZEOF_YMMWORD  ; inptr1(below)
+    add         rdx, byte SIZEOF_YMMWORD  ; outptr0
+    add         rdi, byte SIZEOF_YMMWORD  ; outptr1
+    sub         rax, byte SIZEOF_YMMWORD
+    jg          short .columnloop
+
+    pop         rsi
+    pop         rdi
+    pop         rcx
+    pop         rax
+
+    add         rsi, byte 1*SIZEOF_JSAMPROW  ; input_data
+    add         rdi, byte 2*SIZEOF_JSAMPROW  ; output_data
+    sub         rcx, byte 2                  ; rowctr
+    jg          near .rowloop
+
+.return:
+    pop         rbx
+    vzeroupper
+    uncollect_args 4
+    pop         rbp
+    ret
+
 ; --------------------------------------------------------------------------
 ;
 ; Fast processing for the common case of 2:1 horizontal and 1:1 vertical.
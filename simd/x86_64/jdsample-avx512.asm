@@ -0,0 +1,221 @@
+;
+; jdsample.asm - upsampling (64-bit AVX-512)
+;
+; Copyright 2009 Pierre Ossman <ossman@cendio.se> for Cendio AB
+; Copyright (C) 2009, 2016, D. R. Commander.
+; Copyright (C) 2015, Intel Corporation.
+;
+; Based on the x86 SIMD extension for IJG JPEG library
+; Copyright (C) 1999-2006, MIYASAKA Masaru.
+; For conditions of distribution and use, see copyright notice in jsimdext.inc
+;
+; This file should be assembled with NASM (Netwide Assembler),
+; can *not* be assembled with Microsoft's MASM or any compatible
+; assembler (including Borland's Turbo Assembler).
+; NASM is available from http://nasm.sourceforge.net/ or
+; http://sourceforge.net/project/showfiles.php?group_id=6208
+;
+; [TAB8]
+
+%include "jsimdext.inc"
+
+; --------------------------------------------------------------------------
+    SECTION     SEG_CONST
+
+    alignz      64
+    GLOBAL_DATA(jconst_fancy_upsample_avx512)
+
+EXTN(jconst_fancy_upsample_avx512):
+
+PW_THREE times 32 dw 3
+PW_SEVEN times 32 dw 7
+PW_EIGHT times 32 dw 8
+
+    alignz      32
+
+; --------------------------------------------------------------------------
+    SECTION     SEG_TEXT
+    BITS        64
+;
+; Fancy processing for the common case of 2:1 horizontal and 2:1 vertical.
+; This is the same triangle filter as jsimd_h2v2_fancy_upsample_avx2().
+;
+; Each group of 32 input columns is zero-extended to words as it is loaded,
+; so the samples stay in order across the 128-bit lanes.  The neighbours of
+; each column are loaded again from the addresses one column to the left and
+; right, with the first and last columns of the row using their own values
+; instead (as jdsample.c does.)  Masked loads and stores keep every access
+; within downsampled_width input columns, so unlike the AVX2 version, no
+; dummy sample is written to the input rows.
+;
+; GLOBAL(void)
+; jsimd_h2v2_fancy_upsample_avx512(int max_v_samp_factor,
+;                                  JDIMENSION downsampled_width,
+;                                  JSAMPARRAY input_data,
+;                                  JSAMPARRAY *output_data_ptr);
+;
+
+; r10 = int max_v_samp_factor
+; r11d = JDIMENSION downsampled_width
+; r12 = JSAMPARRAY input_data
+; r13 = JSAMPARRAY *output_data_ptr
+
+    align       32
+    GLOBAL_FUNCTION(jsimd_h2v2_fancy_upsample_avx512)
+
+EXTN(jsimd_h2v2_fancy_upsample_avx512):
+    push        rbp
+    mov         rax, rsp
+    mov         rbp, rsp
+    collect_args 4
+    push        rbx
+
+    mov         eax, r11d               ; colctr
+    test        rax, rax
+    jz          near .return
+
+    mov         rcx, r10                ; rowctr
+    test        rcx, rcx
+    jz          near .return
+
+    vmovdqu64   zmm16, [rel PW_THREE]
+    vmovdqu64   zmm17, [rel PW_SEVEN]
+    vmovdqu64   zmm18, [rel PW_EIGHT]
+
+    mov         rsi, r12                ; input_data
+    mov         rdi, r13
+    mov         rdi, JSAMPARRAY [rdi]   ; output_data
+.rowloop:
+    push        rax                     ; colctr
+    push        rcx
+    push        rdi
+    push        rsi
+
+    mov         rcx, JSAMPROW [rsi-1*SIZEOF_JSAMPROW]  ; inptr1(above)
+    mov         rbx, JSAMPROW [rsi+0*SIZEOF_JSAMPROW]  ; inptr0
+    mov         rsi, JSAMPROW [rsi+1*SIZEOF_JSAMPROW]  ; inptr1(below)
+    mov         rdx, JSAMPROW [rdi+0*SIZEOF_JSAMPROW]  ; outptr0
+    mov         rdi, JSAMPROW [rdi+1*SIZEOF_JSAMPROW]  ; outptr1
+
+    xor         r8d, r8d                ; r8d = 0 for the first column block
+.columnloop:
+    ; k1 = mask of the columns in this block, k2 = mask of their left
+    ; neighbours, k3 = mask of their right neighbours
+    mov         r9d, -1
+    cmp         rax, byte SIZEOF_YMMWORD
+    jae         short .columnmask
+    xor         r9d, r9d
+    bts         r9d, eax
+    dec         r9d
+.columnmask:
+    kmovd       k1, r9d
+    lea         r10d, [r9+r9]
+    or          r10d, r8d
+    kmovd       k2, r10d
+    mov         r10d, r9d
+    cmp         rax, byte SIZEOF_YMMWORD
+    ja          short .notlast
+    shr         r10d, 1
+.notlast:
+    kmovd       k3, r10d
+    ; k4 = the first column of the row, k5 = the last column of the row
+    mov         r10d, r8d
+    xor         r10d, 1
+    kmovd       k4, r10d
+    kandnd      k5, k3, k1
+
+    vpmovzxbw   zmm0{k1}{z}, YMMWORD [rbx]    ; zmm0=row[ 0][x]
+    vpmovzxbw   zmm1{k1}{z}, YMMWORD [rcx]    ; zmm1=row[-1][x]
+    vpmovzxbw   zmm2{k1}{z}, YMMWORD [rsi]    ; zmm2=row[+1][x]
+    vpmovzxbw   zmm3{k2}{z}, YMMWORD [rbx-1]  ; zmm3=row[ 0][x-1]
+    vpmovzxbw   zmm4{k2}{z}, YMMWORD [rcx-1]  ; zmm4=row[-1][x-1]
+    vpmovzxbw   zmm5{k2}{z}, YMMWORD [rsi-1]  ; zmm5=row[+1][x-1]
+    vpmullw     zmm0, zmm0, zmm16
+    vpmullw     zmm3, zmm3, zmm16
+    vpaddw      zmm1, zmm1, zmm0        ; zmm1=Int0[x]
+    vpaddw      zmm2, zmm2, zmm0        ; zmm2=Int1[x]
+    vpaddw      zmm4, zmm4, zmm3        ; zmm4=Int0[x-1]
+    vpaddw      zmm5, zmm5, zmm3        ; zmm5=Int1[x-1]
+
+    vpmovzxbw   zmm0{k3}{z}, YMMWORD [rbx+1]  ; zmm0=row[ 0][x+1]
+    vpmovzxbw   zmm6{k3}{z}, YMMWORD [rcx+1]  ; zmm6=row[-1][x+1]
+    vpmovzxbw   zmm7{k3}{z}, YMMWORD [rsi+1]  ; zmm7=row[+1][x+1]
+    vpmullw     zmm0, zmm0, zmm16
+    vpaddw      zmm6, zmm6, zmm0        ; zmm6=Int0[x+1]
+    vpaddw      zmm7, zmm7, zmm0        ; zmm7=Int1[x+1]
+
+    vmovdqu16   zmm4{k4}, zmm1
+    vmovdqu16   zmm5{k4}, zmm2
+    vmovdqu16   zmm6{k5}, zmm1
+    vmovdqu16   zmm7{k5}, zmm2
+
+    ; -- process the upper row
+
+    vpmullw     zmm0, zmm1, zmm16
+    vpaddw      zmm4, zmm4, zmm18
+    vpaddw      zmm6, zmm6, zmm17
+    vpaddw      zmm4, zmm4, zmm0
+    vpaddw      zmm6, zmm6, zmm0
+    vpsrlw      zmm4, zmm4, 4           ; zmm4=Out0E=( 0  2  4 ... 58 60 62)
+    vpsrlw      zmm6, zmm6, 4           ; zmm6=Out0O=( 1  3  5 ... 59 61 63)
+    vpsllw      zmm6, zmm6, BYTE_BIT
+    vpord       zmm4, zmm4, zmm6        ; zmm4=Out0=( 0  1  2 ... 61 62 63)
+
+    ; -- process the lower row
+
+    vpmullw     zmm0, zmm2, zmm16
+    vpaddw      zmm5, zmm5, zmm18
+    vpaddw      zmm7, zmm7, zmm17
+    vpaddw      zmm5, zmm5, zmm0
+    vpaddw      zmm7, zmm7, zmm0
+    vpsrlw      zmm5, zmm5, 4           ; zmm5=Out1E=( 0  2  4 ... 58 60 62)
+    vpsrlw      zmm7, zmm7, 4           ; zmm7=Out1O=( 1  3  5 ... 59 61 63)
+    vpsllw      zmm7, zmm7, BYTE_BIT
+    vpord       zmm5, zmm5, zmm7        ; zmm5=Out1=( 0  1  2 ... 61 62 63)
+
+    cmp         rax, byte SIZEOF_YMMWORD
+    jb          short .columnstore
+    vmovdqu64   ZMMWORD [rdx], zmm4
+    vmovdqu64   ZMMWORD [rdi], zmm5
+
+    mov         r8d, 1
+    add         rcx, byte SIZEOF_YMMWORD  ; inptr1(above)
+    add         rbx, byte SIZEOF_YMMWORD  ; inptr0
+    add         rsi, byte SIZEOF_YMMWORD  ; inptr1(below)
+    add         rdx, byte SIZEOF_ZMMWORD  ; outptr0
+    add         rdi, byte SIZEOF_ZMMWORD  ; outptr1
+    sub         rax, byte SIZEOF_YMMWORD
+    jnz         near .columnloop
+    jmp         short .nextrow
+
+.columnstore:
+    ; Store the 2*colctr output samples of the last (partial) column block.
+    lea         ecx, [rax+rax]
+    xor         r9d, r9d
+    bts         r9, rcx
+    dec         r9
+    kmovq       k1, r9
+    vmovdqu8    ZMMWORD [rdx]{k1}, zmm4
+    vmovdqu8    ZMMWORD [rdi]{k1}, zmm5
+
+.nextrow:
+    pop         rsi
+    pop         rdi
+    pop         rcx
+    pop         rax
+
+    add         rsi, byte 1*SIZEOF_JSAMPROW  ; input_data
+    add         rdi, byte 2*SIZEOF_JSAMPROW  ; output_data
+    sub         rcx, byte 2                  ; rowctr
+    jg          near .rowloop
+
+.return:
+    pop         rbx
+    vzeroupper
+    uncollect_args 4
+    pop         rbp
+    ret
+
+; For some reason, the OS X linker does not honor the request to align the
+; segment unless we do this.
+    align       32
@@ -479,6 +479,127 @@ EXTN(jsimd_h2v2_fancy_upsample_sse2):
     pop         rbp
     ret
 
+; --------------------------------------------------------------------------
+;
+; Fancy processing for the less common case of 1:1 horizontal and 2:1
+; vertical.  This can be encountered when losslessly rotating/transposing a
+; JPEG file that uses 4:2:2 chroma subsampling.  Again a triangle filter;
+; each output row blends the nearest input row with the next nearest one
+; in the ratio 3:1.
+;
+; GLOBAL(void)
+; jsimd_h1v2_fancy_upsample_sse2(int max_v_samp_factor,
+;                                JDIMENSION downsampled_width,
+;                                JSAMPARRAY input_data,
+;                                JSAMPARRAY *output_data_ptr);
+;
+
+; r10 = int max_v_samp_factor
+; r11d = JDIMENSION downsampled_width
+; r12 = JSAMPARRAY input_data
+; r13 = JSAMPARRAY *output_data_ptr
+
+    align       32
+    GLOBAL_FUNCTION(jsimd_h1v2_fancy_upsample_sse2)
+
+EXTN(jsimd_h1v2_fancy_upsample_sse2):
+    push        rbp
+    mov         rax, rsp
+    mov         rbp, rsp
+    collect_args 4
+    push        rbx
+
+    mov         eax, r11d               ; colctr
+    test        rax, rax
+    jz          near .return
+
+    mov         rcx, r10                ; rowctr
+    test        rcx, rcx
+    jz          near .return
+
+    mov         rsi, r12                ; input_data
+    mov         rdi, r13
+    mov         rdi, JSAMPARRAY [rdi]   ; output_data
+.rowloop:
+    push        rax                     ; colctr
+    push        rcx
+    push        rdi
+    push        rsi
+
+    mov         rcx, JSAMPROW [rsi-1*SIZEOF_JSAMPROW]  ; inptr1(above)
+    mov         rbx, JSAMPROW [rsi+0*SIZEOF_JSAMPROW]  ; inptr0
+    mov         rsi, JSAMPROW [rsi+1*SIZEOF_JSAMPROW]  ; inptr1(below)
+    mov         rdx, JSAMPROW [rdi+0*SIZEOF_JSAMPROW]  ; outptr0
+    mov         rdi, JSAMPROW [rdi+1*SIZEOF_JSAMPROW]  ; outptr1
+
+    pxor        xmm3, xmm3              ; xmm3=(all 0's)
+.columnloop:
+    movdqa      xmm0, XMMWORD [rbx]     ; xmm0=row[ 0][0]
+    movdqa      xmm1, XMMWORD [rcx]     ; xmm1=row[-1][0]
+    movdqa      xmm2, XMMWORD [rsi]     ; xmm2=row[+1][0]
+
+    movdqa      xmm4, xmm0
+    punpcklbw   xmm0, xmm3              ; xmm0=row[ 0]( 0  1  2  3  4  5  6  7)
+    punpckhbw   xmm4, xmm3              ; xmm4=row[ 0]( 8  9 10 11 12 13 14 15)
+    movdqa      xmm5, xmm1
+    punpcklbw   xmm1, xmm3              ; xmm1=row[-1]( 0  1  2  3  4  5  6  7)
+    punpckhbw   xmm5, xmm3              ; xmm5=row[-1]( 8  9 10 11 12 13 14 15)
+
+    pmullw      xmm0, [rel PW_THREE]
+    pmullw      xmm4, [rel PW_THREE]
+
+    ; -- process the upper row
+
+    paddw       xmm1, xmm0
+    paddw       xmm5, xmm4
+    paddw       xmm1, [rel PW_ONE]
+    paddw       xmm5, [rel PW_ONE]
+    psrlw       xmm1, 2                 ; xmm1=Out0L=( 0  1  2  3  4  5  6  7)
+    psrlw       xmm5, 2                 ; xmm5=Out0H=( 8  9 10 11 12 13 14 15)
+
+    packuswb    xmm1, xmm5              ; xmm1=Out0=( 0  1  2 ... 13 14 15)
+    movdqa      XMMWORD [rdx], xmm1
+
+    ; -- process the lower row
+
+    movdqa      xmm5, xmm2
+    punpcklbw   xmm2, xmm3              ; xmm2=row[+1]( 0  1  2  3  4  5  6  7)
+    punpckhbw   xmm5, xmm3              ; xmm5=row[+1]( 8  9 10 11 12 13 14 15)
+
+    paddw       xmm2, xmm0
+    paddw       xmm5, xmm4
+    paddw       xmm2, [rel PW_TWO]
+    paddw       xmm5, [rel PW_TWO]
+    psrlw       xmm2, 2                 ; xmm2=Out1L=( 0  1  2  3  4  5  6  7)
+    psrlw       xmm5, 2                 ; xmm5=Out1H=( 8  9 10 11 12 13 14 15)
+
+    packuswb    xmm2, xmm5              ; xmm2=Out1=( 0  1  2 ... 13 14 15)
+    movdqa      XMMWORD [rdi], xmm2
+
+    add         rcx, byte SIZEOF_XMMWORD  ; inptr1(above)
+    add         rbx, byte SIZEOF_XMMWORD  ; inptr0
+    add         rsi, byte SIZEOF_XMMWORD  ; inptr1(below)
+    add         rdx, byte SIZEOF_XMMWORD  ; outptr0
+    add         rdi, byte SIZEOF_XMMWORD  ; outptr1
+    sub         rax, byte SIZEOF_XMMWORD
+    jg          short .columnloop
+
+    pop         rsi
+    pop         rdi
+    pop         rcx
+    pop         rax
+
+    add         rsi, byte 1*SIZEOF_JSAMPROW  ; input_data
+    add         rdi, byte 2*SIZEOF_JSAMPROW  ; output_data
+    sub         rcx, byte 2                  ; rowctr
+    jg          near .rowloop
+
+.return:
+    pop         rbx
+    uncollect_args 4
+    pop         rbp
+    ret
+
 ; --------------------------------------------------------------------------
 ;
 ; Fast processing for the common case of 2:1 horizontal and 1:1 vertical.
@@ -661,6 +782,335 @@ EXTN(jsimd_h2v2_upsample_sse2):
     pop         rbp
     ret
 
+; --------------------------------------------------------------------------
+;
+; Fast processing for the case of 4:1 horizontal and 1:1 vertical (4:1:1.)
+; It's still a box filter.
+;
+; GLOBAL(void)
+; jsimd_h4v1_upsample_sse2(int max_v_samp_factor, JDIMENSION output_width,
+;                          JSAMPARRAY input_data, JSAMPARRAY *output_data_ptr);
+;
+
+; r10 = int max_v_samp_factor
+; r11d = JDIMENSION output_width
+; r12 = JSAMPARRAY input_data
+; r13 = JSAMPARRAY *output_data_ptr
+
+    align       32
+    GLOBAL_FUNCTION(jsimd_h4v1_upsample_sse2)
+
+EXTN(jsimd_h4v1_upsample_sse2):
+    push        rbp
+    mov         rax, rsp
+    mov         rbp, rsp
+    collect_args 4
+
+    mov         edx, r11d
+    add         rdx, byte (4*SIZEOF_XMMWORD)-1
+    and         rdx, byte -(4*SIZEOF_XMMWORD)
+    jz          near .return
+
+    mov         rcx, r10                ; rowctr
+    test        rcx, rcx
+    jz          short .return
+
+    mov         rsi, r12                ; input_data
+    mov         rdi, r13
+    mov         rdi, JSAMPARRAY [rdi]   ; output_data
+.rowloop:
+    push        rdi
+    push        rsi
+
+    mov         rsi, JSAMPROW [rsi]     ; inptr
+    mov         rdi, JSAMPROW [rdi]     ; outptr
+    mov         rax, rdx                ; colctr
+.columnloop:
+
+    movdqa      xmm0, XMMWORD [rsi+0*SIZEOF_XMMWORD]
+
+    movdqa      xmm1, xmm0
+    punpcklbw   xmm0, xmm0
+    punpckhbw   xmm1, xmm1
+    movdqa      xmm2, xmm0
+    movdqa      xmm3, xmm1
+    punpcklwd   xmm0, xmm0
+    punpckhwd   xmm2, xmm2
+    punpcklwd   xmm1, xmm1
+    punpckhwd   xmm3, xmm3
+
+    movdqa      XMMWORD [rdi+0*SIZEOF_XMMWORD], xmm0
+    movdqa      XMMWORD [rdi+1*SIZEOF_XMMWORD], xmm2
+    movdqa      XMMWORD [rdi+2*SIZEOF_XMMWORD], xmm1
+    movdqa      XMMWORD [rdi+3*SIZEOF_XMMWORD], xmm3
+
+    add         rsi, byte 1*SIZEOF_XMMWORD  ; inptr
+    add         rdi, byte 4*SIZEOF_XMMWORD  ; outptr
+    sub         rax, byte 4*SIZEOF_XMMWORD
+    jnz         short .columnloop
+
+    pop         rsi
+    pop         rdi
+
+    add         rsi, byte SIZEOF_JSAMPROW  ; input_data
+    add         rdi, byte SIZEOF_JSAMPROW  ; output_data
+    dec         rcx                        ; rowctr
+    jg          short .rowloop
+
+.return:
+    uncollect_args 4
+    pop         rbp
+    ret
+
+; --------------------------------------------------------------------------
+;
+; Fast processing for the case of 4:1 horizontal and 2:1 vertical (4:1:0.)
+; It's still a box filter.
+;
+; GLOBAL(void)
+; jsimd_h4v2_upsample_sse2(int max_v_samp_factor, JDIMENSION output_width,
+;                          JSAMPARRAY input_data, JSAMPARRAY *output_data_ptr);
+;
+
+; r10 = int max_v_samp_factor
+; r11d = JDIMENSION output_width
+; r12 = JSAMPARRAY input_data
+; r13 = JSAMPARRAY *output_data_ptr
+
+    align       32
+    GLOBAL_FUNCTION(jsimd_h4v2_upsample_sse2)
+
+EXTN(jsimd_h4v2_upsample_sse2):
+    push        rbp
+    mov         rax, rsp
+    mov         rbp, rsp
+    collect_args 4
+    push        rbx
+
+    mov         edx, r11d
+    add         rdx, byte (4*SIZEOF_XMMWORD)-1
+    and         rdx, byte -(4*SIZEOF_XMMWORD)
+    jz          near .return
+
+    mov         rcx, r10                ; rowctr
+    test        rcx, rcx
+    jz          near .return
+
+    mov         rsi, r12                ; input_data
+    mov         rdi, r13
+    mov         rdi, JSAMPARRAY [rdi]   ; output_data
+.rowloop:
+    push        rdi
+    push        rsi
+
+    mov         rsi, JSAMPROW [rsi]                    ; inptr
+    mov         rbx, JSAMPROW [rdi+0*SIZEOF_JSAMPROW]  ; outptr0
+    mov         rdi, JSAMPROW [rdi+1*SIZEOF_JSAMPROW]  ; outptr1
+    mov         rax, rdx                               ; colctr
+.columnloop:
+
+    movdqa      xmm0, XMMWORD [rsi+0*SIZEOF_XMMWORD]
+
+    movdqa      xmm1, xmm0
+    punpcklbw   xmm0, xmm0
+    punpckhbw   xmm1, xmm1
+    movdqa      xmm2, xmm0
+    movdqa      xmm3, xmm1
+    punpcklwd   xmm0, xmm0
+    punpckhwd   xmm2, xmm2
+    punpcklwd   xmm1, xmm1
+    punpckhwd   xmm3, xmm3
+
+    movdqa      XMMWORD [rbx+0*SIZEOF_XMMWORD], xmm0
+    movdqa      XMMWORD [rbx+1*SIZEOF_XMMWORD], xmm2
+    movdqa      XMMWORD [rbx+2*SIZEOF_XMMWORD], xmm1
+    movdqa      XMMWORD [rbx+3*SIZEOF_XMMWORD], xmm3
+    movdqa      XMMWORD [rdi+0*SIZEOF_XMMWORD], xmm0
+    movdqa      XMMWORD [rdi+1*SIZEOF_XMMWORD], xmm2
+    movdqa      XMMWORD [rdi+2*SIZEOF_XMMWORD], xmm1
+    movdqa      XMMWORD [rdi+3*SIZEOF_XMMWORD], xmm3
+
+    add         rsi, byte 1*SIZEOF_XMMWORD  ; inptr
+    add         rbx, byte 4*SIZEOF_XMMWORD  ; outptr0
+    add         rdi, byte 4*SIZEOF_XMMWORD  ; outptr1
+    sub         rax, byte 4*SIZEOF_XMMWORD
+    jnz         short .columnloop
+
+    pop         rsi
+    pop         rdi
+
+    add         rsi, byte 1*SIZEOF_JSAMPROW  ; input_data
+    add         rdi, byte 2*SIZEOF_JSAMPROW  ; output_data
+    sub         rcx, byte 2                  ; rowctr
+    jg          near .rowloop
+
+.return:
+    pop         rbx
+    uncollect_args 4
+    pop         rbp
+    ret
+
+; --------------------------------------------------------------------------
+;
+; Fast processing for the case of 1:1 horizontal and 2:1 vertical, when fancy
+; upsampling is not used.  Each input row is simply replicated.
+;
+; GLOBAL(void)
+; jsimd_h1v2_upsample_sse2(int max_v_samp_factor, JDIMENSION output_width,
+;                          JSAMPARRAY input_data, JSAMPARRAY *output_data_ptr);
+;
+
+; r10 = int max_v_samp_factor
+; r11d = JDIMENSION output_width
+; r12 = JSAMPARRAY input_data
+; r13 = JSAMPARRAY *output_data_ptr
+
+    align       32
+    GLOBAL_FUNCTION(jsimd_h1v2_upsample_sse2)
+
+EXTN(jsimd_h1v2_upsample_sse2):
+    push        rbp
+    mov         rax, rsp
+    mov         rbp, rsp
+    collect_args 4
+    push        rbx
+
+    mov         edx, r11d
+    add         rdx, byte (2*SIZEOF_XMMWORD)-1
+    and         rdx, byte -(2*SIZEOF_XMMWORD)
+    jz          near .return
+
+    mov         rcx, r10                ; rowctr
+    test        rcx, rcx
+    jz          near .return
+
+    mov         rsi, r12                ; input_data
+    mov         rdi, r13
+    mov         rdi, JSAMPARRAY [rdi]   ; output_data
+.rowloop:
+    push        rdi
+    push        rsi
+
+    mov         rsi, JSAMPROW [rsi]                    ; inptr
+    mov         rbx, JSAMPROW [rdi+0*SIZEOF_JSAMPROW]  ; outptr0
+    mov         rdi, JSAMPROW [rdi+1*SIZEOF_JSAMPROW]  ; outptr1
+    mov         rax, rdx                               ; colctr
+.columnloop:
+
+    movdqa      xmm0, XMMWORD [rsi+0*SIZEOF_XMMWORD]
+    movdqa      xmm1, XMMWORD [rsi+1*SIZEOF_XMMWORD]
+
+    movdqa      XMMWORD [rbx+0*SIZEOF_XMMWORD], xmm0
+    movdqa      XMMWORD [rbx+1*SIZEOF_XMMWORD], xmm1
+    movdqa      XMMWORD [rdi+0*SIZEOF_XMMWORD], xmm0
+    movdqa      XMMWORD [rdi+1*SIZEOF_XMMWORD], xmm1
+
+    add         rsi, byte 2*SIZEOF_XMMWORD  ; inptr
+    add         rbx, byte 2*SIZEOF_XMMWORD  ; outptr0
+    add         rdi, byte 2*SIZEOF_XMMWORD  ; outptr1
+    sub         rax, byte 2*SIZEOF_XMMWORD
+    jnz         short .columnloop
+
+    pop         rsi
+    pop         rdi
+
+    add         rsi, byte 1*SIZEOF_JSAMPROW  ; input_data
+    add         rdi, byte 2*SIZEOF_JSAMPROW  ; output_data
+    sub         rcx, byte 2                  ; rowctr
+    jg          near .rowloop
+
+.return:
+    pop         rbx
+    uncollect_args 4
+    pop         rbp
+    ret
+
+; --------------------------------------------------------------------------
+;
+; Fast processing for the case of 2:1 horizontal and 4:1 vertical.
+; It's still a box filter.
+;
+; GLOBAL(void)
+; jsimd_h2v4_upsample_sse2(int max_v_samp_factor, JDIMENSION output_width,
+;                          JSAMPARRAY input_data, JSAMPARRAY *output_data_ptr);
+;
+
+; r10 = int max_v_samp_factor
+; r11d = JDIMENSION output_width
+; r12 = JSAMPARRAY input_data
+; r13 = JSAMPARRAY *output_data_ptr
+
+    align       32
+    GLOBAL_FUNCTION(jsimd_h2v4_upsample_sse2)
+
+EXTN(jsimd_h2v4_upsample_sse2):
+    push        rbp
+    mov         rax, rsp
+    mov         rbp, rsp
+    collect_args 4
+    push        rbx
+
+    mov         edx, r11d
+    add         rdx, byte (2*SIZEOF_XMMWORD)-1
+    and         rdx, byte -(2*SIZEOF_XMMWORD)
+    jz          near .return
+
+    mov         rcx, r10                ; rowctr
+    test        rcx, rcx
+    jz          near .return
+
+    mov         rsi, r12                ; input_data
+    mov         rdi, r13
+    mov         rdi, JSAMPARRAY [rdi]   ; output_data
+.rowloop:
+    push        rdi
+    push        rsi
+
+    mov         rsi, JSAMPROW [rsi]                    ; inptr
+    mov         rbx, JSAMPROW [rdi+0*SIZEOF_JSAMPROW]  ; outptr0
+    mov         r8,  JSAMPROW [rdi+1*SIZEOF_JSAMPROW]  ; outptr1
+    mov         r9,  JSAMPROW [rdi+2*SIZEOF_JSAMPROW]  ; outptr2
+    mov         rdi, JSAMPROW [rdi+3*SIZEOF_JSAMPROW]  ; outptr3
+    mov         rax, rdx                               ; colctr
+.columnloop:
+
+    movdqa      xmm0, XMMWORD [rsi+0*SIZEOF_XMMWORD]
+
+    movdqa      xmm1, xmm0
+    punpcklbw   xmm0, xmm0
+    punpckhbw   xmm1, xmm1
+
+    movdqa      XMMWORD [rbx+0*SIZEOF_XMMWORD], xmm0
+    movdqa      XMMWORD [rbx+1*SIZEOF_XMMWORD], xmm1
+    movdqa      XMMWORD [r8+0*SIZEOF_XMMWORD], xmm0
+    movdqa      XMMWORD [r8+1*SIZEOF_XMMWORD], xmm1
+    movdqa      XMMWORD [r9+0*SIZEOF_XMMWORD], xmm0
+    movdqa      XMMWORD [r9+1*SIZEOF_XMMWORD], xmm1
+    movdqa      XMMWORD [rdi+0*SIZEOF_XMMWORD], xmm0
+    movdqa      XMMWORD [rdi+1*SIZEOF_XMMWORD], xmm1
+
+    add         rsi, byte 1*SIZEOF_XMMWORD  ; inptr
+    add         rbx, byte 2*SIZEOF_XMMWORD  ; outptr0
+    add         r8,  byte 2*SIZEOF_XMMWORD  ; outptr1
+    add         r9,  byte 2*SIZEOF_XMMWORD  ; outptr2
+    add         rdi, byte 2*SIZEOF_XMMWORD  ; outptr3
+    sub         rax, byte 2*SIZEOF_XMMWORD
+    jnz         short .columnloop
+
+    pop         rsi
+    pop         rdi
+
+    add         rsi, byte 1*SIZEOF_JSAMPROW  ; input_data
+    add         rdi, byte 4*SIZEOF_JSAMPROW  ; output_data
+    sub         rcx, byte 4                  ; rowctr
+    jg          near .rowloop
+
+.return:
+    pop         rbx
+    uncollect_args 4
+    pop         rbp
+    ret
+
 ; For some reason, the OS X linker does not honor the request to align the
 ; segment unless we do this.
     align       32
@@ -0,0 +1,197 @@
+;
+; jfdctflt.asm - floating-point FDCT (64-bit AVX2)
+;
+; Copyright 2009 Pierre Ossman <ossman@cendio.se> for Cendio AB
+; Copyright (C) 2009, 2016, 2018, D. R. Commander.
+;
+; Based on the x86 SIMD extension for IJG JPEG library
+; Copyright (C) 1999-2006, MIYASAKA Masaru.
+; For conditions of distribution and use, see copyright notice in jsimdext.inc
+;
+; This file should be assembled with NASM (Netwide Assembler),
+; can *not* be assembled with Microsoft's MASM or any compatible
+; assembler (including Borland's Turbo Assembler).
+; NASM is available from http://nasm.sourceforge.net/ or
+; http://sourceforge.net/project/showfiles.php?group_id=6208
+;
+; This file contains a floating-point implementation of the forward DCT
+; (Discrete Cosine Transform). The following code is based directly on
+; the IJG's original jfdctflt.c and jfdctflt-sse.asm; see the jfdctflt.c
+; for more details.  Each YMM register holds one row (or column) of the
+; block, and the operations are performed in the same order as in
+; jfdctflt-sse.asm, so the two produce identical output.
+;
+; [TAB8]
+
+%include "jsimdext.inc"
+%include "jdct.inc"
+
+; --------------------------------------------------------------------------
+; In-place 8x8x32-bit matrix transpose using AVX instructions
+; %1-%8:  Input registers (rows 0-7)
+; %9-%12: Temp registers
+; The columns are returned in %9, %10, %11, %12, %5, %6, %7, %8.
+
+%macro dotranspose 12
+    vunpcklps   %9,  %1, %2             ; %9 =(00 10 01 11  04 14 05 15)
+    vunpckhps   %10, %1, %2             ; %10=(02 12 03 13  06 16 07 17)
+    vunpcklps   %11, %3, %4             ; %11=(20 30 21 31  24 34 25 35)
+    vunpckhps   %12, %3, %4             ; %12=(22 32 23 33  26 36 27 37)
+
+    vshufps     %1, %9,  %11, 0x44      ; %1=(00 10 20 30  04 14 24 34)
+    vshufps     %2, %9,  %11, 0xEE      ; %2=(01 11 21 31  05 15 25 35)
+    vshufps     %3, %10, %12, 0x44      ; %3=(02 12 22 32  06 16 26 36)
+    vshufps     %4, %10, %12, 0xEE      ; %4=(03 13 23 33  07 17 27 37)
+
+    vunpcklps   %9,  %5, %6             ; %9 =(40 50 41 51  44 54 45 55)
+    vunpckhps   %10, %5, %6             ; %10=(42 52 43 53  46 56 47 57)
+    vunpcklps   %11, %7, %8             ; %11=(60 70 61 71  64 74 65 75)
+    vunpckhps   %12, %7, %8             ; %12=(62 72 63 73  66 76 67 77)
+
+    vshufps     %5, %9,  %11, 0x44      ; %5=(40 50 60 70  44 54 64 74)
+    vshufps     %6, %9,  %11, 0xEE      ; %6=(41 51 61 71  45 55 65 75)
+    vshufps     %7, %10, %12, 0x44      ; %7=(42 52 62 72  46 56 66 76)
+    vshufps     %8, %10, %12, 0xEE      ; %8=(43 53 63 73  47 57 67 77)
+
+    vperm2f128  %9,  %1, %5, 0x20       ; %9 =(00 10 20 30 40 50 60 70)
+    vperm2f128  %5,  %1, %5, 0x31       ; %5 =(04 14 24 34 44 54 64 74)
+    vperm2f128  %10, %2, %6, 0x20       ; %10=(01 11 21 31 41 51 61 71)
+    vperm2f128  %6,  %2, %6, 0x31       ; %6 =(05 15 25 35 45 55 65 75)
+    vperm2f128  %11, %3, %7, 0x20       ; %11=(02 12 22 32 42 52 62 72)
+    vperm2f128  %7,  %3, %7, 0x31       ; %7 =(06 16 26 36 46 56 66 76)
+    vperm2f128  %12, %4, %8, 0x20       ; %12=(03 13 23 33 43 53 63 73)
+    vperm2f128  %8,  %4, %8, 0x31       ; %8 =(07 17 27 37 47 57 67 77)
+%endmacro
+
+; --------------------------------------------------------------------------
+; In-place 8-point floating-point forward DCT using AVX instructions
+; %1-%8:  Input/output registers (data0-data7)
+; %9-%12: Temp registers
+
+%macro dodct 12
+    vsubps      %9,  %1, %8             ; %9 =data0-data7=tmp7
+    vaddps      %1,  %1, %8             ; %1 =data0+data7=tmp0
+    vsubps      %10, %2, %7             ; %10=data1-data6=tmp6
+    vaddps      %2,  %2, %7             ; %2 =data1+data6=tmp1
+    vsubps      %11, %4, %5             ; %11=data3-data4=tmp4
+    vaddps      %4,  %4, %5             ; %4 =data3+data4=tmp3
+    vsubps      %12, %3, %6             ; %12=data2-data5=tmp5
+    vaddps      %3,  %3, %6             ; %3 =data2+data5=tmp2
+
+    ; -- Even part
+
+    vaddps      %5,  %1, %4             ; %5=tmp10
+    vsubps      %1,  %1, %4             ; %1=tmp13
+    vaddps      %6,  %2, %3             ; %6=tmp11
+    vsubps      %2,  %2, %3             ; %2=tmp12
+
+    vaddps      %2,  %2, %1
+    vmulps      %2,  %2, [rel PD_0_707]  ; %2=z1
+
+    vaddps      %3,  %1, %2             ; %3=data2
+    vsubps      %7,  %1, %2             ; %7=data6
+    vaddps      %1,  %5, %6             ; %1=data0
+    vsubps      %5,  %5, %6             ; %5=data4
+
+    ; -- Odd part
+
+    vaddps      %11, %11, %12           ; %11=tmp10
+    vaddps      %12, %12, %10           ; %12=tmp11
+    vaddps      %10, %10, %9            ; %10=tmp12, %9=tmp7
+
+    vmulps      %12, %12, [rel PD_0_707]  ; %12=z3
+
+    vsubps      %2,  %11, %10
+    vmulps      %2,  %2, [rel PD_0_382]   ; %2=z5
+    vmulps      %11, %11, [rel PD_0_541]  ; %11=MULTIPLY(tmp10,FIX_0_541196)
+    vmulps      %10, %10, [rel PD_1_306]  ; %10=MULTIPLY(tmp12,FIX_1_306562)
+    vaddps      %11, %11, %2            ; %11=z2
+    vaddps      %10, %10, %2            ; %10=z4
+
+    vsubps      %6,  %9, %12            ; %6=z13
+    vaddps      %9,  %9, %12            ; %9=z11
+
+    vsubps      %4,  %6, %11            ; %4=data3
+    vaddps      %6,  %6, %11            ; %6=data5
+    vaddps      %2,  %9, %10            ; %2=data1
+    vsubps      %8,  %9, %10            ; %8=data7
+%endmacro
+
+; --------------------------------------------------------------------------
+    SECTION     SEG_CONST
+
+    alignz      32
+    GLOBAL_DATA(jconst_fdct_float_avx2)
+
+EXTN(jconst_fdct_float_avx2):
+
+PD_0_382 times 8 dd 0.382683432365089771728460
+PD_0_707 times 8 dd 0.707106781186547524400844
+PD_0_541 times 8 dd 0.541196100146196984399723
+PD_1_306 times 8 dd 1.306562964876376527856643
+
+    alignz      32
+
+; --------------------------------------------------------------------------
+    SECTION     SEG_TEXT
+    BITS        64
+;
+; Perform the forward DCT on one block of samples.
+;
+; GLOBAL(void)
+; jsimd_fdct_float_avx2(FAST_FLOAT *data)
+;
+
+; r10 = FAST_FLOAT *data
+
+    align       32
+    GLOBAL_FUNCTION(jsimd_fdct_float_avx2)
+
+EXTN(jsimd_fdct_float_avx2):
+    push        rbp
+    mov         rax, rsp
+    mov         rbp, rsp
+    push_xmm    4
+    collect_args 1
+
+    ; ---- Pass 1: process rows.
+
+    vmovups     ymm0, YMMWORD [YMMBLOCK(0,0,r10,SIZEOF_FAST_FLOAT)]
+    vmovups     ymm1, YMMWORD [YMMBLOCK(1,0,r10,SIZEOF_FAST_FLOAT)]
+    vmovups     ymm2, YMMWORD [YMMBLOCK(2,0,r10,SIZEOF_FAST_FLOAT)]
+    vmovups     ymm3, YMMWORD [YMMBLOCK(3,0,r10,SIZEOF_FAST_FLOAT)]
+    vmovups     ymm4, YMMWORD [YMMBLOCK(4,0,r10,SIZEOF_FAST_FLOAT)]
+    vmovups     ymm5, YMMWORD [YMMBLOCK(5,0,r10,SIZEOF_FAST_FLOAT)]
+    vmovups     ymm6, YMMWORD [YMMBLOCK(6,0,r10,SIZEOF_FAST_FLOAT)]
+    vmovups     ymm7, YMMWORD [YMMBLOCK(7,0,r10,SIZEOF_FAST_FLOAT)]
+
+    dotranspose ymm0, ymm1, ymm2, ymm3, ymm4, ymm5, ymm6, ymm7, ymm8, ymm9, ymm10, ymm11
+    ; ymm8-ymm11,ymm4-ymm7=col0-col7
+
+    dodct ymm8, ymm9, ymm10, ymm11, ymm4, ymm5, ymm6, ymm7, ymm0, ymm1, ymm2, ymm3
+
+    ; ---- Pass 2: process columns.
+
+    dotranspose ymm8, ymm9, ymm10, ymm11, ymm4, ymm5, ymm6, ymm7, ymm0, ymm1, ymm2, ymm3
+    ; ymm0-ymm7=row0-row7
+
+    dodct ymm0, ymm1, ymm2, ymm3, ymm4, ymm5, ymm6, ymm7, ymm8, ymm9, ymm10, ymm11
+
+    vmovups     YMMWORD [YMMBLOCK(0,0,r10,SIZEOF_FAST_FLOAT)], ymm0
+    vmovups     YMMWORD [YMMBLOCK(1,0,r10,SIZEOF_FAST_FLOAT)], ymm1
+    vmovups     YMMWORD [YMMBLOCK(2,0,r10,SIZEOF_FAST_FLOAT)], ymm2
+    vmovups     YMMWORD [YMMBLOCK(3,0,r10,SIZEOF_FAST_FLOAT)], ymm3
+    vmovups     YMMWORD [YMMBLOCK(4,0,r10,SIZEOF_FAST_FLOAT)], ymm4
+    vmovups     YMMWORD [YMMBLOCK(5,0,r10,SIZEOF_FAST_FLOAT)], ymm5
+    vmovups     YMMWORD [YMMBLOCK(6,0,r10,SIZEOF_FAST_FLOAT)], ymm6
+    vmovups     YMMWORD [YMMBLOCK(7,0,r10,SIZEOF_FAST_FLOAT)], ymm7
+
+    vzeroupper
+    uncollect_args 1
+    pop_xmm     4
+    pop         rbp
+    ret
+
+; For some reason, the OS X linker does not honor the request to align the
+; segment unless we do this.
+    align       32
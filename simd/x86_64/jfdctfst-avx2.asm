@@ -0,0 +1,242 @@
+;
+; jfdctfst.asm - fast integer FDCT (64-bit AVX2)
+;
+; Copyright 2009 Pierre Ossman <ossman@cendio.se> for Cendio AB
+; Copyright (C) 2009, 2016, 2018, D. R. Commander.
+;
+; Based on the x86 SIMD extension for IJG JPEG library
+; Copyright (C) 1999-2006, MIYASAKA Masaru.
+; For conditions of distribution and use, see copyright notice in jsimdext.inc
+;
+; This file should be assembled with NASM (Netwide Assembler),
+; can *not* be assembled with Microsoft's MASM or any compatible
+; assembler (including Borland's Turbo Assembler).
+; NASM is available from http://nasm.sourceforge.net/ or
+; http://sourceforge.net/project/showfiles.php?group_id=6208
+;
+; This file contains a fast, not so accurate integer implementation of
+; the forward DCT (Discrete Cosine Transform). The following code is
+; based directly on the IJG's original jfdctfst.c and jfdctfst-sse2.asm;
+; see the jfdctfst.c for more details.  It performs the same arithmetic
+; as jfdctfst-sse2.asm, so the two produce identical output.
+;
+; [TAB8]
+
+%include "jsimdext.inc"
+%include "jdct.inc"
+
+; --------------------------------------------------------------------------
+
+%define CONST_BITS  8  ; 14 is also OK.
+
+%if CONST_BITS == 8
+F_0_382 equ  98  ; FIX(0.382683433)
+F_0_541 equ 139  ; FIX(0.541196100)
+F_0_707 equ 181  ; FIX(0.707106781)
+F_1_306 equ 334  ; FIX(1.306562965)
+%else
+; NASM cannot do compile-time arithmetic on floating-point constants.
+%define DESCALE(x, n)  (((x) + (1 << ((n) - 1))) >> (n))
+F_0_382 equ DESCALE( 410903207, 30 - CONST_BITS)  ; FIX(0.382683433)
+F_0_541 equ DESCALE( 581104887, 30 - CONST_BITS)  ; FIX(0.541196100)
+F_0_707 equ DESCALE( 759250124, 30 - CONST_BITS)  ; FIX(0.707106781)
+F_1_306 equ DESCALE(1402911301, 30 - CONST_BITS)  ; FIX(1.306562965)
+%endif
+
+; PRE_MULTIPLY_SCALE_BITS <= 2 (to avoid overflow)
+; CONST_BITS + CONST_SHIFT + PRE_MULTIPLY_SCALE_BITS == 16 (for pmulhw)
+
+%define PRE_MULTIPLY_SCALE_BITS  2
+%define CONST_SHIFT              (16 - PRE_MULTIPLY_SCALE_BITS - CONST_BITS)
+
+; --------------------------------------------------------------------------
+; In-place 8x8x16-bit matrix transpose using AVX2 instructions
+; %1-%4: Input/output registers
+; %5-%8: Temp registers
+
+%macro dotranspose 8
+    ; %1=(00 01 02 03 04 05 06 07  40 41 42 43 44 45 46 47)
+    ; %2=(10 11 12 13 14 15 16 17  50 51 52 53 54 55 56 57)
+    ; %3=(20 21 22 23 24 25 26 27  60 61 62 63 64 65 66 67)
+    ; %4=(30 31 32 33 34 35 36 37  70 71 72 73 74 75 76 77)
+
+    vpunpcklwd  %5, %1, %2
+    vpunpckhwd  %6, %1, %2
+    vpunpcklwd  %7, %3, %4
+    vpunpckhwd  %8, %3, %4
+    ; transpose coefficients(phase 1)
+    ; %5=(00 10 01 11 02 12 03 13  40 50 41 51 42 52 43 53)
+    ; %6=(04 14 05 15 06 16 07 17  44 54 45 55 46 56 47 57)
+    ; %7=(20 30 21 31 22 32 23 33  60 70 61 71 62 72 63 73)
+    ; %8=(24 34 25 35 26 36 27 37  64 74 65 75 66 76 67 77)
+
+    vpunpckldq  %1, %5, %7
+    vpunpckhdq  %2, %5, %7
+    vpunpckldq  %3, %6, %8
+    vpunpckhdq  %4, %6, %8
+    ; transpose coefficients(phase 2)
+    ; %1=(00 10 20 30 01 11 21 31  40 50 60 70 41 51 61 71)
+    ; %2=(02 12 22 32 03 13 23 33  42 52 62 72 43 53 63 73)
+    ; %3=(04 14 24 34 05 15 25 35  44 54 64 74 45 55 65 75)
+    ; %4=(06 16 26 36 07 17 27 37  46 56 66 76 47 57 67 77)
+
+    vpermq      %1, %1, 0x8D
+    vpermq      %2, %2, 0x8D
+    vpermq      %3, %3, 0xD8
+    vpermq      %4, %4, 0xD8
+    ; transpose coefficients(phase 3)
+    ; %1=(01 11 21 31 41 51 61 71  00 10 20 30 40 50 60 70)
+    ; %2=(03 13 23 33 43 53 63 73  02 12 22 32 42 52 62 72)
+    ; %3=(04 14 24 34 44 54 64 74  05 15 25 35 45 55 65 75)
+    ; %4=(06 16 26 36 46 56 66 76  07 17 27 37 47 57 67 77)
+%endmacro
+
+; --------------------------------------------------------------------------
+; In-place 8x8x16-bit fast integer forward DCT using AVX2 instructions
+; %1-%4: Input/output registers
+; %5-%8: Temp registers
+
+%macro dodct 8
+    vpsubw      %5, %1, %4              ; %5=data1_0-data6_7=tmp6_7
+    vpaddw      %6, %1, %4              ; %6=data1_0+data6_7=tmp1_0
+    vpaddw      %7, %2, %3              ; %7=data3_2+data4_5=tmp3_2
+    vpsubw      %8, %2, %3              ; %8=data3_2-data4_5=tmp4_5
+
+    ; -- Even part
+
+    vperm2i128  %6, %6, %6, 0x01        ; %6=tmp0_1
+    vpaddw      %1, %6, %7              ; %1=tmp0_1+tmp3_2=tmp10_11
+    vpsubw      %6, %6, %7              ; %6=tmp0_1-tmp3_2=tmp13_12
+
+    vperm2i128  %7, %1, %1, 0x01        ; %7=tmp11_10
+    vpsignw     %1, %1, [rel PW_1_NEG1]  ; %1=tmp10_neg11
+    vpaddw      %1, %7, %1              ; %1=(tmp10+tmp11)_(tmp10-tmp11)=data0_4
+
+    vperm2i128  %7, %6, %6, 0x01        ; %7=tmp12_13
+    vpaddw      %2, %6, %7              ; %2=(tmp13+tmp12)_(tmp12+tmp13)
+    vpsllw      %2, %2, PRE_MULTIPLY_SCALE_BITS
+    vpmulhw     %2, %2, [rel PW_F0707]  ; %2=z1_1
+    vpaddw      %6, %6, %2              ; %6=(tmp13+z1)_x
+    vpsubw      %7, %7, %2              ; %7=x_(tmp13-z1)
+    vpblendd    %3, %6, %7, 0xF0        ; %3=data2_6
+
+    ; -- Odd part
+
+    vperm2i128  %2, %8, %8, 0x01        ; %2=tmp5_4
+    vperm2i128  %4, %5, %5, 0x01        ; %4=tmp7_6
+    vpaddw      %6, %2, %5              ; %6=(tmp5+tmp6)_x
+    vpaddw      %7, %8, %4              ; %7=x_(tmp5+tmp6)
+    vpblendd    %6, %6, %7, 0xF0        ; %6=tmp11_11
+    vpaddw      %8, %8, %2              ; %8=tmp10_10
+    vpaddw      %2, %5, %4              ; %2=tmp12_12
+    vpblendd    %5, %4, %5, 0xF0        ; %5=tmp7_7
+
+    vpsllw      %8, %8, PRE_MULTIPLY_SCALE_BITS
+    vpsllw      %2, %2, PRE_MULTIPLY_SCALE_BITS
+    vpsllw      %6, %6, PRE_MULTIPLY_SCALE_BITS
+    vpmulhw     %6, %6, [rel PW_F0707]  ; %6=z3_3
+
+    vpsubw      %4, %8, %2
+    vpmulhw     %4, %4, [rel PW_F0382]  ; %4=z5_5
+    vpblendd    %7, %8, %2, 0xF0        ; %7=tmp10_12
+    vpblendd    %2, %2, %8, 0xF0        ; %2=tmp12_10
+    vpmulhw     %7, %7, [rel PW_F0541_F1306]
+    vpmulhw     %2, %2, [rel PW_F1306_F0541]
+    vpaddw      %7, %7, %4              ; %7=z2_4
+    vpaddw      %2, %2, %4              ; %2=z4_2
+
+    vpsignw     %4, %6, [rel PW_1_NEG1]  ; %4=z3_neg3
+    vpsignw     %6, %6, [rel PW_NEG1_1]  ; %6=neg3_3
+    vpaddw      %4, %5, %4              ; %4=(tmp7+z3)_(tmp7-z3)=z11_13
+    vpaddw      %6, %5, %6              ; %6=(tmp7-z3)_(tmp7+z3)=z13_11
+
+    vpaddw      %2, %4, %2              ; %2=(z11+z4)_(z13+z2)=data1_5
+    vpsubw      %4, %6, %7              ; %4=(z13-z2)_(z11-z4)=data3_7
+%endmacro
+
+; --------------------------------------------------------------------------
+    SECTION     SEG_CONST
+
+    alignz      32
+    GLOBAL_DATA(jconst_fdct_ifast_avx2)
+
+EXTN(jconst_fdct_ifast_avx2):
+
+PW_F0707        times 16 dw  F_0_707 << CONST_SHIFT
+PW_F0382        times 16 dw  F_0_382 << CONST_SHIFT
+PW_F0541_F1306  times 8  dw  F_0_541 << CONST_SHIFT
+                times 8  dw  F_1_306 << CONST_SHIFT
+PW_F1306_F0541  times 8  dw  F_1_306 << CONST_SHIFT
+                times 8  dw  F_0_541 << CONST_SHIFT
+PW_1_NEG1       times 8  dw  1
+                times 8  dw -1
+PW_NEG1_1       times 8  dw -1
+                times 8  dw  1
+
+    alignz      32
+
+; --------------------------------------------------------------------------
+    SECTION     SEG_TEXT
+    BITS        64
+;
+; Perform the forward DCT on one block of samples.
+;
+; GLOBAL(void)
+; jsimd_fdct_ifast_avx2(DCTELEM *data)
+;
+
+; r10 = DCTELEM *data
+
+    align       32
+    GLOBAL_FUNCTION(jsimd_fdct_ifast_avx2)
+
+EXTN(jsimd_fdct_ifast_avx2):
+    push        rbp
+    mov         rax, rsp
+    mov         rbp, rsp
+    collect_args 1
+
+    ; ---- Pass 1: process rows.
+
+    vmovdqu     xmm0, XMMWORD [XMMBLOCK(0,0,r10,SIZEOF_DCTELEM)]
+    vmovdqu     xmm1, XMMWORD [XMMBLOCK(1,0,r10,SIZEOF_DCTELEM)]
+    vmovdqu     xmm2, XMMWORD [XMMBLOCK(2,0,r10,SIZEOF_DCTELEM)]
+    vmovdqu     xmm3, XMMWORD [XMMBLOCK(3,0,r10,SIZEOF_DCTELEM)]
+    vinserti128 ymm0, ymm0, XMMWORD [XMMBLOCK(4,0,r10,SIZEOF_DCTELEM)], 1
+    vinserti128 ymm1, ymm1, XMMWORD [XMMBLOCK(5,0,r10,SIZEOF_DCTELEM)], 1
+    vinserti128 ymm2, ymm2, XMMWORD [XMMBLOCK(6,0,r10,SIZEOF_DCTELEM)], 1
+    vinserti128 ymm3, ymm3, XMMWORD [XMMBLOCK(7,0,r10,SIZEOF_DCTELEM)], 1
+    ; ymm0=(00 01 02 03 04 05 06 07  40 41 42 43 44 45 46 47)
+    ; ymm1=(10 11 12 13 14 15 16 17  50 51 52 53 54 55 56 57)
+    ; ymm2=(20 21 22 23 24 25 26 27  60 61 62 63 64 65 66 67)
+    ; ymm3=(30 31 32 33 34 35 36 37  70 71 72 73 74 75 76 77)
+
+    dotranspose ymm0, ymm1, ymm2, ymm3, ymm4, ymm5, ymm6, ymm7
+
+    dodct       ymm0, ymm1, ymm2, ymm3, ymm4, ymm5, ymm6, ymm7
+    ; ymm0=data0_4, ymm1=data1_5, ymm2=data2_6, ymm3=data3_7
+
+    ; ---- Pass 2: process columns.
+
+    dotranspose ymm0, ymm1, ymm2, ymm3, ymm4, ymm5, ymm6, ymm7
+
+    dodct       ymm0, ymm1, ymm2, ymm3, ymm4, ymm5, ymm6, ymm7
+    ; ymm0=data0_4, ymm1=data1_5, ymm2=data2_6, ymm3=data3_7
+
+    vmovdqu     XMMWORD [XMMBLOCK(0,0,r10,SIZEOF_DCTELEM)], xmm0
+    vmovdqu     XMMWORD [XMMBLOCK(1,0,r10,SIZEOF_DCTELEM)], xmm1
+    vmovdqu     XMMWORD [XMMBLOCK(2,0,r10,SIZEOF_DCTELEM)], xmm2
+    vmovdqu     XMMWORD [XMMBLOCK(3,0,r10,SIZEOF_DCTELEM)], xmm3
+    vextracti128 XMMWORD [XMMBLOCK(4,0,r10,SIZEOF_DCTELEM)], ymm0, 1
+    vextracti128 XMMWORD [XMMBLOCK(5,0,r10,SIZEOF_DCTELEM)], ymm1, 1
+    vextracti128 XMMWORD [XMMBLOCK(6,0,r10,SIZEOF_DCTELEM)], ymm2, 1
+    vextracti128 XMMWORD [XMMBLOCK(7,0,r10,SIZEOF_DCTELEM)], ymm3, 1
+
+    vzeroupper
+    uncollect_args 1
+    pop         rbp
+    ret
+
+; For some reason, the OS X linker does not honor the request to align the
+; segment unless we do this.
+    align       32
@@ -0,0 +1,372 @@
+;
+; jidctfst.asm - fast integer IDCT (64-bit AVX2)
+;
+; Copyright 2009 Pierre Ossman <ossman@cendio.se> for Cendio AB
+; Copyright (C) 2009, 2016, 2018, D. R. Commander.
+;
+; Based on the x86 SIMD extension for IJG JPEG library
+; Copyright (C) 1999-2006, MIYASAKA Masaru.
+; For conditions of distribution and use, see copyright notice in jsimdext.inc
+;
+; This file should be assembled with NASM (Netwide Assembler),
+; can *not* be assembled with Microsoft's MASM or any compatible
+; assembler (including Borland's Turbo Assembler).
+; NASM is available from http://nasm.sourceforge.net/ or
+; http://sourceforge.net/project/showfiles.php?group_id=6208
+;
+; This file contains a fast, not so accurate integer implementation of
+; the inverse DCT (Discrete Cosine Transform). The following code is
+; based directly on the IJG's original jidctfst.c and jidctfst-sse2.asm;
+; see the jidctfst.c for more details.  It performs the same arithmetic
+; as jidctfst-sse2.asm, so the two produce identical output.
+;
+; [TAB8]
+
+%include "jsimdext.inc"
+%include "jdct.inc"
+
+; --------------------------------------------------------------------------
+
+%define CONST_BITS  8  ; 14 is also OK.
+%define PASS1_BITS  2
+
+%if IFAST_SCALE_BITS != PASS1_BITS
+%error "'IFAST_SCALE_BITS' must be equal to 'PASS1_BITS'."
+%endif
+
+%if CONST_BITS == 8
+F_1_082 equ 277              ; FIX(1.082392200)
+F_1_414 equ 362              ; FIX(1.414213562)
+F_1_847 equ 473              ; FIX(1.847759065)
+F_2_613 equ 669              ; FIX(2.613125930)
+F_1_613 equ (F_2_613 - 256)  ; FIX(2.613125930) - FIX(1)
+%else
+; NASM cannot do compile-time arithmetic on floating-point constants.
+%define DESCALE(x, n)  (((x) + (1 << ((n) - 1))) >> (n))
+F_1_082 equ DESCALE(1162209775, 30 - CONST_BITS)  ; FIX(1.082392200)
+F_1_414 equ DESCALE(1518500249, 30 - CONST_BITS)  ; FIX(1.414213562)
+F_1_847 equ DESCALE(1984016188, 30 - CONST_BITS)  ; FIX(1.847759065)
+F_2_613 equ DESCALE(2805822602, 30 - CONST_BITS)  ; FIX(2.613125930)
+F_1_613 equ (F_2_613 - (1 << CONST_BITS))         ; FIX(2.613125930) - FIX(1)
+%endif
+
+; PRE_MULTIPLY_SCALE_BITS <= 2 (to avoid overflow)
+; CONST_BITS + CONST_SHIFT + PRE_MULTIPLY_SCALE_BITS == 16 (for pmulhw)
+
+%define PRE_MULTIPLY_SCALE_BITS  2
+%define CONST_SHIFT              (16 - PRE_MULTIPLY_SCALE_BITS - CONST_BITS)
+
+; --------------------------------------------------------------------------
+; In-place 8x8x16-bit inverse matrix transpose using AVX2 instructions
+; %1-%4: Input/output registers
+; %5-%8: Temp registers
+
+%macro dotranspose 8
+    ; %5=(00 10 20 30 40 50 60 70  01 11 21 31 41 51 61 71)
+    ; %6=(03 13 23 33 43 53 63 73  02 12 22 32 42 52 62 72)
+    ; %7=(04 14 24 34 44 54 64 74  05 15 25 35 45 55 65 75)
+    ; %8=(07 17 27 37 47 57 67 77  06 16 26 36 46 56 66 76)
+
+    vpermq      %5, %1, 0xD8
+    vpermq      %6, %2, 0x72
+    vpermq      %7, %3, 0xD8
+    vpermq      %8, %4, 0x72
+    ; transpose coefficients(phase 1)
+    ; %5=(00 10 20 30 01 11 21 31  40 50 60 70 41 51 61 71)
+    ; %6=(02 12 22 32 03 13 23 33  42 52 62 72 43 53 63 73)
+    ; %7=(04 14 24 34 05 15 25 35  44 54 64 74 45 55 65 75)
+    ; %8=(06 16 26 36 07 17 27 37  46 56 66 76 47 57 67 77)
+
+    vpunpcklwd  %1, %5, %6
+    vpunpckhwd  %2, %5, %6
+    vpunpcklwd  %3, %7, %8
+    vpunpckhwd  %4, %7, %8
+    ; transpose coefficients(phase 2)
+    ; %1=(00 02 10 12 20 22 30 32  40 42 50 52 60 62 70 72)
+    ; %2=(01 03 11 13 21 23 31 33  41 43 51 53 61 63 71 73)
+    ; %3=(04 06 14 16 24 26 34 36  44 46 54 56 64 66 74 76)
+    ; %4=(05 07 15 17 25 27 35 37  45 47 55 57 65 67 75 77)
+
+    vpunpcklwd  %5, %1, %2
+    vpunpcklwd  %6, %3, %4
+    vpunpckhwd  %7, %1, %2
+    vpunpckhwd  %8, %3, %4
+    ; transpose coefficients(phase 3)
+    ; %5=(00 01 02 03 10 11 12 13  40 41 42 43 50 51 52 53)
+    ; %6=(04 05 06 07 14 15 16 17  44 45 46 47 54 55 56 57)
+    ; %7=(20 21 22 23 30 31 32 33  60 61 62 63 70 71 72 73)
+    ; %8=(24 25 26 27 34 35 36 37  64 65 66 67 74 75 76 77)
+
+    vpunpcklqdq %1, %5, %6
+    vpunpckhqdq %2, %5, %6
+    vpunpcklqdq %3, %7, %8
+    vpunpckhqdq %4, %7, %8
+    ; transpose coefficients(phase 4)
+    ; %1=(00 01 02 03 04 05 06 07  40 41 42 43 44 45 46 47)
+    ; %2=(10 11 12 13 14 15 16 17  50 51 52 53 54 55 56 57)
+    ; %3=(20 21 22 23 24 25 26 27  60 61 62 63 64 65 66 67)
+    ; %4=(30 31 32 33 34 35 36 37  70 71 72 73 74 75 76 77)
+%endmacro
+
+; --------------------------------------------------------------------------
+; In-place 8x8x16-bit fast integer inverse DCT using AVX2 instructions
+; %1-%4: Input/output registers
+; %5-%8: Temp registers
+; %9:    Pass (1 or 2)
+;
+; The rows are paired so that most of the butterflies combine the same lane of
+; two registers: the odd part is computed in the upper lane, and only a few
+; cross-lane permutes are needed to bring the terms together.
+
+%macro dodct 9
+    ; -- Even part
+
+    vpaddw      %5, %1, %2              ; %5=in0_2+in4_6=tmp10_13
+    vpsubw      %6, %1, %2              ; %6=in0_2-in4_6=tmp11_z
+
+    vpsllw      %1, %6, PRE_MULTIPLY_SCALE_BITS
+    vpmulhw     %1, %1, [rel PW_F1414]
+    vpsubw      %1, %1, %5              ; %1=x_tmp12
+    vpblendd    %6, %6, %1, 0xF0        ; %6=tmp11_12
+
+    vperm2i128  %1, %5, %6, 0x20        ; %1=tmp10_11
+    vperm2i128  %5, %5, %6, 0x31        ; %5=tmp13_12
+    vpsubw      %6, %1, %5              ; %6=tmp10_11-tmp13_12=tmp3_2
+    vpaddw      %5, %1, %5              ; %5=tmp10_11+tmp13_12=tmp0_1
+
+    ; -- Odd part
+
+    vpaddw      %7, %3, %4              ; %7=in1_5+in7_3=z11_13
+    vpsubw      %8, %3, %4              ; %8=in1_5-in7_3=z12_10
+
+    vperm2i128  %3, %7, %7, 0x01        ; %3=z13_11
+    vpsubw      %4, %3, %7              ; %4=x_(z11-z13)
+    vpaddw      %7, %7, %3              ; %7=tmp7_7
+
+    vpsllw      %4, %4, PRE_MULTIPLY_SCALE_BITS
+    vpmulhw     %4, %4, [rel PW_F1414]  ; %4=x_tmp11
+
+    vperm2i128  %3, %8, %8, 0x01        ; %3=z10_12
+    vpaddw      %1, %3, %8
+    vpsllw      %1, %1, PRE_MULTIPLY_SCALE_BITS
+    vpmulhw     %1, %1, [rel PW_F1847]  ; %1=z5_5
+
+    ; To avoid overflow...
+    ;
+    ; (Original)
+    ; tmp12 = -2.613125930 * z10 + z5;
+    ;
+    ; (This implementation)
+    ; tmp12 = (-1.613125930 - 1) * z10 + z5;
+    ;       = -1.613125930 * z10 - z10 + z5;
+
+    vpsllw      %2, %8, PRE_MULTIPLY_SCALE_BITS
+    vpmulhw     %2, %2, [rel PW_MF1613]
+    vpsubw      %2, %2, %8
+    vpaddw      %2, %2, %1              ; %2=x_tmp12
+    vpsllw      %3, %3, PRE_MULTIPLY_SCALE_BITS
+    vpmulhw     %3, %3, [rel PW_F1082]
+    vpsubw      %3, %3, %1              ; %3=x_tmp10
+
+    ; -- Final output stage
+
+    vpsubw      %2, %2, %7              ; %2=x_tmp6
+    vpsubw      %4, %4, %2              ; %4=x_tmp5
+    vpaddw      %3, %3, %4              ; %3=x_tmp4
+    vpblendd    %7, %7, %2, 0xF0        ; %7=tmp7_6
+    vperm2i128  %3, %3, %4, 0x31        ; %3=tmp4_5
+    vpsignw     %3, %3, [rel PW_NEG1_1]  ; %3=neg4_5
+
+    vpsubw      %4, %5, %7              ; %4=tmp0_1-tmp7_6=data7_6
+    vpaddw      %1, %5, %7              ; %1=tmp0_1+tmp7_6=data0_1
+    vpaddw      %2, %6, %3              ; %2=tmp3_2+neg4_5=data3_2
+    vpsubw      %3, %6, %3              ; %3=tmp3_2-neg4_5=data4_5
+%if %9 == 2
+    vpsraw      %1, %1, (PASS1_BITS+3)  ; descale
+    vpsraw      %2, %2, (PASS1_BITS+3)
+    vpsraw      %3, %3, (PASS1_BITS+3)
+    vpsraw      %4, %4, (PASS1_BITS+3)
+%endif
+%endmacro
+
+; --------------------------------------------------------------------------
+    SECTION     SEG_CONST
+
+    alignz      32
+    GLOBAL_DATA(jconst_idct_ifast_avx2)
+
+EXTN(jconst_idct_ifast_avx2):
+
+PW_F1414        times 16 dw  F_1_414 << CONST_SHIFT
+PW_F1847        times 16 dw  F_1_847 << CONST_SHIFT
+PW_MF1613       times 16 dw -F_1_613 << CONST_SHIFT
+PW_F1082        times 16 dw  F_1_082 << CONST_SHIFT
+PW_NEG1_1       times 8  dw -1
+                times 8  dw  1
+PB_CENTERJSAMP  times 32 db  CENTERJSAMPLE
+PB_INTERLEAVE   times 2  db  0, 8, 1, 9, 2, 10, 3, 11, 4, 12, 5, 13, 6, 14, 7, 15
+PD_ROWORDER     dd  0, 4, 1, 5, 2, 6, 3, 7
+
+    alignz      32
+
+; --------------------------------------------------------------------------
+    SECTION     SEG_TEXT
+    BITS        64
+;
+; Perform dequantization and inverse DCT on one block of coefficients.
+;
+; GLOBAL(void)
+; jsimd_idct_ifast_avx2(void *dct_table, JCOEFPTR coef_block,
+;                       JSAMPARRAY output_buf, JDIMENSION output_col)
+;
+
+; r10 = void *dct_table
+; r11 = JCOEFPTR coef_block
+; r12 = JSAMPARRAY output_buf
+; r13d = JDIMENSION output_col
+
+    align       32
+    GLOBAL_FUNCTION(jsimd_idct_ifast_avx2)
+
+EXTN(jsimd_idct_ifast_avx2):
+    push        rbp
+    mov         rax, rsp                     ; rax = original rbp
+    mov         rbp, rsp                     ; rbp = aligned rbp
+    collect_args 4
+
+    ; ---- Pass 1: process columns.
+
+%ifndef NO_ZERO_COLUMN_TEST_IFAST_AVX2
+    mov         eax, DWORD [DWBLOCK(1,0,r11,SIZEOF_JCOEF)]
+    or          eax, DWORD [DWBLOCK(2,0,r11,SIZEOF_JCOEF)]
+    jnz         near .columnDCT
+
+    movdqa      xmm0, XMMWORD [XMMBLOCK(1,0,r11,SIZEOF_JCOEF)]
+    movdqa      xmm1, XMMWORD [XMMBLOCK(2,0,r11,SIZEOF_JCOEF)]
+    vpor        xmm0, xmm0, XMMWORD [XMMBLOCK(3,0,r11,SIZEOF_JCOEF)]
+    vpor        xmm1, xmm1, XMMWORD [XMMBLOCK(4,0,r11,SIZEOF_JCOEF)]
+    vpor        xmm0, xmm0, XMMWORD [XMMBLOCK(5,0,r11,SIZEOF_JCOEF)]
+    vpor        xmm1, xmm1, XMMWORD [XMMBLOCK(6,0,r11,SIZEOF_JCOEF)]
+    vpor        xmm0, xmm0, XMMWORD [XMMBLOCK(7,0,r11,SIZEOF_JCOEF)]
+    vpor        xmm1, xmm1, xmm0
+    vpacksswb   xmm1, xmm1, xmm1
+    vpacksswb   xmm1, xmm1, xmm1
+    movd        eax, xmm1
+    test        rax, rax
+    jnz         short .columnDCT
+
+    ; -- AC terms all zero
+
+    movdqa      xmm5, XMMWORD [XMMBLOCK(0,0,r11,SIZEOF_JCOEF)]
+    vpmullw     xmm5, xmm5, XMMWORD [XMMBLOCK(0,0,r10,SIZEOF_IFAST_MULT_TYPE)]
+
+    vpunpcklwd  xmm4, xmm5, xmm5        ; xmm4=(00 00 01 01 02 02 03 03)
+    vpunpckhwd  xmm5, xmm5, xmm5        ; xmm5=(04 04 05 05 06 06 07 07)
+    vinserti128 ymm4, ymm4, xmm5, 1
+
+    vpshufd     ymm0, ymm4, 0x00        ; ymm0=col0_4=(00 00 00 00 00 00 00 00  04 04 04 04 04 04 04 04)
+    vpshufd     ymm1, ymm4, 0x55        ; ymm1=col1_5=(01 01 01 01 01 01 01 01  05 05 05 05 05 05 05 05)
+    vpshufd     ymm2, ymm4, 0xAA        ; ymm2=col2_6=(02 02 02 02 02 02 02 02  06 06 06 06 06 06 06 06)
+    vpshufd     ymm3, ymm4, 0xFF        ; ymm3=col3_7=(03 03 03 03 03 03 03 03  07 07 07 07 07 07 07 07)
+
+    jmp         near .column_end
+%endif
+.columnDCT:
+
+    vmovdqu     ymm4, YMMWORD [YMMBLOCK(0,0,r11,SIZEOF_JCOEF)]  ; ymm4=in0_1
+    vmovdqu     ymm5, YMMWORD [YMMBLOCK(2,0,r11,SIZEOF_JCOEF)]  ; ymm5=in2_3
+    vmovdqu     ymm6, YMMWORD [YMMBLOCK(4,0,r11,SIZEOF_JCOEF)]  ; ymm6=in4_5
+    vmovdqu     ymm7, YMMWORD [YMMBLOCK(6,0,r11,SIZEOF_JCOEF)]  ; ymm7=in6_7
+    vpmullw     ymm4, ymm4, YMMWORD [YMMBLOCK(0,0,r10,SIZEOF_IFAST_MULT_TYPE)]
+    vpmullw     ymm5, ymm5, YMMWORD [YMMBLOCK(2,0,r10,SIZEOF_IFAST_MULT_TYPE)]
+    vpmullw     ymm6, ymm6, YMMWORD [YMMBLOCK(4,0,r10,SIZEOF_IFAST_MULT_TYPE)]
+    vpmullw     ymm7, ymm7, YMMWORD [YMMBLOCK(6,0,r10,SIZEOF_IFAST_MULT_TYPE)]
+
+    vperm2i128  ymm0, ymm4, ymm5, 0x20  ; ymm0=in0_2
+    vperm2i128  ymm1, ymm6, ymm7, 0x20  ; ymm1=in4_6
+    vperm2i128  ymm2, ymm4, ymm6, 0x31  ; ymm2=in1_5
+    vperm2i128  ymm3, ymm7, ymm5, 0x31  ; ymm3=in7_3
+
+    dodct ymm0, ymm1, ymm2, ymm3, ymm4, ymm5, ymm6, ymm7, 1
+    ; ymm0=data0_1, ymm1=data3_2, ymm2=data4_5, ymm3=data7_6
+
+    dotranspose ymm0, ymm1, ymm2, ymm3, ymm4, ymm5, ymm6, ymm7
+    ; ymm0=data0_4, ymm1=data1_5, ymm2=data2_6, ymm3=data3_7
+
+.column_end:
+
+    ; -- Prefetch the next coefficient block
+
+    prefetchnta [r11 + DCTSIZE2*SIZEOF_JCOEF + 0*32]
+    prefetchnta [r11 + DCTSIZE2*SIZEOF_JCOEF + 1*32]
+    prefetchnta [r11 + DCTSIZE2*SIZEOF_JCOEF + 2*32]
+    prefetchnta [r11 + DCTSIZE2*SIZEOF_JCOEF + 3*32]
+
+    ; ---- Pass 2: process rows.
+
+    vperm2i128  ymm4, ymm0, ymm2, 0x31  ; ymm4=in4_6
+    vperm2i128  ymm0, ymm0, ymm2, 0x20  ; ymm0=in0_2
+    vperm2i128  ymm3, ymm3, ymm3, 0x01  ; ymm3=in7_3
+
+    dodct ymm0, ymm4, ymm1, ymm3, ymm2, ymm5, ymm6, ymm7, 2
+    ; ymm0=data0_1, ymm4=data3_2, ymm1=data4_5, ymm3=data7_6
+    ; (each register holds two columns of output samples)
+
+    vpacksswb   ymm0, ymm0, ymm1        ; ymm0=(00 10 20 30 40 50 60 70 04 14 24 34 44 54 64 74
+                                        ;       01 11 21 31 41 51 61 71 05 15 25 35 45 55 65 75)
+    vpacksswb   ymm4, ymm4, ymm3        ; ymm4=(03 13 23 33 43 53 63 73 07 17 27 37 47 57 67 77
+                                        ;       02 12 22 32 42 52 62 72 06 16 26 36 46 56 66 76)
+    vpaddb      ymm0, ymm0, [rel PB_CENTERJSAMP]
+    vpaddb      ymm4, ymm4, [rel PB_CENTERJSAMP]
+
+    vpermq      ymm0, ymm0, 0xD8        ; ymm0=(00 10 20 30 40 50 60 70 01 11 21 31 41 51 61 71
+                                        ;       04 14 24 34 44 54 64 74 05 15 25 35 45 55 65 75)
+    vpermq      ymm4, ymm4, 0x72        ; ymm4=(02 12 22 32 42 52 62 72 03 13 23 33 43 53 63 73
+                                        ;       06 16 26 36 46 56 66 76 07 17 27 37 47 57 67 77)
+    vpshufb     ymm0, ymm0, [rel PB_INTERLEAVE]  ; ymm0=(00 01 10 11 20 21 30 31 40 41 50 51 60 61 70 71
+                                                 ;       04 05 14 15 24 25 34 35 44 45 54 55 64 65 74 75)
+    vpshufb     ymm4, ymm4, [rel PB_INTERLEAVE]  ; ymm4=(02 03 12 13 22 23 32 33 42 43 52 53 62 63 72 73
+                                                 ;       06 07 16 17 26 27 36 37 46 47 56 57 66 67 76 77)
+
+    vpunpcklwd  ymm1, ymm0, ymm4        ; ymm1=(00 01 02 03 10 11 12 13 20 21 22 23 30 31 32 33
+                                        ;       04 05 06 07 14 15 16 17 24 25 26 27 34 35 36 37)
+    vpunpckhwd  ymm2, ymm0, ymm4        ; ymm2=(40 41 42 43 50 51 52 53 60 61 62 63 70 71 72 73
+                                        ;       44 45 46 47 54 55 56 57 64 65 66 67 74 75 76 77)
+    vmovdqu     ymm3, [rel PD_ROWORDER]
+    vpermd      ymm1, ymm3, ymm1        ; ymm1=data01_23
+    vpermd      ymm2, ymm3, ymm2        ; ymm2=data45_67
+
+    vextracti128 xmm3, ymm1, 1          ; xmm3=data23
+    vextracti128 xmm5, ymm2, 1          ; xmm5=data67
+
+    vzeroupper
+
+    mov         eax, r13d
+
+    mov         rdx, JSAMPROW [r12+0*SIZEOF_JSAMPROW]  ; (JSAMPLE *)
+    mov         rsi, JSAMPROW [r12+1*SIZEOF_JSAMPROW]  ; (JSAMPLE *)
+    movq        XMM_MMWORD [rdx+rax*SIZEOF_JSAMPLE], xmm1
+    movhps      XMM_MMWORD [rsi+rax*SIZEOF_JSAMPLE], xmm1
+
+    mov         rdx, JSAMPROW [r12+2*SIZEOF_JSAMPROW]  ; (JSAMPLE *)
+    mov         rsi, JSAMPROW [r12+3*SIZEOF_JSAMPROW]  ; (JSAMPLE *)
+    movq        XMM_MMWORD [rdx+rax*SIZEOF_JSAMPLE], xmm3
+    movhps      XMM_MMWORD [rsi+rax*SIZEOF_JSAMPLE], xmm3
+
+    mov         rdx, JSAMPROW [r12+4*SIZEOF_JSAMPROW]  ; (JSAMPLE *)
+    mov         rsi, JSAMPROW [r12+5*SIZEOF_JSAMPROW]  ; (JSAMPLE *)
+    movq        XMM_MMWORD [rdx+rax*SIZEOF_JSAMPLE], xmm2
+    movhps      XMM_MMWORD [rsi+rax*SIZEOF_JSAMPLE], xmm2
+
+    mov         rdx, JSAMPROW [r12+6*SIZEOF_JSAMPROW]  ; (JSAMPLE *)
+    mov         rsi, JSAMPROW [r12+7*SIZEOF_JSAMPROW]  ; (JSAMPLE *)
+    movq        XMM_MMWORD [rdx+rax*SIZEOF_JSAMPLE], xmm5
+    movhps      XMM_MMWORD [rsi+rax*SIZEOF_JSAMPLE], xmm5
+
+    uncollect_args 4
+    pop         rbp
+    ret
+
+; For some reason, the OS X linker does not honor the request to align the
+; segment unless we do this.
+    align       32
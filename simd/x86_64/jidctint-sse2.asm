@@ -78,6 +78,14 @@ PW_MF060_MF089 times 4  dw  (F_0_298 - F_0_899), -F_0_899
 PW_MF089_F060  times 4  dw -F_0_899, (F_1_501 - F_0_899)
 PW_MF050_MF256 times 4  dw  (F_2_053 - F_2_562), -F_2_562
 PW_MF256_F050  times 4  dw -F_2_562, (F_3_072 - F_2_562)
+PW_CORNER4_EVEN dw  1 << CONST_BITS,  (F_0_541 + F_0_765)
+                dw  1 << CONST_BITS,   F_0_541
+                dw  1 << CONST_BITS,  -F_0_541
+                dw  1 << CONST_BITS, -(F_0_541 + F_0_765)
+PW_CORNER4_ODD  dw  (F_1_501 - F_0_899 - F_0_390 + F_1_175), F_1_175
+                dw  F_1_175, (F_3_072 - F_2_562 - F_1_961 + F_1_175)
+                dw  (F_1_175 - F_0_390), (F_1_175 - F_2_562)
+                dw  (F_1_175 - F_0_899), (F_1_175 - F_1_961)
 PD_DESCALE_P1  times 4  dd  1 << (DESCALE_P1 - 1)
 PD_DESCALE_P2  times 4  dd  1 << (DESCALE_P2 - 1)
 PB_CENTERJSAMP times 16 db  CENTERJSAMPLE
@@ -843,6 +851,140 @@ EXTN(jsimd_idct_islow_sse2):
     pop         rbp
     ret
 
+; --------------------------------------------------------------------------
+;
+; Perform dequantization and inverse DCT on one block of coefficients in
+; which only the top left 4x4 coefficients can be nonzero.  This gives the
+; same results as jsimd_idct_islow_sse2() for such a block.
+;
+; With y4 ... y7 zero, each 1-D IDCT output is tmp1x + tmp0..3 (or the
+; difference), where the even part tmp1x = y0 * 2^CONST_BITS + y2 * e and the
+; odd part = y1 * a + y3 * b can each be computed with one pmaddwd.
+; PW_CORNER4_EVEN and PW_CORNER4_ODD hold the pairs of constants for outputs
+; 0 ... 3 (outputs 7 ... 4 are the differences.)  Pass 1 broadcasts one pair
+; of constants and transforms columns 0 ... 3, ordered as 0, 2, 1, 3, at
+; once.  Pass 2 broadcasts one pair of coefficients and computes the four sums
+; and differences of one row at once.
+;
+; GLOBAL(void)
+; jsimd_idct_islow_corner4_sse2(void *dct_table, JCOEFPTR coef_block,
+;                               JSAMPARRAY output_buf, JDIMENSION output_col)
+;
+
+; r10 = jpeg_component_info *compptr
+; r11 = JCOEFPTR coef_block
+; r12 = JSAMPARRAY output_buf
+; r13d = JDIMENSION output_col
+
+;
+; Pass 1: compute rows %2 and 7-%2 of the 4 nonzero columns of the work array
+; into %1 from xmm0 = (y0, y2) and xmm2 = (y1, y3) of columns 0, 2, 1, 3.
+; %3 is the pshufd immediate that selects the constants for row %2.
+;
+
+%macro CORNER4_COL 3
+    pshufd      %1, XMMWORD [rel PW_CORNER4_EVEN], %3
+    pshufd      xmm4, XMMWORD [rel PW_CORNER4_ODD], %3
+    pmaddwd     %1, xmm0                ; %1=tmp1x
+    pmaddwd     xmm4, xmm2              ; xmm4=tmp0..3
+    paddd       %1, [rel PD_DESCALE_P1]
+    movdqa      xmm5, %1
+    paddd       %1, xmm4                ; %1=data(%2)
+    psubd       xmm5, xmm4              ; xmm5=data(7-%2)
+    psrad       %1, DESCALE_P1
+    psrad       xmm5, DESCALE_P1
+    packssdw    %1, xmm5                ; %1=(%2:0 2 1 3 7-%2:0 2 1 3)
+%endmacro
+
+;
+; Pass 2: compute the 8 outputs of the row of the work array held in dwords
+; %3 and %4 (in pshufd immediate form) of %2 into the words of %1.
+;
+
+%macro CORNER4_ROW 4
+    pshufd      %1, %2, %3              ; %1=(w0 w2 w0 w2 w0 w2 w0 w2)
+    pshufd      xmm5, %2, %4            ; xmm5=(w1 w3 w1 w3 w1 w3 w1 w3)
+    pmaddwd     %1, [rel PW_CORNER4_EVEN]  ; %1=tmp10 tmp11 tmp12 tmp13
+    pmaddwd     xmm5, [rel PW_CORNER4_ODD]  ; xmm5=tmp3 tmp2 tmp1 tmp0
+    paddd       %1, [rel PD_DESCALE_P2]
+    movdqa      xmm4, %1
+    paddd       %1, xmm5                ; %1=data0 data1 data2 data3
+    psubd       xmm4, xmm5              ; xmm4=data7 data6 data5 data4
+    psrad       %1, DESCALE_P2
+    psrad       xmm4, DESCALE_P2
+    packssdw    %1, xmm4
+    pshufhw     %1, %1, 0x1B            ; %1=(data0 ... data7)
+%endmacro
+
+;
+; Pass 2: compute and store output rows %2 and 7-%2 from %1.
+;
+
+%macro CORNER4_ROWS 2
+    CORNER4_ROW xmm0, %1, 0x00, 0x55
+    CORNER4_ROW xmm2, %1, 0xAA, 0xFF
+    packsswb    xmm0, xmm2
+    paddb       xmm0, [rel PB_CENTERJSAMP]
+    pshufd      xmm2, xmm0, 0x4E
+    mov         rdx, JSAMPROW [r12+%2*SIZEOF_JSAMPROW]      ; (JSAMPLE *)
+    mov         rsi, JSAMPROW [r12+(7-%2)*SIZEOF_JSAMPROW]  ; (JSAMPLE *)
+    movq        XMM_MMWORD [rdx+rax*SIZEOF_JSAMPLE], xmm0
+    movq        XMM_MMWORD [rsi+rax*SIZEOF_JSAMPLE], xmm2
+%endmacro
+
+    align       32
+    GLOBAL_FUNCTION(jsimd_idct_islow_corner4_sse2)
+
+EXTN(jsimd_idct_islow_corner4_sse2):
+    push        rbp
+    mov         rax, rsp                ; rax = original rbp
+    mov         rbp, rsp                ; rbp = aligned rbp
+    collect_args 4
+
+    ; ---- Pass 1: process columns 0 ... 3 from input.
+
+    movq        xmm0, XMM_MMWORD [MMBLOCK(0,0,r11,SIZEOF_JCOEF)]
+    movq        xmm4, XMM_MMWORD [MMBLOCK(1,0,r11,SIZEOF_JCOEF)]
+    movq        xmm1, XMM_MMWORD [MMBLOCK(2,0,r11,SIZEOF_JCOEF)]
+    movq        xmm5, XMM_MMWORD [MMBLOCK(3,0,r11,SIZEOF_JCOEF)]
+    punpcklqdq  xmm0, xmm4              ; xmm0=(00 01 02 03 10 11 12 13)
+    punpcklqdq  xmm1, xmm5              ; xmm1=(20 21 22 23 30 31 32 33)
+    movq        xmm2, XMM_MMWORD [MMBLOCK(0,0,r10,SIZEOF_ISLOW_MULT_TYPE)]
+    movq        xmm4, XMM_MMWORD [MMBLOCK(1,0,r10,SIZEOF_ISLOW_MULT_TYPE)]
+    movq        xmm3, XMM_MMWORD [MMBLOCK(2,0,r10,SIZEOF_ISLOW_MULT_TYPE)]
+    movq        xmm5, XMM_MMWORD [MMBLOCK(3,0,r10,SIZEOF_ISLOW_MULT_TYPE)]
+    punpcklqdq  xmm2, xmm4
+    punpcklqdq  xmm3, xmm5
+    pmullw      xmm0, xmm2
+    pmullw      xmm1, xmm3
+
+    pshuflw     xmm0, xmm0, 0xD8        ; xmm0=(00 02 01 03 10 12 11 13)
+    pshuflw     xmm1, xmm1, 0xD8        ; xmm1=(20 22 21 23 30 32 31 33)
+    pshufhw     xmm0, xmm0, 0xD8
+    pshufhw     xmm1, xmm1, 0xD8
+
+    movdqa      xmm2, xmm0
+    punpcklwd   xmm0, xmm1              ; xmm0=(00 20 02 22 01 21 03 23)
+    punpckhwd   xmm2, xmm1              ; xmm2=(10 30 12 32 11 31 13 33)
+
+    CORNER4_COL xmm1, 0, 0x00
+    CORNER4_COL xmm6, 1, 0x55
+    CORNER4_COL xmm7, 2, 0xAA
+    CORNER4_COL xmm3, 3, 0xFF
+
+    ; ---- Pass 2: process rows from work array, store into output array.
+
+    mov         eax, r13d
+
+    CORNER4_ROWS xmm1, 0
+    CORNER4_ROWS xmm6, 1
+    CORNER4_ROWS xmm7, 2
+    CORNER4_ROWS xmm3, 3
+
+    uncollect_args 4
+    pop         rbp
+    ret
+
 ; For some reason, the OS X linker does not honor the request to align the
 ; segment unless we do this.
     align       32
@@ -0,0 +1,363 @@
+;
+; jidctscl.asm - scaled inverse DCTs (64-bit AVX2)
+;
+; For conditions of distribution and use, see copyright notice in jsimdext.inc
+;
+; This file should be assembled with NASM (Netwide Assembler),
+; can *not* be assembled with Microsoft's MASM or any compatible
+; assembler (including Borland's Turbo Assembler).
+; NASM is available from http://nasm.sourceforge.net/ or
+; http://sourceforge.net/project/showfiles.php?group_id=6208
+;
+; This file contains inverse DCT routines that produce 3x3, 5x5, 6x6, 7x7
+; and 9x9 ... 16x16 output blocks.  They give the same results as
+; jpeg_idct_3x3() ... jpeg_idct_16x16() in jidctint.c and work like the
+; SSE2 versions (see jidctscl-sse2.asm), but pass 1 computes a whole row of
+; 8 columns per 256-bit multiply, and pass 2 computes all of the outputs of
+; a row (N > 8) or two rows at once (N < 8).
+;
+; [TAB8]
+
+%include "jsimdext.inc"
+%include "jdct.inc"
+
+; --------------------------------------------------------------------------
+
+%define CONST_BITS  13
+%define PASS1_BITS  2
+
+%define DESCALE_P1  (CONST_BITS - PASS1_BITS)
+%define DESCALE_P2  (CONST_BITS + PASS1_BITS + 3)
+
+;
+; Emit PB_ROW_SHUF_%1, the vpshufb mask that gathers an output row of a
+; %1x%1 block from the bytes (e+o 0 ... e+o k-1, e-o 0 ... e-o k-1) in each
+; 128-bit lane, where k = 4 for N < 8 and 8 for N > 8.
+;
+
+%macro PB_ROW_SHUF 1
+%if %1 < 8
+%assign %%k  4
+%else
+%assign %%k  8
+%endif
+PB_ROW_SHUF_%1 db 0
+%assign %%j  1
+%rep 31
+%assign %%i  %%j & 15
+%if %%i < (%1 + 1) / 2
+    db          %%i
+%elif %%i < %1
+    db          %%k + %1 - 1 - %%i
+%else
+    db          -1
+%endif
+%assign %%j  %%j + 1
+%endrep
+%endmacro
+
+; --------------------------------------------------------------------------
+    SECTION     SEG_CONST
+
+    alignz      32
+    GLOBAL_DATA(jconst_idct_scaled_avx2)
+
+EXTN(jconst_idct_scaled_avx2):
+
+PD_DESCALE_P1  times 8  dd  1 << (DESCALE_P1 - 1)
+PD_DESCALE_P2  times 8  dd  1 << (DESCALE_P2 - 1)
+PB_CENTERJSAMP times 32 db  CENTERJSAMPLE
+
+    PB_ROW_SHUF 3
+    PB_ROW_SHUF 5
+    PB_ROW_SHUF 6
+    PB_ROW_SHUF 7
+    PB_ROW_SHUF 9
+    PB_ROW_SHUF 10
+    PB_ROW_SHUF 11
+    PB_ROW_SHUF 12
+    PB_ROW_SHUF 13
+    PB_ROW_SHUF 14
+    PB_ROW_SHUF 15
+    PB_ROW_SHUF 16
+
+    alignz      32
+
+%include "jidctscl.inc"
+
+    alignz      32
+
+; --------------------------------------------------------------------------
+    SECTION     SEG_TEXT
+    BITS        64
+;
+; Store the first %1 bytes of %2 to %3.  Clobbers %2 and r9d.
+;
+
+%macro STORE_ROW 3
+%assign %%off  0
+%assign %%rem  %1
+%if %%rem >= 16
+    vmovdqu     XMMWORD [%3], %2
+%assign %%rem  0
+%elif %%rem >= 8
+    vmovq       XMM_MMWORD [%3], %2
+%assign %%off  8
+%assign %%rem  %%rem - 8
+%if %%rem > 0
+    vpsrldq     %2, %2, 8
+%endif
+%endif
+%if %%rem >= 4
+    vmovd       XMM_DWORD [%3 + %%off], %2
+%assign %%off  %%off + 4
+%assign %%rem  %%rem - 4
+%if %%rem > 0
+    vpsrldq     %2, %2, 4
+%endif
+%endif
+%if %%rem > 0
+    vmovd       r9d, %2
+%endif
+%if %%rem >= 2
+    mov         WORD [%3 + %%off], r9w
+%assign %%off  %%off + 2
+%assign %%rem  %%rem - 2
+%if %%rem > 0
+    shr         r9d, 16
+%endif
+%endif
+%if %%rem > 0
+    mov         BYTE [%3 + %%off], r9b
+%endif
+%endmacro
+
+;
+; Perform dequantization and inverse DCT on one block of coefficients,
+; producing a scaled %1x%1 output block.
+;
+; GLOBAL(void)
+; jsimd_idct_NxN_avx2(void *dct_table, JCOEFPTR coef_block,
+;                     JSAMPARRAY output_buf, JDIMENSION output_col)
+;
+
+; r10 = void *dct_table
+; r11 = JCOEFPTR coef_block
+; r12 = JSAMPARRAY output_buf
+; r13d = JDIMENSION output_col
+
+%define original_rbp  rbp + 0
+%define ws(i)         rbp - (WS_NUM - (i)) * SIZEOF_XMMWORD
+                                        ; xmmword ws[WS_NUM]
+%define WS_NUM        16
+
+;
+; Dequantize rows %3 ... %3+3 of the coefficient block, reorder their columns
+; as 0, 2, 1, 3, 4, 6, 5, 7 (so that pass 2 finds the pairs {0, 2}, {1, 3},
+; {4, 6} and {5, 7} in consecutive dwords) and interleave them:
+; %1 = rows %3 and %3+2, %2 = rows %3+1 and %3+3.
+;
+
+%macro DEQUANT_PAIRS 3
+    vmovdqu     %1, YMMWORD [YMMBLOCK(%3,0,r11,SIZEOF_JCOEF)]
+    vmovdqu     %2, YMMWORD [YMMBLOCK(%3+2,0,r11,SIZEOF_JCOEF)]
+    vpmullw     %1, %1, YMMWORD [YMMBLOCK(%3,0,r10,SIZEOF_ISLOW_MULT_TYPE)]
+    vpmullw     %2, %2, YMMWORD [YMMBLOCK(%3+2,0,r10,SIZEOF_ISLOW_MULT_TYPE)]
+    vpshuflw    %1, %1, 0xD8
+    vpshuflw    %2, %2, 0xD8
+    vpshufhw    %1, %1, 0xD8
+    vpshufhw    %2, %2, 0xD8
+    vpunpcklwd  ymm4, %1, %2
+    vpunpckhwd  ymm5, %1, %2
+    vperm2i128  %1, ymm4, ymm5, 0x20
+    vperm2i128  %2, ymm4, ymm5, 0x31
+%endmacro
+
+;
+; Compute the output samples of the row(s) of the work array at [rsi] into
+; ymm0, gathered by PB_ROW_SHUF_%1.  For N < 8, the two 128-bit lanes of ymm3
+; hold two rows, whose samples end up in the two lanes of ymm0.
+;
+
+%macro ROW_PARTS 2
+%if %1 < 8
+    vpshufd     ymm0, ymm3, 0x00        ; ymm0 = columns 0, 2
+    vpshufd     ymm1, ymm3, 0x55        ; ymm1 = columns 1, 3
+    vbroadcasti128 ymm4, XMMWORD [rcx + 0 * %2]
+    vbroadcasti128 ymm5, XMMWORD [rcx + 1 * %2]
+    vpmaddwd    ymm0, ymm0, ymm4
+    vpmaddwd    ymm1, ymm1, ymm5
+%if %1 > 3
+    vpshufd     ymm2, ymm3, 0xAA        ; ymm2 = columns 4, 6
+    vbroadcasti128 ymm4, XMMWORD [rcx + 2 * %2]
+    vpmaddwd    ymm2, ymm2, ymm4
+    vpaddd      ymm0, ymm0, ymm2
+%endif
+%if %1 > 5
+    vpshufd     ymm3, ymm3, 0xFF        ; ymm3 = columns 5, 7
+    vbroadcasti128 ymm5, XMMWORD [rcx + 3 * %2]
+    vpmaddwd    ymm3, ymm3, ymm5
+    vpaddd      ymm1, ymm1, ymm3
+%endif
+%else
+    vpbroadcastd ymm0, XMM_DWORD [rsi + 0 * SIZEOF_DWORD]  ; columns 0, 2
+    vpbroadcastd ymm1, XMM_DWORD [rsi + 1 * SIZEOF_DWORD]  ; columns 1, 3
+    vpbroadcastd ymm2, XMM_DWORD [rsi + 2 * SIZEOF_DWORD]  ; columns 4, 6
+    vpbroadcastd ymm3, XMM_DWORD [rsi + 3 * SIZEOF_DWORD]  ; columns 5, 7
+    vpmaddwd    ymm0, ymm0, YMMWORD [rcx + 0 * %2]
+    vpmaddwd    ymm1, ymm1, YMMWORD [rcx + 1 * %2]
+    vpmaddwd    ymm2, ymm2, YMMWORD [rcx + 2 * %2]
+    vpmaddwd    ymm3, ymm3, YMMWORD [rcx + 3 * %2]
+    vpaddd      ymm0, ymm0, ymm2
+    vpaddd      ymm1, ymm1, ymm3
+%endif
+    vpaddd      ymm0, ymm0, [rel PD_DESCALE_P2]
+    vpsubd      ymm2, ymm0, ymm1
+    vpaddd      ymm0, ymm0, ymm1
+    vpsrad      ymm2, ymm2, DESCALE_P2
+    vpsrad      ymm0, ymm0, DESCALE_P2
+    vpackssdw   ymm0, ymm0, ymm2
+%if %1 > 8
+    vpermq      ymm0, ymm0, 0xD8
+    vextracti128 xmm2, ymm0, 1
+    vpacksswb   xmm0, xmm0, xmm2
+%else
+    vpacksswb   ymm0, ymm0, ymm0
+%endif
+    vpshufb     ymm0, ymm0, [rel PB_ROW_SHUF_%1]
+    vpaddb      ymm0, ymm0, [rel PB_CENTERJSAMP]
+%endmacro
+
+%macro IDCT_SCALED 1
+%if %1 > 8
+%assign %%stride  8 * SIZEOF_DWORD
+%else
+%assign %%stride  4 * SIZEOF_DWORD
+%endif
+
+    align       32
+    GLOBAL_FUNCTION(jsimd_idct_%1x%1_avx2)
+
+EXTN(jsimd_idct_%1x%1_avx2):
+    push        rbp
+    mov         rax, rsp                     ; rax = original rbp
+    sub         rsp, byte 4
+    and         rsp, byte (-SIZEOF_YMMWORD)  ; align to 256 bits
+    mov         [rsp], rax
+    mov         rbp, rsp                     ; rbp = aligned rbp
+    lea         rsp, [ws(0)]
+    collect_args 4
+
+    ; ---- Pass 1: process columns from input, store into work array.
+
+    DEQUANT_PAIRS ymm0, ymm1, 0
+%if %1 > 3
+    DEQUANT_PAIRS ymm2, ymm3, 4
+%endif
+
+    lea         rcx, [rel PW_IDCT_%1X%1]
+    lea         rsi, [ws(0)]
+    lea         rdi, [ws(%1-1)]
+    mov         r8d, (%1 + 1) / 2
+.columnloop:
+    vpbroadcastd ymm4, XMM_DWORD [rcx + 0 * %%stride]
+    vpbroadcastd ymm5, XMM_DWORD [rcx + 1 * %%stride]
+    vpmaddwd    ymm4, ymm4, ymm0        ; ymm4 = even part
+    vpmaddwd    ymm5, ymm5, ymm1        ; ymm5 = odd part
+%if %1 > 3
+    vpbroadcastd ymm6, XMM_DWORD [rcx + 2 * %%stride]
+    vpmaddwd    ymm6, ymm6, ymm2
+    vpaddd      ymm4, ymm4, ymm6
+%endif
+%if %1 > 5
+    vpbroadcastd ymm7, XMM_DWORD [rcx + 3 * %%stride]
+    vpmaddwd    ymm7, ymm7, ymm3
+    vpaddd      ymm5, ymm5, ymm7
+%endif
+    vpaddd      ymm4, ymm4, [rel PD_DESCALE_P1]
+    vpsubd      ymm6, ymm4, ymm5
+    vpaddd      ymm4, ymm4, ymm5
+    vpsrad      ymm6, ymm6, DESCALE_P1
+    vpsrad      ymm4, ymm4, DESCALE_P1
+    vpackssdw   ymm4, ymm4, ymm6
+    vpermq      ymm4, ymm4, 0xD8        ; ymm4 = (e+o 0-7 e-o 0-7)
+    vmovdqa     XMMWORD [rsi], xmm4
+    vextracti128 XMMWORD [rdi], ymm4, 1
+
+    add         rcx, byte SIZEOF_DWORD
+    add         rsi, byte SIZEOF_XMMWORD
+    sub         rdi, byte SIZEOF_XMMWORD
+    dec         r8d
+    jnz         near .columnloop
+
+    ; ---- Pass 2: process rows from work array, store into output array.
+
+    lea         rcx, [rel PW_IDCT_%1X%1]
+    lea         rsi, [ws(0)]
+    mov         rdi, r12                ; (JSAMPROW *)
+    mov         eax, r13d
+%if %1 < 8
+    mov         r8d, %1 / 2
+.rowloop:
+    vmovdqa     ymm3, YMMWORD [rsi]
+    ROW_PARTS   %1, %%stride
+    vextracti128 xmm1, ymm0, 1
+
+    mov         rdx, JSAMPROW [rdi]
+    mov         r10, JSAMPROW [rdi+SIZEOF_JSAMPROW]
+    add         rdx, rax
+    add         r10, rax
+    STORE_ROW   %1, xmm0, rdx
+    STORE_ROW   %1, xmm1, r10
+
+    add         rsi, byte 2 * SIZEOF_XMMWORD
+    add         rdi, byte 2 * SIZEOF_JSAMPROW
+    dec         r8d
+    jnz         near .rowloop
+%if %1 & 1
+    vmovdqa     xmm3, XMMWORD [rsi]
+    ROW_PARTS   %1, %%stride
+
+    mov         rdx, JSAMPROW [rdi]
+    add         rdx, rax
+    STORE_ROW   %1, xmm0, rdx
+%endif
+%else
+    mov         r8d, %1
+.rowloop:
+    ROW_PARTS   %1, %%stride
+
+    mov         rdx, JSAMPROW [rdi]
+    add         rdx, rax
+    STORE_ROW   %1, xmm0, rdx
+
+    add         rsi, byte SIZEOF_XMMWORD
+    add         rdi, byte SIZEOF_JSAMPROW
+    dec         r8d
+    jnz         near .rowloop
+%endif
+
+    vzeroupper
+    uncollect_args 4
+    mov         rsp, rbp                ; rsp <- aligned rbp
+    pop         rsp                     ; rsp <- original rbp
+    pop         rbp
+    ret
+%endmacro
+
+    IDCT_SCALED 3
+    IDCT_SCALED 5
+    IDCT_SCALED 6
+    IDCT_SCALED 7
+    IDCT_SCALED 9
+    IDCT_SCALED 10
+    IDCT_SCALED 11
+    IDCT_SCALED 12
+    IDCT_SCALED 13
+    IDCT_SCALED 14
+    IDCT_SCALED 15
+    IDCT_SCALED 16
+
+; For some reason, the OS X linker does not honor the request to align the
+; segment unless we do this.
+    align       32
@@ -0,0 +1,354 @@
+;
+; jidctscl.asm - scaled inverse DCTs (64-bit SSE2)
+;
+; For conditions of distribution and use, see copyright notice in jsimdext.inc
+;
+; This file should be assembled with NASM (Netwide Assembler),
+; can *not* be assembled with Microsoft's MASM or any compatible
+; assembler (including Borland's Turbo Assembler).
+; NASM is available from http://nasm.sourceforge.net/ or
+; http://sourceforge.net/project/showfiles.php?group_id=6208
+;
+; This file contains inverse DCT routines that produce 3x3, 5x5, 6x6, 7x7
+; and 9x9 ... 16x16 output blocks.  They give the same results as
+; jpeg_idct_3x3() ... jpeg_idct_16x16() in jidctint.c, but rather than
+; following the butterflies of each size, every pass multiplies its input by
+; the matrix those butterflies work out to (see jidctscl.inc), two inputs at
+; a time with pmaddwd.
+;
+; [TAB8]
+
+%include "jsimdext.inc"
+%include "jdct.inc"
+
+; --------------------------------------------------------------------------
+
+%define CONST_BITS  13
+%define PASS1_BITS  2
+
+%define DESCALE_P1  (CONST_BITS - PASS1_BITS)
+%define DESCALE_P2  (CONST_BITS + PASS1_BITS + 3)
+
+; --------------------------------------------------------------------------
+    SECTION     SEG_CONST
+
+    alignz      32
+    GLOBAL_DATA(jconst_idct_scaled_sse2)
+
+EXTN(jconst_idct_scaled_sse2):
+
+PD_DESCALE_P1  times 4  dd  1 << (DESCALE_P1 - 1)
+PD_DESCALE_P2  times 4  dd  1 << (DESCALE_P2 - 1)
+PB_CENTERJSAMP times 16 db  CENTERJSAMPLE
+
+    alignz      32
+
+%include "jidctscl.inc"
+
+    alignz      32
+
+; --------------------------------------------------------------------------
+    SECTION     SEG_TEXT
+    BITS        64
+;
+; Store the first %1 bytes of %2 to %3.  Clobbers %2 and r9d.
+;
+
+%macro STORE_ROW 3
+%assign %%off  0
+%assign %%rem  %1
+%if %%rem >= 16
+    movdqu      XMMWORD [%3], %2
+%assign %%rem  0
+%elif %%rem >= 8
+    movq        XMM_MMWORD [%3], %2
+%assign %%off  8
+%assign %%rem  %%rem - 8
+%if %%rem > 0
+    psrldq      %2, 8
+%endif
+%endif
+%if %%rem >= 4
+    movd        XMM_DWORD [%3 + %%off], %2
+%assign %%off  %%off + 4
+%assign %%rem  %%rem - 4
+%if %%rem > 0
+    psrldq      %2, 4
+%endif
+%endif
+%if %%rem > 0
+    movd        r9d, %2
+%endif
+%if %%rem >= 2
+    mov         WORD [%3 + %%off], r9w
+%assign %%off  %%off + 2
+%assign %%rem  %%rem - 2
+%if %%rem > 0
+    shr         r9d, 16
+%endif
+%endif
+%if %%rem > 0
+    mov         BYTE [%3 + %%off], r9b
+%endif
+%endmacro
+
+;
+; Perform dequantization and inverse DCT on one block of coefficients,
+; producing a scaled %1x%1 output block.
+;
+; GLOBAL(void)
+; jsimd_idct_NxN_sse2(void *dct_table, JCOEFPTR coef_block,
+;                     JSAMPARRAY output_buf, JDIMENSION output_col)
+;
+
+; r10 = void *dct_table
+; r11 = JCOEFPTR coef_block
+; r12 = JSAMPARRAY output_buf
+; r13d = JDIMENSION output_col
+
+%define original_rbp  rbp + 0
+%define wk(i)         rbp - (WK_NUM - (i)) * SIZEOF_XMMWORD
+                                        ; xmmword wk[WK_NUM]
+%define WK_NUM        24
+%define ws(i)         wk(8 + (i))       ; work array, one row per xmmword
+
+;
+; Dequantize rows %1 and %1+2 of the coefficient block, reorder their columns
+; as 0, 2, 1, 3, 4, 6, 5, 7 (so that pass 2 finds the pairs {0, 2}, {1, 3},
+; {4, 6} and {5, 7} in consecutive dwords) and store them interleaved:
+; wk(%2) = columns 0-3 and wk(%2+1) = columns 4-7 of the pairs.
+;
+
+%macro DEQUANT_PAIR 2
+    movdqa      xmm0, XMMWORD [XMMBLOCK(%1,0,r11,SIZEOF_JCOEF)]
+    movdqa      xmm1, XMMWORD [XMMBLOCK(%1+2,0,r11,SIZEOF_JCOEF)]
+    pmullw      xmm0, XMMWORD [XMMBLOCK(%1,0,r10,SIZEOF_ISLOW_MULT_TYPE)]
+    pmullw      xmm1, XMMWORD [XMMBLOCK(%1+2,0,r10,SIZEOF_ISLOW_MULT_TYPE)]
+    pshuflw     xmm0, xmm0, 0xD8
+    pshuflw     xmm1, xmm1, 0xD8
+    pshufhw     xmm0, xmm0, 0xD8
+    pshufhw     xmm1, xmm1, 0xD8
+    movdqa      xmm2, xmm0
+    punpcklwd   xmm0, xmm1
+    punpckhwd   xmm2, xmm1
+    movdqa      XMMWORD [wk(%2)], xmm0
+    movdqa      XMMWORD [wk(%2+1)], xmm2
+%endmacro
+
+;
+; Multiply the input pairs in wk(%3) (columns 0-3) and wk(%3+1) (columns
+; 4-7) by the coefficient pair at [rcx + %4] and store the products in %1
+; and %2.
+;
+
+%macro COLUMN_PAIR 4
+    movd        %1, XMM_DWORD [rcx + %4]
+    pshufd      %1, %1, 0x00
+    movdqa      %2, %1
+    pmaddwd     %1, XMMWORD [wk(%3)]
+    pmaddwd     %2, XMMWORD [wk(%3+1)]
+%endmacro
+
+%macro IDCT_SCALED 1
+%if %1 == 3
+%assign %%kpairs  2
+%elif %1 == 5
+%assign %%kpairs  3
+%else
+%assign %%kpairs  4
+%endif
+%if %1 > 8
+%assign %%stride  8 * SIZEOF_DWORD
+%else
+%assign %%stride  4 * SIZEOF_DWORD
+%endif
+%assign %%even  (%1 + 1) / 2           ; outputs 0 ... even-1 = even + odd
+%assign %%odd   %1 / 2                 ; outputs N-1 ... even = even - odd
+
+    align       32
+    GLOBAL_FUNCTION(jsimd_idct_%1x%1_sse2)
+
+EXTN(jsimd_idct_%1x%1_sse2):
+    push        rbp
+    mov         rax, rsp                     ; rax = original rbp
+    sub         rsp, byte 4
+    and         rsp, byte (-SIZEOF_XMMWORD)  ; align to 128 bits
+    mov         [rsp], rax
+    mov         rbp, rsp                     ; rbp = aligned rbp
+    lea         rsp, [wk(0)]
+    collect_args 4
+
+    ; ---- Pass 1: process columns from input, store into work array.
+
+    DEQUANT_PAIR 0, 0
+    DEQUANT_PAIR 1, 2
+%if %%kpairs > 2
+    DEQUANT_PAIR 4, 4
+%endif
+%if %%kpairs > 3
+    DEQUANT_PAIR 5, 6
+%endif
+
+    lea         rcx, [rel PW_IDCT_%1X%1]
+    lea         rsi, [ws(0)]
+    lea         rdi, [ws(%1-1)]
+    mov         r8d, %%even
+.columnloop:
+    COLUMN_PAIR xmm4, xmm5, 0, 0 * %%stride  ; xmm4/xmm5 = even part
+    COLUMN_PAIR xmm6, xmm7, 2, 1 * %%stride  ; xmm6/xmm7 = odd part
+%if %%kpairs > 2
+    COLUMN_PAIR xmm0, xmm1, 4, 2 * %%stride
+    paddd       xmm4, xmm0
+    paddd       xmm5, xmm1
+%endif
+%if %%kpairs > 3
+    COLUMN_PAIR xmm2, xmm3, 6, 3 * %%stride
+    paddd       xmm6, xmm2
+    paddd       xmm7, xmm3
+%endif
+    paddd       xmm4, [rel PD_DESCALE_P1]
+    paddd       xmm5, [rel PD_DESCALE_P1]
+    movdqa      xmm0, xmm4
+    movdqa      xmm1, xmm5
+    paddd       xmm4, xmm6
+    paddd       xmm5, xmm7
+    psubd       xmm0, xmm6
+    psubd       xmm1, xmm7
+    psrad       xmm4, DESCALE_P1
+    psrad       xmm5, DESCALE_P1
+    psrad       xmm0, DESCALE_P1
+    psrad       xmm1, DESCALE_P1
+    packssdw    xmm4, xmm5
+    packssdw    xmm0, xmm1
+    movdqa      XMMWORD [rsi], xmm4
+    movdqa      XMMWORD [rdi], xmm0
+
+    add         rcx, byte SIZEOF_DWORD
+    add         rsi, byte SIZEOF_XMMWORD
+    sub         rdi, byte SIZEOF_XMMWORD
+    dec         r8d
+    jnz         near .columnloop
+
+    ; ---- Pass 2: process rows from work array, store into output array.
+
+    lea         rcx, [rel PW_IDCT_%1X%1]
+    lea         rsi, [ws(0)]
+    mov         rdi, r12                ; (JSAMPROW *)
+    mov         eax, r13d
+    mov         r8d, %1
+.rowloop:
+    movdqa      xmm3, XMMWORD [rsi]
+    pshufd      xmm0, xmm3, 0x00        ; xmm0 = columns 0, 2
+    pshufd      xmm1, xmm3, 0x55        ; xmm1 = columns 1, 3
+%if %%kpairs > 2
+    pshufd      xmm2, xmm3, 0xAA        ; xmm2 = columns 4, 6
+%endif
+%if %%kpairs > 3
+    pshufd      xmm3, xmm3, 0xFF        ; xmm3 = columns 5, 7
+%endif
+
+%if %1 < 8
+    pmaddwd     xmm0, XMMWORD [rcx + 0 * %%stride]
+    pmaddwd     xmm1, XMMWORD [rcx + 1 * %%stride]
+%if %%kpairs > 2
+    pmaddwd     xmm2, XMMWORD [rcx + 2 * %%stride]
+    paddd       xmm0, xmm2
+%endif
+%if %%kpairs > 3
+    pmaddwd     xmm3, XMMWORD [rcx + 3 * %%stride]
+    paddd       xmm1, xmm3
+%endif
+    paddd       xmm0, [rel PD_DESCALE_P2]
+    movdqa      xmm2, xmm0
+    paddd       xmm0, xmm1
+    psubd       xmm2, xmm1
+    psrad       xmm0, DESCALE_P2
+    psrad       xmm2, DESCALE_P2
+    packssdw    xmm0, xmm2              ; xmm0 = (e+o 0-3 e-o 0-3)
+%if %1 == 7
+    pshufhw     xmm0, xmm0, 0xC6        ; xmm0 = (e+o 0-3 e-o 2-0 3)
+%assign %%skip  4
+%else
+    pshufhw     xmm0, xmm0, 0x1B        ; xmm0 = (e+o 0-3 e-o 3-0)
+%assign %%skip  8 - %%odd
+%endif
+    packsswb    xmm0, xmm0
+%else
+    movdqa      xmm4, xmm0
+    movdqa      xmm5, xmm2
+    pmaddwd     xmm4, XMMWORD [rcx + 0 * %%stride]
+    pmaddwd     xmm0, XMMWORD [rcx + 0 * %%stride + SIZEOF_XMMWORD]
+    pmaddwd     xmm5, XMMWORD [rcx + 2 * %%stride]
+    pmaddwd     xmm2, XMMWORD [rcx + 2 * %%stride + SIZEOF_XMMWORD]
+    paddd       xmm4, xmm5
+    paddd       xmm0, xmm2              ; xmm4/xmm0 = even part
+    movdqa      xmm5, xmm1
+    movdqa      xmm2, xmm3
+    pmaddwd     xmm5, XMMWORD [rcx + 1 * %%stride]
+    pmaddwd     xmm1, XMMWORD [rcx + 1 * %%stride + SIZEOF_XMMWORD]
+    pmaddwd     xmm2, XMMWORD [rcx + 3 * %%stride]
+    pmaddwd     xmm3, XMMWORD [rcx + 3 * %%stride + SIZEOF_XMMWORD]
+    paddd       xmm5, xmm2
+    paddd       xmm1, xmm3              ; xmm5/xmm1 = odd part
+    paddd       xmm4, [rel PD_DESCALE_P2]
+    paddd       xmm0, [rel PD_DESCALE_P2]
+    movdqa      xmm2, xmm4
+    movdqa      xmm3, xmm0
+    paddd       xmm4, xmm5
+    paddd       xmm0, xmm1
+    psubd       xmm2, xmm5
+    psubd       xmm3, xmm1
+    psrad       xmm4, DESCALE_P2
+    psrad       xmm0, DESCALE_P2
+    psrad       xmm2, DESCALE_P2
+    psrad       xmm3, DESCALE_P2
+    packssdw    xmm4, xmm0              ; xmm4 = (e+o 0-7)
+    packssdw    xmm2, xmm3              ; xmm2 = (e-o 0-7)
+    pshuflw     xmm2, xmm2, 0x1B
+    pshufhw     xmm2, xmm2, 0x1B
+    pshufd      xmm0, xmm2, 0x4E        ; xmm0 = (e-o 7-0)
+    packsswb    xmm4, xmm0
+    movdqa      xmm0, xmm4
+%assign %%skip  16 - %%odd
+%endif
+    paddb       xmm0, [rel PB_CENTERJSAMP]
+
+    mov         rdx, JSAMPROW [rdi]
+    add         rdx, rax
+%if %%skip == %%even
+    STORE_ROW   %1, xmm0, rdx
+%else
+    movdqa      xmm1, xmm0
+    psrldq      xmm1, %%skip
+    STORE_ROW   %%even, xmm0, rdx
+    STORE_ROW   %%odd, xmm1, rdx + %%even
+%endif
+
+    add         rsi, byte SIZEOF_XMMWORD
+    add         rdi, byte SIZEOF_JSAMPROW
+    dec         r8d
+    jnz         near .rowloop
+
+    uncollect_args 4
+    mov         rsp, rbp                ; rsp <- aligned rbp
+    pop         rsp                     ; rsp <- original rbp
+    pop         rbp
+    ret
+%endmacro
+
+    IDCT_SCALED 3
+    IDCT_SCALED 5
+    IDCT_SCALED 6
+    IDCT_SCALED 7
+    IDCT_SCALED 9
+    IDCT_SCALED 10
+    IDCT_SCALED 11
+    IDCT_SCALED 12
+    IDCT_SCALED 13
+    IDCT_SCALED 14
+    IDCT_SCALED 15
+    IDCT_SCALED 16
+
+; For some reason, the OS X linker does not honor the request to align the
+; segment unless we do this.
+    align       32
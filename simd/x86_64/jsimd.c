@@ -17,9 +17,11 @@
 #define JPEG_INTERNALS
 #include "../../jinclude.h"
 #include "../../jpeglib.h"
+#include "../../jpegcomp.h"
 #include "../../jsimd.h"
 #include "../../jdct.h"
 #include "../../jsimddct.h"
+#include "../../jthread.h"
 #include "../jsimd.h"
 #include "jconfigint.h"
 
@@ -31,35 +33,154 @@
 
 #define IS_ALIGNED_SSE(ptr)  (IS_ALIGNED(ptr, 4)) /* 16 byte alignment */
 #define IS_ALIGNED_AVX(ptr)  (IS_ALIGNED(ptr, 5)) /* 32 byte alignment */
+#define IS_ALIGNED_AVX512(ptr)  (IS_ALIGNED(ptr, 6)) /* 64 byte alignment */
 
-static unsigned int simd_support = (unsigned int)(~0);
-static unsigned int simd_huffman = 1;
+/* Number of entries in the tables of color conversion functions, which are
+ * indexed by J_COLOR_SPACE
+ */
+#define NUM_COLOR_SPACES  (JCS_RGB565 + 1)
+
+/* The ordered dither pattern of jdcolor.c and jdmerge.c, which the RGB565
+ * kernels take one row at a time
+ */
+#define DITHER_MASK  0x3
+static const JLONG dither_matrix[4] = {
+  0x0008020A,
+  0x0C040E06,
+  0x030B0109,
+  0x0F070D05
+};
 
 /*
- * Check what SIMD accelerations are supported.
- *
- * FIXME: This code is racy under a multi-threaded environment.
+ * The SIMD functions used by this process.  These are resolved once, the
+ * first time that any jsimd_can_*() function is called, and a NULL entry
+ * means that no SIMD implementation can be used.
+ */
+static struct {
+  void (*rgb_ycc_convert[NUM_COLOR_SPACES]) (JDIMENSION, JSAMPARRAY,
+                                             JSAMPIMAGE, JDIMENSION, int);
+  void (*rgb_gray_convert[NUM_COLOR_SPACES]) (JDIMENSION, JSAMPARRAY,
+                                              JSAMPIMAGE, JDIMENSION, int);
+  void (*ycc_rgb_convert[NUM_COLOR_SPACES]) (JDIMENSION, JSAMPIMAGE,
+                                             JDIMENSION, JSAMPARRAY, int);
+  void (*ycc_rgb565_convert) (JDIMENSION, JSAMPIMAGE, JDIMENSION, JSAMPARRAY,
+                              int, JLONG);
+  void (*c_rgb_rgb_convert[NUM_COLOR_SPACES]) (JDIMENSION, JSAMPARRAY,
+                                               JSAMPIMAGE, JDIMENSION, int);
+  void (*gray_rgb_convert[NUM_COLOR_SPACES]) (JDIMENSION, JSAMPIMAGE,
+                                              JDIMENSION, JSAMPARRAY, int);
+  void (*rgb_rgb_convert[NUM_COLOR_SPACES]) (JDIMENSION, JSAMPIMAGE,
+                                             JDIMENSION, JSAMPARRAY, int);
+  void (*cmyk_ycck_convert) (JDIMENSION, JSAMPARRAY, JSAMPIMAGE, JDIMENSION,
+                             int);
+  void (*ycck_cmyk_convert) (JDIMENSION, JSAMPIMAGE, JDIMENSION, JSAMPARRAY,
+                             int);
+  void (*cmyk_rgb_convert[NUM_COLOR_SPACES]) (JDIMENSION, JSAMPIMAGE,
+                                              JDIMENSION, JSAMPARRAY, int);
+  void (*ycck_rgb_convert[NUM_COLOR_SPACES]) (JDIMENSION, JSAMPIMAGE,
+                                              JDIMENSION, JSAMPARRAY, int);
+  void (*h2v2_downsample) (JDIMENSION, int, JDIMENSION, JDIMENSION,
+                           JSAMPARRAY, JSAMPARRAY);
+  void (*h2v1_downsample) (JDIMENSION, int, JDIMENSION, JDIMENSION,
+                           JSAMPARRAY, JSAMPARRAY);
+  void (*h4v1_downsample) (JDIMENSION, int, JDIMENSION, JDIMENSION,
+                           JSAMPARRAY, JSAMPARRAY);
+  void (*h4v2_downsample) (JDIMENSION, int, JDIMENSION, JDIMENSION,
+                           JSAMPARRAY, JSAMPARRAY);
+  void (*h1v2_downsample) (JDIMENSION, int, JDIMENSION, JDIMENSION,
+                           JSAMPARRAY, JSAMPARRAY);
+  void (*h2v4_downsample) (JDIMENSION, int, JDIMENSION, JDIMENSION,
+                           JSAMPARRAY, JSAMPARRAY);
+  void (*h2v2_smooth_downsample) (JDIMENSION, JDIMENSION, int, JDIMENSION,
+                                  JSAMPARRAY, JSAMPARRAY);
+  void (*fullsize_smooth_downsample) (JDIMENSION, JDIMENSION, int,
+                                      JDIMENSION, JSAMPARRAY, JSAMPARRAY);
+  void (*h2v2_upsample) (int, JDIMENSION, JSAMPARRAY, JSAMPARRAY *);
+  void (*h2v1_upsample) (int, JDIMENSION, JSAMPARRAY, JSAMPARRAY *);
+  void (*h4v1_upsample) (int, JDIMENSION, JSAMPARRAY, JSAMPARRAY *);
+  void (*h4v2_upsample) (int, JDIMENSION, JSAMPARRAY, JSAMPARRAY *);
+  void (*h1v2_upsample) (int, JDIMENSION, JSAMPARRAY, JSAMPARRAY *);
+  void (*h2v4_upsample) (int, JDIMENSION, JSAMPARRAY, JSAMPARRAY *);
+  void (*h2v2_fancy_upsample) (int, JDIMENSION, JSAMPARRAY, JSAMPARRAY *);
+  void (*h2v1_fancy_upsample) (int, JDIMENSION, JSAMPARRAY, JSAMPARRAY *);
+  void (*h1v2_fancy_upsample) (int, JDIMENSION, JSAMPARRAY, JSAMPARRAY *);
+  void (*h2v2_merged_upsample[NUM_COLOR_SPACES]) (JDIMENSION, JSAMPIMAGE,
+                                                  JDIMENSION, JSAMPARRAY);
+  void (*h2v1_merged_upsample[NUM_COLOR_SPACES]) (JDIMENSION, JSAMPIMAGE,
+                                                  JDIMENSION, JSAMPARRAY);
+  void (*h2v1_merged_upsample_565) (JDIMENSION, JSAMPIMAGE, JDIMENSION,
+                                    JSAMPARRAY, JLONG);
+  void (*fancy_merged_upsample_row[NUM_COLOR_SPACES]) (JDIMENSION, JSAMPARRAY,
+                                                       JSAMPROW, int);
+  void (*convsamp) (JSAMPARRAY, JDIMENSION, DCTELEM *);
+  void (*convsamp_float) (JSAMPARRAY, JDIMENSION, FAST_FLOAT *);
+  void (*fdct_islow) (DCTELEM *);
+  void (*fdct_ifast) (DCTELEM *);
+  void (*fdct_float) (FAST_FLOAT *);
+  void (*quantize) (JCOEFPTR, DCTELEM *, DCTELEM *);
+  void (*quantize_float) (JCOEFPTR, FAST_FLOAT *, FAST_FLOAT *);
+  void (*idct_2x2) (void *, JCOEFPTR, JSAMPARRAY, JDIMENSION);
+  void (*idct_4x4) (void *, JCOEFPTR, JSAMPARRAY, JDIMENSION);
+  void (*idct_scaled[DCTSIZE * 2 + 1]) (void *, JCOEFPTR, JSAMPARRAY,
+                                        JDIMENSION);
+  void (*idct_islow) (void *, JCOEFPTR, JSAMPARRAY, JDIMENSION);
+  void (*idct_ifast) (void *, JCOEFPTR, JSAMPARRAY, JDIMENSION);
+  void (*idct_float) (void *, JCOEFPTR, JSAMPARRAY, JDIMENSION);
+  void (*idct_islow_corner4) (void *, JCOEFPTR, JSAMPARRAY, JDIMENSION);
+  void (*idct_islow_blocks) (void *, JCOEFPTR, JSAMPARRAY, JDIMENSION,
+                             JDIMENSION);
+  JOCTET *(*huff_encode_one_block) (void *, JOCTET *, JCOEFPTR, int,
+                                    c_derived_tbl *, c_derived_tbl *);
+  void (*encode_mcu_AC_first_prepare) (const JCOEF *, const int *, int, int,
+                                       JCOEF *, size_t *);
+  int (*encode_mcu_AC_refine_prepare) (const JCOEF *, const int *, int, int,
+                                       JCOEF *, size_t *);
+} simd;
+
+static jthread_once_t simd_once = JTHREAD_ONCE_INIT;
+
+/* Fill one of the tables of color conversion functions.  The extended RGB
+ * color spaces each get their own function, and every other color space gets
+ * the one for JCS_RGB.
+ */
+#define SET_COLOR_FUNCTIONS(table, rgb, extrgb, extrgbx, extbgr, extbgrx, \
+                            extxbgr, extxrgb) do { \
+  int cs; \
+  for (cs = 0; cs < NUM_COLOR_SPACES; cs++) \
+    table[cs] = rgb; \
+  table[JCS_EXT_RGB] = extrgb; \
+  table[JCS_EXT_RGBX] = table[JCS_EXT_RGBA] = extrgbx; \
+  table[JCS_EXT_BGR] = extbgr; \
+  table[JCS_EXT_BGRX] = table[JCS_EXT_BGRA] = extbgrx; \
+  table[JCS_EXT_XBGR] = table[JCS_EXT_ABGR] = extxbgr; \
+  table[JCS_EXT_XRGB] = table[JCS_EXT_ARGB] = extxrgb; \
+} while (0)
+
+/*
+ * Check what SIMD accelerations are supported, keep only those in force_mask,
+ * and pick the function to use for each operation.  This is only ever called
+ * through jthread_once(), so the environment and the CPU are queried once per
+ * process.
  */
 LOCAL(void)
-init_simd(void)
+select_simd_functions_masked(unsigned int force_mask)
 {
+  unsigned int simd_support = jpeg_simd_cpu_support() & force_mask;
+  unsigned int simd_huffman = 1;
+  boolean use_avx512, use_avx2, use_sse2;
 #ifndef NO_GETENV
   char *env = NULL;
-#endif
-
-  if (simd_support != ~0U)
-    return;
-
-  simd_support = jpeg_simd_cpu_support();
 
-#ifndef NO_GETENV
   /* Force different settings through environment variables */
   env = getenv("JSIMD_FORCESSE2");
   if ((env != NULL) && (strcmp(env, "1") == 0))
     simd_support &= JSIMD_SSE2;
   env = getenv("JSIMD_FORCEAVX2");
   if ((env != NULL) && (strcmp(env, "1") == 0))
-    simd_support &= JSIMD_AVX2;
+    simd_support &= JSIMD_AVX2 | JSIMD_BMI2;
+  env = getenv("JSIMD_NOAVX512");
+  if ((env != NULL) && (strcmp(env, "1") == 0))
+    simd_support &= ~JSIMD_AVX512;
   env = getenv("JSIMD_FORCENONE");
   if ((env != NULL) && (strcmp(env, "1") == 0))
     simd_support = 0;
@@ -67,6 +188,425 @@ init_simd(void)
   if ((env != NULL) && (strcmp(env, "1") == 0))
     simd_huffman = 0;
 #endif
+
+  use_avx512 = (simd_support & JSIMD_AVX512) != 0;
+  use_avx2 = (simd_support & JSIMD_AVX2) != 0;
+  use_sse2 = (simd_support & JSIMD_SSE2) != 0;
+
+  /* Color conversion */
+  if (use_avx2 && IS_ALIGNED_AVX(jconst_rgb_ycc_convert_avx2))
+    SET_COLOR_FUNCTIONS(simd.rgb_ycc_convert,
+                        jsimd_rgb_ycc_convert_avx2,
+                        jsimd_extrgb_ycc_convert_avx2,
+                        jsimd_extrgbx_ycc_convert_avx2,
+                        jsimd_extbgr_ycc_convert_avx2,
+                        jsimd_extbgrx_ycc_convert_avx2,
+                        jsimd_extxbgr_ycc_convert_avx2,
+                        jsimd_extxrgb_ycc_convert_avx2);
+  else if (use_sse2 && IS_ALIGNED_SSE(jconst_rgb_ycc_convert_sse2))
+    SET_COLOR_FUNCTIONS(simd.rgb_ycc_convert,
+                        jsimd_rgb_ycc_convert_sse2,
+                        jsimd_extrgb_ycc_convert_sse2,
+                        jsimd_extrgbx_ycc_convert_sse2,
+                        jsimd_extbgr_ycc_convert_sse2,
+                        jsimd_extbgrx_ycc_convert_sse2,
+                        jsimd_extxbgr_ycc_convert_sse2,
+                        jsimd_extxrgb_ycc_convert_sse2);
+
+  if (use_avx2 && IS_ALIGNED_AVX(jconst_rgb_gray_convert_avx2))
+    SET_COLOR_FUNCTIONS(simd.rgb_gray_convert,
+                        jsimd_rgb_gray_convert_avx2,
+                        jsimd_extrgb_gray_convert_avx2,
+                        jsimd_extrgbx_gray_convert_avx2,
+                        jsimd_extbgr_gray_convert_avx2,
+                        jsimd_extbgrx_gray_convert_avx2,
+                        jsimd_extxbgr_gray_convert_avx2,
+                        jsimd_extxrgb_gray_convert_avx2);
+  else if (use_sse2 && IS_ALIGNED_SSE(jconst_rgb_gray_convert_sse2))
+    SET_COLOR_FUNCTIONS(simd.rgb_gray_convert,
+                        jsimd_rgb_gray_convert_sse2,
+                        jsimd_extrgb_gray_convert_sse2,
+                        jsimd_extrgbx_gray_convert_sse2,
+                        jsimd_extbgr_gray_convert_sse2,
+                        jsimd_extbgrx_gray_convert_sse2,
+                        jsimd_extxbgr_gray_convert_sse2,
+                        jsimd_extxrgb_gray_convert_sse2);
+
+  if (use_avx512 && IS_ALIGNED_AVX512(jconst_ycc_rgb_convert_avx512))
+    SET_COLOR_FUNCTIONS(simd.ycc_rgb_convert,
+                        jsimd_ycc_rgb_convert_avx512,
+                        jsimd_ycc_extrgb_convert_avx512,
+                        jsimd_ycc_extrgbx_convert_avx512,
+                        jsimd_ycc_extbgr_convert_avx512,
+                        jsimd_ycc_extbgrx_convert_avx512,
+                        jsimd_ycc_extxbgr_convert_avx512,
+                        jsimd_ycc_extxrgb_convert_avx512);
+  else if (use_avx2 && IS_ALIGNED_AVX(jconst_ycc_rgb_convert_avx2))
+    SET_COLOR_FUNCTIONS(simd.ycc_rgb_convert,
+                        jsimd_ycc_rgb_convert_avx2,
+                        jsimd_ycc_extrgb_convert_avx2,
+                        jsimd_ycc_extrgbx_convert_avx2,
+                        jsimd_ycc_extbgr_convert_avx2,
+                        jsimd_ycc_extbgrx_convert_avx2,
+                        jsimd_ycc_extxbgr_convert_avx2,
+                        jsimd_ycc_extxrgb_convert_avx2);
+  else if (use_sse2 && IS_ALIGNED_SSE(jconst_ycc_rgb_convert_sse2))
+    SET_COLOR_FUNCTIONS(simd.ycc_rgb_convert,
+                        jsimd_ycc_rgb_convert_sse2,
+                        jsimd_ycc_extrgb_convert_sse2,
+                        jsimd_ycc_extrgbx_convert_sse2,
+                        jsimd_ycc_extbgr_convert_sse2,
+                        jsimd_ycc_extbgrx_convert_sse2,
+                        jsimd_ycc_extxbgr_convert_sse2,
+                        jsimd_ycc_extxrgb_convert_sse2);
+
+  if (use_avx2 && IS_ALIGNED_AVX(jconst_ycc_rgb_convert_avx2))
+    simd.ycc_rgb565_convert = jsimd_ycc_rgb565_convert_avx2;
+  else if (use_sse2 && IS_ALIGNED_SSE(jconst_ycc_rgb_convert_sse2))
+    simd.ycc_rgb565_convert = jsimd_ycc_rgb565_convert_sse2;
+
+  if (use_avx2 && IS_ALIGNED_AVX(jconst_rgb_ycc_convert_avx2))
+    simd.cmyk_ycck_convert = jsimd_cmyk_ycck_convert_avx2;
+  else if (use_sse2 && IS_ALIGNED_SSE(jconst_rgb_ycc_convert_sse2))
+    simd.cmyk_ycck_convert = jsimd_cmyk_ycck_convert_sse2;
+
+  if (use_avx2 && IS_ALIGNED_AVX(jconst_cmyk_rgb_convert_avx2)) {
+    simd.ycck_cmyk_convert = jsimd_ycck_cmyk_convert_avx2;
+    SET_COLOR_FUNCTIONS(simd.cmyk_rgb_convert,
+                        jsimd_cmyk_rgb_convert_avx2,
+                        jsimd_cmyk_extrgb_convert_avx2,
+                        jsimd_cmyk_extrgbx_convert_avx2,
+                        jsimd_cmyk_extbgr_convert_avx2,
+                        jsimd_cmyk_extbgrx_convert_avx2,
+                        jsimd_cmyk_extxbgr_convert_avx2,
+                        jsimd_cmyk_extxrgb_convert_avx2);
+    SET_COLOR_FUNCTIONS(simd.ycck_rgb_convert,
+                        jsimd_ycck_rgb_convert_avx2,
+                        jsimd_ycck_extrgb_convert_avx2,
+                        jsimd_ycck_extrgbx_convert_avx2,
+                        jsimd_ycck_extbgr_convert_avx2,
+                        jsimd_ycck_extbgrx_convert_avx2,
+                        jsimd_ycck_extxbgr_convert_avx2,
+                        jsimd_ycck_extxrgb_convert_avx2);
+  } else if (use_sse2 && IS_ALIGNED_SSE(jconst_cmyk_rgb_convert_sse2)) {
+    simd.ycck_cmyk_convert = jsimd_ycck_cmyk_convert_sse2;
+    SET_COLOR_FUNCTIONS(simd.cmyk_rgb_convert,
+                        jsimd_cmyk_rgb_convert_sse2,
+                        jsimd_cmyk_extrgb_convert_sse2,
+                        jsimd_cmyk_extrgbx_convert_sse2,
+                        jsimd_cmyk_extbgr_convert_sse2,
+                        jsimd_cmyk_extbgrx_convert_sse2,
+                        jsimd_cmyk_extxbgr_convert_sse2,
+                        jsimd_cmyk_extxrgb_convert_sse2);
+    SET_COLOR_FUNCTIONS(simd.ycck_rgb_convert,
+                        jsimd_ycck_rgb_convert_sse2,
+                        jsimd_ycck_extrgb_convert_sse2,
+                        jsimd_ycck_extrgbx_convert_sse2,
+                        jsimd_ycck_extbgr_convert_sse2,
+                        jsimd_ycck_extbgrx_convert_sse2,
+                        jsimd_ycck_extxbgr_convert_sse2,
+                        jsimd_ycck_extxrgb_convert_sse2);
+  }
+
+  /* The RGB->RGB and grayscale->RGB converters only move bytes around and
+   * build their masks in registers, so unlike the others, they have no
+   * constant table whose alignment needs to be checked.
+   */
+  if (use_avx2) {
+    SET_COLOR_FUNCTIONS(simd.c_rgb_rgb_convert,
+                        jsimd_c_rgb_rgb_convert_avx2,
+                        jsimd_c_extrgb_rgb_convert_avx2,
+                        jsimd_c_extrgbx_rgb_convert_avx2,
+                        jsimd_c_extbgr_rgb_convert_avx2,
+                        jsimd_c_extbgrx_rgb_convert_avx2,
+                        jsimd_c_extxbgr_rgb_convert_avx2,
+                        jsimd_c_extxrgb_rgb_convert_avx2);
+    SET_COLOR_FUNCTIONS(simd.gray_rgb_convert,
+                        jsimd_gray_rgb_convert_avx2,
+                        jsimd_gray_extrgb_convert_avx2,
+                        jsimd_gray_extrgbx_convert_avx2,
+                        jsimd_gray_extbgr_convert_avx2,
+                        jsimd_gray_extbgrx_convert_avx2,
+                        jsimd_gray_extxbgr_convert_avx2,
+                        jsimd_gray_extxrgb_convert_avx2);
+    SET_COLOR_FUNCTIONS(simd.rgb_rgb_convert,
+                        jsimd_rgb_rgb_convert_avx2,
+                        jsimd_rgb_extrgb_convert_avx2,
+                        jsimd_rgb_extrgbx_convert_avx2,
+                        jsimd_rgb_extbgr_convert_avx2,
+                        jsimd_rgb_extbgrx_convert_avx2,
+                        jsimd_rgb_extxbgr_convert_avx2,
+                        jsimd_rgb_extxrgb_convert_avx2);
+  } else if (use_sse2) {
+    SET_COLOR_FUNCTIONS(simd.c_rgb_rgb_convert,
+                        jsimd_c_rgb_rgb_convert_sse2,
+                        jsimd_c_extrgb_rgb_convert_sse2,
+                        jsimd_c_extrgbx_rgb_convert_sse2,
+                        jsimd_c_extbgr_rgb_convert_sse2,
+                        jsimd_c_extbgrx_rgb_convert_sse2,
+                        jsimd_c_extxbgr_rgb_convert_sse2,
+                        jsimd_c_extxrgb_rgb_convert_sse2);
+    SET_COLOR_FUNCTIONS(simd.gray_rgb_convert,
+                        jsimd_gray_rgb_convert_sse2,
+                        jsimd_gray_extrgb_convert_sse2,
+                        jsimd_gray_extrgbx_convert_sse2,
+                        jsimd_gray_extbgr_convert_sse2,
+                        jsimd_gray_extbgrx_convert_sse2,
+                        jsimd_gray_extxbgr_convert_sse2,
+                        jsimd_gray_extxrgb_convert_sse2);
+    SET_COLOR_FUNCTIONS(simd.rgb_rgb_convert,
+                        jsimd_rgb_rgb_convert_sse2,
+                        jsimd_rgb_extrgb_convert_sse2,
+                        jsimd_rgb_extrgbx_convert_sse2,
+                        jsimd_rgb_extbgr_convert_sse2,
+                        jsimd_rgb_extbgrx_convert_sse2,
+                        jsimd_rgb_extxbgr_convert_sse2,
+                        jsimd_rgb_extxrgb_convert_sse2);
+  }
+
+  /* Downsampling and upsampling */
+  if (use_avx2) {
+    simd.h2v2_downsample = jsimd_h2v2_downsample_avx2;
+    simd.h2v1_downsample = jsimd_h2v1_downsample_avx2;
+    simd.h2v2_smooth_downsample = jsimd_h2v2_smooth_downsample_avx2;
+    simd.fullsize_smooth_downsample = jsimd_fullsize_smooth_downsample_avx2;
+    simd.h2v2_upsample = jsimd_h2v2_upsample_avx2;
+    simd.h2v1_upsample = jsimd_h2v1_upsample_avx2;
+  } else if (use_sse2) {
+    simd.h2v2_downsample = jsimd_h2v2_downsample_sse2;
+    simd.h2v1_downsample = jsimd_h2v1_downsample_sse2;
+    simd.h2v2_smooth_downsample = jsimd_h2v2_smooth_downsample_sse2;
+    simd.fullsize_smooth_downsample = jsimd_fullsize_smooth_downsample_sse2;
+    simd.h2v2_upsample = jsimd_h2v2_upsample_sse2;
+    simd.h2v1_upsample = jsimd_h2v1_upsample_sse2;
+  }
+  if (use_sse2) {
+    simd.h4v1_downsample = jsimd_h4v1_downsample_sse2;
+    simd.h4v2_downsample = jsimd_h4v2_downsample_sse2;
+    simd.h1v2_downsample = jsimd_h1v2_downsample_sse2;
+    simd.h2v4_downsample = jsimd_h2v4_downsample_sse2;
+    simd.h4v1_upsample = jsimd_h4v1_upsample_sse2;
+    simd.h4v2_upsample = jsimd_h4v2_upsample_sse2;
+    simd.h1v2_upsample = jsimd_h1v2_upsample_sse2;
+    simd.h2v4_upsample = jsimd_h2v4_upsample_sse2;
+  }
+
+  if (use_avx2 && IS_ALIGNED_AVX(jconst_fancy_upsample_avx2)) {
+    simd.h2v2_fancy_upsample = jsimd_h2v2_fancy_upsample_avx2;
+    simd.h2v1_fancy_upsample = jsimd_h2v1_fancy_upsample_avx2;
+    simd.h1v2_fancy_upsample = jsimd_h1v2_fancy_upsample_avx2;
+  } else if (use_sse2 && IS_ALIGNED_SSE(jconst_fancy_upsample_sse2)) {
+    simd.h2v2_fancy_upsample = jsimd_h2v2_fancy_upsample_sse2;
+    simd.h2v1_fancy_upsample = jsimd_h2v1_fancy_upsample_sse2;
+    simd.h1v2_fancy_upsample = jsimd_h1v2_fancy_upsample_sse2;
+  }
+  if (use_avx512 && simd.h2v2_fancy_upsample != NULL &&
+      IS_ALIGNED_AVX512(jconst_fancy_upsample_avx512))
+    simd.h2v2_fancy_upsample = jsimd_h2v2_fancy_upsample_avx512;
+
+  if (use_avx512 && IS_ALIGNED_AVX512(jconst_merged_upsample_avx512)) {
+    SET_COLOR_FUNCTIONS(simd.h2v2_merged_upsample,
+                        jsimd_h2v2_merged_upsample_avx512,
+                        jsimd_h2v2_extrgb_merged_upsample_avx512,
+                        jsimd_h2v2_extrgbx_merged_upsample_avx512,
+                        jsimd_h2v2_extbgr_merged_upsample_avx512,
+                        jsimd_h2v2_extbgrx_merged_upsample_avx512,
+                        jsimd_h2v2_extxbgr_merged_upsample_avx512,
+                        jsimd_h2v2_extxrgb_merged_upsample_avx512);
+    SET_COLOR_FUNCTIONS(simd.h2v1_merged_upsample,
+                        jsimd_h2v1_merged_upsample_avx512,
+                        jsimd_h2v1_extrgb_merged_upsample_avx512,
+                        jsimd_h2v1_extrgbx_merged_upsample_avx512,
+                        jsimd_h2v1_extbgr_merged_upsample_avx512,
+                        jsimd_h2v1_extbgrx_merged_upsample_avx512,
+                        jsimd_h2v1_extxbgr_merged_upsample_avx512,
+                        jsimd_h2v1_extxrgb_merged_upsample_avx512);
+  } else if (use_avx2 && IS_ALIGNED_AVX(jconst_merged_upsample_avx2)) {
+    SET_COLOR_FUNCTIONS(simd.h2v2_merged_upsample,
+                        jsimd_h2v2_merged_upsample_avx2,
+                        jsimd_h2v2_extrgb_merged_upsample_avx2,
+                        jsimd_h2v2_extrgbx_merged_upsample_avx2,
+                        jsimd_h2v2_extbgr_merged_upsample_avx2,
+                        jsimd_h2v2_extbgrx_merged_upsample_avx2,
+                        jsimd_h2v2_extxbgr_merged_upsample_avx2,
+                        jsimd_h2v2_extxrgb_merged_upsample_avx2);
+    SET_COLOR_FUNCTIONS(simd.h2v1_merged_upsample,
+                        jsimd_h2v1_merged_upsample_avx2,
+                        jsimd_h2v1_extrgb_merged_upsample_avx2,
+                        jsimd_h2v1_extrgbx_merged_upsample_avx2,
+                        jsimd_h2v1_extbgr_merged_upsample_avx2,
+                        jsimd_h2v1_extbgrx_merged_upsample_avx2,
+                        jsimd_h2v1_extxbgr_merged_upsample_avx2,
+                        jsimd_h2v1_extxrgb_merged_upsample_avx2);
+  } else if (use_sse2 && IS_ALIGNED_SSE(jconst_merged_upsample_sse2)) {
+    SET_COLOR_FUNCTIONS(simd.h2v2_merged_upsample,
+                        jsimd_h2v2_merged_upsample_sse2,
+                        jsimd_h2v2_extrgb_merged_upsample_sse2,
+                        jsimd_h2v2_extrgbx_merged_upsample_sse2,
+                        jsimd_h2v2_extbgr_merged_upsample_sse2,
+                        jsimd_h2v2_extbgrx_merged_upsample_sse2,
+                        jsimd_h2v2_extxbgr_merged_upsample_sse2,
+                        jsimd_h2v2_extxrgb_merged_upsample_sse2);
+    SET_COLOR_FUNCTIONS(simd.h2v1_merged_upsample,
+                        jsimd_h2v1_merged_upsample_sse2,
+                        jsimd_h2v1_extrgb_merged_upsample_sse2,
+                        jsimd_h2v1_extrgbx_merged_upsample_sse2,
+                        jsimd_h2v1_extbgr_merged_upsample_sse2,
+                        jsimd_h2v1_extbgrx_merged_upsample_sse2,
+                        jsimd_h2v1_extxbgr_merged_upsample_sse2,
+                        jsimd_h2v1_extxrgb_merged_upsample_sse2);
+  }
+
+  if (use_avx2 && IS_ALIGNED_AVX(jconst_merged_upsample_avx2))
+    simd.h2v1_merged_upsample_565 = jsimd_h2v1_merged_upsample_565_avx2;
+  else if (use_sse2 && IS_ALIGNED_SSE(jconst_merged_upsample_sse2))
+    simd.h2v1_merged_upsample_565 = jsimd_h2v1_merged_upsample_565_sse2;
+
+  if (use_avx2 && IS_ALIGNED_AVX(jconst_merged_upsample_avx2))
+    SET_COLOR_FUNCTIONS(simd.fancy_merged_upsample_row,
+                        jsimd_fancy_merged_upsample_row_avx2,
+                        jsimd_extrgb_fancy_merged_upsample_row_avx2,
+                        jsimd_extrgbx_fancy_merged_upsample_row_avx2,
+                        jsimd_extbgr_fancy_merged_upsample_row_avx2,
+                        jsimd_extbgrx_fancy_merged_upsample_row_avx2,
+                        jsimd_extxbgr_fancy_merged_upsample_row_avx2,
+                        jsimd_extxrgb_fancy_merged_upsample_row_avx2);
+  else if (use_sse2 && IS_ALIGNED_SSE(jconst_merged_upsample_sse2))
+    SET_COLOR_FUNCTIONS(simd.fancy_merged_upsample_row,
+                        jsimd_fancy_merged_upsample_row_sse2,
+                        jsimd_extrgb_fancy_merged_upsample_row_sse2,
+                        jsimd_extrgbx_fancy_merged_upsample_row_sse2,
+                        jsimd_extbgr_fancy_merged_upsample_row_sse2,
+                        jsimd_extbgrx_fancy_merged_upsample_row_sse2,
+                        jsimd_extxbgr_fancy_merged_upsample_row_sse2,
+                        jsimd_extxrgb_fancy_merged_upsample_row_sse2);
+
+  /* Sample conversion, forward DCT and quantization */
+  if (use_avx2) {
+    simd.convsamp = jsimd_convsamp_avx2;
+    simd.quantize = jsimd_quantize_avx2;
+  } else if (use_sse2) {
+    simd.convsamp = jsimd_convsamp_sse2;
+    simd.quantize = jsimd_quantize_sse2;
+  }
+  if (use_sse2) {
+    simd.convsamp_float = jsimd_convsamp_float_sse2;
+    simd.quantize_float = jsimd_quantize_float_sse2;
+  }
+
+  if (use_avx2 && IS_ALIGNED_AVX(jconst_fdct_islow_avx2))
+    simd.fdct_islow = jsimd_fdct_islow_avx2;
+  else if (use_sse2 && IS_ALIGNED_SSE(jconst_fdct_islow_sse2))
+    simd.fdct_islow = jsimd_fdct_islow_sse2;
+  if (use_avx2 && IS_ALIGNED_AVX(jconst_fdct_ifast_avx2))
+    simd.fdct_ifast = jsimd_fdct_ifast_avx2;
+  else if (use_sse2 && IS_ALIGNED_SSE(jconst_fdct_ifast_sse2))
+    simd.fdct_ifast = jsimd_fdct_ifast_sse2;
+  if (use_avx2 && IS_ALIGNED_AVX(jconst_fdct_float_avx2))
+    simd.fdct_float = jsimd_fdct_float_avx2;
+  else if ((simd_support & JSIMD_SSE) &&
+           IS_ALIGNED_SSE(jconst_fdct_float_sse))
+    simd.fdct_float = jsimd_fdct_float_sse;
+
+  /* Inverse DCT */
+  if (use_sse2 && IS_ALIGNED_SSE(jconst_idct_red_sse2)) {
+    simd.idct_2x2 = jsimd_idct_2x2_sse2;
+    simd.idct_4x4 = jsimd_idct_4x4_sse2;
+  }
+  /* The AVX2 3x3 IDCT has too little work to fill 256-bit registers and is
+   * slower than the SSE2 one.
+   */
+  if (use_sse2 && IS_ALIGNED_SSE(jconst_idct_scaled_sse2)) {
+    simd.idct_scaled[3] = jsimd_idct_3x3_sse2;
+    simd.idct_scaled[5] = jsimd_idct_5x5_sse2;
+    simd.idct_scaled[6] = jsimd_idct_6x6_sse2;
+    simd.idct_scaled[7] = jsimd_idct_7x7_sse2;
+    simd.idct_scaled[9] = jsimd_idct_9x9_sse2;
+    simd.idct_scaled[10] = jsimd_idct_10x10_sse2;
+    simd.idct_scaled[11] = jsimd_idct_11x11_sse2;
+    simd.idct_scaled[12] = jsimd_idct_12x12_sse2;
+    simd.idct_scaled[13] = jsimd_idct_13x13_sse2;
+    simd.idct_scaled[14] = jsimd_idct_14x14_sse2;
+    simd.idct_scaled[15] = jsimd_idct_15x15_sse2;
+    simd.idct_scaled[16] = jsimd_idct_16x16_sse2;
+  }
+  if (use_avx2 && IS_ALIGNED_AVX(jconst_idct_scaled_avx2)) {
+    simd.idct_scaled[5] = jsimd_idct_5x5_avx2;
+    simd.idct_scaled[6] = jsimd_idct_6x6_avx2;
+    simd.idct_scaled[7] = jsimd_idct_7x7_avx2;
+    simd.idct_scaled[9] = jsimd_idct_9x9_avx2;
+    simd.idct_scaled[10] = jsimd_idct_10x10_avx2;
+    simd.idct_scaled[11] = jsimd_idct_11x11_avx2;
+    simd.idct_scaled[12] = jsimd_idct_12x12_avx2;
+    simd.idct_scaled[13] = jsimd_idct_13x13_avx2;
+    simd.idct_scaled[14] = jsimd_idct_14x14_avx2;
+    simd.idct_scaled[15] = jsimd_idct_15x15_avx2;
+    simd.idct_scaled[16] = jsimd_idct_16x16_avx2;
+  }
+  if (use_avx2 && IS_ALIGNED_AVX(jconst_idct_islow_avx2))
+    simd.idct_islow = jsimd_idct_islow_avx2;
+  else if (use_sse2 && IS_ALIGNED_SSE(jconst_idct_islow_sse2))
+    simd.idct_islow = jsimd_idct_islow_sse2;
+  if (use_avx2 && IS_ALIGNED_AVX(jconst_idct_ifast_avx2))
+    simd.idct_ifast = jsimd_idct_ifast_avx2;
+  else if (use_sse2 && IS_ALIGNED_SSE(jconst_idct_ifast_sse2))
+    simd.idct_ifast = jsimd_idct_ifast_sse2;
+  if (use_avx2 && IS_ALIGNED_AVX(jconst_idct_float_avx2))
+    simd.idct_float = jsimd_idct_float_avx2;
+  else if (use_sse2 && IS_ALIGNED_SSE(jconst_idct_float_sse2))
+    simd.idct_float = jsimd_idct_float_sse2;
+  if (use_sse2 && IS_ALIGNED_SSE(jconst_idct_islow_sse2))
+    simd.idct_islow_corner4 = jsimd_idct_islow_corner4_sse2;
+  /* The AVX-512 IDCT transforms pairs of blocks, and a run of blocks with
+   * odd length ends with one for the single-block IDCT.
+   */
+  if (use_avx512 && simd.idct_islow != NULL &&
+      IS_ALIGNED_AVX512(jconst_idct_islow_avx512))
+    simd.idct_islow_blocks = jsimd_idct_islow_avx512;
+
+  /* Entropy encoding */
+  if (simd_huffman) {
+    if (use_avx2 && (simd_support & JSIMD_BMI2) &&
+        IS_ALIGNED_AVX(jconst_huff_encode_one_block_avx2))
+      simd.huff_encode_one_block = jsimd_huff_encode_one_block_avx2;
+    else if (use_sse2 && IS_ALIGNED_SSE(jconst_huff_encode_one_block))
+      simd.huff_encode_one_block = jsimd_huff_encode_one_block_sse2;
+  }
+  if (use_sse2) {
+    simd.encode_mcu_AC_first_prepare = jsimd_encode_mcu_AC_first_prepare_sse2;
+    simd.encode_mcu_AC_refine_prepare =
+      jsimd_encode_mcu_AC_refine_prepare_sse2;
+  }
+}
+
+LOCAL(void)
+select_simd_functions(void)
+{
+  select_simd_functions_masked(~0U);
+}
+
+LOCAL(void)
+select_simd_functions_forcesse2(void)
+{
+  select_simd_functions_masked(JSIMD_SSE2);
+}
+
+LOCAL(void)
+init_simd(void)
+{
+  jthread_once(&simd_once, select_simd_functions);
+}
+
+/*
+ * Whichever of these calls reaches jthread_once() first determines the
+ * function table for the rest of the process.  Every x86-64 CPU has SSE2, so
+ * only JSIMD_FORCESSE2 has an effect here.
+ */
+GLOBAL(void)
+jsimd_force(int level)
+{
+  if (level == JSIMD_FORCESSE2)
+    jthread_once(&simd_once, select_simd_functions_forcesse2);
 }
 
 GLOBAL(int)
@@ -82,18 +622,452 @@ jsimd_can_rgb_ycc(void)
   if ((RGB_PIXELSIZE != 3) && (RGB_PIXELSIZE != 4))
     return 0;
 
-  if ((simd_support & JSIMD_AVX2) &&
-      IS_ALIGNED_AVX(jconst_rgb_ycc_convert_avx2))
-    return 1;
-  if ((simd_support & JSIMD_SSE2) &&
-      IS_ALIGNED_SSE(jconst_rgb_ycc_convert_sse2))
-    return 1;
+  return simd.rgb_ycc_convert[JCS_RGB] != NULL;
+}
+
+GLOBAL(int)
+jsimd_can_rgb_gray(void)
+{
+  init_simd();
+
+  /* The code is optimised for these values only */
+  if (BITS_IN_JSAMPLE != 8)
+    return 0;
+  if (sizeof(JDIMENSION) != 4)
+    return 0;
+  if ((RGB_PIXELSIZE != 3) && (RGB_PIXELSIZE != 4))
+    return 0;
+
+  return simd.rgb_gray_convert[JCS_RGB] != NULL;
+}
+
+GLOBAL(int)
+jsimd_can_ycc_rgb(void)
+{
+  init_simd();
+
+  /* The code is optimised for these values only */
+  if (BITS_IN_JSAMPLE != 8)
+    return 0;
+  if (sizeof(JDIMENSION) != 4)
+    return 0;
+  if ((RGB_PIXELSIZE != 3) && (RGB_PIXELSIZE != 4))
+    return 0;
+
+  return simd.ycc_rgb_convert[JCS_RGB] != NULL;
+}
+
+GLOBAL(int)
+jsimd_can_ycc_rgb565(void)
+{
+  init_simd();
+
+  /* The code is optimised for these values only */
+  if (BITS_IN_JSAMPLE != 8)
+    return 0;
+  if (sizeof(JDIMENSION) != 4)
+    return 0;
+
+  return simd.ycc_rgb565_convert != NULL;
+}
+
+GLOBAL(int)
+jsimd_can_ycc_rgb565D(void)
+{
+  init_simd();
+
+  /* The code is optimised for these values only */
+  if (BITS_IN_JSAMPLE != 8)
+    return 0;
+  if (sizeof(JDIMENSION) != 4)
+    return 0;
+
+  return simd.ycc_rgb565_convert != NULL;
+}
+
+GLOBAL(int)
+jsimd_can_cmyk_ycck(void)
+{
+  init_simd();
+
+  /* The code is optimised for these values only */
+  if (BITS_IN_JSAMPLE != 8)
+    return 0;
+  if (sizeof(JDIMENSION) != 4)
+    return 0;
+
+  return simd.cmyk_ycck_convert != NULL;
+}
+
+GLOBAL(int)
+jsimd_can_ycck_cmyk(void)
+{
+  init_simd();
+
+  /* The code is optimised for these values only */
+  if (BITS_IN_JSAMPLE != 8)
+    return 0;
+  if (sizeof(JDIMENSION) != 4)
+    return 0;
+
+  return simd.ycck_cmyk_convert != NULL;
+}
+
+GLOBAL(int)
+jsimd_can_cmyk_rgb(void)
+{
+  init_simd();
+
+  /* The code is optimised for these values only */
+  if (BITS_IN_JSAMPLE != 8)
+    return 0;
+  if (sizeof(JDIMENSION) != 4)
+    return 0;
+  if ((RGB_PIXELSIZE != 3) && (RGB_PIXELSIZE != 4))
+    return 0;
+
+  return simd.cmyk_rgb_convert[JCS_RGB] != NULL;
+}
+
+GLOBAL(int)
+jsimd_can_ycck_rgb(void)
+{
+  init_simd();
+
+  /* The code is optimised for these values only */
+  if (BITS_IN_JSAMPLE != 8)
+    return 0;
+  if (sizeof(JDIMENSION) != 4)
+    return 0;
+  if ((RGB_PIXELSIZE != 3) && (RGB_PIXELSIZE != 4))
+    return 0;
+
+  return simd.ycck_rgb_convert[JCS_RGB] != NULL;
+}
+
+GLOBAL(int)
+jsimd_c_can_rgb_rgb(void)
+{
+  init_simd();
+
+  /* The code is optimised for these values only */
+  if (BITS_IN_JSAMPLE != 8)
+    return 0;
+  if (sizeof(JDIMENSION) != 4)
+    return 0;
+  if ((RGB_PIXELSIZE != 3) && (RGB_PIXELSIZE != 4))
+    return 0;
+
+  return simd.c_rgb_rgb_convert[JCS_RGB] != NULL;
+}
+
+GLOBAL(int)
+jsimd_can_gray_rgb(void)
+{
+  init_simd();
+
+  /* The code is optimised for these values only */
+  if (BITS_IN_JSAMPLE != 8)
+    return 0;
+  if (sizeof(JDIMENSION) != 4)
+    return 0;
+  if ((RGB_PIXELSIZE != 3) && (RGB_PIXELSIZE != 4))
+    return 0;
+
+  return simd.gray_rgb_convert[JCS_RGB] != NULL;
+}
+
+GLOBAL(int)
+jsimd_can_rgb_rgb(void)
+{
+  init_simd();
+
+  /* The code is optimised for these values only */
+  if (BITS_IN_JSAMPLE != 8)
+    return 0;
+  if (sizeof(JDIMENSION) != 4)
+    return 0;
+  if ((RGB_PIXELSIZE != 3) && (RGB_PIXELSIZE != 4))
+    return 0;
+
+  return simd.rgb_rgb_convert[JCS_RGB] != NULL;
+}
+
+GLOBAL(void)
+jsimd_rgb_ycc_convert(j_compress_ptr cinfo, JSAMPARRAY input_buf,
+                      JSAMPIMAGE output_buf, JDIMENSION output_row,
+                      int num_rows)
+{
+  (*simd.rgb_ycc_convert[cinfo->in_color_space]) (cinfo->image_width,
+                                                  input_buf, output_buf,
+                                                  output_row, num_rows);
+}
+
+GLOBAL(void)
+jsimd_rgb_gray_convert(j_compress_ptr cinfo, JSAMPARRAY input_buf,
+                       JSAMPIMAGE output_buf, JDIMENSION output_row,
+                       int num_rows)
+{
+  (*simd.rgb_gray_convert[cinfo->in_color_space]) (cinfo->image_width,
+                                                   input_buf, output_buf,
+                                                   output_row, num_rows);
+}
+
+GLOBAL(void)
+jsimd_ycc_rgb_convert(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                      JDIMENSION input_row, JSAMPARRAY output_buf,
+                      int num_rows)
+{
+  (*simd.ycc_rgb_convert[cinfo->out_color_space]) (cinfo->output_width,
+                                                   input_buf, input_row,
+                                                   output_buf, num_rows);
+}
+
+GLOBAL(void)
+jsimd_cmyk_ycck_convert(j_compress_ptr cinfo, JSAMPARRAY input_buf,
+                        JSAMPIMAGE output_buf, JDIMENSION output_row,
+                        int num_rows)
+{
+  (*simd.cmyk_ycck_convert) (cinfo->image_width, input_buf, output_buf,
+                             output_row, num_rows);
+}
+
+GLOBAL(void)
+jsimd_ycck_cmyk_convert(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                        JDIMENSION input_row, JSAMPARRAY output_buf,
+                        int num_rows)
+{
+  (*simd.ycck_cmyk_convert) (cinfo->output_width, input_buf, input_row,
+                             output_buf, num_rows);
+}
+
+GLOBAL(void)
+jsimd_cmyk_rgb_convert(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                       JDIMENSION input_row, JSAMPARRAY output_buf,
+                       int num_rows)
+{
+  (*simd.cmyk_rgb_convert[cinfo->out_color_space]) (cinfo->output_width,
+                                                    input_buf, input_row,
+                                                    output_buf, num_rows);
+}
+
+GLOBAL(void)
+jsimd_ycck_rgb_convert(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                       JDIMENSION input_row, JSAMPARRAY output_buf,
+                       int num_rows)
+{
+  (*simd.ycck_rgb_convert[cinfo->out_color_space]) (cinfo->output_width,
+                                                    input_buf, input_row,
+                                                    output_buf, num_rows);
+}
+
+GLOBAL(void)
+jsimd_c_rgb_rgb_convert(j_compress_ptr cinfo, JSAMPARRAY input_buf,
+                        JSAMPIMAGE output_buf, JDIMENSION output_row,
+                        int num_rows)
+{
+  (*simd.c_rgb_rgb_convert[cinfo->in_color_space]) (cinfo->image_width,
+                                                    input_buf, output_buf,
+                                                    output_row, num_rows);
+}
+
+GLOBAL(void)
+jsimd_gray_rgb_convert(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                       JDIMENSION input_row, JSAMPARRAY output_buf,
+                       int num_rows)
+{
+  (*simd.gray_rgb_convert[cinfo->out_color_space]) (cinfo->output_width,
+                                                    input_buf, input_row,
+                                                    output_buf, num_rows);
+}
+
+GLOBAL(void)
+jsimd_rgb_rgb_convert(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                      JDIMENSION input_row, JSAMPARRAY output_buf,
+                      int num_rows)
+{
+  (*simd.rgb_rgb_convert[cinfo->out_color_space]) (cinfo->output_width,
+                                                   input_buf, input_row,
+                                                   output_buf, num_rows);
+}
+
+GLOBAL(void)
+jsimd_ycc_rgb565_convert(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                         JDIMENSION input_row, JSAMPARRAY output_buf,
+                         int num_rows)
+{
+  (*simd.ycc_rgb565_convert) (cinfo->output_width, input_buf, input_row,
+                              output_buf, num_rows, 0);
+}
+
+GLOBAL(void)
+jsimd_ycc_rgb565D_convert(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                          JDIMENSION input_row, JSAMPARRAY output_buf,
+                          int num_rows)
+{
+  JLONG d0 = dither_matrix[cinfo->output_scanline & DITHER_MASK];
+  JSAMPROW inptr[3], outptr;
+  JSAMPARRAY inrows[3];
+  JDIMENSION num_cols;
+
+  inrows[0] = &inptr[0];
+  inrows[1] = &inptr[1];
+  inrows[2] = &inptr[2];
+
+  /* Reproduce ycc_rgb565D_convert(), which carries the dither pattern from
+   * one row to the next and converts the first pixel of a row that is not
+   * 4-byte aligned without rotating it.
+   */
+  while (--num_rows >= 0) {
+    inptr[0] = input_buf[0][input_row];
+    inptr[1] = input_buf[1][input_row];
+    inptr[2] = input_buf[2][input_row];
+    input_row++;
+    outptr = *output_buf++;
+    num_cols = cinfo->output_width;
+    if (((size_t)outptr) & 3) {
+      (*simd.ycc_rgb565_convert) (1, inrows, 0, &outptr, 1, d0);
+      inptr[0]++;
+      inptr[1]++;
+      inptr[2]++;
+      outptr += 2;
+      num_cols--;
+    }
+    (*simd.ycc_rgb565_convert) (num_cols, inrows, 0, &outptr, 1, d0);
+    /* The pattern rotates by one byte per pixel of each pair of pixels. */
+    if (num_cols & 2)
+      d0 = ((d0 & 0xFFFF) << 16) | ((d0 >> 16) & 0xFFFF);
+  }
+}
+
+GLOBAL(int)
+jsimd_can_h2v2_downsample(void)
+{
+  init_simd();
+
+  /* The code is optimised for these values only */
+  if (BITS_IN_JSAMPLE != 8)
+    return 0;
+  if (sizeof(JDIMENSION) != 4)
+    return 0;
+
+  return simd.h2v2_downsample != NULL;
+}
+
+GLOBAL(int)
+jsimd_can_h2v1_downsample(void)
+{
+  init_simd();
+
+  /* The code is optimised for these values only */
+  if (BITS_IN_JSAMPLE != 8)
+    return 0;
+  if (sizeof(JDIMENSION) != 4)
+    return 0;
+
+  return simd.h2v1_downsample != NULL;
+}
+
+GLOBAL(void)
+jsimd_h2v2_downsample(j_compress_ptr cinfo, jpeg_component_info *compptr,
+                      JSAMPARRAY input_data, JSAMPARRAY output_data)
+{
+  (*simd.h2v2_downsample) (cinfo->image_width, cinfo->max_v_samp_factor,
+                           compptr->v_samp_factor, compptr->width_in_blocks,
+                           input_data, output_data);
+}
+
+GLOBAL(void)
+jsimd_h2v1_downsample(j_compress_ptr cinfo, jpeg_component_info *compptr,
+                      JSAMPARRAY input_data, JSAMPARRAY output_data)
+{
+  (*simd.h2v1_downsample) (cinfo->image_width, cinfo->max_v_samp_factor,
+                           compptr->v_samp_factor, compptr->width_in_blocks,
+                           input_data, output_data);
+}
+
+GLOBAL(int)
+jsimd_can_h2v2_smooth_downsample(void)
+{
+  init_simd();
+
+  /* The code is optimised for these values only */
+  if (BITS_IN_JSAMPLE != 8)
+    return 0;
+  if (sizeof(JDIMENSION) != 4)
+    return 0;
+
+  return simd.h2v2_smooth_downsample != NULL;
+}
+
+GLOBAL(int)
+jsimd_can_fullsize_smooth_downsample(void)
+{
+  init_simd();
+
+  /* The code is optimised for these values only */
+  if (BITS_IN_JSAMPLE != 8)
+    return 0;
+  if (sizeof(JDIMENSION) != 4)
+    return 0;
+
+  return simd.fullsize_smooth_downsample != NULL;
+}
+
+GLOBAL(void)
+jsimd_h2v2_smooth_downsample(j_compress_ptr cinfo,
+                             jpeg_component_info *compptr,
+                             JSAMPARRAY input_data, JSAMPARRAY output_data)
+{
+  (*simd.h2v2_smooth_downsample) (cinfo->image_width, compptr->v_samp_factor,
+                                  cinfo->smoothing_factor,
+                                  compptr->width_in_blocks, input_data,
+                                  output_data);
+}
+
+GLOBAL(void)
+jsimd_fullsize_smooth_downsample(j_compress_ptr cinfo,
+                                 jpeg_component_info *compptr,
+                                 JSAMPARRAY input_data,
+                                 JSAMPARRAY output_data)
+{
+  (*simd.fullsize_smooth_downsample) (cinfo->image_width,
+                                      compptr->v_samp_factor,
+                                      cinfo->smoothing_factor,
+                                      compptr->width_in_blocks, input_data,
+                                      output_data);
+}
+
+GLOBAL(int)
+jsimd_can_h4v1_downsample(void)
+{
+  init_simd();
+
+  /* The code is optimised for these values only */
+  if (BITS_IN_JSAMPLE != 8)
+    return 0;
+  if (sizeof(JDIMENSION) != 4)
+    return 0;
+
+  return simd.h4v1_downsample != NULL;
+}
+
+GLOBAL(int)
+jsimd_can_h4v2_downsample(void)
+{
+  init_simd();
+
+  /* The code is optimised for these values only */
+  if (BITS_IN_JSAMPLE != 8)
+    return 0;
+  if (sizeof(JDIMENSION) != 4)
+    return 0;
 
-  return 0;
+  return simd.h4v2_downsample != NULL;
 }
 
 GLOBAL(int)
-jsimd_can_rgb_gray(void)
+jsimd_can_h1v2_downsample(void)
 {
   init_simd();
 
@@ -102,21 +1076,12 @@ jsimd_can_rgb_gray(void)
     return 0;
   if (sizeof(JDIMENSION) != 4)
     return 0;
-  if ((RGB_PIXELSIZE != 3) && (RGB_PIXELSIZE != 4))
-    return 0;
-
-  if ((simd_support & JSIMD_AVX2) &&
-      IS_ALIGNED_AVX(jconst_rgb_gray_convert_avx2))
-    return 1;
-  if ((simd_support & JSIMD_SSE2) &&
-      IS_ALIGNED_SSE(jconst_rgb_gray_convert_sse2))
-    return 1;
 
-  return 0;
+  return simd.h1v2_downsample != NULL;
 }
 
 GLOBAL(int)
-jsimd_can_ycc_rgb(void)
+jsimd_can_h2v4_downsample(void)
 {
   init_simd();
 
@@ -125,181 +1090,48 @@ jsimd_can_ycc_rgb(void)
     return 0;
   if (sizeof(JDIMENSION) != 4)
     return 0;
-  if ((RGB_PIXELSIZE != 3) && (RGB_PIXELSIZE != 4))
-    return 0;
-
-  if ((simd_support & JSIMD_AVX2) &&
-      IS_ALIGNED_AVX(jconst_ycc_rgb_convert_avx2))
-    return 1;
-  if ((simd_support & JSIMD_SSE2) &&
-      IS_ALIGNED_SSE(jconst_ycc_rgb_convert_sse2))
-    return 1;
 
-  return 0;
-}
-
-GLOBAL(int)
-jsimd_can_ycc_rgb565(void)
-{
-  return 0;
+  return simd.h2v4_downsample != NULL;
 }
 
 GLOBAL(void)
-jsimd_rgb_ycc_convert(j_compress_ptr cinfo, JSAMPARRAY input_buf,
-                      JSAMPIMAGE output_buf, JDIMENSION output_row,
-                      int num_rows)
+jsimd_h4v1_downsample(j_compress_ptr cinfo, jpeg_component_info *compptr,
+                      JSAMPARRAY input_data, JSAMPARRAY output_data)
 {
-  void (*avx2fct) (JDIMENSION, JSAMPARRAY, JSAMPIMAGE, JDIMENSION, int);
-  void (*sse2fct) (JDIMENSION, JSAMPARRAY, JSAMPIMAGE, JDIMENSION, int);
-
-  switch (cinfo->in_color_space) {
-  case JCS_EXT_RGB:
-    avx2fct = jsimd_extrgb_ycc_convert_avx2;
-    sse2fct = jsimd_extrgb_ycc_convert_sse2;
-    break;
-  case JCS_EXT_RGBX:
-  case JCS_EXT_RGBA:
-    avx2fct = jsimd_extrgbx_ycc_convert_avx2;
-    sse2fct = jsimd_extrgbx_ycc_convert_sse2;
-    break;
-  case JCS_EXT_BGR:
-    avx2fct = jsimd_extbgr_ycc_convert_avx2;
-    sse2fct = jsimd_extbgr_ycc_convert_sse2;
-    break;
-  case JCS_EXT_BGRX:
-  case JCS_EXT_BGRA:
-    avx2fct = jsimd_extbgrx_ycc_convert_avx2;
-    sse2fct = jsimd_extbgrx_ycc_convert_sse2;
-    break;
-  case JCS_EXT_XBGR:
-  case JCS_EXT_ABGR:
-    avx2fct = jsimd_extxbgr_ycc_convert_avx2;
-    sse2fct = jsimd_extxbgr_ycc_convert_sse2;
-    break;
-  case JCS_EXT_XRGB:
-  case JCS_EXT_ARGB:
-    avx2fct = jsimd_extxrgb_ycc_convert_avx2;
-    sse2fct = jsimd_extxrgb_ycc_convert_sse2;
-    break;
-  default:
-    avx2fct = jsimd_rgb_ycc_convert_avx2;
-    sse2fct = jsimd_rgb_ycc_convert_sse2;
-    break;
-  }
-
-  if (simd_support & JSIMD_AVX2)
-    avx2fct(cinfo->image_width, input_buf, output_buf, output_row, num_rows);
-  else
-    sse2fct(cinfo->image_width, input_buf, output_buf, output_row, num_rows);
+  (*simd.h4v1_downsample) (cinfo->image_width, cinfo->max_v_samp_factor,
+                           compptr->v_samp_factor, compptr->width_in_blocks,
+                           input_data, output_data);
 }
 
 GLOBAL(void)
-jsimd_rgb_gray_convert(j_compress_ptr cinfo, JSAMPARRAY input_buf,
-                       JSAMPIMAGE output_buf, JDIMENSION output_row,
-                       int num_rows)
+jsimd_h4v2_downsample(j_compress_ptr cinfo, jpeg_component_info *compptr,
+                      JSAMPARRAY input_data, JSAMPARRAY output_data)
 {
-  void (*avx2fct) (JDIMENSION, JSAMPARRAY, JSAMPIMAGE, JDIMENSION, int);
-  void (*sse2fct) (JDIMENSION, JSAMPARRAY, JSAMPIMAGE, JDIMENSION, int);
-
-  switch (cinfo->in_color_space) {
-  case JCS_EXT_RGB:
-    avx2fct = jsimd_extrgb_gray_convert_avx2;
-    sse2fct = jsimd_extrgb_gray_convert_sse2;
-    break;
-  case JCS_EXT_RGBX:
-  case JCS_EXT_RGBA:
-    avx2fct = jsimd_extrgbx_gray_convert_avx2;
-    sse2fct = jsimd_extrgbx_gray_convert_sse2;
-    break;
-  case JCS_EXT_BGR:
-    avx2fct = jsimd_extbgr_gray_convert_avx2;
-    sse2fct = jsimd_extbgr_gray_convert_sse2;
-    break;
-  case JCS_EXT_BGRX:
-  case JCS_EXT_BGRA:
-    avx2fct = jsimd_extbgrx_gray_convert_avx2;
-    sse2fct = jsimd_extbgrx_gray_convert_sse2;
-    break;
-  case JCS_EXT_XBGR:
-  case JCS_EXT_ABGR:
-    avx2fct = jsimd_extxbgr_gray_convert_avx2;
-    sse2fct = jsimd_extxbgr_gray_convert_sse2;
-    break;
-  case JCS_EXT_XRGB:
-  case JCS_EXT_ARGB:
-    avx2fct = jsimd_extxrgb_gray_convert_avx2;
-    sse2fct = jsimd_extxrgb_gray_convert_sse2;
-    break;
-  default:
-    avx2fct = jsimd_rgb_gray_convert_avx2;
-    sse2fct = jsimd_rgb_gray_convert_sse2;
-    break;
-  }
-
-  if (simd_support & JSIMD_AVX2)
-    avx2fct(cinfo->image_width, input_buf, output_buf, output_row, num_rows);
-  else
-    sse2fct(cinfo->image_width, input_buf, output_buf, output_row, num_rows);
+  (*simd.h4v2_downsample) (cinfo->image_width, cinfo->max_v_samp_factor,
+                           compptr->v_samp_factor, compptr->width_in_blocks,
+                           input_data, output_data);
 }
 
 GLOBAL(void)
-jsimd_ycc_rgb_convert(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
-                      JDIMENSION input_row, JSAMPARRAY output_buf,
-                      int num_rows)
+jsimd_h1v2_downsample(j_compress_ptr cinfo, jpeg_component_info *compptr,
+                      JSAMPARRAY input_data, JSAMPARRAY output_data)
 {
-  void (*avx2fct) (JDIMENSION, JSAMPIMAGE, JDIMENSION, JSAMPARRAY, int);
-  void (*sse2fct) (JDIMENSION, JSAMPIMAGE, JDIMENSION, JSAMPARRAY, int);
-
-  switch (cinfo->out_color_space) {
-  case JCS_EXT_RGB:
-    avx2fct = jsimd_ycc_extrgb_convert_avx2;
-    sse2fct = jsimd_ycc_extrgb_convert_sse2;
-    break;
-  case JCS_EXT_RGBX:
-  case JCS_EXT_RGBA:
-    avx2fct = jsimd_ycc_extrgbx_convert_avx2;
-    sse2fct = jsimd_ycc_extrgbx_convert_sse2;
-    break;
-  case JCS_EXT_BGR:
-    avx2fct = jsimd_ycc_extbgr_convert_avx2;
-    sse2fct = jsimd_ycc_extbgr_convert_sse2;
-    break;
-  case JCS_EXT_BGRX:
-  case JCS_EXT_BGRA:
-    avx2fct = jsimd_ycc_extbgrx_convert_avx2;
-    sse2fct = jsimd_ycc_extbgrx_convert_sse2;
-    break;
-  case JCS_EXT_XBGR:
-  case JCS_EXT_ABGR:
-    avx2fct = jsimd_ycc_extxbgr_convert_avx2;
-    sse2fct = jsimd_ycc_extxbgr_convert_sse2;
-    break;
-  case JCS_EXT_XRGB:
-  case JCS_EXT_ARGB:
-    avx2fct = jsimd_ycc_extxrgb_convert_avx2;
-    sse2fct = jsimd_ycc_extxrgb_convert_sse2;
-    break;
-  default:
-    avx2fct = jsimd_ycc_rgb_convert_avx2;
-    sse2fct = jsimd_ycc_rgb_convert_sse2;
-    break;
-  }
-
-  if (simd_support & JSIMD_AVX2)
-    avx2fct(cinfo->output_width, input_buf, input_row, output_buf, num_rows);
-  else
-    sse2fct(cinfo->output_width, input_buf, input_row, output_buf, num_rows);
+  (*simd.h1v2_downsample) (cinfo->image_width, cinfo->max_v_samp_factor,
+                           compptr->v_samp_factor, compptr->width_in_blocks,
+                           input_data, output_data);
 }
 
 GLOBAL(void)
-jsimd_ycc_rgb565_convert(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
-                         JDIMENSION input_row, JSAMPARRAY output_buf,
-                         int num_rows)
+jsimd_h2v4_downsample(j_compress_ptr cinfo, jpeg_component_info *compptr,
+                      JSAMPARRAY input_data, JSAMPARRAY output_data)
 {
+  (*simd.h2v4_downsample) (cinfo->image_width, cinfo->max_v_samp_factor,
+                           compptr->v_samp_factor, compptr->width_in_blocks,
+                           input_data, output_data);
 }
 
 GLOBAL(int)
-jsimd_can_h2v2_downsample(void)
+jsimd_can_h2v2_upsample(void)
 {
   init_simd();
 
@@ -309,16 +1141,11 @@ jsimd_can_h2v2_downsample(void)
   if (sizeof(JDIMENSION) != 4)
     return 0;
 
-  if (simd_support & JSIMD_AVX2)
-    return 1;
-  if (simd_support & JSIMD_SSE2)
-    return 1;
-
-  return 0;
+  return simd.h2v2_upsample != NULL;
 }
 
 GLOBAL(int)
-jsimd_can_h2v1_downsample(void)
+jsimd_can_h2v1_upsample(void)
 {
   init_simd();
 
@@ -328,48 +1155,27 @@ jsimd_can_h2v1_downsample(void)
   if (sizeof(JDIMENSION) != 4)
     return 0;
 
-  if (simd_support & JSIMD_AVX2)
-    return 1;
-  if (simd_support & JSIMD_SSE2)
-    return 1;
-
-  return 0;
+  return simd.h2v1_upsample != NULL;
 }
 
 GLOBAL(void)
-jsimd_h2v2_downsample(j_compress_ptr cinfo, jpeg_component_info *compptr,
-                      JSAMPARRAY input_data, JSAMPARRAY output_data)
+jsimd_h2v2_upsample(j_decompress_ptr cinfo, jpeg_component_info *compptr,
+                    JSAMPARRAY input_data, JSAMPARRAY *output_data_ptr)
 {
-  if (simd_support & JSIMD_AVX2)
-    jsimd_h2v2_downsample_avx2(cinfo->image_width, cinfo->max_v_samp_factor,
-                               compptr->v_samp_factor,
-                               compptr->width_in_blocks, input_data,
-                               output_data);
-  else
-    jsimd_h2v2_downsample_sse2(cinfo->image_width, cinfo->max_v_samp_factor,
-                               compptr->v_samp_factor,
-                               compptr->width_in_blocks, input_data,
-                               output_data);
+  (*simd.h2v2_upsample) (cinfo->max_v_samp_factor, cinfo->output_width,
+                         input_data, output_data_ptr);
 }
 
 GLOBAL(void)
-jsimd_h2v1_downsample(j_compress_ptr cinfo, jpeg_component_info *compptr,
-                      JSAMPARRAY input_data, JSAMPARRAY output_data)
+jsimd_h2v1_upsample(j_decompress_ptr cinfo, jpeg_component_info *compptr,
+                    JSAMPARRAY input_data, JSAMPARRAY *output_data_ptr)
 {
-  if (simd_support & JSIMD_AVX2)
-    jsimd_h2v1_downsample_avx2(cinfo->image_width, cinfo->max_v_samp_factor,
-                               compptr->v_samp_factor,
-                               compptr->width_in_blocks, input_data,
-                               output_data);
-  else
-    jsimd_h2v1_downsample_sse2(cinfo->image_width, cinfo->max_v_samp_factor,
-                               compptr->v_samp_factor,
-                               compptr->width_in_blocks, input_data,
-                               output_data);
+  (*simd.h2v1_upsample) (cinfo->max_v_samp_factor, cinfo->output_width,
+                         input_data, output_data_ptr);
 }
 
 GLOBAL(int)
-jsimd_can_h2v2_upsample(void)
+jsimd_can_h4v1_upsample(void)
 {
   init_simd();
 
@@ -379,16 +1185,39 @@ jsimd_can_h2v2_upsample(void)
   if (sizeof(JDIMENSION) != 4)
     return 0;
 
-  if (simd_support & JSIMD_AVX2)
-    return 1;
-  if (simd_support & JSIMD_SSE2)
-    return 1;
+  return simd.h4v1_upsample != NULL;
+}
+
+GLOBAL(int)
+jsimd_can_h4v2_upsample(void)
+{
+  init_simd();
+
+  /* The code is optimised for these values only */
+  if (BITS_IN_JSAMPLE != 8)
+    return 0;
+  if (sizeof(JDIMENSION) != 4)
+    return 0;
 
-  return 0;
+  return simd.h4v2_upsample != NULL;
 }
 
 GLOBAL(int)
-jsimd_can_h2v1_upsample(void)
+jsimd_can_h1v2_upsample(void)
+{
+  init_simd();
+
+  /* The code is optimised for these values only */
+  if (BITS_IN_JSAMPLE != 8)
+    return 0;
+  if (sizeof(JDIMENSION) != 4)
+    return 0;
+
+  return simd.h1v2_upsample != NULL;
+}
+
+GLOBAL(int)
+jsimd_can_h2v4_upsample(void)
 {
   init_simd();
 
@@ -398,36 +1227,39 @@ jsimd_can_h2v1_upsample(void)
   if (sizeof(JDIMENSION) != 4)
     return 0;
 
-  if (simd_support & JSIMD_AVX2)
-    return 1;
-  if (simd_support & JSIMD_SSE2)
-    return 1;
+  return simd.h2v4_upsample != NULL;
+}
 
-  return 0;
+GLOBAL(void)
+jsimd_h4v1_upsample(j_decompress_ptr cinfo, jpeg_component_info *compptr,
+                    JSAMPARRAY input_data, JSAMPARRAY *output_data_ptr)
+{
+  (*simd.h4v1_upsample) (cinfo->max_v_samp_factor, cinfo->output_width,
+                         input_data, output_data_ptr);
 }
 
 GLOBAL(void)
-jsimd_h2v2_upsample(j_decompress_ptr cinfo, jpeg_component_info *compptr,
+jsimd_h4v2_upsample(j_decompress_ptr cinfo, jpeg_component_info *compptr,
                     JSAMPARRAY input_data, JSAMPARRAY *output_data_ptr)
 {
-  if (simd_support & JSIMD_AVX2)
-    jsimd_h2v2_upsample_avx2(cinfo->max_v_samp_factor, cinfo->output_width,
-                             input_data, output_data_ptr);
-  else
-    jsimd_h2v2_upsample_sse2(cinfo->max_v_samp_factor, cinfo->output_width,
-                             input_data, output_data_ptr);
+  (*simd.h4v2_upsample) (cinfo->max_v_samp_factor, cinfo->output_width,
+                         input_data, output_data_ptr);
 }
 
 GLOBAL(void)
-jsimd_h2v1_upsample(j_decompress_ptr cinfo, jpeg_component_info *compptr,
+jsimd_h1v2_upsample(j_decompress_ptr cinfo, jpeg_component_info *compptr,
                     JSAMPARRAY input_data, JSAMPARRAY *output_data_ptr)
 {
-  if (simd_support & JSIMD_AVX2)
-    jsimd_h2v1_upsample_avx2(cinfo->max_v_samp_factor, cinfo->output_width,
-                             input_data, output_data_ptr);
-  else
-    jsimd_h2v1_upsample_sse2(cinfo->max_v_samp_factor, cinfo->output_width,
-                             input_data, output_data_ptr);
+  (*simd.h1v2_upsample) (cinfo->max_v_samp_factor, cinfo->output_width,
+                         input_data, output_data_ptr);
+}
+
+GLOBAL(void)
+jsimd_h2v4_upsample(j_decompress_ptr cinfo, jpeg_component_info *compptr,
+                    JSAMPARRAY input_data, JSAMPARRAY *output_data_ptr)
+{
+  (*simd.h2v4_upsample) (cinfo->max_v_samp_factor, cinfo->output_width,
+                         input_data, output_data_ptr);
 }
 
 GLOBAL(int)
@@ -441,14 +1273,7 @@ jsimd_can_h2v2_fancy_upsample(void)
   if (sizeof(JDIMENSION) != 4)
     return 0;
 
-  if ((simd_support & JSIMD_AVX2) &&
-      IS_ALIGNED_AVX(jconst_fancy_upsample_avx2))
-    return 1;
-  if ((simd_support & JSIMD_SSE2) &&
-      IS_ALIGNED_SSE(jconst_fancy_upsample_sse2))
-    return 1;
-
-  return 0;
+  return simd.h2v2_fancy_upsample != NULL;
 }
 
 GLOBAL(int)
@@ -462,54 +1287,48 @@ jsimd_can_h2v1_fancy_upsample(void)
   if (sizeof(JDIMENSION) != 4)
     return 0;
 
-  if ((simd_support & JSIMD_AVX2) &&
-      IS_ALIGNED_AVX(jconst_fancy_upsample_avx2))
-    return 1;
-  if ((simd_support & JSIMD_SSE2) &&
-      IS_ALIGNED_SSE(jconst_fancy_upsample_sse2))
-    return 1;
-
-  return 0;
+  return simd.h2v1_fancy_upsample != NULL;
 }
 
 GLOBAL(int)
 jsimd_can_h1v2_fancy_upsample(void)
 {
-  return 0;
+  init_simd();
+
+  /* The code is optimised for these values only */
+  if (BITS_IN_JSAMPLE != 8)
+    return 0;
+  if (sizeof(JDIMENSION) != 4)
+    return 0;
+
+  return simd.h1v2_fancy_upsample != NULL;
 }
 
 GLOBAL(void)
 jsimd_h2v2_fancy_upsample(j_decompress_ptr cinfo, jpeg_component_info *compptr,
                           JSAMPARRAY input_data, JSAMPARRAY *output_data_ptr)
 {
-  if (simd_support & JSIMD_AVX2)
-    jsimd_h2v2_fancy_upsample_avx2(cinfo->max_v_samp_factor,
-                                   compptr->downsampled_width, input_data,
-                                   output_data_ptr);
-  else
-    jsimd_h2v2_fancy_upsample_sse2(cinfo->max_v_samp_factor,
-                                   compptr->downsampled_width, input_data,
-                                   output_data_ptr);
+  (*simd.h2v2_fancy_upsample) (cinfo->max_v_samp_factor,
+                               compptr->downsampled_width, input_data,
+                               output_data_ptr);
 }
 
 GLOBAL(void)
 jsimd_h2v1_fancy_upsample(j_decompress_ptr cinfo, jpeg_component_info *compptr,
                           JSAMPARRAY input_data, JSAMPARRAY *output_data_ptr)
 {
-  if (simd_support & JSIMD_AVX2)
-    jsimd_h2v1_fancy_upsample_avx2(cinfo->max_v_samp_factor,
-                                   compptr->downsampled_width, input_data,
-                                   output_data_ptr);
-  else
-    jsimd_h2v1_fancy_upsample_sse2(cinfo->max_v_samp_factor,
-                                   compptr->downsampled_width, input_data,
-                                   output_data_ptr);
+  (*simd.h2v1_fancy_upsample) (cinfo->max_v_samp_factor,
+                               compptr->downsampled_width, input_data,
+                               output_data_ptr);
 }
 
 GLOBAL(void)
 jsimd_h1v2_fancy_upsample(j_decompress_ptr cinfo, jpeg_component_info *compptr,
                           JSAMPARRAY input_data, JSAMPARRAY *output_data_ptr)
 {
+  (*simd.h1v2_fancy_upsample) (cinfo->max_v_samp_factor,
+                               compptr->downsampled_width, input_data,
+                               output_data_ptr);
 }
 
 GLOBAL(int)
@@ -523,14 +1342,7 @@ jsimd_can_h2v2_merged_upsample(void)
   if (sizeof(JDIMENSION) != 4)
     return 0;
 
-  if ((simd_support & JSIMD_AVX2) &&
-      IS_ALIGNED_AVX(jconst_merged_upsample_avx2))
-    return 1;
-  if ((simd_support & JSIMD_SSE2) &&
-      IS_ALIGNED_SSE(jconst_merged_upsample_sse2))
-    return 1;
-
-  return 0;
+  return simd.h2v2_merged_upsample[JCS_RGB] != NULL;
 }
 
 GLOBAL(int)
@@ -544,110 +1356,187 @@ jsimd_can_h2v1_merged_upsample(void)
   if (sizeof(JDIMENSION) != 4)
     return 0;
 
-  if ((simd_support & JSIMD_AVX2) &&
-      IS_ALIGNED_AVX(jconst_merged_upsample_avx2))
-    return 1;
-  if ((simd_support & JSIMD_SSE2) &&
-      IS_ALIGNED_SSE(jconst_merged_upsample_sse2))
-    return 1;
+  return simd.h2v1_merged_upsample[JCS_RGB] != NULL;
+}
+
+GLOBAL(int)
+jsimd_can_h2v2_merged_upsample_565(void)
+{
+  init_simd();
+
+  /* The code is optimised for these values only */
+  if (BITS_IN_JSAMPLE != 8)
+    return 0;
+  if (sizeof(JDIMENSION) != 4)
+    return 0;
+
+  return simd.h2v1_merged_upsample_565 != NULL;
+}
+
+GLOBAL(int)
+jsimd_can_h2v1_merged_upsample_565(void)
+{
+  init_simd();
+
+  /* The code is optimised for these values only */
+  if (BITS_IN_JSAMPLE != 8)
+    return 0;
+  if (sizeof(JDIMENSION) != 4)
+    return 0;
+
+  return simd.h2v1_merged_upsample_565 != NULL;
+}
+
+GLOBAL(int)
+jsimd_can_h2v2_fancy_merged_upsample(void)
+{
+  init_simd();
+
+  /* The code is optimised for these values only */
+  if (BITS_IN_JSAMPLE != 8)
+    return 0;
+  if (sizeof(JDIMENSION) != 4)
+    return 0;
+
+  return simd.fancy_merged_upsample_row[JCS_RGB] != NULL;
+}
+
+GLOBAL(int)
+jsimd_can_h2v1_fancy_merged_upsample(void)
+{
+  init_simd();
+
+  /* The code is optimised for these values only */
+  if (BITS_IN_JSAMPLE != 8)
+    return 0;
+  if (sizeof(JDIMENSION) != 4)
+    return 0;
 
-  return 0;
+  return simd.fancy_merged_upsample_row[JCS_RGB] != NULL;
 }
 
 GLOBAL(void)
 jsimd_h2v2_merged_upsample(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
                            JDIMENSION in_row_group_ctr, JSAMPARRAY output_buf)
 {
-  void (*avx2fct) (JDIMENSION, JSAMPIMAGE, JDIMENSION, JSAMPARRAY);
-  void (*sse2fct) (JDIMENSION, JSAMPIMAGE, JDIMENSION, JSAMPARRAY);
-
-  switch (cinfo->out_color_space) {
-  case JCS_EXT_RGB:
-    avx2fct = jsimd_h2v2_extrgb_merged_upsample_avx2;
-    sse2fct = jsimd_h2v2_extrgb_merged_upsample_sse2;
-    break;
-  case JCS_EXT_RGBX:
-  case JCS_EXT_RGBA:
-    avx2fct = jsimd_h2v2_extrgbx_merged_upsample_avx2;
-    sse2fct = jsimd_h2v2_extrgbx_merged_upsample_sse2;
-    break;
-  case JCS_EXT_BGR:
-    avx2fct = jsimd_h2v2_extbgr_merged_upsample_avx2;
-    sse2fct = jsimd_h2v2_extbgr_merged_upsample_sse2;
-    break;
-  case JCS_EXT_BGRX:
-  case JCS_EXT_BGRA:
-    avx2fct = jsimd_h2v2_extbgrx_merged_upsample_avx2;
-    sse2fct = jsimd_h2v2_extbgrx_merged_upsample_sse2;
-    break;
-  case JCS_EXT_XBGR:
-  case JCS_EXT_ABGR:
-    avx2fct = jsimd_h2v2_extxbgr_merged_upsample_avx2;
-    sse2fct = jsimd_h2v2_extxbgr_merged_upsample_sse2;
-    break;
-  case JCS_EXT_XRGB:
-  case JCS_EXT_ARGB:
-    avx2fct = jsimd_h2v2_extxrgb_merged_upsample_avx2;
-    sse2fct = jsimd_h2v2_extxrgb_merged_upsample_sse2;
-    break;
-  default:
-    avx2fct = jsimd_h2v2_merged_upsample_avx2;
-    sse2fct = jsimd_h2v2_merged_upsample_sse2;
-    break;
-  }
-
-  if (simd_support & JSIMD_AVX2)
-    avx2fct(cinfo->output_width, input_buf, in_row_group_ctr, output_buf);
-  else
-    sse2fct(cinfo->output_width, input_buf, in_row_group_ctr, output_buf);
+  (*simd.h2v2_merged_upsample[cinfo->out_color_space])
+    (cinfo->output_width, input_buf, in_row_group_ctr, output_buf);
 }
 
 GLOBAL(void)
 jsimd_h2v1_merged_upsample(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
                            JDIMENSION in_row_group_ctr, JSAMPARRAY output_buf)
 {
-  void (*avx2fct) (JDIMENSION, JSAMPIMAGE, JDIMENSION, JSAMPARRAY);
-  void (*sse2fct) (JDIMENSION, JSAMPIMAGE, JDIMENSION, JSAMPARRAY);
-
-  switch (cinfo->out_color_space) {
-  case JCS_EXT_RGB:
-    avx2fct = jsimd_h2v1_extrgb_merged_upsample_avx2;
-    sse2fct = jsimd_h2v1_extrgb_merged_upsample_sse2;
-    break;
-  case JCS_EXT_RGBX:
-  case JCS_EXT_RGBA:
-    avx2fct = jsimd_h2v1_extrgbx_merged_upsample_avx2;
-    sse2fct = jsimd_h2v1_extrgbx_merged_upsample_sse2;
-    break;
-  case JCS_EXT_BGR:
-    avx2fct = jsimd_h2v1_extbgr_merged_upsample_avx2;
-    sse2fct = jsimd_h2v1_extbgr_merged_upsample_sse2;
-    break;
-  case JCS_EXT_BGRX:
-  case JCS_EXT_BGRA:
-    avx2fct = jsimd_h2v1_extbgrx_merged_upsample_avx2;
-    sse2fct = jsimd_h2v1_extbgrx_merged_upsample_sse2;
-    break;
-  case JCS_EXT_XBGR:
-  case JCS_EXT_ABGR:
-    avx2fct = jsimd_h2v1_extxbgr_merged_upsample_avx2;
-    sse2fct = jsimd_h2v1_extxbgr_merged_upsample_sse2;
-    break;
-  case JCS_EXT_XRGB:
-  case JCS_EXT_ARGB:
-    avx2fct = jsimd_h2v1_extxrgb_merged_upsample_avx2;
-    sse2fct = jsimd_h2v1_extxrgb_merged_upsample_sse2;
-    break;
-  default:
-    avx2fct = jsimd_h2v1_merged_upsample_avx2;
-    sse2fct = jsimd_h2v1_merged_upsample_sse2;
-    break;
-  }
+  (*simd.h2v1_merged_upsample[cinfo->out_color_space])
+    (cinfo->output_width, input_buf, in_row_group_ctr, output_buf);
+}
+
+/* Both rows of an h2v2 row group are upsampled with the h2v1 kernel, the
+ * same way as the assembly versions of jsimd_h2v2_merged_upsample() do it,
+ * but the two rows use different dither patterns.
+ */
+LOCAL(void)
+h2v2_merged_upsample_565(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                         JDIMENSION in_row_group_ctr, JSAMPARRAY output_buf,
+                         JLONG d0, JLONG d1)
+{
+  JSAMPROW inptr[3];
+  JSAMPARRAY inrows[3];
+
+  inrows[0] = &inptr[0];
+  inrows[1] = &inptr[1];
+  inrows[2] = &inptr[2];
+  inptr[0] = input_buf[0][in_row_group_ctr * 2];
+  inptr[1] = input_buf[1][in_row_group_ctr];
+  inptr[2] = input_buf[2][in_row_group_ctr];
+  (*simd.h2v1_merged_upsample_565) (cinfo->output_width, inrows, 0,
+                                    output_buf, d0);
+  inptr[0] = input_buf[0][in_row_group_ctr * 2 + 1];
+  (*simd.h2v1_merged_upsample_565) (cinfo->output_width, inrows, 0,
+                                    output_buf + 1, d1);
+}
+
+GLOBAL(void)
+jsimd_h2v2_merged_upsample_565(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                               JDIMENSION in_row_group_ctr,
+                               JSAMPARRAY output_buf)
+{
+  h2v2_merged_upsample_565(cinfo, input_buf, in_row_group_ctr, output_buf, 0,
+                           0);
+}
+
+GLOBAL(void)
+jsimd_h2v2_merged_upsample_565D(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                                JDIMENSION in_row_group_ctr,
+                                JSAMPARRAY output_buf)
+{
+  h2v2_merged_upsample_565(cinfo, input_buf, in_row_group_ctr, output_buf,
+                           dither_matrix[cinfo->output_scanline & DITHER_MASK],
+                           dither_matrix[(cinfo->output_scanline + 1) &
+                                         DITHER_MASK]);
+}
 
-  if (simd_support & JSIMD_AVX2)
-    avx2fct(cinfo->output_width, input_buf, in_row_group_ctr, output_buf);
-  else
-    sse2fct(cinfo->output_width, input_buf, in_row_group_ctr, output_buf);
+GLOBAL(void)
+jsimd_h2v1_merged_upsample_565(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                               JDIMENSION in_row_group_ctr,
+                               JSAMPARRAY output_buf)
+{
+  (*simd.h2v1_merged_upsample_565) (cinfo->output_width, input_buf,
+                                    in_row_group_ctr, output_buf, 0);
+}
+
+GLOBAL(void)
+jsimd_h2v1_merged_upsample_565D(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                                JDIMENSION in_row_group_ctr,
+                                JSAMPARRAY output_buf)
+{
+  (*simd.h2v1_merged_upsample_565)
+    (cinfo->output_width, input_buf, in_row_group_ctr, output_buf,
+     dither_matrix[cinfo->output_scanline & DITHER_MASK]);
+}
+
+/* The fancy merged upsampling kernels produce one output row at a time from
+ * the Y row and from the nearer and the farther row of each chroma component,
+ * which are the same row for h2v1.  jdmerge.c passes a NULL output row for
+ * h2v2 if it does not need that row yet.
+ */
+GLOBAL(void)
+jsimd_h2v2_fancy_merged_upsample(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                                 JDIMENSION in_row_group_ctr,
+                                 JSAMPARRAY output_buf)
+{
+  JSAMPARRAY inrows1 = input_buf[1] + in_row_group_ctr;
+  JSAMPARRAY inrows2 = input_buf[2] + in_row_group_ctr;
+  JSAMPROW inrows[5];
+
+  inrows[0] = input_buf[0][in_row_group_ctr * 2];
+  inrows[1] = inrows1[0];
+  inrows[2] = inrows1[-1];
+  inrows[3] = inrows2[0];
+  inrows[4] = inrows2[-1];
+  if (output_buf[0] != NULL)
+    (*simd.fancy_merged_upsample_row[cinfo->out_color_space])
+      (cinfo->output_width, inrows, output_buf[0], 2);
+  inrows[0] = input_buf[0][in_row_group_ctr * 2 + 1];
+  inrows[2] = inrows1[1];
+  inrows[4] = inrows2[1];
+  if (output_buf[1] != NULL)
+    (*simd.fancy_merged_upsample_row[cinfo->out_color_space])
+      (cinfo->output_width, inrows, output_buf[1], 2);
+}
+
+GLOBAL(void)
+jsimd_h2v1_fancy_merged_upsample(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                                 JDIMENSION in_row_group_ctr,
+                                 JSAMPARRAY output_buf)
+{
+  JSAMPROW inrows[5];
+
+  inrows[0] = input_buf[0][in_row_group_ctr];
+  inrows[1] = inrows[2] = input_buf[1][in_row_group_ctr];
+  inrows[3] = inrows[4] = input_buf[2][in_row_group_ctr];
+  (*simd.fancy_merged_upsample_row[cinfo->out_color_space])
+    (cinfo->output_width, inrows, output_buf[0], 1);
 }
 
 GLOBAL(int)
@@ -665,12 +1554,7 @@ jsimd_can_convsamp(void)
   if (sizeof(DCTELEM) != 2)
     return 0;
 
-  if (simd_support & JSIMD_AVX2)
-    return 1;
-  if (simd_support & JSIMD_SSE2)
-    return 1;
-
-  return 0;
+  return simd.convsamp != NULL;
 }
 
 GLOBAL(int)
@@ -688,27 +1572,21 @@ jsimd_can_convsamp_float(void)
   if (sizeof(FAST_FLOAT) != 4)
     return 0;
 
-  if (simd_support & JSIMD_SSE2)
-    return 1;
-
-  return 0;
+  return simd.convsamp_float != NULL;
 }
 
 GLOBAL(void)
 jsimd_convsamp(JSAMPARRAY sample_data, JDIMENSION start_col,
                DCTELEM *workspace)
 {
-  if (simd_support & JSIMD_AVX2)
-    jsimd_convsamp_avx2(sample_data, start_col, workspace);
-  else
-    jsimd_convsamp_sse2(sample_data, start_col, workspace);
+  (*simd.convsamp) (sample_data, start_col, workspace);
 }
 
 GLOBAL(void)
 jsimd_convsamp_float(JSAMPARRAY sample_data, JDIMENSION start_col,
                      FAST_FLOAT *workspace)
 {
-  jsimd_convsamp_float_sse2(sample_data, start_col, workspace);
+  (*simd.convsamp_float) (sample_data, start_col, workspace);
 }
 
 GLOBAL(int)
@@ -722,12 +1600,7 @@ jsimd_can_fdct_islow(void)
   if (sizeof(DCTELEM) != 2)
     return 0;
 
-  if ((simd_support & JSIMD_AVX2) && IS_ALIGNED_AVX(jconst_fdct_islow_avx2))
-    return 1;
-  if ((simd_support & JSIMD_SSE2) && IS_ALIGNED_SSE(jconst_fdct_islow_sse2))
-    return 1;
-
-  return 0;
+  return simd.fdct_islow != NULL;
 }
 
 GLOBAL(int)
@@ -741,10 +1614,7 @@ jsimd_can_fdct_ifast(void)
   if (sizeof(DCTELEM) != 2)
     return 0;
 
-  if ((simd_support & JSIMD_SSE2) && IS_ALIGNED_SSE(jconst_fdct_ifast_sse2))
-    return 1;
-
-  return 0;
+  return simd.fdct_ifast != NULL;
 }
 
 GLOBAL(int)
@@ -758,31 +1628,25 @@ jsimd_can_fdct_float(void)
   if (sizeof(FAST_FLOAT) != 4)
     return 0;
 
-  if ((simd_support & JSIMD_SSE) && IS_ALIGNED_SSE(jconst_fdct_float_sse))
-    return 1;
-
-  return 0;
+  return simd.fdct_float != NULL;
 }
 
 GLOBAL(void)
 jsimd_fdct_islow(DCTELEM *data)
 {
-  if (simd_support & JSIMD_AVX2)
-    jsimd_fdct_islow_avx2(data);
-  else
-    jsimd_fdct_islow_sse2(data);
+  (*simd.fdct_islow) (data);
 }
 
 GLOBAL(void)
 jsimd_fdct_ifast(DCTELEM *data)
 {
-  jsimd_fdct_ifast_sse2(data);
+  (*simd.fdct_ifast) (data);
 }
 
 GLOBAL(void)
 jsimd_fdct_float(FAST_FLOAT *data)
 {
-  jsimd_fdct_float_sse(data);
+  (*simd.fdct_float) (data);
 }
 
 GLOBAL(int)
@@ -798,12 +1662,7 @@ jsimd_can_quantize(void)
   if (sizeof(DCTELEM) != 2)
     return 0;
 
-  if (simd_support & JSIMD_AVX2)
-    return 1;
-  if (simd_support & JSIMD_SSE2)
-    return 1;
-
-  return 0;
+  return simd.quantize != NULL;
 }
 
 GLOBAL(int)
@@ -819,26 +1678,20 @@ jsimd_can_quantize_float(void)
   if (sizeof(FAST_FLOAT) != 4)
     return 0;
 
-  if (simd_support & JSIMD_SSE2)
-    return 1;
-
-  return 0;
+  return simd.quantize_float != NULL;
 }
 
 GLOBAL(void)
 jsimd_quantize(JCOEFPTR coef_block, DCTELEM *divisors, DCTELEM *workspace)
 {
-  if (simd_support & JSIMD_AVX2)
-    jsimd_quantize_avx2(coef_block, divisors, workspace);
-  else
-    jsimd_quantize_sse2(coef_block, divisors, workspace);
+  (*simd.quantize) (coef_block, divisors, workspace);
 }
 
 GLOBAL(void)
 jsimd_quantize_float(JCOEFPTR coef_block, FAST_FLOAT *divisors,
                      FAST_FLOAT *workspace)
 {
-  jsimd_quantize_float_sse2(coef_block, divisors, workspace);
+  (*simd.quantize_float) (coef_block, divisors, workspace);
 }
 
 GLOBAL(int)
@@ -858,10 +1711,7 @@ jsimd_can_idct_2x2(void)
   if (sizeof(ISLOW_MULT_TYPE) != 2)
     return 0;
 
-  if ((simd_support & JSIMD_SSE2) && IS_ALIGNED_SSE(jconst_idct_red_sse2))
-    return 1;
-
-  return 0;
+  return simd.idct_2x2 != NULL;
 }
 
 GLOBAL(int)
@@ -881,10 +1731,7 @@ jsimd_can_idct_4x4(void)
   if (sizeof(ISLOW_MULT_TYPE) != 2)
     return 0;
 
-  if ((simd_support & JSIMD_SSE2) && IS_ALIGNED_SSE(jconst_idct_red_sse2))
-    return 1;
-
-  return 0;
+  return simd.idct_4x4 != NULL;
 }
 
 GLOBAL(void)
@@ -892,7 +1739,7 @@ jsimd_idct_2x2(j_decompress_ptr cinfo, jpeg_component_info *compptr,
                JCOEFPTR coef_block, JSAMPARRAY output_buf,
                JDIMENSION output_col)
 {
-  jsimd_idct_2x2_sse2(compptr->dct_table, coef_block, output_buf, output_col);
+  (*simd.idct_2x2) (compptr->dct_table, coef_block, output_buf, output_col);
 }
 
 GLOBAL(void)
@@ -900,11 +1747,11 @@ jsimd_idct_4x4(j_decompress_ptr cinfo, jpeg_component_info *compptr,
                JCOEFPTR coef_block, JSAMPARRAY output_buf,
                JDIMENSION output_col)
 {
-  jsimd_idct_4x4_sse2(compptr->dct_table, coef_block, output_buf, output_col);
+  (*simd.idct_4x4) (compptr->dct_table, coef_block, output_buf, output_col);
 }
 
 GLOBAL(int)
-jsimd_can_idct_islow(void)
+jsimd_can_idct_scaled(int scaled_size)
 {
   init_simd();
 
@@ -919,13 +1766,40 @@ jsimd_can_idct_islow(void)
     return 0;
   if (sizeof(ISLOW_MULT_TYPE) != 2)
     return 0;
+  if (scaled_size < 1 || scaled_size > DCTSIZE * 2)
+    return 0;
+
+  return simd.idct_scaled[scaled_size] != NULL;
+}
+
+GLOBAL(void)
+jsimd_idct_scaled(j_decompress_ptr cinfo, jpeg_component_info *compptr,
+                  JCOEFPTR coef_block, JSAMPARRAY output_buf,
+                  JDIMENSION output_col)
+{
+  (*simd.idct_scaled[compptr->_DCT_scaled_size]) (compptr->dct_table,
+                                                  coef_block, output_buf,
+                                                  output_col);
+}
+
+GLOBAL(int)
+jsimd_can_idct_islow(void)
+{
+  init_simd();
 
-  if ((simd_support & JSIMD_AVX2) && IS_ALIGNED_AVX(jconst_idct_islow_avx2))
-    return 1;
-  if ((simd_support & JSIMD_SSE2) && IS_ALIGNED_SSE(jconst_idct_islow_sse2))
-    return 1;
+  /* The code is optimised for these values only */
+  if (DCTSIZE != 8)
+    return 0;
+  if (sizeof(JCOEF) != 2)
+    return 0;
+  if (BITS_IN_JSAMPLE != 8)
+    return 0;
+  if (sizeof(JDIMENSION) != 4)
+    return 0;
+  if (sizeof(ISLOW_MULT_TYPE) != 2)
+    return 0;
 
-  return 0;
+  return simd.idct_islow != NULL;
 }
 
 GLOBAL(int)
@@ -947,10 +1821,7 @@ jsimd_can_idct_ifast(void)
   if (IFAST_SCALE_BITS != 2)
     return 0;
 
-  if ((simd_support & JSIMD_SSE2) && IS_ALIGNED_SSE(jconst_idct_ifast_sse2))
-    return 1;
-
-  return 0;
+  return simd.idct_ifast != NULL;
 }
 
 GLOBAL(int)
@@ -971,10 +1842,7 @@ jsimd_can_idct_float(void)
   if (sizeof(FLOAT_MULT_TYPE) != 4)
     return 0;
 
-  if ((simd_support & JSIMD_SSE2) && IS_ALIGNED_SSE(jconst_idct_float_sse2))
-    return 1;
-
-  return 0;
+  return simd.idct_float != NULL;
 }
 
 GLOBAL(void)
@@ -982,12 +1850,7 @@ jsimd_idct_islow(j_decompress_ptr cinfo, jpeg_component_info *compptr,
                  JCOEFPTR coef_block, JSAMPARRAY output_buf,
                  JDIMENSION output_col)
 {
-  if (simd_support & JSIMD_AVX2)
-    jsimd_idct_islow_avx2(compptr->dct_table, coef_block, output_buf,
-                          output_col);
-  else
-    jsimd_idct_islow_sse2(compptr->dct_table, coef_block, output_buf,
-                          output_col);
+  (*simd.idct_islow) (compptr->dct_table, coef_block, output_buf, output_col);
 }
 
 GLOBAL(void)
@@ -995,8 +1858,7 @@ jsimd_idct_ifast(j_decompress_ptr cinfo, jpeg_component_info *compptr,
                  JCOEFPTR coef_block, JSAMPARRAY output_buf,
                  JDIMENSION output_col)
 {
-  jsimd_idct_ifast_sse2(compptr->dct_table, coef_block, output_buf,
-                        output_col);
+  (*simd.idct_ifast) (compptr->dct_table, coef_block, output_buf, output_col);
 }
 
 GLOBAL(void)
@@ -1004,25 +1866,83 @@ jsimd_idct_float(j_decompress_ptr cinfo, jpeg_component_info *compptr,
                  JCOEFPTR coef_block, JSAMPARRAY output_buf,
                  JDIMENSION output_col)
 {
-  jsimd_idct_float_sse2(compptr->dct_table, coef_block, output_buf,
-                        output_col);
+  (*simd.idct_float) (compptr->dct_table, coef_block, output_buf, output_col);
 }
 
 GLOBAL(int)
-jsimd_can_huff_encode_one_block(void)
+jsimd_can_idct_islow_corner4(void)
+{
+  init_simd();
+
+  /* The code is optimised for these values only */
+  if (DCTSIZE != 8)
+    return 0;
+  if (sizeof(JCOEF) != 2)
+    return 0;
+  if (BITS_IN_JSAMPLE != 8)
+    return 0;
+  if (sizeof(JDIMENSION) != 4)
+    return 0;
+  if (sizeof(ISLOW_MULT_TYPE) != 2)
+    return 0;
+
+  return simd.idct_islow_corner4 != NULL;
+}
+
+GLOBAL(void)
+jsimd_idct_islow_corner4(j_decompress_ptr cinfo, jpeg_component_info *compptr,
+                         JCOEFPTR coef_block, JSAMPARRAY output_buf,
+                         JDIMENSION output_col)
+{
+  (*simd.idct_islow_corner4) (compptr->dct_table, coef_block, output_buf,
+                              output_col);
+}
+
+GLOBAL(int)
+jsimd_can_idct_islow_blocks(void)
 {
   init_simd();
 
+  /* The code is optimised for these values only */
   if (DCTSIZE != 8)
     return 0;
   if (sizeof(JCOEF) != 2)
     return 0;
+  if (BITS_IN_JSAMPLE != 8)
+    return 0;
+  if (sizeof(JDIMENSION) != 4)
+    return 0;
+  if (sizeof(ISLOW_MULT_TYPE) != 2)
+    return 0;
+
+  return simd.idct_islow_blocks != NULL;
+}
+
+GLOBAL(void)
+jsimd_idct_islow_blocks(j_decompress_ptr cinfo, jpeg_component_info *compptr,
+                        JCOEFPTR coef_blocks, JSAMPARRAY output_buf,
+                        JDIMENSION output_col, JDIMENSION num_blocks)
+{
+  if (num_blocks >= 2)
+    (*simd.idct_islow_blocks) (compptr->dct_table, coef_blocks, output_buf,
+                               output_col, num_blocks / 2);
+  if (num_blocks & 1)
+    (*simd.idct_islow) (compptr->dct_table,
+                        coef_blocks + (num_blocks - 1) * DCTSIZE2,
+                        output_buf, output_col + (num_blocks - 1) * DCTSIZE);
+}
+
+GLOBAL(int)
+jsimd_can_huff_encode_one_block(void)
+{
+  init_simd();
 
-  if ((simd_support & JSIMD_SSE2) && simd_huffman &&
-      IS_ALIGNED_SSE(jconst_huff_encode_one_block))
-    return 1;
+  if (DCTSIZE != 8)
+    return 0;
+  if (sizeof(JCOEF) != 2)
+    return 0;
 
-  return 0;
+  return simd.huff_encode_one_block != NULL;
 }
 
 GLOBAL(JOCTET *)
@@ -1030,8 +1950,8 @@ jsimd_huff_encode_one_block(void *state, JOCTET *buffer, JCOEFPTR block,
                             int last_dc_val, c_derived_tbl *dctbl,
                             c_derived_tbl *actbl)
 {
-  return jsimd_huff_encode_one_block_sse2(state, buffer, block, last_dc_val,
-                                          dctbl, actbl);
+  return (*simd.huff_encode_one_block) (state, buffer, block, last_dc_val,
+                                        dctbl, actbl);
 }
 
 GLOBAL(int)
@@ -1045,10 +1965,8 @@ jsimd_can_encode_mcu_AC_first_prepare(void)
     return 0;
   if (SIZEOF_SIZE_T != 8)
     return 0;
-  if (simd_support & JSIMD_SSE2)
-    return 1;
 
-  return 0;
+  return simd.encode_mcu_AC_first_prepare != NULL;
 }
 
 GLOBAL(void)
@@ -1056,8 +1974,8 @@ jsimd_encode_mcu_AC_first_prepare(const JCOEF *block,
                                   const int *jpeg_natural_order_start, int Sl,
                                   int Al, JCOEF *values, size_t *zerobits)
 {
-  jsimd_encode_mcu_AC_first_prepare_sse2(block, jpeg_natural_order_start,
-                                         Sl, Al, values, zerobits);
+  (*simd.encode_mcu_AC_first_prepare) (block, jpeg_natural_order_start, Sl,
+                                       Al, values, zerobits);
 }
 
 GLOBAL(int)
@@ -1071,10 +1989,8 @@ jsimd_can_encode_mcu_AC_refine_prepare(void)
     return 0;
   if (SIZEOF_SIZE_T != 8)
     return 0;
-  if (simd_support & JSIMD_SSE2)
-    return 1;
 
-  return 0;
+  return simd.encode_mcu_AC_refine_prepare != NULL;
 }
 
 GLOBAL(int)
@@ -1082,7 +1998,7 @@ jsimd_encode_mcu_AC_refine_prepare(const JCOEF *block,
                                    const int *jpeg_natural_order_start, int Sl,
                                    int Al, JCOEF *absvalues, size_t *bits)
 {
-  return jsimd_encode_mcu_AC_refine_prepare_sse2(block,
-                                                 jpeg_natural_order_start,
-                                                 Sl, Al, absvalues, bits);
+  return (*simd.encode_mcu_AC_refine_prepare) (block,
+                                              jpeg_natural_order_start, Sl,
+                                              Al, absvalues, bits);
 }
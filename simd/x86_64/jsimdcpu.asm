@@ -54,6 +54,15 @@ EXTN(jpeg_simd_cpu_support):
     xor         rcx, rcx
     cpuid
     mov         rax, rbx                ; rax = Extended feature flags
+    mov         r8, rbx                 ; r8 = Extended feature flags
+
+    ; Check for BMI1 & BMI2 instruction support
+    mov         rcx, rax
+    and         rcx, (1<<3) | (1<<8)    ; bit3:BMI1, bit8:BMI2
+    cmp         rcx, (1<<3) | (1<<8)
+    jne         short .no_bmi
+    or          rdi, JSIMD_BMI2
+.no_bmi:
 
     test        rax, 1<<5               ; bit5:AVX2
     jz          short .return
@@ -69,6 +78,7 @@ EXTN(jpeg_simd_cpu_support):
 
     xor         rcx, rcx
     xgetbv
+    mov         rdx, rax                ; rdx = XCR0
     and         rax, 6
     cmp         rax, 6                  ; O/S does not manage XMM/YMM state
                                         ; using XSAVE
@@ -76,6 +86,20 @@ EXTN(jpeg_simd_cpu_support):
 
     or          rdi, JSIMD_AVX2
 
+    ; Check for AVX-512 instruction support
+    and         r8d, (1<<16) | (1<<30) | (1<<31)  ; bit16:AVX512F,
+                                                  ; bit30:AVX512BW,
+                                                  ; bit31:AVX512VL
+    cmp         r8d, (1<<16) | (1<<30) | (1<<31)
+    jne         short .return
+
+    and         rdx, 0xE6
+    cmp         rdx, 0xE6               ; O/S does not manage opmask/ZMM state
+                                        ; using XSAVE
+    jnz         short .return
+
+    or          rdi, JSIMD_AVX512
+
 .return:
     mov         rax, rdi
 
@@ -749,6 +749,10 @@ void usage(char *progName)
   printf("     underlying codec\n");
   printf("-progressive = Use progressive entropy coding in JPEG images generated by\n");
   printf("     compression and transform operations.\n");
+  printf("-mt = Use multiple threads for compression/decompression operations that\n");
+  printf("     support it (see TJFLAG_MULTITHREAD)\n");
+  printf("-speculative = With -mt, also decompress images without restart markers\n");
+  printf("     using multiple threads (see TJFLAG_SPECULATIVE)\n");
   printf("-subsamp <s> = When testing JPEG compression, this option specifies the level\n");
   printf("     of chrominance subsampling to use (<s> = 444, 422, 440, 420, 411, or\n");
   printf("     GRAY).  The default is to test Grayscale, 4:2:0, 4:2:2, and 4:4:4 in\n");
@@ -843,6 +847,12 @@ int main(int argc, char *argv[])
       } else if (!strcasecmp(argv[i], "-progressive")) {
         printf("Using progressive entropy coding\n\n");
         flags |= TJFLAG_PROGRESSIVE;
+      } else if (!strcasecmp(argv[i], "-mt")) {
+        printf("Using multiple threads\n\n");
+        flags |= TJFLAG_MULTITHREAD;
+      } else if (!strcasecmp(argv[i], "-speculative")) {
+        printf("Using speculative multi-threaded decompression\n\n");
+        flags |= TJFLAG_SPECULATIVE;
       } else if (!strcasecmp(argv[i], "-rgb"))
         pf = TJPF_RGB;
       else if (!strcasecmp(argv[i], "-rgbx"))
@@ -54,7 +54,9 @@ void usage(char *progName)
   printf("-noyuvpad = do not pad each line of each Y, U, and V plane to the nearest\n");
   printf("            4-byte boundary\n");
   printf("-alloc = test automatic buffer allocation\n");
-  printf("-bmp = tjLoadImage()/tjSaveImage() unit test\n\n");
+  printf("-bmp = tjLoadImage()/tjSaveImage() unit test\n");
+  printf("-mt = compare the multi-threaded code paths with the single-threaded\n");
+  printf("      ones\n\n");
   exit(1);
 }
 
@@ -845,6 +847,280 @@ int bmpTest(void)
 }
 
 
+/* The multi-threaded code paths must produce exactly the same output as the
+   single-threaded code paths, so the test images contain noise rather than a
+   pattern that checkBuf() can verify. */
+
+void initNoiseBuf(unsigned char *buf, int w, int h, int ps, int noise)
+{
+  int row, col, i;
+
+  for (row = 0; row < h; row++) {
+    for (col = 0; col < w; col++) {
+      for (i = 0; i < ps; i++)
+        *buf++ = (unsigned char)(((row + col) * (i + 1) / 4 +
+                                  random() % noise) & 255);
+    }
+  }
+}
+
+
+const char *restartEnv[] = {
+  "TJ_RESTART=", "TJ_RESTART=1", "TJ_RESTART=2", "TJ_RESTART=7B"
+};
+#define NUMRESTART  (int)(sizeof(restartEnv) / sizeof(restartEnv[0]))
+
+/* Decompress the image at every scaling factor with and without mtFlags, and
+   check that the output is identical */
+
+void mtDecompTest(tjhandle handle, unsigned char *jpegBuf,
+                  unsigned long jpegSize, int w, int h, int pf, int flags,
+                  int mtFlags)
+{
+  unsigned char *stBuf = NULL, *mtBuf = NULL;
+  int i, n = 0, scaledw, scaledh, ps = tjPixelSize[pf];
+  tjscalingfactor *sf = tjGetScalingFactors(&n);
+
+  if (!sf || !n) _throwtj();
+
+  for (i = 0; i < n; i++) {
+    scaledw = TJSCALED(w, sf[i]);
+    scaledh = TJSCALED(h, sf[i]);
+    if ((stBuf = (unsigned char *)malloc(scaledw * scaledh * ps)) == NULL ||
+        (mtBuf = (unsigned char *)malloc(scaledw * scaledh * ps)) == NULL)
+      _throw("Memory allocation failure");
+    memset(mtBuf, 0, scaledw * scaledh * ps);
+    _tj(tjDecompress2(handle, jpegBuf, jpegSize, stBuf, scaledw, 0, scaledh,
+                      pf, flags));
+    _tj(tjDecompress2(handle, jpegBuf, jpegSize, mtBuf, scaledw, 0, scaledh,
+                      pf, flags | mtFlags));
+    if (memcmp(stBuf, mtBuf, scaledw * scaledh * ps)) {
+      printf("\n   Multi-threaded output differs at scaling factor %d/%d\n",
+             sf[i].num, sf[i].denom);
+      bailout()
+    }
+    free(stBuf);  stBuf = NULL;
+    free(mtBuf);  mtBuf = NULL;
+  }
+
+bailout:
+  if (stBuf) free(stBuf);
+  if (mtBuf) free(mtBuf);
+}
+
+
+void doMTTest(int w, int h, int subsamp)
+{
+  tjhandle chandle = NULL, dhandle = NULL;
+  unsigned char *srcBuf = NULL, *jpegBuf = NULL;
+  unsigned long jpegSize = 0;
+  int pf = subsamp == TJSAMP_GRAY ? TJPF_GRAY : TJPF_RGB, r, i;
+
+  if ((chandle = tjInitCompress()) == NULL ||
+      (dhandle = tjInitDecompress()) == NULL)
+    _throwtj();
+  if ((srcBuf = (unsigned char *)malloc(w * h * tjPixelSize[pf])) == NULL)
+    _throw("Memory allocation failure");
+  initNoiseBuf(srcBuf, w, h, tjPixelSize[pf], 64);
+
+  for (r = 0; r < NUMRESTART; r++) {
+    putenv((char *)restartEnv[r]);
+    printf("%s %d x %d Q95 %s ... ", subNameLong[subsamp], w, h,
+           strlen(restartEnv[r]) > 11 ? restartEnv[r] : "(no restarts)");
+    _tj(tjCompress2(chandle, srcBuf, w, 0, h, pf, &jpegBuf, &jpegSize,
+                    subsamp, 95, 0));
+    for (i = 0; i < 4; i++) {
+      int flags = (i & 1 ? TJFLAG_FASTUPSAMPLE : 0) |
+                  (i & 2 ? TJFLAG_BOTTOMUP : 0);
+
+      mtDecompTest(dhandle, jpegBuf, jpegSize, w, h, pf, flags,
+                   TJFLAG_MULTITHREAD);
+      /* Too small to be split, so this tests the fallback */
+      if (r == 0)
+        mtDecompTest(dhandle, jpegBuf, jpegSize, w, h, pf, flags,
+                     TJFLAG_MULTITHREAD | TJFLAG_SPECULATIVE);
+      if (exitStatus < 0) goto bailout;
+    }
+    printf("Passed.\n");
+  }
+
+bailout:
+  putenv((char *)"TJ_RESTART=");
+  if (chandle) tjDestroy(chandle);
+  if (dhandle) tjDestroy(dhandle);
+  if (srcBuf) free(srcBuf);
+  if (jpegBuf) tjFree(jpegBuf);
+}
+
+
+/* Speculative decompression gives each thread at least 512 KB of
+   entropy-coded data, so the image must be large and noisy and must not
+   contain restart markers.  A 1.5 MB image is split into at least three
+   stripes. */
+
+void doSpeculativeTest(int w, int h, int subsamp)
+{
+  tjhandle chandle = NULL, dhandle = NULL;
+  unsigned char *srcBuf = NULL, *jpegBuf = NULL;
+  unsigned long jpegSize = 0;
+  int pf = subsamp == TJSAMP_GRAY ? TJPF_GRAY : TJPF_RGB, i;
+
+  if ((chandle = tjInitCompress()) == NULL ||
+      (dhandle = tjInitDecompress()) == NULL)
+    _throwtj();
+  if ((srcBuf = (unsigned char *)malloc(w * h * tjPixelSize[pf])) == NULL)
+    _throw("Memory allocation failure");
+  initNoiseBuf(srcBuf, w, h, tjPixelSize[pf], 256);
+
+  printf("%s %d x %d Q100 speculative ... ", subNameLong[subsamp], w, h);
+  _tj(tjCompress2(chandle, srcBuf, w, 0, h, pf, &jpegBuf, &jpegSize, subsamp,
+                  100, 0));
+  if (jpegSize < 3 * 512 * 1024)
+    _throw("Test image is too small to be split");
+  for (i = 0; i < 2; i++) {
+    int flags = i ? TJFLAG_FASTUPSAMPLE | TJFLAG_BOTTOMUP : 0;
+
+    mtDecompTest(dhandle, jpegBuf, jpegSize, w, h, pf, flags,
+                 TJFLAG_MULTITHREAD | TJFLAG_SPECULATIVE);
+    if (exitStatus < 0) goto bailout;
+  }
+  printf("Passed.\n");
+
+bailout:
+  if (chandle) tjDestroy(chandle);
+  if (dhandle) tjDestroy(dhandle);
+  if (srcBuf) free(srcBuf);
+  if (jpegBuf) tjFree(jpegBuf);
+}
+
+
+/* Compress the image with and without TJFLAG_MULTITHREAD.  If the image is
+   expected to be split into stripes, then the multi-threaded JPEG image must
+   have restart markers and must decompress to the same pixels.  Otherwise,
+   the JPEG images must be identical. */
+
+void mtCompTest(tjhandle chandle, tjhandle dhandle, unsigned char *srcBuf,
+                int w, int h, int pf, int subsamp, int flags, int expectSplit)
+{
+  unsigned char *stJpegBuf = NULL, *mtJpegBuf = NULL, *stBuf = NULL,
+    *mtBuf = NULL;
+  unsigned long stJpegSize = 0, mtJpegSize = 0, i;
+  int ps = tjPixelSize[pf], split = 0;
+
+  if (flags & TJFLAG_NOREALLOC) {
+    stJpegSize = mtJpegSize = tjBufSize(w, h, subsamp);
+    if ((stJpegBuf = tjAlloc(stJpegSize)) == NULL ||
+        (mtJpegBuf = tjAlloc(mtJpegSize)) == NULL)
+      _throw("Memory allocation failure");
+  }
+  _tj(tjCompress2(chandle, srcBuf, w, 0, h, pf, &stJpegBuf, &stJpegSize,
+                  subsamp, 95, flags));
+  _tj(tjCompress2(chandle, srcBuf, w, 0, h, pf, &mtJpegBuf, &mtJpegSize,
+                  subsamp, 95, flags | TJFLAG_MULTITHREAD));
+  if (!expectSplit) {
+    if (stJpegSize != mtJpegSize || memcmp(stJpegBuf, mtJpegBuf, stJpegSize))
+      _throw("Multi-threaded JPEG image differs");
+  } else {
+    /* Look for the DRI marker that stripes add */
+    for (i = 0; i + 1 < mtJpegSize; i++) {
+      if (mtJpegBuf[i] == 0xFF && mtJpegBuf[i + 1] == 0xDA) break;
+      if (mtJpegBuf[i] == 0xFF && mtJpegBuf[i + 1] == 0xDD) split = 1;
+    }
+    if (!split) _throw("Image was not split into stripes");
+
+    if ((stBuf = (unsigned char *)malloc(w * h * ps)) == NULL ||
+        (mtBuf = (unsigned char *)malloc(w * h * ps)) == NULL)
+      _throw("Memory allocation failure");
+    memset(mtBuf, 0, w * h * ps);
+    _tj(tjDecompress2(dhandle, stJpegBuf, stJpegSize, stBuf, w, 0, h, pf,
+                      flags));
+    _tj(tjDecompress2(dhandle, mtJpegBuf, mtJpegSize, mtBuf, w, 0, h, pf,
+                      flags));
+    if (memcmp(stBuf, mtBuf, w * h * ps))
+      _throw("Multi-threaded JPEG image decompresses differently");
+  }
+
+bailout:
+  if (stJpegBuf) tjFree(stJpegBuf);
+  if (mtJpegBuf) tjFree(mtJpegBuf);
+  if (stBuf) free(stBuf);
+  if (mtBuf) free(mtBuf);
+}
+
+
+/* Progressive, optimized, and restart-interval compression fall back to
+   single-threaded compression of the whole image, as do images that are too
+   small to be split. */
+
+const char *fallbackEnv[] = {
+  "TJ_OPTIMIZE=1", "TJ_RESTART=1", "TJ_RESTART=7B"
+};
+#define NUMFALLBACK  (int)(sizeof(fallbackEnv) / sizeof(fallbackEnv[0]))
+
+void doMTCompTest(int w, int h, int subsamp)
+{
+  tjhandle chandle = NULL, dhandle = NULL;
+  unsigned char *srcBuf = NULL;
+  int pf = subsamp == TJSAMP_GRAY ? TJPF_GRAY : TJPF_BGRX, i;
+  int canSplit = (h + tjMCUHeight[subsamp] - 1) / tjMCUHeight[subsamp] > 4;
+
+  if ((chandle = tjInitCompress()) == NULL ||
+      (dhandle = tjInitDecompress()) == NULL)
+    _throwtj();
+  if ((srcBuf = (unsigned char *)malloc(w * h * tjPixelSize[pf])) == NULL)
+    _throw("Memory allocation failure");
+  initNoiseBuf(srcBuf, w, h, tjPixelSize[pf], 64);
+
+  printf("%s %d x %d -> %s multi-threaded ... ", pixFormatStr[pf], w, h,
+         subNameLong[subsamp]);
+  for (i = 0; i < 2; i++) {
+    int flags = i ? TJFLAG_BOTTOMUP : 0;
+
+    mtCompTest(chandle, dhandle, srcBuf, w, h, pf, subsamp, flags, canSplit);
+    mtCompTest(chandle, dhandle, srcBuf, w, h, pf, subsamp,
+               flags | TJFLAG_NOREALLOC, canSplit);
+    mtCompTest(chandle, dhandle, srcBuf, w, h, pf, subsamp,
+               flags | TJFLAG_PROGRESSIVE, 0);
+    if (exitStatus < 0) goto bailout;
+  }
+  for (i = 0; i < NUMFALLBACK; i++) {
+    putenv((char *)fallbackEnv[i]);
+    mtCompTest(chandle, dhandle, srcBuf, w, h, pf, subsamp, 0, 0);
+    putenv((char *)"TJ_OPTIMIZE=");
+    putenv((char *)"TJ_RESTART=");
+    if (exitStatus < 0) goto bailout;
+  }
+  printf("Passed.\n");
+
+bailout:
+  if (chandle) tjDestroy(chandle);
+  if (dhandle) tjDestroy(dhandle);
+  if (srcBuf) free(srcBuf);
+}
+
+
+int mtTest(void)
+{
+  int subsamp;
+
+  putenv((char *)"TJ_NUMTHREADS=4");
+  for (subsamp = 0; subsamp < TJ_NUMSAMP; subsamp++) {
+    doMTTest(301, 257, subsamp);
+    if (exitStatus < 0) return exitStatus;
+  }
+  for (subsamp = 0; subsamp < TJ_NUMSAMP; subsamp++) {
+    doSpeculativeTest(1024, 1031, subsamp);
+    if (exitStatus < 0) return exitStatus;
+  }
+  for (subsamp = 0; subsamp < TJ_NUMSAMP; subsamp++) {
+    doMTCompTest(301, 257, subsamp);
+    doMTCompTest(41, 32, subsamp);
+    if (exitStatus < 0) break;
+  }
+  return exitStatus;
+}
+
+
 int main(int argc, char *argv[])
 {
   int i, num4bf = 5;
@@ -858,6 +1134,7 @@ int main(int argc, char *argv[])
       else if (!strcasecmp(argv[i], "-noyuvpad")) pad = 1;
       else if (!strcasecmp(argv[i], "-alloc")) alloc = 1;
       else if (!strcasecmp(argv[i], "-bmp")) return bmpTest();
+      else if (!strcasecmp(argv[i], "-mt")) return mtTest();
       else usage(argv[0]);
     }
   }
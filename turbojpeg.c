@@ -43,6 +43,8 @@
 #include "transupp.h"
 #include "./jpegcomp.h"
 #include "./cdjpeg.h"
+#include "./jthread.h"
+#include "./jsimd.h"
 
 extern void jpeg_mem_dest_tj(j_compress_ptr, unsigned char **, unsigned long *,
                              boolean);
@@ -98,6 +100,69 @@ static void my_emit_message(j_common_ptr cinfo, int msg_level)
 }
 
 
+/* The TJFLAG_FORCE* flags restrict the SIMD extensions in the same way as the
+   JSIMD_FORCE* environment variables, and likewise only take effect with the
+   first image that the process compresses or decompresses. */
+
+static void forceSIMD(int flags)
+{
+  if (flags & TJFLAG_FORCEMMX) jsimd_force(JSIMD_FORCEMMX);
+  else if (flags & TJFLAG_FORCESSE) jsimd_force(JSIMD_FORCESSE);
+  else if (flags & TJFLAG_FORCESSE2) jsimd_force(JSIMD_FORCESSE2);
+}
+
+
+/* Helpers for the multi-threaded code paths */
+
+/* The thread count is determined once per process, so that the environment is
+   not queried for every image, possibly while another thread modifies it. */
+
+static int defaultNumThreads = 1;
+static jthread_once_t numThreadsOnce = JTHREAD_ONCE_INIT;
+
+static void initNumThreads(void)
+{
+#ifndef NO_GETENV
+  char *env = NULL;
+#endif
+
+  defaultNumThreads = jthread_num_cpus();
+#ifndef NO_GETENV
+  if ((env = getenv("TJ_NUMTHREADS")) != NULL && strlen(env) > 0) {
+    int temp = atoi(env);
+
+    if (temp >= 1 && temp <= JTHREAD_MAX_THREADS) defaultNumThreads = temp;
+  }
+#endif
+}
+
+static int getNumThreads(void)
+{
+  jthread_once(&numThreadsOnce, initNumThreads);
+  return defaultNumThreads;
+}
+
+static void my_discard_message(j_common_ptr cinfo)
+{
+}
+
+/* Any warning means that a stripe might not be compressed or decompressed the
+   same way as in a single-threaded operation, so we treat it as an error.
+   Messages are discarded, since the caller will redo the whole image with a
+   single thread and report them from there. */
+
+static void initStripeErrorMgr(j_common_ptr cinfo, struct my_error_mgr *jerr)
+{
+  cinfo->err = jpeg_std_error(&jerr->pub);
+  jerr->pub.error_exit = my_error_exit;
+  jerr->pub.output_message = my_discard_message;
+  jerr->emit_message = jerr->pub.emit_message;
+  jerr->pub.emit_message = my_emit_message;
+  jerr->warning = FALSE;
+  jerr->stopOnWarning = TRUE;
+}
+
+
 /* Global structures, macros, etc. */
 
 enum { COMPRESS = 1, DECOMPRESS = 2 };
@@ -605,6 +670,253 @@ bailout:
 }
 
 
+/* Multi-threaded compression */
+
+/* Minimum number of iMCU rows in a stripe.  Each stripe is compressed as a
+   separate image, so very small stripes would spend most of their time
+   setting up the compressor. */
+#define MIN_COMP_STRIPE_IMCU_ROWS  4
+
+typedef struct {
+  unsigned char *jpegBuf;       /* the stripe, compressed as a separate image */
+  unsigned long jpegSize;
+  unsigned long sofOffset;      /* offset of the image height in the SOF */
+  unsigned long dataOffset;     /* offset of the entropy-coded data */
+  int failed;
+} tjcompstripe;
+
+typedef struct {
+  JSAMPROW *rowPointer;
+  int width, height, pixelFormat, subsamp, jpegQual, flags;
+  int restartRows;              /* height of a stripe in iMCU rows */
+  int stripeHeight;             /* height of a stripe in pixels */
+  int numStripes;
+  tjcompstripe *stripes;
+} tjcompstripeinfo;
+
+/* Find the image height field in the SOF marker and the start of the
+   entropy-coded data in a compressed stripe.  Returns -1 if the stripe does
+   not consist of markers followed by a single scan and EOI. */
+
+static int scanStripe(tjcompstripe *stripe)
+{
+  const unsigned char *buf = stripe->jpegBuf;
+  unsigned long i = 2;
+
+  if (stripe->jpegSize < 4 || buf[0] != 0xFF || buf[1] != 0xD8 ||
+      buf[stripe->jpegSize - 2] != 0xFF || buf[stripe->jpegSize - 1] != 0xD9)
+    return -1;
+
+  stripe->sofOffset = 0;
+  while (i + 4 <= stripe->jpegSize - 2) {
+    int marker, length;
+
+    if (buf[i] != 0xFF) return -1;
+    marker = buf[i + 1];
+    length = (buf[i + 2] << 8) | buf[i + 3];
+    if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 &&
+        marker != 0xC8 && marker != 0xCC)
+      stripe->sofOffset = i + 5;
+    i += 2 + length;
+    if (marker == 0xDA) {
+      if (stripe->sofOffset == 0 || i > stripe->jpegSize - 2) return -1;
+      stripe->dataOffset = i;
+      return 0;
+    }
+  }
+  return -1;
+}
+
+/* Compress one stripe.  The stripe is compressed as a separate image whose
+   restart interval is the height of a stripe, so that the image contains no
+   restart markers and its entropy-coded data is exactly one restart interval
+   of the whole image. */
+
+static void compressStripe(void *arg, int index)
+{
+  tjcompstripeinfo *info = (tjcompstripeinfo *)arg;
+  tjcompstripe *stripe = &info->stripes[index];
+  struct jpeg_compress_struct cinfo;
+  struct my_error_mgr jerr;
+  int startRow = index * info->stripeHeight, height;
+
+  stripe->failed = 1;
+
+  height = info->height - startRow;
+  if (height > info->stripeHeight) height = info->stripeHeight;
+  /* Use a fixed-size buffer, so that the memory destination manager never
+     needs to reallocate it. */
+  stripe->jpegSize = tjBufSize(info->width, height, info->subsamp);
+  if ((stripe->jpegBuf = (unsigned char *)malloc(stripe->jpegSize)) == NULL)
+    return;
+
+  initStripeErrorMgr((j_common_ptr)&cinfo, &jerr);
+
+  if (setjmp(jerr.setjmp_buffer)) {
+    /* If we get here, the JPEG code has signaled an error. */
+    goto destroy;
+  }
+
+  jpeg_create_compress(&cinfo);
+  cinfo.image_width = info->width;
+  cinfo.image_height = height;
+  jpeg_mem_dest_tj(&cinfo, &stripe->jpegBuf, &stripe->jpegSize, FALSE);
+  setCompDefaults(&cinfo, info->pixelFormat, info->subsamp, info->jpegQual,
+                  info->flags);
+  cinfo.restart_in_rows = info->restartRows;
+
+  jpeg_start_compress(&cinfo, TRUE);
+  while (cinfo.next_scanline < cinfo.image_height)
+    jpeg_write_scanlines(&cinfo,
+                         &info->rowPointer[startRow + cinfo.next_scanline],
+                         cinfo.image_height - cinfo.next_scanline);
+  jpeg_finish_compress(&cinfo);
+
+  if (scanStripe(stripe) == 0) stripe->failed = 0;
+
+destroy:
+  jpeg_destroy_compress(&cinfo);
+}
+
+static void freeCompStripes(tjcompstripeinfo *info)
+{
+  int i;
+
+  if (info->stripes) {
+    for (i = 0; i < info->numStripes; i++)
+      free(info->stripes[i].jpegBuf);
+    free(info->stripes);
+    info->stripes = NULL;
+  }
+}
+
+/* Based on emit_byte() in jcmarker.c */
+
+static void writeStripeData(j_compress_ptr cinfo, const unsigned char *buf,
+                            unsigned long size)
+{
+  struct jpeg_destination_mgr *dest = cinfo->dest;
+
+  while (size > 0) {
+    size_t count = MIN(size, dest->free_in_buffer);
+
+    MEMCOPY(dest->next_output_byte, buf, count);
+    dest->next_output_byte += count;
+    dest->free_in_buffer -= count;
+    buf += count;  size -= count;
+    if (dest->free_in_buffer == 0) {
+      if (!(*dest->empty_output_buffer) (cinfo))
+        ERREXIT(cinfo, JERR_CANT_SUSPEND);
+    }
+  }
+}
+
+/* Compress an image using multiple threads.  The image is split into
+   horizontal stripes of whole iMCU rows, and each stripe is compressed as a
+   separate image with a restart interval equal to the stripe height.  The
+   entropy-coded data of the stripes is then joined with RSTn markers, which
+   produces exactly the same JPEG image as a single-threaded compression with
+   that restart interval.  cinfo must have been set up with setCompDefaults()
+   but not started.  Returns -1 (without having touched cinfo) if the image
+   cannot be split into stripes or if any stripe could not be compressed
+   cleanly. */
+
+static int compressParallel(j_compress_ptr cinfo, JSAMPROW *rowPointer,
+                            int pixelFormat, int jpegSubsamp, int jpegQual,
+                            int flags)
+{
+  tjcompstripeinfo info;
+  my_error_ptr myerr = (my_error_ptr)cinfo->err;
+  jmp_buf callerSetjmpBuffer;
+  unsigned char marker[2];
+  tjcompstripe *stripe;
+  int numThreads, mcusPerRow, imcuRows, i;
+
+  MEMZERO(&info, sizeof(tjcompstripeinfo));
+
+  /* Progressive images have multiple scans, and optimized Huffman tables
+     would differ from one stripe to the next.  A restart interval requested
+     through the TJ_RESTART environment variable is honored by falling back to
+     single-threaded compression. */
+  if (cinfo->scan_info != NULL || cinfo->optimize_coding ||
+      cinfo->restart_interval != 0 || cinfo->restart_in_rows != 0)
+    return -1;
+  if ((numThreads = getNumThreads()) < 2) return -1;
+
+  info.rowPointer = rowPointer;
+  info.width = cinfo->image_width;
+  info.height = cinfo->image_height;
+  info.pixelFormat = pixelFormat;
+  info.subsamp = jpegSubsamp;
+  info.jpegQual = jpegQual;
+  info.flags = flags;
+
+  mcusPerRow = (info.width + tjMCUWidth[jpegSubsamp] - 1) /
+               tjMCUWidth[jpegSubsamp];
+  imcuRows = (info.height + tjMCUHeight[jpegSubsamp] - 1) /
+             tjMCUHeight[jpegSubsamp];
+  info.restartRows = (imcuRows + numThreads - 1) / numThreads;
+  if (info.restartRows < MIN_COMP_STRIPE_IMCU_ROWS)
+    info.restartRows = MIN_COMP_STRIPE_IMCU_ROWS;
+  /* The restart interval is a 16-bit quantity in MCUs. */
+  if ((long)info.restartRows * mcusPerRow > 65535L)
+    info.restartRows = 65535 / mcusPerRow;
+  info.stripeHeight = info.restartRows * tjMCUHeight[jpegSubsamp];
+  info.numStripes = (imcuRows + info.restartRows - 1) / info.restartRows;
+  if (info.numStripes < 2) return -1;
+
+  if ((info.stripes =
+       (tjcompstripe *)calloc(info.numStripes, sizeof(tjcompstripe))) == NULL)
+    return -1;
+
+  jthread_run(info.numStripes, numThreads, compressStripe, &info);
+
+  for (i = 0; i < info.numStripes; i++) {
+    if (info.stripes[i].failed) {
+      freeCompStripes(&info);
+      return -1;
+    }
+  }
+
+  /* Write the image through cinfo's destination manager, so that the
+     destination buffer is handled in the same way as in a single-threaded
+     compression.  If that fails, free the stripes before passing the error
+     on to the caller. */
+  memcpy(callerSetjmpBuffer, myerr->setjmp_buffer, sizeof(jmp_buf));
+  if (setjmp(myerr->setjmp_buffer)) {
+    /* If we get here, the JPEG code has signaled an error. */
+    memcpy(myerr->setjmp_buffer, callerSetjmpBuffer, sizeof(jmp_buf));
+    freeCompStripes(&info);
+    longjmp(myerr->setjmp_buffer, 1);
+  }
+
+  (*cinfo->dest->init_destination) (cinfo);
+  stripe = &info.stripes[0];
+  stripe->jpegBuf[stripe->sofOffset] =
+    (unsigned char)(cinfo->image_height >> 8);
+  stripe->jpegBuf[stripe->sofOffset + 1] =
+    (unsigned char)(cinfo->image_height & 0xFF);
+  writeStripeData(cinfo, stripe->jpegBuf, stripe->dataOffset);
+  for (i = 0; i < info.numStripes; i++) {
+    stripe = &info.stripes[i];
+    if (i > 0) {
+      marker[0] = 0xFF;
+      marker[1] = (unsigned char)(0xD0 + ((i - 1) & 7));
+      writeStripeData(cinfo, marker, 2);
+    }
+    writeStripeData(cinfo, &stripe->jpegBuf[stripe->dataOffset],
+                    stripe->jpegSize - 2 - stripe->dataOffset);
+  }
+  marker[0] = 0xFF;
+  marker[1] = 0xD9;
+  writeStripeData(cinfo, marker, 2);
+  (*cinfo->dest->term_destination) (cinfo);
+
+  memcpy(myerr->setjmp_buffer, callerSetjmpBuffer, sizeof(jmp_buf));
+  freeCompStripes(&info);
+  return 0;
+}
+
 DLLEXPORT int tjCompress2(tjhandle handle, const unsigned char *srcBuf,
                           int width, int pitch, int height, int pixelFormat,
                           unsigned char **jpegBuf, unsigned long *jpegSize,
@@ -637,11 +949,7 @@ DLLEXPORT int tjCompress2(tjhandle handle, const unsigned char *srcBuf,
   cinfo->image_width = width;
   cinfo->image_height = height;
 
-#ifndef NO_PUTENV
-  if (flags & TJFLAG_FORCEMMX) putenv("JSIMD_FORCEMMX=1");
-  else if (flags & TJFLAG_FORCESSE) putenv("JSIMD_FORCESSE=1");
-  else if (flags & TJFLAG_FORCESSE2) putenv("JSIMD_FORCESSE2=1");
-#endif
+  forceSIMD(flags);
 
   if (flags & TJFLAG_NOREALLOC) {
     alloc = 0;  *jpegSize = tjBufSize(width, height, jpegSubsamp);
@@ -650,13 +958,20 @@ DLLEXPORT int tjCompress2(tjhandle handle, const unsigned char *srcBuf,
   if (setCompDefaults(cinfo, pixelFormat, jpegSubsamp, jpegQual, flags) == -1)
     return -1;
 
-  jpeg_start_compress(cinfo, TRUE);
   for (i = 0; i < height; i++) {
     if (flags & TJFLAG_BOTTOMUP)
       row_pointer[i] = (JSAMPROW)&srcBuf[(height - i - 1) * pitch];
     else
       row_pointer[i] = (JSAMPROW)&srcBuf[i * pitch];
   }
+  if ((flags & TJFLAG_MULTITHREAD) &&
+      compressParallel(cinfo, row_pointer, pixelFormat, jpegSubsamp, jpegQual,
+                       flags) == 0)
+    goto bailout;
+
+  jpeg_start_compress(cinfo, TRUE);
+  if (flags & TJFLAG_MULTITHREAD)
+    jpeg_set_scan_threads(cinfo, getNumThreads());
   while (cinfo->next_scanline < cinfo->image_height)
     jpeg_write_scanlines(cinfo, &row_pointer[cinfo->next_scanline],
                          cinfo->image_height - cinfo->next_scanline);
@@ -737,11 +1052,7 @@ DLLEXPORT int tjEncodeYUVPlanes(tjhandle handle, const unsigned char *srcBuf,
   cinfo->image_width = width;
   cinfo->image_height = height;
 
-#ifndef NO_PUTENV
-  if (flags & TJFLAG_FORCEMMX) putenv("JSIMD_FORCEMMX=1");
-  else if (flags & TJFLAG_FORCESSE) putenv("JSIMD_FORCESSE=1");
-  else if (flags & TJFLAG_FORCESSE2) putenv("JSIMD_FORCESSE2=1");
-#endif
+  forceSIMD(flags);
 
   if (setCompDefaults(cinfo, pixelFormat, subsamp, -1, flags) == -1) return -1;
 
@@ -947,11 +1258,7 @@ DLLEXPORT int tjCompressFromYUVPlanes(tjhandle handle,
   cinfo->image_width = width;
   cinfo->image_height = height;
 
-#ifndef NO_PUTENV
-  if (flags & TJFLAG_FORCEMMX) putenv("JSIMD_FORCEMMX=1");
-  else if (flags & TJFLAG_FORCESSE) putenv("JSIMD_FORCESSE=1");
-  else if (flags & TJFLAG_FORCESSE2) putenv("JSIMD_FORCESSE2=1");
-#endif
+  forceSIMD(flags);
 
   if (flags & TJFLAG_NOREALLOC) {
     alloc = 0;  *jpegSize = tjBufSize(width, height, subsamp);
@@ -962,6 +1269,8 @@ DLLEXPORT int tjCompressFromYUVPlanes(tjhandle handle,
   cinfo->raw_data_in = TRUE;
 
   jpeg_start_compress(cinfo, TRUE);
+  if (flags & TJFLAG_MULTITHREAD)
+    jpeg_set_scan_threads(cinfo, getNumThreads());
   for (i = 0; i < cinfo->num_components; i++) {
     jpeg_component_info *compptr = &cinfo->comp_info[i];
     int ih;
@@ -1213,6 +1522,613 @@ DLLEXPORT tjscalingfactor *tjGetScalingFactors(int *numscalingfactors)
 }
 
 
+/* Multi-threaded decompression */
+
+/* Minimum number of iMCU rows in a stripe.  Each stripe also decodes up to
+   one restart interval above and below itself to provide the upsampling
+   context, so very small stripes would waste too much work. */
+#define MIN_STRIPE_IMCU_ROWS  4
+
+/* Speculative decompression (see TJFLAG_SPECULATIVE) works only with the
+   library's own memory source, which jpeg_start_speculative() recognizes. */
+#if JPEG_LIB_VERSION >= 80 || defined(MEM_SRCDST_SUPPORTED)
+#define SPECULATIVE_SUPPORTED
+#endif
+
+typedef struct {
+  int startRow, endRow;         /* iMCU rows [startRow, endRow) */
+  int failed;
+} tjstripe;
+
+typedef struct {
+  const unsigned char *jpegBuf;
+  unsigned long headerSize;     /* size of all markers up to the end of SOS */
+  unsigned long sofOffset;      /* offset of the image height in the SOF */
+  unsigned long *segStart, *segEnd;  /* entropy data of each restart interval */
+  int numIntervals, restartInterval, mcusPerRow, imcuRows;
+  int imageHeight, imcuHeight;  /* in source pixels */
+  int outputHeight, outputWidth, outImcuHeight, pixelSize;
+  J_COLOR_SPACE outColorSpace;
+  J_DCT_METHOD dctMethod;
+  boolean fancyUpsampling;
+  unsigned int scaleNum, scaleDenom;
+  JSAMPROW *rowPointer;
+  tjstripe *stripes;
+#ifdef SPECULATIVE_SUPPORTED
+  unsigned long jpegSize;
+  struct tjchunk *chunks;       /* see decompressSpeculative() */
+  jpeg_mcu_position *positions; /* MCU positions at which stripes can start */
+  int numPositions;
+  int compsInScan;              /* # of valid last_dc_val[] entries */
+#endif
+} tjstripeinfo;
+
+#define IS_INTERVAL_START(info, row) \
+  (((unsigned long)(row) * (info)->mcusPerRow) % (info)->restartInterval == 0)
+
+/* Find the image height field in the SOF marker and the entropy-coded data
+   of each restart interval.  Returns -1 if the scan is not terminated by EOI,
+   if it contains markers other than RSTn, or if the restart markers do not
+   match the restart interval declared in the header.  The caller then falls
+   back to single-threaded decompression, which handles all such cases. */
+
+static int scanJPEG(tjstripeinfo *info, unsigned long jpegSize)
+{
+  const unsigned char *buf = info->jpegBuf;
+  unsigned long i = 2;
+  int n = 0;
+
+  info->sofOffset = 0;
+  while (i + 4 <= info->headerSize) {
+    int marker, length;
+
+    if (buf[i] != 0xFF) return -1;
+    marker = buf[i + 1];
+    if (marker == 0xFF) { i++;  continue; }
+    if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) {
+      i += 2;  continue;
+    }
+    length = (buf[i + 2] << 8) | buf[i + 3];
+    if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 &&
+        marker != 0xC8 && marker != 0xCC)
+      info->sofOffset = i + 5;
+    if (marker == 0xDA) break;
+    i += 2 + length;
+  }
+  if (info->sofOffset == 0 || info->sofOffset + 2 > info->headerSize)
+    return -1;
+
+  i = info->headerSize;
+  info->segStart[0] = i;
+  while (i + 1 < jpegSize) {
+    const unsigned char *ptr = memchr(&buf[i], 0xFF, jpegSize - 1 - i);
+
+    if (!ptr) break;
+    i = ptr - buf;
+    if (buf[i + 1] == 0x00)
+      i += 2;
+    else if (buf[i + 1] == 0xFF)
+      i++;
+    else if (buf[i + 1] >= 0xD0 && buf[i + 1] <= 0xD7) {
+      if (n >= info->numIntervals - 1 || buf[i + 1] != 0xD0 + (n & 7))
+        return -1;
+      info->segEnd[n++] = i;
+      i += 2;
+      info->segStart[n] = i;
+    } else if (buf[i + 1] == 0xD9 && n == info->numIntervals - 1) {
+      info->segEnd[n] = i;
+      return 0;
+    } else
+      return -1;
+  }
+  return -1;
+}
+
+/* Decompress one stripe.  The stripe is extracted into a self-contained JPEG
+   image consisting of the original markers (with the image height patched)
+   followed by the entropy-coded data of the restart intervals that the stripe
+   needs, with the restart markers renumbered.  In order to reproduce the
+   output of a single-threaded decode exactly, we also decode the iMCU rows
+   immediately above and below the stripe, so that smooth upsampling sees the
+   same context.  The rows above the stripe are decoded into a scratch buffer,
+   and we stop before outputting the rows below it. */
+
+static void decompressStripe(void *arg, int index)
+{
+  tjstripeinfo *info = (tjstripeinfo *)arg;
+  tjstripe *stripe = &info->stripes[index];
+  struct jpeg_decompress_struct dinfo;
+  struct my_error_mgr jerr;
+  unsigned char *buf = NULL, *ptr, *scratch = NULL;
+  JSAMPROW *rowPointer = NULL;
+  unsigned long size;
+  int decStartRow, decEndRow, firstInterval, lastInterval, i;
+  int skipRows, numRows, height;
+
+  stripe->failed = 1;
+
+  decStartRow = stripe->startRow;
+  if (decStartRow > 0) {
+    decStartRow--;
+    while (!IS_INTERVAL_START(info, decStartRow)) decStartRow--;
+  }
+  decEndRow = stripe->endRow;
+  if (decEndRow < info->imcuRows) {
+    decEndRow++;
+    while (decEndRow < info->imcuRows && !IS_INTERVAL_START(info, decEndRow))
+      decEndRow++;
+  }
+  firstInterval =
+    (int)((unsigned long)decStartRow * info->mcusPerRow /
+          info->restartInterval);
+  if (decEndRow == info->imcuRows) {
+    lastInterval = info->numIntervals;
+    height = info->imageHeight - decStartRow * info->imcuHeight;
+  } else {
+    lastInterval =
+      (int)((unsigned long)decEndRow * info->mcusPerRow /
+            info->restartInterval);
+    height = (decEndRow - decStartRow) * info->imcuHeight;
+  }
+
+  size = info->headerSize + 2;
+  for (i = firstInterval; i < lastInterval; i++)
+    size += info->segEnd[i] - info->segStart[i] + 2;
+  if ((buf = (unsigned char *)malloc(size)) == NULL)
+    return;
+  memcpy(buf, info->jpegBuf, info->headerSize);
+  buf[info->sofOffset] = (unsigned char)(height >> 8);
+  buf[info->sofOffset + 1] = (unsigned char)(height & 0xFF);
+  ptr = buf + info->headerSize;
+  for (i = firstInterval; i < lastInterval; i++) {
+    if (i > firstInterval) {
+      *ptr++ = 0xFF;
+      *ptr++ = (unsigned char)(0xD0 + ((i - firstInterval - 1) & 7));
+    }
+    memcpy(ptr, &info->jpegBuf[info->segStart[i]],
+           info->segEnd[i] - info->segStart[i]);
+    ptr += info->segEnd[i] - info->segStart[i];
+  }
+  *ptr++ = 0xFF;
+  *ptr++ = 0xD9;
+  size = ptr - buf;
+
+  skipRows = (stripe->startRow - decStartRow) * info->outImcuHeight;
+  numRows = stripe->endRow * info->outImcuHeight;
+  if (numRows > info->outputHeight) numRows = info->outputHeight;
+  numRows -= stripe->startRow * info->outImcuHeight;
+  if ((rowPointer =
+       (JSAMPROW *)malloc(sizeof(JSAMPROW) * (skipRows + numRows))) == NULL)
+    goto bailout;
+  if (skipRows > 0 &&
+      (scratch = (unsigned char *)malloc(info->outputWidth *
+                                         info->pixelSize)) == NULL)
+    goto bailout;
+  for (i = 0; i < skipRows; i++)
+    rowPointer[i] = scratch;
+  for (i = 0; i < numRows; i++)
+    rowPointer[skipRows + i] =
+      info->rowPointer[stripe->startRow * info->outImcuHeight + i];
+
+  initStripeErrorMgr((j_common_ptr)&dinfo, &jerr);
+
+  if (setjmp(jerr.setjmp_buffer)) {
+    /* If we get here, the JPEG code has signaled an error. */
+    goto destroy;
+  }
+
+  jpeg_create_decompress(&dinfo);
+  jpeg_mem_src_tj(&dinfo, buf, size);
+  jpeg_read_header(&dinfo, TRUE);
+  dinfo.out_color_space = info->outColorSpace;
+  dinfo.dct_method = info->dctMethod;
+  dinfo.do_fancy_upsampling = info->fancyUpsampling;
+  dinfo.scale_num = info->scaleNum;
+  dinfo.scale_denom = info->scaleDenom;
+  jpeg_start_decompress(&dinfo);
+  if ((int)dinfo.output_width != info->outputWidth ||
+      (int)dinfo.output_height < skipRows + numRows)
+    goto destroy;
+
+  while ((int)dinfo.output_scanline < skipRows + numRows)
+    jpeg_read_scanlines(&dinfo, &rowPointer[dinfo.output_scanline],
+                        skipRows + numRows - dinfo.output_scanline);
+  /* Let the last stripe check the end of the scan, so that a warning about
+     trailing garbage makes the caller fall back to a single thread as well */
+  if (stripe->endRow == info->imcuRows) jpeg_finish_decompress(&dinfo);
+  stripe->failed = 0;
+
+destroy:
+  jpeg_destroy_decompress(&dinfo);
+bailout:
+  free(rowPointer);
+  free(scratch);
+  free(buf);
+}
+
+#ifdef SPECULATIVE_SUPPORTED
+
+/* Speculative decompression of images without restart markers
+
+   The entropy-coded data is divided into equal-sized chunks, one per thread.
+   Each thread guesses that an MCU begins at the start of its chunk and
+   records the first SYNC_POSITIONS MCU boundaries that it finds from there.
+   Huffman codes tend to resynchronize quickly, so unless the guess was lucky,
+   only the first few boundaries are wrong.  However, a decode that starts at
+   the wrong block of an MCU can also run into invalid data before it
+   resynchronizes (this is common with 4:2:0 subsampling), in which case the
+   thread guesses again just past the point at which the decode stopped.  Next, each thread decodes through
+   the rest of its chunk and on into the next one, until it reaches one of the
+   boundaries that the next thread recorded.  Since both decodes reach that
+   bit position at the start of an MCU, they are identical from there on.
+   Chaining these matches together, starting from the first chunk (which
+   begins at a known MCU boundary), gives the true MCU index and DC predictions
+   at the start of each chunk.  These are handed to the library as checkpoints
+   (see jpeg_use_mcu_positions()), and the image is then decompressed in
+   stripes as with restart markers, each stripe skipping to its first row with
+   jpeg_skip_scanlines().  If any thread fails to synchronize, the caller falls
+   back to single-threaded decompression. */
+
+/* Minimum size of the entropy-coded data for each thread.  Each thread
+   Huffman-decodes its chunk twice, so small chunks are not worth the
+   overhead. */
+#define MIN_CHUNK_SIZE  (1 << 19)
+
+/* Number of MCU boundaries recorded at the start of each chunk */
+#define SYNC_POSITIONS  1024
+
+/* Number of guesses at the start of each chunk */
+#define SYNC_ATTEMPTS  64
+
+typedef struct tjchunk {
+  size_t start;                 /* guessed position of an MCU boundary */
+  jpeg_mcu_position *positions; /* MCU boundaries found from there */
+  JDIMENSION numPositions;
+  jpeg_mcu_position end;        /* first boundary of next chunk reached */
+  JDIMENSION endIndex;          /* index of end in next chunk's positions */
+  int failed;
+} tjchunk;
+
+static int comparePositions(const jpeg_mcu_position *a,
+                            const jpeg_mcu_position *b)
+{
+  if (a->byte_offset != b->byte_offset)
+    return a->byte_offset < b->byte_offset ? -1 : 1;
+  return a->bit_index - b->bit_index;
+}
+
+/* Set up a decompressor for speculative decoding.  Raw data output is
+   requested, since it is the cheapest way to get jpeg_start_decompress() to
+   start the entropy decoder. */
+
+static boolean startSpeculative(tjstripeinfo *info, j_decompress_ptr dinfo,
+                                size_t start)
+{
+  jpeg_create_decompress(dinfo);
+  jpeg_mem_src(dinfo, info->jpegBuf, info->jpegSize);
+  jpeg_read_header(dinfo, TRUE);
+  dinfo->raw_data_out = TRUE;
+  jpeg_start_decompress(dinfo);
+  return jpeg_start_speculative(dinfo, start);
+}
+
+/* Record the first MCU boundaries found from the start of chunk index + 1.
+   If the decode stops early, then the start of the chunk is moved past the
+   point at which it stopped, and the chunk is retried. */
+
+static void recordChunkStart(void *arg, int index)
+{
+  tjstripeinfo *info = (tjstripeinfo *)arg;
+  tjchunk *chunk = &info->chunks[index + 1];
+  struct jpeg_decompress_struct dinfo;
+  struct my_error_mgr jerr;
+  const unsigned char *scan = &info->jpegBuf[info->headerSize];
+  int attempt;
+
+  chunk->failed = 1;
+  initStripeErrorMgr((j_common_ptr)&dinfo, &jerr);
+  if (setjmp(jerr.setjmp_buffer)) goto destroy;
+
+  for (attempt = 0; attempt < SYNC_ATTEMPTS; attempt++) {
+    if (attempt > 0) {
+      /* A zero byte that follows an FF byte is never the start of an MCU */
+      chunk->start = chunk->numPositions > 0 ?
+        chunk->positions[chunk->numPositions - 1].byte_offset + 1 :
+        chunk->start + 1;
+      if (scan[chunk->start - 1] == 0xFF) chunk->start++;
+      chunk->numPositions = 0;
+      jpeg_destroy_decompress(&dinfo);
+    }
+    if (!startSpeculative(info, &dinfo, chunk->start)) goto destroy;
+    while (chunk->numPositions < SYNC_POSITIONS &&
+           jpeg_speculate_mcu(&dinfo, &chunk->positions[chunk->numPositions]))
+      chunk->numPositions++;
+    if (chunk->numPositions == SYNC_POSITIONS) break;
+  }
+  /* Near the end of the image, fewer positions may be available. */
+  if (chunk->numPositions > 0) chunk->failed = 0;
+
+destroy:
+  jpeg_destroy_decompress(&dinfo);
+}
+
+/* Decode from the start of chunk index until reaching one of the MCU
+   boundaries recorded for the next chunk */
+
+static void syncChunkEnd(void *arg, int index)
+{
+  tjstripeinfo *info = (tjstripeinfo *)arg;
+  tjchunk *chunk = &info->chunks[index], *next = &info->chunks[index + 1];
+  struct jpeg_decompress_struct dinfo;
+  struct my_error_mgr jerr;
+  jpeg_mcu_position pos;
+  JDIMENSION j = 0;
+  int cmp;
+
+  chunk->failed = 1;
+  initStripeErrorMgr((j_common_ptr)&dinfo, &jerr);
+  if (setjmp(jerr.setjmp_buffer)) goto destroy;
+
+  if (!startSpeculative(info, &dinfo, chunk->start)) goto destroy;
+  while (jpeg_speculate_mcu(&dinfo, &pos)) {
+    while ((cmp = comparePositions(&next->positions[j], &pos)) < 0)
+      if (++j >= next->numPositions) goto destroy;
+    if (cmp == 0) {
+      chunk->end = pos;
+      chunk->endIndex = j;
+      chunk->failed = 0;
+      break;
+    }
+  }
+
+destroy:
+  jpeg_destroy_decompress(&dinfo);
+}
+
+/* Decompress one stripe, starting from the nearest MCU position */
+
+static void decompressSpeculativeStripe(void *arg, int index)
+{
+  tjstripeinfo *info = (tjstripeinfo *)arg;
+  tjstripe *stripe = &info->stripes[index];
+  struct jpeg_decompress_struct dinfo;
+  struct my_error_mgr jerr;
+  int startRow, numRows;
+
+  stripe->failed = 1;
+  startRow = stripe->startRow * info->outImcuHeight;
+  numRows = stripe->endRow * info->outImcuHeight;
+  if (numRows > info->outputHeight) numRows = info->outputHeight;
+  numRows -= startRow;
+
+  initStripeErrorMgr((j_common_ptr)&dinfo, &jerr);
+  if (setjmp(jerr.setjmp_buffer)) goto destroy;
+
+  jpeg_create_decompress(&dinfo);
+  jpeg_mem_src(&dinfo, info->jpegBuf, info->jpegSize);
+  jpeg_read_header(&dinfo, TRUE);
+  if (index > 0)
+    jpeg_use_mcu_positions(&dinfo, info->positions,
+                           (JDIMENSION)info->numPositions);
+  dinfo.out_color_space = info->outColorSpace;
+  dinfo.dct_method = info->dctMethod;
+  dinfo.do_fancy_upsampling = info->fancyUpsampling;
+  dinfo.scale_num = info->scaleNum;
+  dinfo.scale_denom = info->scaleDenom;
+  jpeg_start_decompress(&dinfo);
+  if ((int)dinfo.output_width != info->outputWidth ||
+      (int)dinfo.output_height < startRow + numRows)
+    goto destroy;
+
+  if (startRow > 0) jpeg_skip_scanlines(&dinfo, startRow);
+  while ((int)dinfo.output_scanline < startRow + numRows)
+    jpeg_read_scanlines(&dinfo, &info->rowPointer[dinfo.output_scanline],
+                        startRow + numRows - dinfo.output_scanline);
+  if (stripe->endRow == info->imcuRows) jpeg_finish_decompress(&dinfo);
+  stripe->failed = 0;
+
+destroy:
+  jpeg_destroy_decompress(&dinfo);
+}
+
+/* Decompress a single-scan Huffman-coded JPEG image without restart markers
+   using multiple threads.  info must have been set up by
+   decompressParallel(). */
+
+static int decompressSpeculative(tjstripeinfo *info, size_t scanOffset,
+                                 size_t scanSize, int numThreads)
+{
+  int retval = -1, numChunks, numStripes, i, ci;
+  JDIMENSION base = 0, syncIndex = 0;
+  int dcOffset[MAX_COMPS_IN_SCAN];
+
+  numChunks = numThreads;
+  if ((size_t)numChunks > scanSize / MIN_CHUNK_SIZE)
+    numChunks = (int)(scanSize / MIN_CHUNK_SIZE);
+  if (numChunks < 2) return -1;
+
+  if ((info->chunks = (tjchunk *)calloc(numChunks, sizeof(tjchunk))) == NULL ||
+      (info->positions = (jpeg_mcu_position *)
+         calloc(numChunks, sizeof(jpeg_mcu_position))) == NULL ||
+      (info->stripes = (tjstripe *)malloc(sizeof(tjstripe) *
+                                          numChunks)) == NULL)
+    goto bailout;
+  for (i = 1; i < numChunks; i++) {
+    tjchunk *chunk = &info->chunks[i];
+
+    /* A zero byte that follows an FF byte is never the start of an MCU */
+    chunk->start = scanSize * i / numChunks;
+    if (info->jpegBuf[scanOffset + chunk->start - 1] == 0xFF) chunk->start++;
+    if ((chunk->positions = (jpeg_mcu_position *)
+           calloc(SYNC_POSITIONS, sizeof(jpeg_mcu_position))) == NULL)
+      goto bailout;
+  }
+
+  jthread_run(numChunks - 1, numThreads, recordChunkStart, info);
+  for (i = 1; i < numChunks; i++)
+    if (info->chunks[i].failed) goto bailout;
+  jthread_run(numChunks - 1, numThreads, syncChunkEnd, info);
+
+  /* Work out the true MCU index and DC predictions at each synchronization
+     point.  Within each chunk, the MCU indices and DC predictions are off by a
+     constant, which is known once the previous chunk has been synchronized.
+     Chunk 0 starts at MCU 0 with zero DC predictions, so it is correct from
+     the start.  Only the first compsInScan DC predictions of each position are
+     filled in. */
+  for (ci = 0; ci < info->compsInScan; ci++) dcOffset[ci] = 0;
+  info->stripes[0].startRow = 0;
+  numStripes = 1;
+  for (i = 0; i < numChunks - 1; i++) {
+    tjchunk *chunk = &info->chunks[i];
+    jpeg_mcu_position *sync, *pos = &info->positions[i];
+    int row;
+
+    /* The match must not precede the point at which this chunk was itself
+       synchronized, since the decode is not known to be correct before it. */
+    if (chunk->failed || chunk->end.mcu_index < syncIndex) goto bailout;
+    sync = &info->chunks[i + 1].positions[chunk->endIndex];
+    *pos = chunk->end;
+    pos->mcu_index += base;
+    for (ci = 0; ci < info->compsInScan; ci++)
+      pos->last_dc_val[ci] += dcOffset[ci];
+    if (i > 0 && pos->mcu_index <= info->positions[i - 1].mcu_index)
+      goto bailout;
+    base = pos->mcu_index - sync->mcu_index;
+    for (ci = 0; ci < info->compsInScan; ci++)
+      dcOffset[ci] = pos->last_dc_val[ci] - sync->last_dc_val[ci];
+    syncIndex = sync->mcu_index;
+
+    /* Start the stripe far enough past the position that
+       jpeg_skip_scanlines() does not need to decode any MCUs before it, even
+       if it decodes the preceding iMCU row for context. */
+    row = (int)((pos->mcu_index + info->mcusPerRow - 1) / info->mcusPerRow) +
+          1;
+    if (row - info->stripes[numStripes - 1].startRow >= MIN_STRIPE_IMCU_ROWS &&
+        info->imcuRows - row >= MIN_STRIPE_IMCU_ROWS) {
+      info->stripes[numStripes - 1].endRow = row;
+      info->stripes[numStripes++].startRow = row;
+    }
+  }
+  info->stripes[numStripes - 1].endRow = info->imcuRows;
+  info->numPositions = numChunks - 1;
+  if (numStripes < 2) goto bailout;
+
+  jthread_run(numStripes, numThreads, decompressSpeculativeStripe, info);
+
+  for (i = 0; i < numStripes; i++)
+    if (info->stripes[i].failed) goto bailout;
+  retval = 0;
+
+bailout:
+  if (info->chunks) {
+    for (i = 0; i < numChunks; i++) free(info->chunks[i].positions);
+  }
+  free(info->chunks);
+  free(info->positions);
+  return retval;
+}
+
+#endif /* SPECULATIVE_SUPPORTED */
+
+/* Decompress a single-scan Huffman-coded JPEG image with restart markers
+   using multiple threads.  dinfo must have been started with
+   jpeg_start_decompress() and must not have read any scanlines.  Returns -1
+   (without having touched dinfo) if the image cannot be split into stripes or
+   if any stripe could not be decoded cleanly. */
+
+static int decompressParallel(j_decompress_ptr dinfo,
+                              const unsigned char *jpegBuf,
+                              unsigned long jpegSize, JSAMPROW *rowPointer,
+                              int pixelSize, int flags)
+{
+  tjstripeinfo info;
+  int retval = -1, numThreads, numStripes, i, row;
+
+  MEMZERO(&info, sizeof(tjstripeinfo));
+
+  if (dinfo->progressive_mode || dinfo->arith_code ||
+      (dinfo->restart_interval == 0 && !(flags & TJFLAG_SPECULATIVE)) ||
+      dinfo->quantize_colors ||
+      dinfo->comps_in_scan != dinfo->num_components ||
+      jpeg_has_multiple_scans(dinfo) ||
+      (dinfo->comps_in_scan == 1 &&
+       dinfo->cur_comp_info[0]->v_samp_factor != 1) ||
+      dinfo->output_scanline != 0)
+    return -1;
+  if ((numThreads = getNumThreads()) < 2) return -1;
+
+  info.jpegBuf = jpegBuf;
+  info.headerSize = jpegSize - dinfo->src->bytes_in_buffer;
+  info.restartInterval = dinfo->restart_interval;
+  info.mcusPerRow = dinfo->MCUs_per_row;
+  info.imcuRows = dinfo->MCU_rows_in_scan;
+  info.imageHeight = dinfo->image_height;
+  info.imcuHeight = dinfo->max_v_samp_factor * DCTSIZE;
+  info.outputWidth = dinfo->output_width;
+  info.outputHeight = dinfo->output_height;
+  info.outImcuHeight = dinfo->max_v_samp_factor * dinfo->_min_DCT_scaled_size;
+  info.pixelSize = pixelSize;
+  info.outColorSpace = dinfo->out_color_space;
+  info.dctMethod = dinfo->dct_method;
+  info.fancyUpsampling = dinfo->do_fancy_upsampling;
+  info.scaleNum = dinfo->scale_num;
+  info.scaleDenom = dinfo->scale_denom;
+  info.rowPointer = rowPointer;
+  if (info.imcuRows < 2 * MIN_STRIPE_IMCU_ROWS) return -1;
+
+  if (dinfo->restart_interval == 0) {
+#ifdef SPECULATIVE_SUPPORTED
+    info.jpegSize = jpegSize;
+    info.compsInScan = dinfo->comps_in_scan;
+    retval = decompressSpeculative(&info, info.headerSize,
+                                   jpegSize - info.headerSize, numThreads);
+    free(info.stripes);
+#endif
+    return retval;
+  }
+
+  info.numIntervals =
+    (int)(((unsigned long)info.mcusPerRow * info.imcuRows +
+           info.restartInterval - 1) / info.restartInterval);
+
+  if ((info.segStart = (unsigned long *)malloc(sizeof(unsigned long) *
+                                               info.numIntervals)) == NULL ||
+      (info.segEnd = (unsigned long *)malloc(sizeof(unsigned long) *
+                                             info.numIntervals)) == NULL ||
+      (info.stripes = (tjstripe *)malloc(sizeof(tjstripe) *
+                                         numThreads)) == NULL)
+    goto bailout;
+  if (scanJPEG(&info, jpegSize) < 0) goto bailout;
+
+  /* Split the image into (at most) one stripe per thread.  Stripes must begin
+     at an iMCU row that is also the start of a restart interval. */
+  numStripes = 0;
+  info.stripes[0].startRow = 0;
+  for (i = 1; i < numThreads; i++) {
+    row = (int)((unsigned long)info.imcuRows * i / numThreads);
+    while (row < info.imcuRows && !IS_INTERVAL_START(&info, row)) row++;
+    if (row - info.stripes[numStripes].startRow >= MIN_STRIPE_IMCU_ROWS &&
+        info.imcuRows - row >= MIN_STRIPE_IMCU_ROWS) {
+      info.stripes[numStripes++].endRow = row;
+      info.stripes[numStripes].startRow = row;
+    }
+  }
+  info.stripes[numStripes++].endRow = info.imcuRows;
+  if (numStripes < 2) goto bailout;
+
+  jthread_run(numStripes, numThreads, decompressStripe, &info);
+
+  for (i = 0; i < numStripes; i++)
+    if (info.stripes[i].failed) goto bailout;
+  retval = 0;
+
+bailout:
+  free(info.segStart);
+  free(info.segEnd);
+  free(info.stripes);
+  return retval;
+}
+
 DLLEXPORT int tjDecompress2(tjhandle handle, const unsigned char *jpegBuf,
                             unsigned long jpegSize, unsigned char *dstBuf,
                             int width, int pitch, int height, int pixelFormat,
@@ -1230,11 +2146,7 @@ DLLEXPORT int tjDecompress2(tjhandle handle, const unsigned char *jpegBuf,
       pitch < 0 || height < 0 || pixelFormat < 0 || pixelFormat >= TJ_NUMPF)
     _throw("tjDecompress2(): Invalid argument");
 
-#ifndef NO_PUTENV
-  if (flags & TJFLAG_FORCEMMX) putenv("JSIMD_FORCEMMX=1");
-  else if (flags & TJFLAG_FORCESSE) putenv("JSIMD_FORCESSE=1");
-  else if (flags & TJFLAG_FORCESSE2) putenv("JSIMD_FORCESSE2=1");
-#endif
+  forceSIMD(flags);
 
   if (setjmp(this->jerr.setjmp_buffer)) {
     /* If we get here, the JPEG code has signaled an error. */
@@ -1278,6 +2190,10 @@ DLLEXPORT int tjDecompress2(tjhandle handle, const unsigned char *jpegBuf,
     else
       row_pointer[i] = &dstBuf[i * pitch];
   }
+  if ((flags & TJFLAG_MULTITHREAD) &&
+      decompressParallel(dinfo, jpegBuf, jpegSize, row_pointer,
+                         tjPixelSize[pixelFormat], flags) == 0)
+    goto bailout;
   while (dinfo->output_scanline < dinfo->output_height)
     jpeg_read_scanlines(dinfo, &row_pointer[dinfo->output_scanline],
                         dinfo->output_height - dinfo->output_scanline);
@@ -1398,11 +2314,7 @@ DLLEXPORT int tjDecodeYUVPlanes(tjhandle handle,
   dinfo->image_width = width;
   dinfo->image_height = height;
 
-#ifndef NO_PUTENV
-  if (flags & TJFLAG_FORCEMMX) putenv("JSIMD_FORCEMMX=1");
-  else if (flags & TJFLAG_FORCESSE) putenv("JSIMD_FORCESSE=1");
-  else if (flags & TJFLAG_FORCESSE2) putenv("JSIMD_FORCESSE2=1");
-#endif
+  forceSIMD(flags);
 
   if (setDecodeDefaults(dinfo, pixelFormat, subsamp, flags) == -1) {
     retval = -1;  goto bailout;
@@ -1566,11 +2478,7 @@ DLLEXPORT int tjDecompressToYUVPlanes(tjhandle handle,
       width < 0 || height < 0)
     _throw("tjDecompressToYUVPlanes(): Invalid argument");
 
-#ifndef NO_PUTENV
-  if (flags & TJFLAG_FORCEMMX) putenv("JSIMD_FORCEMMX=1");
-  else if (flags & TJFLAG_FORCESSE) putenv("JSIMD_FORCESSE=1");
-  else if (flags & TJFLAG_FORCESSE2) putenv("JSIMD_FORCESSE2=1");
-#endif
+  forceSIMD(flags);
 
   if (setjmp(this->jerr.setjmp_buffer)) {
     /* If we get here, the JPEG code has signaled an error. */
@@ -1680,6 +2588,8 @@ DLLEXPORT int tjDecompressToYUVPlanes(tjhandle handle,
           sf[sfi].num / sf[sfi].denom *
           compptr->v_samp_factor / dinfo->max_v_samp_factor;
         dinfo->idct->inverse_DCT[i] = dinfo->idct->inverse_DCT[0];
+        dinfo->idct->inverse_DCT_blocks[i] =
+          dinfo->idct->inverse_DCT_blocks[0];
       }
       crow[i] = row * compptr->v_samp_factor / dinfo->max_v_samp_factor;
       if (usetmpbuf) yuvptr[i] = tmpbuf[i];
@@ -1822,11 +2732,7 @@ DLLEXPORT int tjTransform(tjhandle handle, const unsigned char *jpegBuf,
       dstSizes == NULL || t == NULL || flags < 0)
     _throw("tjTransform(): Invalid argument");
 
-#ifndef NO_PUTENV
-  if (flags & TJFLAG_FORCEMMX) putenv("JSIMD_FORCEMMX=1");
-  else if (flags & TJFLAG_FORCESSE) putenv("JSIMD_FORCESSE=1");
-  else if (flags & TJFLAG_FORCESSE2) putenv("JSIMD_FORCESSE2=1");
-#endif
+  forceSIMD(flags);
 
   if ((xinfo =
        (jpeg_transform_info *)malloc(sizeof(jpeg_transform_info) * n)) == NULL)
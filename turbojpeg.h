@@ -418,6 +418,46 @@ enum TJCS {
  * reduce compression and decompression performance considerably.
  */
 #define TJFLAG_PROGRESSIVE  16384
+/**
+ * Use multiple threads when compressing or decompressing a JPEG image.
+ *
+ * #tjCompress2() splits the source image into horizontal stripes of whole MCU
+ * rows and compresses the stripes concurrently.  Each stripe becomes one
+ * restart interval, so the JPEG image contains restart markers (and is thus
+ * slightly larger) even though a single-threaded compression would not add
+ * them.  Images for which a restart interval or Huffman table optimization is
+ * requested through the TJ_RESTART or TJ_OPTIMIZE environment variables are
+ * not split.  Instead, the Huffman statistics of optimized images are gathered
+ * on several threads, and the scans of progressive JPEG images are encoded
+ * concurrently once the image has been transformed.  Either way, this yields
+ * the same JPEG image as a single-threaded compression.  This also applies to
+ * #tjCompressFromYUVPlanes().
+ *
+ * #tjDecompress2() supports this for single-scan Huffman-coded JPEG images
+ * whose restart intervals begin at MCU row boundaries.  Such images are split
+ * into horizontal stripes of whole restart intervals, and the stripes are
+ * decompressed concurrently directly into the destination buffer.  The output
+ * is identical to that of a single-threaded decompression, and images that
+ * cannot be split are decompressed using a single thread.
+ *
+ * By default, one thread per CPU core is used.  This can be overridden by
+ * setting the TJ_NUMTHREADS environment variable, which is read the first time
+ * that this flag is used in the process.
+ */
+#define TJFLAG_MULTITHREAD  32768
+/**
+ * When used with #TJFLAG_MULTITHREAD, also decompress single-scan
+ * Huffman-coded JPEG images that have no restart markers using multiple
+ * threads.  Each thread guesses where an MCU begins in its share of the
+ * entropy-coded data and relies on the self-synchronizing property of Huffman
+ * codes to find the true MCU boundaries.  The results are verified before they
+ * are used, so the output is still identical to that of a single-threaded
+ * decompression, but some of the entropy-coded data is decoded twice, and if
+ * the threads fail to synchronize, the work is wasted.  Thus, this is only
+ * attempted with images that have at least 512 KB of entropy-coded data per
+ * thread.
+ */
+#define TJFLAG_SPECULATIVE  65536
 
 
 /**